@@ -11,14 +11,10 @@ uniform mat4 TU_mvMatrix;
 uniform mat4 TU_mMatrix;
 uniform mat4 TU_normalMatrix;
 uniform float TU_roughness;
+// TerrainVertex, the position is quantized, TU_mMatrix carries the scale and offset of the chunk
 in vec3 a_position;
-in vec3 a_normal;
-in vec2 a_texcoord;
-in vec3 a_color;
-in vec3 a_bc;
-in ivec3 a_mat;
-in vec3 a_matBlend;
-in vec3 a_tangent;
+in vec2 a_packedNormal;
+in uvec4 a_mat;
 
 out vec3 v_position;
 out vec3 v_normal;
@@ -30,18 +26,33 @@ out vec3 v_heightColor;
 out vec3 v_tangent;
 out vec3 v_matBlend;
 out float[16] v_mat;
+vec3 decodeOctahedron(vec2 e)
+{
+	vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0.0)
+	{
+		vec2 signNotZero = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+		n.xy = (1.0 - abs(n.yx)) * signNotZero;
+	}
+	return normalize(n);
+}
+
 //! [0]
 void main()
 {
+	vec3 a_normal = decodeOctahedron(a_packedNormal);
+	// high four bit for material 1, low four bit for material 2, see MatBlendInfo
+	float blend1 = float((a_mat.w >> 4) & 15u) / 15.0;
+	float blend2 = float(a_mat.w & 15u) / 15.0;
+	vec3 a_matBlend = vec3(blend1, blend2, 1.0 - blend1 - blend2);
 
 	v_position = (TU_mMatrix * vec4(a_position,1.0)).xyz;
 	v_normal = (TU_normalMatrix * vec4(a_normal,0.0)).xyz;
-    // Pass texture coordinate to fragment shader
-    // Value will be automatically interpolated to fragments inside polygon faces
-    v_texcoord = a_texcoord;
 	v_worldPos = (TU_mMatrix * vec4(a_position, 1.0)).xyz;
-	v_bc = a_bc;
-	v_color = a_color;
+	v_texcoord = v_worldPos.xz;
+	// no barycentric in the packed vertex, so no wire frame edge either
+	v_bc = vec3(1.0);
+	v_color = vec3(1.0);
 	v_mat = float[16](0.0);
 	v_mat[a_mat.x] = a_matBlend.x;
     if (a_mat.y != a_mat.x)
@@ -53,7 +64,7 @@ void main()
         v_mat[a_mat.z] = a_matBlend.z;
     }
 
-	v_tangent = (TU_mMatrix * vec4(a_tangent,0.0)).xyz;
+	v_tangent = (TU_mMatrix * vec4(1.0, 0.0, 0.0, 0.0)).xyz;
 
     // Calculate vertex position in screen space
     gl_Position = TU_mvpMatrix * vec4(a_position,1.0);
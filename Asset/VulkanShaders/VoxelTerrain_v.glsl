@@ -14,13 +14,10 @@ layout(set = 1, binding = 0) uniform UniformBufferObject {
 
 
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec4 inColor;
-layout(location = 2) in vec2 texcoord;
-layout(location = 3) in vec3 inNormal;
-layout(location = 4) in vec3 inTangent;
-layout(location = 5) in vec3 a_matBlend;
-layout(location = 6) in ivec3 a_mat;
+// TerrainVertex, the position is quantized, TU_mMatrix carries the scale and offset of the chunk
+layout(location = 0) in uvec4 inPackedPosition;
+layout(location = 1) in vec2 inPackedNormal;
+layout(location = 2) in uvec4 a_mat;
 
 layout(location = 0) out vec4 fragColor;
 layout(location = 1) out vec2 v_texcoord;
@@ -30,15 +27,32 @@ layout(location = 4) out vec3 v_matBlend;
 layout(location = 5) out float[16] v_mat;
 layout(location = 22) out vec3 v_worldPos;
 
+vec3 decodeOctahedron(vec2 e)
+{
+	vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0.0)
+	{
+		vec2 signNotZero = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+		n.xy = (1.0 - abs(n.yx)) * signNotZero;
+	}
+	return normalize(n);
+}
+
 void main() {
+	vec3 inPosition = vec3(inPackedPosition.xyz);
+	vec3 inNormal = decodeOctahedron(inPackedNormal);
+	// high four bit for material 1, low four bit for material 2, see MatBlendInfo
+	float blend1 = float((a_mat.w >> 4) & 15u) / 15.0;
+	float blend2 = float(a_mat.w & 15u) / 15.0;
+	vec3 a_matBlend = vec3(blend1, blend2, 1.0 - blend1 - blend2);
     gl_Position = t_ObjectUniform.mvp * vec4(inPosition, 1.0);
 	
-	v_texcoord = texcoord;
-	
 	v_worldPos = (t_ObjectUniform.TU_mMatrix * vec4(inPosition, 1.0)).xyz;
-	fragColor = inColor * t_shaderUnifom.TU_color;
+	v_texcoord = v_worldPos.xz;
+	fragColor = t_shaderUnifom.TU_color;
 	v_normal = (t_ObjectUniform.TU_mMatrix * vec4(inNormal,0.0)).xyz;
-	v_tangent = (t_ObjectUniform.TU_mMatrix * vec4(inTangent,0.0)).xyz;
+	v_tangent = (t_ObjectUniform.TU_mMatrix * vec4(1.0, 0.0, 0.0, 0.0)).xyz;
+	v_matBlend = a_matBlend;
 	v_mat = float[16](0.0,0.0,0.0,0.0, 0.0,0.0,0.0,0.0, 0.0,0.0,0.0,0.0, 0.0,0.0,0.0,0.0);
 	v_mat[a_mat.x] = a_matBlend.x;
 	if (a_mat.y != a_mat.x)
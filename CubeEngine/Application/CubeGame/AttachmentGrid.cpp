@@ -0,0 +1,115 @@
+#include "AttachmentGrid.h"
+#include "Attachment.h"
+#include "GamePart.h"
+#include <algorithm>
+#include <cmath>
+
+namespace tzw
+{
+	//bigger than the matching distance, so a probe almost always touches a single cell
+	static const float ATTACHMENT_CELL_SIZE = 0.125f;
+
+	void AttachmentGrid::add(GamePart* part)
+	{
+		for(int i = 0; i < part->getAttachmentCount(); i++)
+		{
+			auto attach = part->getAttachment(i);
+			vec3 p, n, up;
+			attach->getAttachmentInfo(p, n, up);
+			int cell[3];
+			getCell(p, cell);
+			uint64_t key = getKey(cell[0], cell[1], cell[2]);
+			auto result = m_keyMap.emplace(attach, key);
+			if(!result.second)
+			{
+				continue;
+			}
+			m_cellMap[key].push_back(attach);
+		}
+	}
+
+	void AttachmentGrid::remove(GamePart* part)
+	{
+		for(int i = 0; i < part->getAttachmentCount(); i++)
+		{
+			auto attach = part->getAttachment(i);
+			auto keyIter = m_keyMap.find(attach);
+			if(keyIter == m_keyMap.end())
+			{
+				continue;
+			}
+			auto cellIter = m_cellMap.find(keyIter->second);
+			auto & attachList = cellIter->second;
+			auto result = std::find(attachList.begin(), attachList.end(), attach);
+			*result = attachList.back();
+			attachList.pop_back();
+			if(attachList.empty())
+			{
+				m_cellMap.erase(cellIter);
+			}
+			m_keyMap.erase(keyIter);
+		}
+	}
+
+	void AttachmentGrid::update(GamePart* part)
+	{
+		remove(part);
+		add(part);
+	}
+
+	void AttachmentGrid::clear()
+	{
+		m_cellMap.clear();
+		m_keyMap.clear();
+	}
+
+	Attachment* AttachmentGrid::findFree(const vec3& pos, GamePart* exceptPart, float distance)
+	{
+		int minCell[3];
+		int maxCell[3];
+		getCell(pos - vec3(distance, distance, distance), minCell);
+		getCell(pos + vec3(distance, distance, distance), maxCell);
+		for(int x = minCell[0]; x <= maxCell[0]; x++)
+		{
+			for(int y = minCell[1]; y <= maxCell[1]; y++)
+			{
+				for(int z = minCell[2]; z <= maxCell[2]; z++)
+				{
+					auto cellIter = m_cellMap.find(getKey(x, y, z));
+					if(cellIter == m_cellMap.end()) continue;
+					for(auto attach : cellIter->second)
+					{
+						if(attach->m_connected || attach->m_parent == exceptPart) continue;
+						//the stored cell may be stale if the part moved, always test the current position
+						vec3 p, n, up;
+						attach->getAttachmentInfo(p, n, up);
+						if(pos.distance(p) < distance)
+						{
+							return attach;
+						}
+					}
+				}
+			}
+		}
+		return nullptr;
+	}
+
+	size_t AttachmentGrid::size() const
+	{
+		return m_keyMap.size();
+	}
+
+	uint64_t AttachmentGrid::getKey(int x, int y, int z) const
+	{
+		//21 bits per axis, enough for +-131km with the cell size above
+		const uint64_t mask = (1ull << 21) - 1;
+		return (uint64_t(x) & mask) | ((uint64_t(y) & mask) << 21) | ((uint64_t(z) & mask) << 42);
+	}
+
+	void AttachmentGrid::getCell(const vec3& pos, int cell[3]) const
+	{
+		cell[0] = int(std::floor(pos.x / ATTACHMENT_CELL_SIZE));
+		cell[1] = int(std::floor(pos.y / ATTACHMENT_CELL_SIZE));
+		cell[2] = int(std::floor(pos.z / ATTACHMENT_CELL_SIZE));
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "Math/vec3.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace tzw
+{
+	struct Attachment;
+	class GamePart;
+	// Spatial hash of the attachments of an island, keyed by the quantized position in the island space,
+	// so the position stays valid while the island itself moves.
+	// Every attachment of the inserted parts is kept, connected or not, because a connection can be broken
+	// at any time, the free ones are filtered when probing.
+	class AttachmentGrid
+	{
+	public:
+		void add(GamePart * part);
+		void remove(GamePart * part);
+		//for the part moved inside the island after it is added
+		void update(GamePart * part);
+		void clear();
+		//the free attachment of another part within distance of pos, or nullptr
+		Attachment * findFree(const vec3 & pos, GamePart * exceptPart, float distance = 0.001f);
+		size_t size() const;
+	private:
+		uint64_t getKey(int x, int y, int z) const;
+		void getCell(const vec3 & pos, int cell[3]) const;
+		std::unordered_map<uint64_t, std::vector<Attachment *>> m_cellMap;
+		//the key each attachment was stored with, the part may move afterward
+		std::unordered_map<Attachment *, uint64_t> m_keyMap;
+	};
+}
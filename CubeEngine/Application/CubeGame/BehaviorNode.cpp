@@ -1,5 +1,6 @@
 #include "BehaviorNode.h"
 #include "GameUISystem.h"
+#include "NodeProgram.h"
 
 
 namespace tzw
@@ -10,9 +11,9 @@ namespace tzw
 		m_out = addOutExe(u8" ");
 	}
 
-	NodeAttrValue BehaviorNode::execute()
+	void BehaviorNode::compile(NodeProgramBuilder& builder)
 	{
-		return NodeAttrValue();
+		builder.addFollow(m_out);
 	}
 
 	vec3 BehaviorNode::getNodeColor()
@@ -24,19 +25,4 @@ namespace tzw
 	{
 		return Node_TYPE_BEHAVIOR;
 	}
-
-	void BehaviorNode::handleExeOut()
-	{
-		auto nodeEditor = getNodeEditor();
-		std::vector<GraphNode * > node_list;
-		nodeEditor->findNodeLinksToAttr(m_out, node_list);
-		for(auto node : node_list)
-		{
-			if(node->getType() == Node_TYPE_BEHAVIOR)
-			{
-				//static_cast<BehaviorNode *>(node)->execute();
-				nodeEditor->pushToStack(node);
-			}
-		}
-	}
 }
@@ -9,10 +9,9 @@ struct BehaviorNode: public GraphNode
 {
 public:
 	BehaviorNode();
-	NodeAttrValue execute() override;
+	void compile(NodeProgramBuilder & builder) override;
 	vec3 getNodeColor() override;
 	int getType() override;
-	void handleExeOut() override;
 protected:
 	NodeAttr * m_out;
 };
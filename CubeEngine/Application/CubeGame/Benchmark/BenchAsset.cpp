@@ -0,0 +1,144 @@
+#include "BenchCheck.h"
+#include "CubeGame/BenchmarkReplay.h"
+#include "3D/Model/ModelLoader.h"
+#include "Mesh/Mesh.h"
+#include "Utility/log/Log.h"
+#include "Utility/file/Tfile.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+
+namespace tzw
+{
+static bool isModelMeshEqual(Mesh * a, Mesh * b)
+{
+	if(a->getMatIndex() != b->getMatIndex() || a->m_vertices.size() != b->m_vertices.size() || a->m_indices.size() != b->m_indices.size())
+	{
+		return false;
+	}
+	return (a->m_vertices.empty() || !memcmp(a->m_vertices.data(), b->m_vertices.data(), a->m_vertices.size() * sizeof(VertexData)))
+		&& (a->m_indices.empty() || !memcmp(a->m_indices.data(), b->m_indices.data(), a->m_indices.size() * sizeof(short_u)));
+}
+
+void runModelLoad(const rapidjson::Value & option)
+{
+	int runs = std::max(getBenchInt(option, "runs", 20), 1);
+	auto loader = ModelLoader::shared();
+	auto & files = option["files"];
+	for(unsigned int f = 0; f < files.Size(); f++)
+	{
+		std::string filePath = files[f].GetString();
+		//written to the temp folder, a binary left in the asset tree would be loaded by the game
+		std::error_code error;
+		auto binaryPath = (std::filesystem::temp_directory_path(error) / (std::filesystem::path(filePath).stem().string() + ".tzwb")).string();
+		if(error || !loader->convertToBinary(filePath, binaryPath))
+		{
+			BenchmarkReplay::shared()->reportFailure("model load: can't convert %s", filePath.c_str());
+			continue;
+		}
+		std::string pathList[] = {filePath, binaryPath};
+		double timeList[2];
+		for(int k = 0; k < 2; k++)
+		{
+			auto begin = std::chrono::high_resolution_clock::now();
+			for(int i = 0; i < runs; i++)
+			{
+				std::vector<Mesh *> meshList;
+				loader->readMeshes(pathList[k], meshList);
+				for(auto mesh : meshList)
+				{
+					delete mesh;
+				}
+			}
+			timeList[k] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count() / runs;
+		}
+		tlog("model %s: json %.3f ms, binary %.3f ms", filePath.c_str(), timeList[0], timeList[1]);
+		//the binary keeps the vertices after Mesh::finish, so both have to be byte identical
+		std::vector<Mesh *> jsonList, binaryList;
+		loader->readMeshes(filePath, jsonList);
+		loader->readMeshes(binaryPath, binaryList);
+		int mismatchCount = int(std::max(jsonList.size(), binaryList.size()) - std::min(jsonList.size(), binaryList.size()));
+		for(size_t i = 0; i < std::min(jsonList.size(), binaryList.size()); i++)
+		{
+			if(!isModelMeshEqual(jsonList[i], binaryList[i]))
+			{
+				mismatchCount++;
+			}
+		}
+		for(auto mesh : jsonList)
+		{
+			delete mesh;
+		}
+		for(auto mesh : binaryList)
+		{
+			delete mesh;
+		}
+		if(mismatchCount)
+		{
+			BenchmarkReplay::shared()->reportFailure("model load: %d meshes of %s differ between the json and the binary", mismatchCount, filePath.c_str());
+		}
+		std::filesystem::remove(binaryPath, error);
+	}
+}
+
+void runFileLookup(const rapidjson::Value & option)
+{
+	int runs = std::max(getBenchInt(option, "runs", 1000), 1);
+	int threadCount = std::max(getBenchInt(option, "threads", 4), 1);
+	auto file = Tfile::shared();
+	auto & files = option["files"];
+	for(unsigned int f = 0; f < files.Size(); f++)
+	{
+		std::string filePath = files[f].GetString();
+		if(!file->isExist(filePath))
+		{
+			BenchmarkReplay::shared()->reportFailure("file lookup: %s is not found", filePath.c_str());
+			continue;
+		}
+		auto begin = std::chrono::high_resolution_clock::now();
+		for(int i = 0; i < runs; i++)
+		{
+			file->isExist(filePath);
+		}
+		double existTime = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - begin).count() / runs;
+		begin = std::chrono::high_resolution_clock::now();
+		size_t size = 0;
+		for(int i = 0; i < runs; i++)
+		{
+			size = file->getData(filePath, false).getSize();
+		}
+		double dataTime = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - begin).count() / runs;
+		tlog("file %s (%zu bytes): isExist %.2f us, getData %.2f us", filePath.c_str(), size, existTime, dataTime);
+		//the lookups are shared by every thread, each one has to read the same bytes
+		auto reference = file->getData(filePath, false);
+		std::atomic<int> mismatchCount(0);
+		std::vector<std::thread> threadList;
+		for(int t = 0; t < threadCount; t++)
+		{
+			threadList.emplace_back([&]()
+			{
+				for(int i = 0; i < runs; i++)
+				{
+					auto data = file->getData(filePath, false);
+					if(data.getSize() != reference.getSize() || (data.getSize() && memcmp(data.getBytes(), reference.getBytes(), data.getSize())))
+					{
+						mismatchCount++;
+					}
+				}
+			});
+		}
+		for(auto & thread : threadList)
+		{
+			thread.join();
+		}
+		if(mismatchCount)
+		{
+			BenchmarkReplay::shared()->reportFailure("file lookup: %d reads of %s on %d threads differ", int(mismatchCount), filePath.c_str(), threadCount);
+		}
+	}
+}
+}
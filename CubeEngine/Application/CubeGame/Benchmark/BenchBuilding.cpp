@@ -0,0 +1,45 @@
+#include "BenchCheck.h"
+#include "CubeGame/BuildingSystem.h"
+#include "CubeGame/GamePartType.h"
+#include "Utility/log/Log.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+
+namespace tzw
+{
+void runStaticBlocks(const rapidjson::Value & option)
+{
+	int count = std::max(getBenchInt(option, "count", 5000), 1);
+	std::string item = option.HasMember("item") ? option["item"].GetString() : "Block";
+	vec3 origin;
+	if(option.HasMember("origin"))
+	{
+		auto & originValue = option["origin"];
+		origin = vec3(originValue[0].GetDouble(), originValue[1].GetDouble(), originValue[2].GetDouble());
+	}
+	const float blockSize = 0.5f;
+	const int batchSize = 1000;
+	int side = int(std::ceil(std::cbrt(float(count))));
+	auto batchBegin = std::chrono::high_resolution_clock::now();
+	auto totalBegin = batchBegin;
+	for(int i = 0; i < count; i++)
+	{
+		//fill x first, then z, then y, so every block touches the ones placed before it
+		int x = i % side;
+		int z = (i / side) % side;
+		int y = i / (side * side);
+		auto part = BuildingSystem::shared()->createPart(int(GamePartType::GAME_PART_BLOCK), item);
+		BuildingSystem::shared()->placeGamePartStatic(part, origin + vec3(x, y, z) * blockSize);
+		if((i + 1) % batchSize == 0 || i + 1 == count)
+		{
+			auto now = std::chrono::high_resolution_clock::now();
+			tlog("static blocks %d ~ %d: %.2f ms", (i / batchSize) * batchSize, i + 1, std::chrono::duration<double, std::milli>(now - batchBegin).count());
+			batchBegin = now;
+		}
+	}
+	auto totalTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - totalBegin).count();
+	tlog("static blocks %d: %.2f ms, %.4f ms per block", count, totalTime, totalTime / count);
+}
+}
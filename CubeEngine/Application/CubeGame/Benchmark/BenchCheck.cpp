@@ -0,0 +1,100 @@
+#include "BenchCheck.h"
+#include "CubeGame/GameWorld.h"
+#include "CubeGame/GameMap.h"
+#include "CubeGame/CubePlayer.h"
+#include "Mesh/Mesh.h"
+#include "Utility/log/Log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace tzw
+{
+BenchCheckTable::BenchCheckTable()
+{
+	//name, runner, one line of doc
+	add("static_blocks", runStaticBlocks, "{count = 5000, item = Block, origin} places the blocks one by one as a solid cube, logs every thousand placements");
+	add("node_graph", runNodeGraph, "{count = 2000, runs = 100} compiles and runs a chain of if nodes in a detached node editor, the equal node at its end has to run");
+	add("script_calls", runScriptCalls, "count, calls a python builtin through a cached ScriptPyFunction and through one resolved per call");
+	add("model_load", runModelLoad, "{files, runs = 20} reads the geometry of the json models and of their .tzwb, both have to match");
+	add("file_lookup", runFileLookup, "{files, runs = 1000, threads = 4} Tfile::isExist and getData per file, reads on the threads have to match");
+	add("math_kernels", runMathKernels, "{count = 100000, runs = 10} SIMD Matrix44, AABB and Frustum kernels on random inputs, have to match the scalar paths");
+	add("transform_tree", runTransformTree, "{count = 100000, fan_out = 2, depth = 8, runs = 20} Node::reCache against cacheTransform node by node over vehicle trees, has to match a scalar reference");
+	add("chunk_stress", runChunkStress, "{radius, threads = 8, runs = 4} threaded meshing of every LOD around the player, has to match one thread");
+	add("noise_columns", runNoiseColumns, "{count = 65536, runs = 10} terrain height of random columns by getHeightBatch on every SIMD level, has to match getHeight");
+	add("region_read", runRegionRead, "{radius, runs = 5} deflate load, raw load and map of the buffers around the player, has to match the map");
+	add("transvoxel", runTransVoxel, "{radius, runs = 3} meshing of every LOD around the player with the SIMD cell classification, has to match the scalar one");
+	add("triangle_bvh", runTriangleBVH, "{radius, rays = 200} TriangleBVH build and rayCastFirst on the LOD0 meshes around the player, has to match a loop over every triangle");
+}
+
+void BenchCheckTable::run(const rapidjson::Value & script)
+{
+	for(auto & check : m_checkList)
+	{
+		if(!script.HasMember(check.m_name)) continue;
+		tlog("bench check %s: %s", check.m_name, check.m_doc);
+		check.m_runner(script[check.m_name]);
+	}
+}
+
+void BenchCheckTable::add(const char * name, BenchCheckRunner runner, const char * doc)
+{
+	BenchCheck check;
+	check.m_name = name;
+	check.m_runner = runner;
+	check.m_doc = doc;
+	m_checkList.push_back(check);
+}
+
+int getBenchInt(const rapidjson::Value & option, const char * name, int defaultValue)
+{
+	if(!option.IsObject() || !option.HasMember(name)) return defaultValue;
+	return option[name].GetInt();
+}
+
+float getBenchRelativeError(const float * a, const float * b, int count)
+{
+	float diff = 0.0f, range = 1e-6f;
+	for(int i = 0; i < count; i++)
+	{
+		diff = std::max(diff, std::fabs(a[i] - b[i]));
+		range = std::max(range, std::fabs(b[i]));
+	}
+	return diff / range;
+}
+
+std::vector<BenchChunk> getBenchChunks(int radius)
+{
+	auto voxelPos = GameMap::shared()->worldPosToVoxelPos(GameWorld::shared()->getPlayer()->getPos()) - vec3(LOD_SHIFT);
+	int posX = int(floor(voxelPos.x / MAX_BLOCK));
+	int posZ = int(floor(voxelPos.z / MAX_BLOCK));
+	float chunkSize = BLOCK_SIZE * MAX_BLOCK;
+	std::vector<BenchChunk> chunkList;
+	for(int i = posX - radius; i <= posX + radius; i++)
+	{
+		for(int j = 0; j < GAME_MAP_HEIGHT; j++)
+		{
+			for(int k = posZ - radius; k <= posZ + radius; k++)
+			{
+				BenchChunk chunk;
+				chunk.x = i;
+				chunk.y = j;
+				chunk.z = k;
+				chunk.m_basePoint = vec3(i * chunkSize, j * chunkSize, k * chunkSize) + vec3(LOD_SHIFT * BLOCK_SIZE) + GameMap::shared()->getMapOffset();
+				chunkList.push_back(chunk);
+			}
+		}
+	}
+	return chunkList;
+}
+
+bool isBenchMeshEqual(Mesh * a, Mesh * b)
+{
+	if(a->m_terrainVertices.size() != b->m_terrainVertices.size() || a->m_indices.size() != b->m_indices.size())
+	{
+		return false;
+	}
+	return (a->m_terrainVertices.empty() || !memcmp(a->m_terrainVertices.data(), b->m_terrainVertices.data(), a->m_terrainVertices.size() * sizeof(TerrainVertex)))
+		&& (a->m_indices.empty() || !memcmp(a->m_indices.data(), b->m_indices.data(), a->m_indices.size() * sizeof(short_u)));
+}
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "Engine/EngineDef.h"
+#include "Math/vec3.h"
+#include <rapidjson/document.h>
+#include <vector>
+namespace tzw
+{
+class Mesh;
+//gets the member of the script named like the check, an object of options or a single value
+typedef void (*BenchCheckRunner)(const rapidjson::Value & option);
+struct BenchCheck
+{
+	const char * m_name;
+	BenchCheckRunner m_runner;
+	//the options and what is compared, logged before the check runs
+	const char * m_doc;
+};
+// The micro benchmarks of a benchmark script, run by BenchmarkReplay once the world is loaded and before the warm up.
+// every check times a subsystem and logs the result, a check with a reference path compares against it and passes
+// a difference to BenchmarkReplay::reportFailure.
+class BenchCheckTable : public Singleton<BenchCheckTable>
+{
+public:
+	BenchCheckTable();
+	//runs the checks which are a member of the script, in table order
+	void run(const rapidjson::Value & script);
+private:
+	void add(const char * name, BenchCheckRunner runner, const char * doc);
+	std::vector<BenchCheck> m_checkList;
+};
+
+//helpers shared by the checks
+int getBenchInt(const rapidjson::Value & option, const char * name, int defaultValue);
+//max |a - b| over the largest |b|, so the error of a matrix doesn't depend on its scale
+float getBenchRelativeError(const float * a, const float * b, int count);
+struct BenchChunk
+{
+	int x;
+	int y;
+	int z;
+	vec3 m_basePoint;
+};
+//the columns GameWorld::loadChunksAroundPlayer would load for the given range
+std::vector<BenchChunk> getBenchChunks(int radius);
+//same terrain vertices and indices
+bool isBenchMeshEqual(Mesh * a, Mesh * b);
+
+//BenchTerrain.cpp
+void runChunkStress(const rapidjson::Value & option);
+void runNoiseColumns(const rapidjson::Value & option);
+void runRegionRead(const rapidjson::Value & option);
+void runTransVoxel(const rapidjson::Value & option);
+void runTriangleBVH(const rapidjson::Value & option);
+
+//BenchMath.cpp
+void runTransformTree(const rapidjson::Value & option);
+void runMathKernels(const rapidjson::Value & option);
+
+//BenchBuilding.cpp
+void runStaticBlocks(const rapidjson::Value & option);
+
+//BenchScript.cpp
+void runNodeGraph(const rapidjson::Value & option);
+void runScriptCalls(const rapidjson::Value & option);
+
+//BenchAsset.cpp
+void runModelLoad(const rapidjson::Value & option);
+void runFileLookup(const rapidjson::Value & option);
+}
@@ -0,0 +1,236 @@
+#include "BenchCheck.h"
+#include "CubeGame/BenchmarkReplay.h"
+#include "Base/Node.h"
+#include "Utility/log/Log.h"
+#include "Math/Frustum.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <random>
+
+namespace tzw
+{
+void runTransformTree(const rapidjson::Value & option)
+{
+	int count = std::max(getBenchInt(option, "count", 100000), 1);
+	int fanOut = std::max(getBenchInt(option, "fan_out", 2), 1);
+	int depth = std::max(getBenchInt(option, "depth", 8), 0);
+	int runs = std::max(getBenchInt(option, "runs", 20), 1);
+	int vehicleSize = 1;
+	for(int level = 0, levelSize = 1; level < depth; level++)
+	{
+		levelSize *= fanOut;
+		vehicleSize += levelSize;
+	}
+	int vehicleCount = std::max(count / vehicleSize, 1);
+	//built parent first, so nodeList is in breadth first order and parentList points backwards
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> offsetRange(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> angleRange(-30.0f, 30.0f);
+	auto root = Node::create();
+	std::vector<Node *> nodeList;
+	std::vector<int> parentList;
+	std::vector<Node *> vehicleList;
+	for(int v = 0; v < vehicleCount; v++)
+	{
+		auto vehicle = Node::create();
+		vehicle->setPos(vec3(float(v % 100) * 10.0f, 0.0f, float(v / 100) * 10.0f));
+		root->addChild(vehicle, false);
+		vehicleList.push_back(vehicle);
+		size_t levelBegin = nodeList.size();
+		nodeList.push_back(vehicle);
+		parentList.push_back(-1);
+		for(int level = 0; level < depth; level++)
+		{
+			size_t levelEnd = nodeList.size();
+			for(size_t p = levelBegin; p < levelEnd; p++)
+			{
+				for(int c = 0; c < fanOut; c++)
+				{
+					auto part = Node::create();
+					part->setPos(vec3(offsetRange(random), offsetRange(random), offsetRange(random)));
+					part->setRotateE(vec3(angleRange(random), angleRange(random), angleRange(random)));
+					nodeList[p]->addChild(part, false);
+					nodeList.push_back(part);
+					parentList.push_back(int(p));
+				}
+			}
+			levelBegin = levelEnd;
+		}
+	}
+	auto moveVehicles = [&](int run)
+	{
+		for(size_t v = 0; v < vehicleList.size(); v++)
+		{
+			vehicleList[v]->setRotateE(vec3(0.0f, float((run * 7 + v) % 360), 0.0f));
+		}
+	};
+	auto batchBegin = std::chrono::high_resolution_clock::now();
+	for(int r = 0; r < runs; r++)
+	{
+		moveVehicles(r);
+		root->reCache();
+	}
+	double batchTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - batchBegin).count() / runs;
+	//the scalar reference of the last run, root is at the origin
+	std::vector<Matrix44> referenceList(nodeList.size());
+	float error = 0.0f;
+	for(size_t i = 0; i < nodeList.size(); i++)
+	{
+		Matrix44 local = nodeList[i]->getLocalTransform();
+		if(parentList[i] < 0)
+		{
+			referenceList[i] = root->getLocalTransform().multiplyScalar(local);
+		}
+		else
+		{
+			referenceList[i] = referenceList[parentList[i]].multiplyScalar(local);
+		}
+		error = std::max(error, getBenchRelativeError(nodeList[i]->getTransform().data(), referenceList[i].data(), 16));
+	}
+	auto nodeBegin = std::chrono::high_resolution_clock::now();
+	for(int r = 0; r < runs; r++)
+	{
+		moveVehicles(r);
+		for(auto node : nodeList)
+		{
+			node->cacheTransform();
+		}
+	}
+	double nodeTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - nodeBegin).count() / runs;
+	tlog("transform tree %zu nodes in %d vehicles: reCache %.3f ms, per node %.3f ms, max error %g", nodeList.size(), vehicleCount, batchTime, nodeTime, error);
+	if(error > 1e-6f)
+	{
+		BenchmarkReplay::shared()->reportFailure("transform tree: max error %g against the scalar reference", error);
+	}
+	delete root;
+}
+
+void runMathKernels(const rapidjson::Value & option)
+{
+	//the SSE paths keep the scalar summation order, only the block inverse is expected to differ
+	const float exactTolerance = 1e-6f;
+	const float inverseTolerance = 1e-3f;
+	int count = std::max(getBenchInt(option, "count", 100000), 1);
+	int runs = std::max(getBenchInt(option, "runs", 10), 1);
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> posRange(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> angleRange(-180.0f, 180.0f);
+	std::uniform_real_distribution<float> scaleRange(0.5f, 2.0f);
+	std::vector<Matrix44> matList(count);
+	std::vector<vec3> pointList(count);
+	std::vector<AABB> boxList(count);
+	for(int i = 0; i < count; i++)
+	{
+		Quaternion q;
+		q.fromEulerAngle(vec3(angleRange(random), angleRange(random), angleRange(random)));
+		matList[i].setTRS(vec3(posRange(random), posRange(random), posRange(random)), q, vec3(scaleRange(random), scaleRange(random), scaleRange(random)));
+		pointList[i] = vec3(posRange(random), posRange(random), posRange(random));
+		vec3 half(scaleRange(random), scaleRange(random), scaleRange(random));
+		boxList[i].setMin(pointList[i] - half);
+		boxList[i].setMax(pointList[i] + half);
+	}
+	auto timeKernel = [runs, count](const std::function<void()> & func)
+	{
+		auto begin = std::chrono::high_resolution_clock::now();
+		for(int r = 0; r < runs; r++)
+		{
+			func();
+		}
+		return std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - begin).count() / (double(runs) * count);
+	};
+	auto report = [](const char * name, double simdTime, double scalarTime, float error, float tolerance)
+	{
+		tlog("math %s: simd %.2f ns, scalar %.2f ns, max error %g", name, simdTime, scalarTime, error);
+		if(error > tolerance)
+		{
+			BenchmarkReplay::shared()->reportFailure("math %s: max error %g is over the tolerance %g", name, error, tolerance);
+		}
+	};
+	auto reportMismatch = [](const char * name, double simdTime, double scalarTime, int mismatch)
+	{
+		tlog("math %s: simd %.2f ns, scalar %.2f ns, %d results differ", name, simdTime, scalarTime, mismatch);
+		if(mismatch)
+		{
+			BenchmarkReplay::shared()->reportFailure("math %s: %d results differ from the scalar path", name, mismatch);
+		}
+	};
+
+	//matrix multiply, each matrix with its neighbour
+	std::vector<Matrix44> simdMat(count), scalarMat(count);
+	double simdTime = timeKernel([&]{ for(int i = 0; i < count; i++) simdMat[i] = matList[i] * matList[(i + 1) % count]; });
+	double scalarTime = timeKernel([&]{ for(int i = 0; i < count; i++) scalarMat[i] = matList[i].multiplyScalar(matList[(i + 1) % count]); });
+	float error = 0.0f;
+	for(int i = 0; i < count; i++)
+	{
+		error = std::max(error, getBenchRelativeError(simdMat[i].data(), scalarMat[i].data(), 16));
+	}
+	report("multiply", simdTime, scalarTime, error, exactTolerance);
+	simdTime = timeKernel([&]{ Matrix44::multiplyList(matList[0], matList.data(), simdMat.data(), count); });
+	error = 0.0f;
+	for(int i = 0; i < count; i++)
+	{
+		error = std::max(error, getBenchRelativeError(simdMat[i].data(), matList[0].multiplyScalar(matList[i]).data(), 16));
+	}
+	report("multiplyList", simdTime, scalarTime, error, exactTolerance);
+
+	//inverse, the error is taken against the cofactor expansion of the scalar path
+	simdTime = timeKernel([&]{ for(int i = 0; i < count; i++) simdMat[i] = matList[i].inverted(); });
+	scalarTime = timeKernel([&]{ for(int i = 0; i < count; i++) scalarMat[i] = matList[i].invertedScalar(); });
+	error = 0.0f;
+	for(int i = 0; i < count; i++)
+	{
+		error = std::max(error, getBenchRelativeError(simdMat[i].data(), scalarMat[i].data(), 16));
+	}
+	report("inverted", simdTime, scalarTime, error, inverseTolerance);
+
+	//points
+	std::vector<vec3> simdPoint(count), scalarPoint(count);
+	simdTime = timeKernel([&]{ matList[0].transformVec3List(pointList.data(), simdPoint.data(), count); });
+	scalarTime = timeKernel([&]{ for(int i = 0; i < count; i++) scalarPoint[i] = matList[0].transformVec3(pointList[i]); });
+	error = 0.0f;
+	for(int i = 0; i < count; i++)
+	{
+		error = std::max(error, getBenchRelativeError(&simdPoint[i].x, &scalarPoint[i].x, 3));
+	}
+	report("transformVec3List", simdTime, scalarTime, error, exactTolerance);
+
+	//boxes
+	std::vector<AABB> simdBox(boxList), scalarBox(boxList);
+	simdTime = timeKernel([&]{ for(int i = 0; i < count; i++) { simdBox[i] = boxList[i]; simdBox[i].transForm(matList[i]); } });
+	scalarTime = timeKernel([&]{ for(int i = 0; i < count; i++) { scalarBox[i] = boxList[i]; scalarBox[i].transFormScalar(matList[i]); } });
+	error = 0.0f;
+	for(int i = 0; i < count; i++)
+	{
+		vec3 simdMin = simdBox[i].min(), simdMax = simdBox[i].max(), scalarMin = scalarBox[i].min(), scalarMax = scalarBox[i].max();
+		error = std::max(error, std::max(getBenchRelativeError(&simdMin.x, &scalarMin.x, 3), getBenchRelativeError(&simdMax.x, &scalarMax.x, 3)));
+	}
+	report("AABB::transForm", simdTime, scalarTime, error, exactTolerance);
+
+	//frustum, a perspective camera at the origin looking down -z, about half of the boxes are in it
+	Matrix44 projection;
+	projection.perspective(60.0f, 16.0f / 9.0f, 0.1f, 150.0f);
+	Frustum frustum;
+	frustum.initFrustumFromProjectMatrix(projection);
+	std::unique_ptr<bool[]> simdOut(new bool[count]), scalarOut(new bool[count]), batchOut(new bool[count]);
+	simdTime = timeKernel([&]{ for(int i = 0; i < count; i++) simdOut[i] = frustum.isOutOfFrustum(boxList[i]); });
+	scalarTime = timeKernel([&]{ for(int i = 0; i < count; i++) scalarOut[i] = frustum.isOutOfFrustumScalar(boxList[i]); });
+	double batchTime = timeKernel([&]{ frustum.isOutOfFrustum(boxList.data(), count, batchOut.get()); });
+	int mismatch = 0;
+	for(int i = 0; i < count; i++)
+	{
+		mismatch += (simdOut[i] != scalarOut[i]) + (batchOut[i] != scalarOut[i]);
+	}
+	reportMismatch("isOutOfFrustum", simdTime, scalarTime, mismatch);
+	tlog("math isOutOfFrustum batch: %.2f ns", batchTime);
+	simdTime = timeKernel([&]{ for(int i = 0; i < count; i++) simdOut[i] = frustum.isInsideFrustum(boxList[i]); });
+	scalarTime = timeKernel([&]{ for(int i = 0; i < count; i++) scalarOut[i] = frustum.isInsideFrustumScalar(boxList[i]); });
+	mismatch = 0;
+	for(int i = 0; i < count; i++)
+	{
+		mismatch += simdOut[i] != scalarOut[i];
+	}
+	reportMismatch("isInsideFrustum", simdTime, scalarTime, mismatch);
+}
+}
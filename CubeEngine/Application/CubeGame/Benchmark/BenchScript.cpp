@@ -0,0 +1,88 @@
+#include "BenchCheck.h"
+#include "CubeGame/GameNodeEditor.h"
+#include "CubeGame/BenchmarkReplay.h"
+#include "CubeGame/NodeEditorNodes/IfNode.h"
+#include "CubeGame/NodeEditorNodes/EqualNode.h"
+#include "CubeGame/NodeEditorNodes/VarNode.h"
+#include "Utility/log/Log.h"
+#include "ScriptPy/ScriptPyMgr.h"
+#include <algorithm>
+#include <chrono>
+
+namespace tzw
+{
+void runNodeGraph(const rapidjson::Value & option)
+{
+	int count = std::max(getBenchInt(option, "count", 2000), 2);
+	int runs = std::max(getBenchInt(option, "runs", 100), 1);
+	auto editor = new GameNodeEditor();
+	GraphNode * firstNode = nullptr;
+	IfNode * lastIf = nullptr;
+	//every step is an if node and the variable on its condition, the then pin runs the next step
+	for(int i = 0; i < count / 2; i++)
+	{
+		auto ifNode = new IfNode();
+		auto varNode = new VarNode();
+		varNode->setInt(1);
+		editor->addNode(ifNode);
+		editor->addNode(varNode);
+		editor->makeLinkByNode(varNode, ifNode, 0, 1);
+		if(lastIf)
+		{
+			editor->makeLinkByNode(lastIf, ifNode, 1, 0);
+		}
+		else
+		{
+			firstNode = ifNode;
+		}
+		lastIf = ifNode;
+	}
+	//the then pin of the last step compares a variable with 1, the result is only written when the whole chain ran
+	auto equalNode = new EqualNode();
+	auto sourceNode = new VarNode();
+	sourceNode->setInt(1);
+	editor->addNode(equalNode);
+	editor->addNode(sourceNode);
+	editor->makeLinkByNode(lastIf, equalNode, 1, 0);
+	editor->makeLinkByNode(sourceNode, equalNode, 0, 1);
+	auto compileBegin = std::chrono::high_resolution_clock::now();
+	editor->compileGraph();
+	auto compileTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - compileBegin).count();
+	auto runBegin = std::chrono::high_resolution_clock::now();
+	for(int i = 0; i < runs; i++)
+	{
+		editor->pushToStack(firstNode);
+		editor->runExeChain();
+	}
+	auto runTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - runBegin).count();
+	tlog("node graph %d nodes: compile %.2f ms, %.4f ms per run", count, compileTime, runTime / runs);
+	auto & result = equalNode->getOutByIndex(1)->m_localAttrValue;
+	if(result.m_list.size() != 1 || result.getInt() != 1)
+	{
+		BenchmarkReplay::shared()->reportFailure("node graph: the end of the chain didn't run");
+	}
+	editor->clearAll();
+	delete editor;
+}
+
+void runScriptCalls(const rapidjson::Value & option)
+{
+	int count = std::max(option.GetInt(), 1);
+	ScriptPyFunction cachedFunc("math", "fabs");
+	cachedFunc.callVoid(-1.0f);
+	auto cachedBegin = std::chrono::high_resolution_clock::now();
+	for(int i = 0; i < count; i++)
+	{
+		cachedFunc.callVoid(-1.0f);
+	}
+	auto cachedTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - cachedBegin).count();
+	auto uncachedBegin = std::chrono::high_resolution_clock::now();
+	for(int i = 0; i < count; i++)
+	{
+		ScriptPyFunction func("math", "fabs");
+		func.callVoid(-1.0f);
+	}
+	auto uncachedTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - uncachedBegin).count();
+	tlog("script calls %d: cached %.0f calls/s, resolved per call %.0f calls/s", count, count / std::max(cachedTime, 1e-9), count / std::max(uncachedTime, 1e-9));
+}
+}
@@ -0,0 +1,408 @@
+#include "BenchCheck.h"
+#include "CubeGame/BenchmarkReplay.h"
+#include "CubeGame/Chunk.h"
+#include "CubeGame/GameMap.h"
+#include "Mesh/Mesh.h"
+#include "Utility/log/Log.h"
+#include "FastNoise/FastNoise.h"
+#include "CubeGame/GameWorld.h"
+#include "CubeGame/CubePlayer.h"
+#include "CubeGame/TerrainRegionStore.h"
+#include "Utility/misc/Tmisc.h"
+#include "3D/Terrain/Transvoxel.h"
+#include "Collision/TriangleBVH.h"
+#include "Math/Ray.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <thread>
+
+namespace tzw
+{
+void runChunkStress(const rapidjson::Value & option)
+{
+	int threadCount = std::max(getBenchInt(option, "threads", 8), 1);
+	int runs = std::max(getBenchInt(option, "runs", 4), 1);
+	auto chunkList = getBenchChunks(getBenchInt(option, "radius", 1));
+	//a mesh and a transition mesh per chunk and LOD
+	int meshCount = int(chunkList.size()) * 3;
+	std::vector<std::unique_ptr<Mesh>> referenceList;
+	std::vector<std::unique_ptr<Mesh>> meshList;
+	for(int i = 0; i < meshCount * 2; i++)
+	{
+		referenceList.emplace_back(new Mesh());
+		meshList.emplace_back(new Mesh());
+	}
+	auto buildOne = [&](std::vector<std::unique_ptr<Mesh>> & outList, int index, ChunkInfo * chunkInfo)
+	{
+		auto & chunk = chunkList[index / 3];
+		Chunk::buildMesh(chunk.x, chunk.y, chunk.z, chunk.m_basePoint, index % 3, outList[index * 2].get(), outList[index * 2 + 1].get(), chunkInfo);
+	};
+	auto singleBegin = std::chrono::high_resolution_clock::now();
+	auto chunkInfo = GameMap::shared()->acquireScratchChunkInfo();
+	for(int i = 0; i < meshCount; i++)
+	{
+		buildOne(referenceList, i, chunkInfo);
+	}
+	GameMap::shared()->releaseScratchChunkInfo(chunkInfo);
+	double singleTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - singleBegin).count();
+	size_t triangleCount = 0;
+	for(auto & mesh : referenceList)
+	{
+		triangleCount += mesh->m_indices.size() / 3;
+	}
+	tlog("chunk stress %zu chunks, %zu triangles: 1 thread %.3f ms", chunkList.size(), triangleCount, singleTime);
+	int mismatchCount = 0;
+	for(int r = 0; r < runs; r++)
+	{
+		//the threads pick the meshes in turn, so neighbours are built at the same time and share the map buffers
+		std::atomic<int> next(0);
+		std::vector<std::thread> threadList;
+		auto threadedBegin = std::chrono::high_resolution_clock::now();
+		for(int t = 0; t < threadCount; t++)
+		{
+			threadList.emplace_back([&]()
+			{
+				auto info = GameMap::shared()->acquireScratchChunkInfo();
+				for(int i = next++; i < meshCount; i = next++)
+				{
+					buildOne(meshList, i, info);
+				}
+				GameMap::shared()->releaseScratchChunkInfo(info);
+			});
+		}
+		for(auto & thread : threadList)
+		{
+			thread.join();
+		}
+		double threadedTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - threadedBegin).count();
+		int runMismatch = 0;
+		for(size_t i = 0; i < meshList.size(); i++)
+		{
+			if(!isBenchMeshEqual(referenceList[i].get(), meshList[i].get()))
+			{
+				runMismatch++;
+			}
+		}
+		mismatchCount += runMismatch;
+		tlog("chunk stress run %d: %d threads %.3f ms, %d meshes differ", r, threadCount, threadedTime, runMismatch);
+	}
+	if(mismatchCount)
+	{
+		BenchmarkReplay::shared()->reportFailure("chunk stress: %d meshes built on %d threads differ from the single thread ones", mismatchCount, threadCount);
+	}
+}
+
+void runNoiseColumns(const rapidjson::Value & option)
+{
+	int count = std::max(getBenchInt(option, "count", 65536), 1);
+	int runs = std::max(getBenchInt(option, "runs", 10), 1);
+	auto map = GameMap::shared();
+	vec3 mapOffset = map->getMapOffset();
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> rangeX(mapOffset.x, mapOffset.x + GAME_MAP_WIDTH * MAX_BLOCK * BLOCK_SIZE);
+	std::uniform_real_distribution<float> rangeZ(mapOffset.z, mapOffset.z + GAME_MAP_DEPTH * MAX_BLOCK * BLOCK_SIZE);
+	std::vector<float> posX(count), posZ(count), reference(count), height(count);
+	for(int i = 0; i < count; i++)
+	{
+		posX[i] = rangeX(random);
+		posZ[i] = rangeZ(random);
+	}
+	auto scalarBegin = std::chrono::high_resolution_clock::now();
+	for(int r = 0; r < runs; r++)
+	{
+		for(int i = 0; i < count; i++)
+		{
+			reference[i] = map->getHeight(vec2(posX[i], posZ[i]));
+		}
+	}
+	double scalarTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - scalarBegin).count();
+	tlog("noise columns %d: getHeight %.0f columns/s", count, double(count) * runs / scalarTime);
+	//SetSIMDLevel only caps the level, a level the cpu lacks is reported by GetSIMDLevel and skipped
+	static const char * levelName[] = {"scalar", "SSE2", "AVX2"};
+	auto bestLevel = FastNoise::GetSIMDLevel();
+	for(int level = FastNoise::SIMD_Scalar; level <= bestLevel; level++)
+	{
+		FastNoise::SetSIMDLevel(FastNoise::SIMDLevel(level));
+		if(FastNoise::GetSIMDLevel() != level) continue;
+		auto batchBegin = std::chrono::high_resolution_clock::now();
+		for(int r = 0; r < runs; r++)
+		{
+			map->getHeightBatch(posX.data(), posZ.data(), height.data(), count);
+		}
+		double batchTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - batchBegin).count();
+		float diff = 0.0f;
+		for(int i = 0; i < count; i++)
+		{
+			diff = std::max(diff, std::abs(height[i] - reference[i]));
+		}
+		tlog("noise columns %d: getHeightBatch %s %.0f columns/s, max height difference %g", count, levelName[level], double(count) * runs / batchTime, diff);
+		if(diff > 0.0f)
+		{
+			BenchmarkReplay::shared()->reportFailure("noise columns: getHeightBatch %s differs from getHeight by %g", levelName[level], diff);
+		}
+	}
+	FastNoise::SetSIMDLevel(bestLevel);
+}
+
+void runRegionRead(const rapidjson::Value & option)
+{
+	int radius = std::max(getBenchInt(option, "radius", 1), 0);
+	int runs = std::max(getBenchInt(option, "runs", 5), 1);
+	const size_t voxelCount = GAME_MAX_BUFFER_SIZE * GAME_MAX_BUFFER_SIZE * GAME_MAX_BUFFER_SIZE;
+	auto map = GameMap::shared();
+	auto voxelPos = map->worldPosToVoxelPos(GameWorld::shared()->getPlayer()->getPos());
+	int posX = int(floor(voxelPos.x / GAME_MAX_BUFFER_SIZE));
+	int posZ = int(floor(voxelPos.z / GAME_MAX_BUFFER_SIZE));
+	int countY = (GAME_MAP_HEIGHT * MAX_BLOCK) / GAME_MAX_BUFFER_SIZE + 1;
+	//copied voxel by voxel, so the map buffers aren't marked as edited
+	std::vector<TerrainRegionEntry> entryList;
+	std::vector<std::vector<voxelInfo>> sourceList;
+	for(int x = posX - radius; x <= posX + radius; x++)
+	{
+		for(int y = 0; y < countY; y++)
+		{
+			for(int z = posZ - radius; z <= posZ + radius; z++)
+			{
+				sourceList.emplace_back(voxelCount);
+				auto & source = sourceList.back();
+				for(int i = 0; i < GAME_MAX_BUFFER_SIZE; i++)
+				{
+					for(int j = 0; j < GAME_MAX_BUFFER_SIZE; j++)
+					{
+						for(int k = 0; k < GAME_MAX_BUFFER_SIZE; k++)
+						{
+							source[(i * GAME_MAX_BUFFER_SIZE + j) * GAME_MAX_BUFFER_SIZE + k] =
+								map->getDensityI(x * GAME_MAX_BUFFER_SIZE + i, y * GAME_MAX_BUFFER_SIZE + j, z * GAME_MAX_BUFFER_SIZE + k);
+						}
+					}
+				}
+				entryList.push_back(TerrainRegionEntry{x, y, z, nullptr});
+			}
+		}
+	}
+	for(size_t i = 0; i < entryList.size(); i++)
+	{
+		entryList[i].m_buff = sourceList[i].data();
+	}
+	auto deflatePath = (std::filesystem::temp_directory_path() / "tzw_region_deflate").string();
+	auto rawPath = (std::filesystem::temp_directory_path() / "tzw_region_raw").string();
+	{
+		TerrainRegionStore deflateStore(deflatePath);
+		deflateStore.clear();
+		deflateStore.save(entryList);
+		TerrainRegionStore rawStore(rawPath);
+		rawStore.clear();
+		rawStore.setIsMapped(true);
+		rawStore.save(entryList);
+	}
+	//the files were just written, so every way reads from a warm file cache
+	int mismatchCount = 0;
+	std::vector<voxelInfo> buffer(voxelCount);
+	auto readAll = [&](const std::string & folder, bool isMap, double & time, size_t & faults)
+	{
+		time = 0.0;
+		faults = 0;
+		for(int r = 0; r < runs; r++)
+		{
+			TerrainRegionStore store(folder);
+			size_t faultBegin = Tmisc::getPageFaultCount();
+			auto begin = std::chrono::high_resolution_clock::now();
+			volatile unsigned int pageSum = 0;
+			for(size_t i = 0; i < entryList.size(); i++)
+			{
+				auto & entry = entryList[i];
+				const voxelInfo * data = buffer.data();
+				if(isMap)
+				{
+					data = store.map(entry.x, entry.y, entry.z);
+					if(!data)
+					{
+						mismatchCount++;
+						continue;
+					}
+					//the mapping is lazy, read a byte of every page like the mesher would
+					auto bytes = reinterpret_cast<const unsigned char *>(data);
+					for(size_t offset = 0; offset < voxelCount * sizeof(voxelInfo); offset += 4096)
+					{
+						pageSum += bytes[offset];
+					}
+				}
+				else if(!store.load(entry.x, entry.y, entry.z, buffer.data()))
+				{
+					mismatchCount++;
+					continue;
+				}
+				if(r == 0 && memcmp(data, sourceList[i].data(), voxelCount * sizeof(voxelInfo)))
+				{
+					mismatchCount++;
+				}
+			}
+			time += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count();
+			faults += Tmisc::getPageFaultCount() - faultBegin;
+		}
+		time /= runs;
+		faults /= runs;
+	};
+	double deflateTime, rawTime, mapTime;
+	size_t deflateFaults, rawFaults, mapFaults;
+	readAll(deflatePath, false, deflateTime, deflateFaults);
+	readAll(rawPath, false, rawTime, rawFaults);
+	readAll(rawPath, true, mapTime, mapFaults);
+	tlog("region read %zu buffers: deflate load %.3f ms %zu faults, raw load %.3f ms %zu faults, map %.3f ms %zu faults",
+		entryList.size(), deflateTime, deflateFaults, rawTime, rawFaults, mapTime, mapFaults);
+	if(mismatchCount)
+	{
+		BenchmarkReplay::shared()->reportFailure("region read: %d buffers are missing or differ from the map", mismatchCount);
+	}
+	std::error_code err;
+	std::filesystem::remove_all(deflatePath, err);
+	std::filesystem::remove_all(rawPath, err);
+}
+
+void runTransVoxel(const rapidjson::Value & option)
+{
+	int runs = std::max(getBenchInt(option, "runs", 3), 1);
+	auto chunkList = getBenchChunks(getBenchInt(option, "radius", 4));
+	auto transVoxel = TransVoxel::shared();
+	auto chunkInfo = GameMap::shared()->acquireScratchChunkInfo();
+	Mesh simdMesh, simdTransition, scalarMesh, scalarTransition;
+	double simdTime = 0.0, scalarTime = 0.0;
+	size_t meshCount = 0, triangleCount = 0;
+	int mismatchCount = 0;
+	for(auto & chunk : chunkList)
+	{
+		for(int lod = 0; lod < 3; lod++)
+		{
+			//only the meshing is timed, the samples are fetched once for both paths
+			GameMap::shared()->fetchFromSource(chunk.x, chunk.y, chunk.z, lod, chunkInfo);
+			int voxelSize = (MAX_BLOCK >> lod) + MIN_PADDING + MAX_PADDING;
+			auto generate = [&](bool isSimd, Mesh * mesh, Mesh * transition)
+			{
+				transVoxel->setIsSimdEnabled(isSimd);
+				auto begin = std::chrono::high_resolution_clock::now();
+				for(int r = 0; r < runs; r++)
+				{
+					mesh->clear();
+					transition->clear();
+					transVoxel->generateWithoutNormal(chunk.m_basePoint, mesh, transition, voxelSize, chunkInfo->mcPoints[lod], 0.0f, lod);
+				}
+				return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin).count();
+			};
+			simdTime += generate(true, &simdMesh, &simdTransition);
+			scalarTime += generate(false, &scalarMesh, &scalarTransition);
+			meshCount += runs;
+			triangleCount += (simdMesh.m_indices.size() + simdTransition.m_indices.size()) / 3 * runs;
+			if(!isBenchMeshEqual(&simdMesh, &scalarMesh) || !isBenchMeshEqual(&simdTransition, &scalarTransition))
+			{
+				mismatchCount++;
+			}
+		}
+	}
+	transVoxel->setIsSimdEnabled(true);
+	GameMap::shared()->releaseScratchChunkInfo(chunkInfo);
+	tlog("transvoxel %zu chunks x 3 LODs: SIMD %.0f chunks/s %.0f triangles/s, scalar %.0f chunks/s %.0f triangles/s, %d meshes differ",
+		chunkList.size(), meshCount / simdTime, triangleCount / simdTime, meshCount / scalarTime, triangleCount / scalarTime, mismatchCount);
+	if(mismatchCount)
+	{
+		BenchmarkReplay::shared()->reportFailure("transvoxel: %d meshes of the SIMD path differ from the scalar path", mismatchCount);
+	}
+}
+
+void runTriangleBVH(const rapidjson::Value & option)
+{
+	int rayCount = std::max(getBenchInt(option, "rays", 200), 1);
+	auto chunkList = getBenchChunks(getBenchInt(option, "radius", 1));
+	auto chunkInfo = GameMap::shared()->acquireScratchChunkInfo();
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> unitRange(0.0f, 1.0f);
+	Mesh mesh, transition;
+	TriangleBVH bvh;
+	std::vector<Ray> rayList;
+	double buildTime = 0.0, bvhTime = 0.0, bruteTime = 0.0;
+	size_t meshCount = 0, triangleCount = 0, queryCount = 0, hitCount = 0;
+	int mismatchCount = 0;
+	for(auto & chunk : chunkList)
+	{
+		Chunk::buildMesh(chunk.x, chunk.y, chunk.z, chunk.m_basePoint, 0, &mesh, &transition, chunkInfo);
+		size_t indexCount = mesh.getIndicesSize();
+		if(!indexCount) continue;
+		auto buildBegin = std::chrono::high_resolution_clock::now();
+		bvh.build(&mesh);
+		buildTime += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - buildBegin).count();
+		meshCount++;
+		triangleCount += indexCount / 3;
+		//from anywhere around the mesh towards a point inside its bounds, so most of the rays cross the surface
+		AABB aabb;
+		for(size_t i = 0; i < indexCount; i++)
+		{
+			aabb.update(mesh.getVertexPos(mesh.getIndex(i)));
+		}
+		vec3 size = aabb.max() - aabb.min();
+		auto randomIn = [&](vec3 minP, vec3 range)
+		{
+			return minP + vec3(range.x * unitRange(random), range.y * unitRange(random), range.z * unitRange(random));
+		};
+		rayList.clear();
+		for(int i = 0; i < rayCount; i++)
+		{
+			vec3 origin = randomIn(aabb.min() - size, size * 3.0f);
+			vec3 target = randomIn(aabb.min(), size);
+			rayList.emplace_back(origin, (target - origin).normalized());
+		}
+		std::vector<float> bvhT(rayCount, -1.0f);
+		auto bvhBegin = std::chrono::high_resolution_clock::now();
+		for(int i = 0; i < rayCount; i++)
+		{
+			float t;
+			if(bvh.rayCastFirst(rayList[i], t))
+			{
+				bvhT[i] = t;
+			}
+		}
+		bvhTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - bvhBegin).count();
+		//the same winding as TriangleBVH::build
+		auto bruteBegin = std::chrono::high_resolution_clock::now();
+		for(int i = 0; i < rayCount; i++)
+		{
+			float closest = -1.0f;
+			for(size_t j = 0; j < indexCount; j += 3)
+			{
+				float t;
+				if(rayList[i].intersectTriangle(mesh.getVertexPos(mesh.getIndex(j + 2)), mesh.getVertexPos(mesh.getIndex(j + 1)), mesh.getVertexPos(mesh.getIndex(j)), &t)
+					&& (closest < 0.0f || t < closest))
+				{
+					closest = t;
+				}
+			}
+			if(closest != bvhT[i])
+			{
+				mismatchCount++;
+			}
+			if(closest >= 0.0f)
+			{
+				hitCount++;
+			}
+		}
+		bruteTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - bruteBegin).count();
+		queryCount += rayCount;
+	}
+	GameMap::shared()->releaseScratchChunkInfo(chunkInfo);
+	if(!meshCount)
+	{
+		tlog("triangle bvh: no chunk with a surface around the player");
+		return;
+	}
+	tlog("triangle bvh %zu meshes, %zu triangles: build %.3f ms per mesh, %zu rays %zu hits, BVH %.0f rays/s, brute force %.0f rays/s, %d hits differ",
+		meshCount, triangleCount, buildTime / meshCount, queryCount, hitCount, queryCount / bvhTime, queryCount / bruteTime, mismatchCount);
+	if(mismatchCount)
+	{
+		BenchmarkReplay::shared()->reportFailure("triangle bvh: %d closest hits differ from the brute force loop", mismatchCount);
+	}
+}
+}
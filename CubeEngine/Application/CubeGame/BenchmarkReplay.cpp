@@ -0,0 +1,228 @@
+#include "BenchmarkReplay.h"
+#include "Benchmark/BenchCheck.h"
+#include "GameWorld.h"
+#include "BuildingSystem.h"
+#include "CubePlayer.h"
+#include "Engine/Engine.h"
+#include "Engine/FrameProfiler.h"
+#include "Engine/WorkerThreadSystem.h"
+#include "Utility/file/Tfile.h"
+#include "Utility/log/Log.h"
+#include <rapidjson/document.h>
+#include <cstdarg>
+#include <cstdio>
+
+namespace tzw
+{
+BenchmarkReplay::BenchmarkReplay():
+	m_warmupFrames(120),
+	m_frames(1000),
+	m_delta(1.0f / 60.0f),
+	m_outputPath("bench.csv"),
+	m_state(State::Idle),
+	m_frameIndex(0),
+	m_idleFrames(0),
+	m_failCount(0)
+{
+}
+
+bool BenchmarkReplay::loadScript(std::string filePath)
+{
+	auto data = Tfile::shared()->getData(filePath, true);
+	auto & doc = m_script;
+	doc.Parse<rapidjson::kParseDefaultFlags>(data.getString().c_str());
+	if (doc.HasParseError() || !doc.IsObject())
+	{
+		tlogError("bad benchmark script %s", filePath.c_str());
+		return false;
+	}
+	if(doc.HasMember("world"))
+	{
+		m_worldName = doc["world"].GetString();
+	}
+	if(doc.HasMember("vehicles"))
+	{
+		auto & vehicles = doc["vehicles"];
+		for(unsigned int i = 0; i < vehicles.Size(); i++)
+		{
+			m_vehicleList.emplace_back(vehicles[i].GetString());
+		}
+	}
+	if(doc.HasMember("warmup_frames"))
+	{
+		m_warmupFrames = doc["warmup_frames"].GetInt();
+	}
+	if(doc.HasMember("frames"))
+	{
+		m_frames = doc["frames"].GetInt();
+	}
+	if(doc.HasMember("delta"))
+	{
+		m_delta = doc["delta"].GetDouble();
+	}
+	if(doc.HasMember("output"))
+	{
+		m_outputPath = doc["output"].GetString();
+	}
+	if(doc.HasMember("path"))
+	{
+		auto & path = doc["path"];
+		for(unsigned int i = 0; i < path.Size(); i++)
+		{
+			auto & key = path[i];
+			PathKey pathKey;
+			pathKey.m_time = key["time"].GetDouble();
+			auto & pos = key["pos"];
+			pathKey.m_pos = vec3(pos[0].GetDouble(), pos[1].GetDouble(), pos[2].GetDouble());
+			auto & target = key["target"];
+			pathKey.m_target = vec3(target[0].GetDouble(), target[1].GetDouble(), target[2].GetDouble());
+			m_path.push_back(pathKey);
+		}
+	}
+	return true;
+}
+
+void BenchmarkReplay::start()
+{
+	GameWorld::shared()->loadGame(m_worldName);
+	m_state = State::Loading;
+	m_frameIndex = 0;
+}
+
+void BenchmarkReplay::update(float delta)
+{
+	switch(m_state)
+	{
+	case State::Loading:
+	{
+		//the map is built by the jobs queued in loadGame, wait for all of them
+		if(GameWorld::shared()->getCurrentState() != GAME_STATE_RUNNING) return;
+		for(auto & vehicle : m_vehicleList)
+		{
+			BuildingSystem::shared()->loadVehicle(vehicle);
+		}
+		BenchCheckTable::shared()->run(m_script);
+		auto player = GameWorld::shared()->getPlayer();
+		player->camera()->setIsEnableGravity(false);
+		player->camera()->pausePhysics();
+		m_state = State::Settling;
+		m_idleFrames = 0;
+		applyPath(0.0f);
+	}
+	break;
+	case State::Settling:
+	{
+		//GAME_STATE_RUNNING is set while the chunk jobs of loadGame still run, and moving to the start of
+		//the path queues more, the timings only mean something once all of them are done
+		applyPath(0.0f);
+		if(WorkerThreadSystem::shared()->isIdle() && !GameWorld::shared()->isAnyChunkBusy())
+		{
+			m_idleFrames++;
+		}
+		else
+		{
+			m_idleFrames = 0;
+		}
+		//the chunk loads of a move are queued by the world update, give it a frame to do so
+		if(m_idleFrames >= 2)
+		{
+			m_state = State::WarmUp;
+			m_frameIndex = 0;
+		}
+	}
+	break;
+	case State::WarmUp:
+	{
+		applyPath(0.0f);
+		m_frameIndex++;
+		if(m_frameIndex >= m_warmupFrames)
+		{
+			m_frameIndex = 0;
+			FrameProfiler::shared()->clear();
+			FrameProfiler::shared()->setIsEnable(true);
+			m_state = State::Recording;
+		}
+	}
+	break;
+	case State::Recording:
+	{
+		applyPath(m_frameIndex * m_delta);
+		m_frameIndex++;
+		if(FrameProfiler::shared()->getFrameCount() >= size_t(m_frames))
+		{
+			finish();
+		}
+	}
+	break;
+	default:
+		break;
+	}
+}
+
+float BenchmarkReplay::getDelta() const
+{
+	return m_delta;
+}
+
+void BenchmarkReplay::reportFailure(const char * pattern, ...)
+{
+	char message[1024];
+	va_list args;
+	va_start(args, pattern);
+	vsnprintf(message, sizeof(message), pattern, args);
+	va_end(args);
+	tlogError("%s", message);
+	m_failCount++;
+}
+
+int BenchmarkReplay::getFailCount() const
+{
+	return m_failCount;
+}
+
+void BenchmarkReplay::applyPath(float time)
+{
+	if(m_path.empty()) return;
+	auto player = GameWorld::shared()->getPlayer();
+	PathKey key = m_path.back();
+	if(time <= m_path.front().m_time)
+	{
+		key = m_path.front();
+	}
+	else
+	{
+		for(size_t i = 1; i < m_path.size(); i++)
+		{
+			if(time < m_path[i].m_time)
+			{
+				auto & prev = m_path[i - 1];
+				auto & next = m_path[i];
+				float t = (time - prev.m_time) / (next.m_time - prev.m_time);
+				key.m_pos = prev.m_pos + (next.m_pos - prev.m_pos) * t;
+				key.m_target = prev.m_target + (next.m_target - prev.m_target) * t;
+				break;
+			}
+		}
+	}
+	player->setPos(key.m_pos);
+	player->camera()->lookAt(key.m_target);
+}
+
+void BenchmarkReplay::finish()
+{
+	auto profiler = FrameProfiler::shared();
+	profiler->setIsEnable(false);
+	tlog("benchmark finished\n%s", profiler->getReport().c_str());
+	if(!profiler->saveCSV(m_outputPath))
+	{
+		reportFailure("can not write %s", m_outputPath.c_str());
+	}
+	m_state = State::Finished;
+	if(m_failCount)
+	{
+		tlogError("benchmark failed, %d results differ from their reference", m_failCount);
+		EngineDef::headlessExitCode = EXIT_FAILURE;
+	}
+	Engine::shared()->requestClose();
+}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "Engine/EngineDef.h"
+#include "Math/vec3.h"
+#include <rapidjson/document.h>
+#include <string>
+#include <vector>
+namespace tzw
+{
+// Replays a recorded camera path through a saved world with the null render device and writes the per-stage frame times.
+// the warm up starts once the job pool is idle and no chunk is loading or waiting for a remesh at the start of the path.
+// the run exits with EXIT_FAILURE if the script can't be read or a check reports a failure.
+// every other member of the script names a check of BenchCheckTable, run before the warm up with the options listed
+// in its table.
+// script:
+// { "world": "MyWorld", "vehicles": ["Data/PlayerData/Vehicles/a.json"], "warmup_frames": 120, "frames": 1000,
+//   "delta": 0.016666, "output": "bench.csv", "path": [{"time": 0, "pos": [x, y, z], "target": [x, y, z]}, ...],
+//   "chunk_stress": {"radius": 1}, "math_kernels": {"count": 100000} }
+class BenchmarkReplay : public Singleton<BenchmarkReplay>
+{
+public:
+	BenchmarkReplay();
+	bool loadScript(std::string filePath);
+	void start();
+	//called by the app entry every frame
+	void update(float delta);
+	float getDelta() const;
+	//a check found a result which differs from its reference, it is logged as an error and the run exits with EXIT_FAILURE
+	void reportFailure(const char * pattern, ...);
+	int getFailCount() const;
+private:
+	struct PathKey
+	{
+		float m_time;
+		vec3 m_pos;
+		vec3 m_target;
+	};
+	enum class State
+	{
+		Idle,
+		Loading,
+		//the chunk jobs of the start position are still running
+		Settling,
+		WarmUp,
+		Recording,
+		Finished,
+	};
+	void applyPath(float time);
+	void finish();
+	rapidjson::Document m_script;
+	std::string m_worldName;
+	std::vector<std::string> m_vehicleList;
+	std::vector<PathKey> m_path;
+	int m_warmupFrames;
+	int m_frames;
+	float m_delta;
+	std::string m_outputPath;
+	State m_state;
+	int m_frameIndex;
+	int m_idleFrames;
+	int m_failCount;
+};
+}
@@ -924,6 +924,18 @@ namespace tzw
 
 	void BuildingSystem::update(float dt)
 	{
+		if(!m_physicsDirtyIslandSet.empty())
+		{
+			std::set<Island *> dirtyIslandSet;
+			dirtyIslandSet.swap(m_physicsDirtyIslandSet);
+			for(auto island : dirtyIslandSet)
+			{
+				if(island->isPhysicsDirty())
+				{
+					island->updatePhysics();
+				}
+			}
+		}
 		updateBearing(dt);
 
 		//update thrusters
@@ -933,6 +945,16 @@ namespace tzw
 		}
 	}
 
+	void BuildingSystem::addPhysicsDirtyIsland(Island* island)
+	{
+		m_physicsDirtyIslandSet.insert(island);
+	}
+
+	void BuildingSystem::removePhysicsDirtyIsland(Island* island)
+	{
+		m_physicsDirtyIslandSet.erase(island);
+	}
+
 	std::set<Vehicle*>& BuildingSystem::getVehicleList()
 	{
 		return m_vehicleList;
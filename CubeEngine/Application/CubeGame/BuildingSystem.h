@@ -69,6 +69,9 @@ public:
 	void removeIsland(Island * island);
 	void update(float dt);
 	std::set<Vehicle * >& getVehicleList();
+	//the rigid bodies of these islands are refreshed once in the next update, so placing many parts in one frame costs one refresh
+	void addPhysicsDirtyIsland(Island * island);
+	void removePhysicsDirtyIsland(Island * island);
 private:
 	bool m_isInXRayMode;
 public:
@@ -88,6 +91,7 @@ private:
 	GamePart * m_currPointPart;
 	std::set<Vehicle * > m_vehicleList;
 	Vehicle * m_staticVehicle;
+	std::set<Island * > m_physicsDirtyIslandSet;
 };
 
 
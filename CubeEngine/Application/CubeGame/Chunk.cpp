@@ -16,6 +16,7 @@
 static int g_chunkSize = BLOCK_SIZE * MAX_BLOCK;
 #include "../EngineSrc/3D/Terrain/MCTable.h"
 #include "../EngineSrc/Collision/CollisionUtility.h"
+#include "EngineSrc/Collision/TriangleBVH.h"
 
 #include "EngineSrc/Collision/PhysicsMgr.h"
 #include <random>
@@ -28,7 +29,16 @@ namespace tzw
 	module::Perlin flatNoise;
 	/// <summary>	The grass noise. </summary>
 	module::Perlin grassNoise;
-	FastNoise treeNoise;
+	static FastNoise createTreeNoise()
+	{
+		FastNoise noise;
+		noise.SetSeed(233);
+		noise.SetFrequency(0.02);
+		noise.SetNoiseType(FastNoise::Perlin);
+		return noise;
+	}
+	//configured once, the vegetation jobs run on several workers and only read the noise modules
+	static const FastNoise treeNoise = createTreeNoise();
 	/// <summary>	The LOD list[]. </summary>
 	static int lodList[] = {1, 2, 4, 8};
 	Chunk::Chunk(int the_x, int the_y, int the_z)
@@ -38,8 +48,12 @@ namespace tzw
 		, m_currenState(State::INVALID)
 		, m_rigidBody(nullptr),
 		m_isTreeloaded(false)
+		, m_isDirty(false)
+		, m_staleLodMask(0)
+		, m_bvh(nullptr)
 	{
 		m_lod = 0;
+		m_currentLOD = 0;
 		m_localAABB.update(vec3(0, 0, 0));
 
 		m_localAABB.update(vec3(MAX_BLOCK * BLOCK_SIZE,
@@ -54,14 +68,12 @@ namespace tzw
 		memset(m_mesh, 0,sizeof(m_mesh));
 		memset(m_meshTransition, 0,sizeof(m_meshTransition));
 
-		m_needToUpdate = true;
+		setNeedToUpdate(true);
 
-		m_isNeedSubmitMesh = false;
+		m_isUnloadPending = false;
 
 		reCacheAABB();
 
-		m_tmpNeighborChunk.clear();
-
 		m_grass = new TreeGroup(GameMap::shared()->getGrassId());
 
 		m_grass2 = new TreeGroup(GameMap::shared()->getGrassId());
@@ -70,10 +82,29 @@ namespace tzw
 
 		m_isHitable = true;
 
-		grassNoise.SetSeed(time(nullptr));
 		m_chunkInfo = GameMap::shared()->getChunkInfo(m_x, m_y, m_z);
 	}
 
+	Chunk::~Chunk()
+	{
+		dropRemesh();
+		for(int i = 0 ; i< 3; i++)
+		{
+			delete m_mesh[i];
+			delete m_meshTransition[i];
+		}
+		delete m_bvh;
+		if (m_rigidBody)
+		{
+			PhysicsMgr::shared()->removeRigidBody(m_rigidBody);
+			delete m_rigidBody;
+		}
+		delete m_grass;
+		delete m_grass2;
+		delete m_tree;
+		delete m_chunkInfo;
+	}
+
 	vec3
 	Chunk::getGridPos(int the_x, int the_y, int the_z)
 	{
@@ -86,18 +117,7 @@ namespace tzw
 	{
 		if (m_currenState != State::LOADED)
 			return false;
-		auto size = m_mesh[0]->getIndicesSize();
-		for (size_t i = 0; i < size; i += 3)
-		{
-			for (int k = 0; k < 3; k++)
-			{
-				if (other.isInside(m_mesh[0]->m_vertices[i + k].m_pos))
-				{
-					return true;
-				}
-			}
-		}
-		return false;
+		return m_bvh->isAnyVertexInside(other);
 	}
 
 	Drawable3D*
@@ -115,20 +135,8 @@ namespace tzw
 	{
 		if (m_currenState != State::LOADED)
 			return false;
-		auto size = m_mesh[0]->getIndicesSize();
 		std::vector<vec3> resultList;
-		float t = 0;
-		for (size_t i = 0; i < size; i += 3)
-		{
-			vec3 tmpHitPoint;
-			if (sphere.intersectWithTriangle(m_mesh[0]->m_vertices[i + 2].m_pos,
-											m_mesh[0]->m_vertices[i + 1].m_pos,
-											m_mesh[0]->m_vertices[i].m_pos,
-											tmpHitPoint))
-			{
-				resultList.push_back(tmpHitPoint);
-			}
-		}
+		m_bvh->sphereQuery(sphere, resultList);
 		if (!resultList.empty())
 		{
 			std::sort(resultList.begin(),
@@ -146,30 +154,34 @@ namespace tzw
 	}
 
 	void
-	Chunk::logicUpdate(float delta)
+	Chunk::onLoadFinished()
 	{
-		if (m_isNeedSubmitMesh)
+		// every load job which is not canceled ends here, empty chunks included, so LOADING always means in flight
+		for(int i = 0; i < 3;i++)
+		{
+			m_mesh[i]->finish();
+			m_meshTransition[i]->finish();
+		}
+		
+		if (m_rigidBody)
+		{
+			PhysicsMgr::shared()->removeRigidBody(m_rigidBody);
+			delete m_rigidBody;
+			m_rigidBody = nullptr;
+		}
+		if (!m_mesh[0]->isEmpty())
 		{
-			m_isNeedSubmitMesh = false;
-			for(int i = 0; i < 3;i++)
-			{
-				m_mesh[i]->finish();
-				m_meshTransition[i]->finish();
-			}
-			
-			if (m_rigidBody)
-			{
-				PhysicsMgr::shared()->removeRigidBody(m_rigidBody);
-				delete m_rigidBody;
-				m_rigidBody = nullptr;
-			}
 			m_rigidBody = PhysicsMgr::shared()->createRigidBodyMesh(m_mesh[0], nullptr);
-
 			m_rigidBody->setFriction(10.0);
 			PhysicsMgr::shared()->addRigidBody(m_rigidBody);
-			loading_mutex.lock();
-			m_currenState = State::LOADED;
-			loading_mutex.unlock();
+		}
+		loading_mutex.lock();
+		m_currenState = State::LOADED;
+		loading_mutex.unlock();
+		if (m_isUnloadPending)
+		{
+			m_isUnloadPending = false;
+			unload();
 		}
 	}
 
@@ -189,8 +201,6 @@ namespace tzw
 			return;
 		if (m_mesh[0]->getIndicesSize() == 0)
 			return;
-		if (m_isNeedSubmitMesh)
-			return;
 		if (m_mesh[0]->getIndexBuf()->bufferId() == 0)
 			return;
 		if (requirementType != RenderFlag::RenderStageType::COMMON)
@@ -214,6 +224,11 @@ namespace tzw
 		{
 			m_currentLOD = 2;
 		}
+		// keep drawing the old coarse mesh until the new one is ready
+		if ((m_staleLodMask & (1u << m_currentLOD)) && !m_remeshTicket)
+		{
+			requestRemesh(1u << m_currentLOD);
+		}
 		auto xList = {-1, 0, 1};
 		auto yList = {-1, 0, 1};
 		auto zList = {-1, 0, 1};
@@ -225,8 +240,7 @@ namespace tzw
 				for (int offsetZ : zList)
 				{
 					if(offsetX == 0 && offsetY ==0 && offsetZ == 0) continue;// skip self chunk
-					auto neighborChunk = GameWorld::shared()->getChunk(
-						this->m_x + offsetX, this->m_y + offsetY, this->m_z + offsetZ);
+					auto neighborChunk = GameWorld::shared()->getNeighborChunk(this, offsetX, offsetY, offsetZ);
 					if (neighborChunk)
 					{
 						if(neighborChunk->m_currentLOD != m_currentLOD)
@@ -259,8 +273,14 @@ namespace tzw
 	}
 
 	void
-	Chunk::load(int lodLevel)
+	Chunk::load(int lodLevel, float priority)
 	{
+		// wanted again before the running job is done
+		if (m_currenState == State::LOADING)
+		{
+			m_isUnloadPending = false;
+			return;
+		}
 		if (m_currenState != State::INVALID)
 			return;
 		reCache();
@@ -272,36 +292,51 @@ namespace tzw
 				m_mesh[i] = new Mesh();
 				m_meshTransition[i] = new Mesh();
 			}
+			m_bvh = new TriangleBVH();
 			m_material = MaterialPool::shared()->getMatFromTemplate("VoxelTerrain");
 		}
 		loading_mutex.lock();
 		m_currenState = State::LOADING;
 		loading_mutex.unlock();
 		setCamera(g_GetCurrScene()->defaultCamera());
-		if (!m_chunkInfo->isLoaded)
+		WorkerThreadSystem::shared()->pushOrder(WorkerJob([this, lodLevel]()
 		{
-			WorkerThreadSystem::shared()->pushOrder(WorkerJob([&]()
-			{
-				initData();
-				genMesh(lodLevel);
-				generateVegetation();
-			}));
-		}
-		else
+			initData();
+			genMesh(lodLevel);
+			generateVegetation();
+		}, [this]()
 		{
-			WorkerThreadSystem::shared()->pushOrder(WorkerJob([&]() { genMesh(lodLevel); generateVegetation(); }));
-		}
+			onLoadFinished();
+		}, priority, this));
 	}
 
 	void
 	Chunk::unload()
 	{
+		if (m_currenState == State::LOADING)
+		{
+			// the job is still in queue or only its callback is left, just drop it.
+			if (WorkerThreadSystem::shared()->cancelOrder(this))
+			{
+				loading_mutex.lock();
+				m_currenState = State::INVALID;
+				loading_mutex.unlock();
+			}
+			else
+			{
+				m_isUnloadPending = true;
+			}
+			return;
+		}
 		if (m_currenState != State::LOADED)
 		{
 			return;
 		}
 		m_currenState = State::INVALID;
-		m_isNeedSubmitMesh = false;
+		m_isUnloadPending = false;
+		m_isDirty = false;
+		m_staleLodMask = 0;
+		dropRemesh();
 
 		for(int i = 0 ; i< 3; i++)
 		{
@@ -311,13 +346,14 @@ namespace tzw
 			delete m_meshTransition[i];
 			m_meshTransition[i] = nullptr;
 		}
+		delete m_bvh;
+		m_bvh = nullptr;
 
 	}
 
 	void
 	Chunk::deformSphere(vec3 pos, float value, float range)
 	{
-		m_tmpNeighborChunk.clear();
 		vec3 relativePost = pos - m_basePoint;
 		relativePost = relativePost / BLOCK_SIZE;
 		int posX = relativePost.x;
@@ -345,23 +381,11 @@ namespace tzw
 				}
 			}
 		}
-		genMesh(m_currentLOD);
-
-
-		if (!m_tmpNeighborChunk.empty())
-		{
-			for (auto chunk : m_tmpNeighborChunk)
-			{
-				chunk->genMesh(chunk->m_currentLOD);
-			}
-		}
-		m_tmpNeighborChunk.clear();
 	}
 
 	void
 	Chunk::deformCube(vec3 pos, float value, float range /*= 1.0f*/)
 	{
-		m_tmpNeighborChunk.clear();
 		vec3 relativePost = pos - m_basePoint;
 		relativePost = relativePost / BLOCK_SIZE;
 		int posX = relativePost.x;
@@ -381,20 +405,10 @@ namespace tzw
 				}
 			}
 		}
-		genMesh(m_currentLOD);
-		if (!m_tmpNeighborChunk.empty())
-		{
-			for (auto chunk : m_tmpNeighborChunk)
-			{
-				chunk->genMesh(chunk->m_currentLOD);
-			}
-		}
-		m_tmpNeighborChunk.clear();
 	}
 
 	void Chunk::paintSphere(vec3 pos, int matIndex, float range)
 	{
-		m_tmpNeighborChunk.clear();
 		vec3 relativePost = pos - m_basePoint;
 		relativePost = relativePost / BLOCK_SIZE;
 		int posX = relativePost.x;
@@ -421,16 +435,6 @@ namespace tzw
 				}
 			}
 		}
-		genMesh(m_currentLOD);
-
-		if (!m_tmpNeighborChunk.empty())
-		{
-			for (auto chunk : m_tmpNeighborChunk)
-			{
-				chunk->genMesh(m_currentLOD);
-			}
-		}
-		m_tmpNeighborChunk.clear();
 	}
 /*
 ߽£BPadding1 2 Aʵ,
@@ -479,8 +483,7 @@ BAAAABB
 			{
 				for (int offsetZ : zList)
 				{
-					auto neighborChunk = GameWorld::shared()->getChunk(
-						this->m_x + offsetX, this->m_y + offsetY, this->m_z + offsetZ);
+					auto neighborChunk = GameWorld::shared()->getNeighborChunk(this, offsetX, offsetY, offsetZ);
 					if (neighborChunk)
 					{
 						int nx = X;
@@ -502,16 +505,8 @@ BAAAABB
 							nz += (MAX_BLOCK);
 						else if (offsetZ == 1)
 							nz -= (MAX_BLOCK);
+						// the neighbor marks itself dirty
 						neighborTrigger(neighborChunk,nx, ny, nz);
-						//neighborChunk->setVoxelScalar(nx, ny, nz, value);
-						auto result = std::find(m_tmpNeighborChunk.begin(),
-												m_tmpNeighborChunk.end(),
-												neighborChunk);
-						if (result == m_tmpNeighborChunk.end() && neighborChunk != this &&
-							neighborChunk != nullptr)
-						{
-							m_tmpNeighborChunk.push_back(neighborChunk);
-						}
 					}
 				}
 			}
@@ -544,18 +539,7 @@ BAAAABB
 			GameMap::shared()->setVoxel(m_x * MAX_BLOCK + (i - offset) + LOD_SHIFT, m_y * MAX_BLOCK + (j - offset) + LOD_SHIFT, m_z * MAX_BLOCK + (k - offset) + LOD_SHIFT, std::clamp(scalarInShort, short(0), short(255)));
 		}
 		m_chunkInfo->isEdit = true;
-	}
-
-	void
-	Chunk::addVoexlScalar(int x, int y, int z, float scalar)
-	{
-		//	std::cout<<"chunk ("<<this->x<<this->y << this->z<<")"<< " set!!!!!("<<x
-		//<<" , "<< y <<" , "<< z <<") as"<< scalar << std::endl;
-		int YtimeZ = (MAX_BLOCK + 1) * (MAX_BLOCK + 1);
-		int ind = x * YtimeZ + y * (MAX_BLOCK + 1) + z;
-		m_chunkInfo->mcPoints[0][ind].w += scalar;
-		if (m_chunkInfo->mcPoints[0][ind].w > 1.0)
-			m_chunkInfo->mcPoints[0][ind].w = 1.0;
+		markDirty(m_x * MAX_BLOCK + (i - offset) + LOD_SHIFT, m_y * MAX_BLOCK + (j - offset) + LOD_SHIFT, m_z * MAX_BLOCK + (k - offset) + LOD_SHIFT);
 	}
 
 	void Chunk::setVoxelMat(int i, int j, int k, int matIndex, bool isAdd)
@@ -569,246 +553,7 @@ BAAAABB
 		auto v = GameMap::shared()->getVoxel(m_x * MAX_BLOCK + (i - offset) + LOD_SHIFT, m_y * MAX_BLOCK + (j - offset) + LOD_SHIFT, m_z * MAX_BLOCK + (k - offset) + LOD_SHIFT);
 		v->setMat(matIndex, 0, 0, vec3(1, 0, 0));
 		m_chunkInfo->isEdit = true;
-	}
-
-	voxelInfo Chunk::getVoxel(int x, int y, int z)
-	{
-		int YtimeZ = (MAX_BLOCK + 1) * (MAX_BLOCK + 1);
-		int ind = x * YtimeZ + y * (MAX_BLOCK + 1) + z;
-		return m_chunkInfo->mcPoints[0][ind];
-	}
-
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-	/// <summary>	Linear interp. </summary>
-	///
-	/// <remarks>	Tzwn, 2017/12/21. </remarks>
-	///
-	/// <param name="p1">   	[in,out] The first vec4. </param>
-	/// <param name="p2">   	[in,out] The second vec4. </param>
-	/// <param name="value">	The value. </param>
-	///
-	/// <returns>	A vec3. </returns>
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-
-	static vec3
-	LinearInterp(vec4& p1, vec4& p2, float value)
-	{
-		vec3 p;
-		vec3 tp1 = vec3(p1.x, p1.y, p1.z);
-		vec3 tp2 = vec3(p2.x, p2.y, p2.z);
-		if (p1.w != p2.w)
-			p = tp1 + (tp2 - tp1) / (p2.w - p1.w) * (value - p1.w);
-		else
-			p = tp1;
-		return p;
-	}
-
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-	/// <summary>	A macro that defines Calculate Graduated Vertical 0. </summary>
-	///
-	/// <remarks>	Tzwn, 2017/12/21. </remarks>
-	///
-	/// <param name="verts">	The vertices. </param>
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-
-#define CALC_GRAD_VERT_0(verts)                                                \
-  vec4(getPoint(i - 1, j, k).w - (verts[1]).w,                                 \
-       getPoint(i, j - 1, k).w - (verts[4]).w,                                 \
-       (verts[3]).w - getPoint(i, j, k - 1).w,                                 \
-       (verts[0]).w);
-
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-	/// <summary>	A macro that defines Calculate Graduated Vertical 1. </summary>
-	///
-	/// <remarks>	Tzwn, 2017/12/21. </remarks>
-	///
-	/// <param name="verts">	The vertices. </param>
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-
-#define CALC_GRAD_VERT_1(verts)                                                \
-  vec4((verts[0]).w - getPoint(i + 2, j, k).w,                                 \
-       getPoint(i + 1, j - 1, k).w - (verts[5]).w,                             \
-       (verts[2]).w - getPoint(i + 1, j, k - 1).w,                             \
-       (verts[1]).w);
-
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-	/// <summary>	A macro that defines Calculate Graduated Vertical 2. </summary>
-	///
-	/// <remarks>	Tzwn, 2017/12/21. </remarks>
-	///
-	/// <param name="verts">	The vertices. </param>
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-
-#define CALC_GRAD_VERT_2(verts)                                                \
-  vec4((verts[3]).w - getPoint(i + 2, j, k + 1).w,                             \
-       getPoint(i + 1, j - 1, k + 1).w - (verts[6]).w,                         \
-       getPoint(i + 1, j, k + 2).w - (verts[1]).w,                             \
-       (verts[2]).w);
-
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-	/// <summary>	A macro that defines Calculate Graduated Vertical 3. </summary>
-	///
-	/// <remarks>	Tzwn, 2017/12/21. </remarks>
-	///
-	/// <param name="verts">	The vertices. </param>
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-
-#define CALC_GRAD_VERT_3(verts)                                                \
-  vec4(getPoint(i - 1, j, k + 1).w - (verts[2]).w,                             \
-       getPoint(i, j - 1, k + 1).w - (verts[7]).w,                             \
-       getPoint(i, j, k + 2).w - (verts[0]).w,                                 \
-       (verts[3]).w);
-
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-	/// <summary>	A macro that defines Calculate Graduated Vertical 4. </summary>
-	///
-	/// <remarks>	Tzwn, 2017/12/21. </remarks>
-	///
-	/// <param name="verts">	The vertices. </param>
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-
-#define CALC_GRAD_VERT_4(verts)                                                \
-  vec4(getPoint(i - 1, j + 1, k).w - (verts[5]).w,                             \
-       (verts[0]).w - getPoint(i, j + 2, k).w,                                 \
-       (verts[7]).w - getPoint(i, j + 1, k - 1).w,                             \
-       (verts[4]).w);
-
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-	/// <summary>	A macro that defines Calculate Graduated Vertical 5. </summary>
-	///
-	/// <remarks>	Tzwn, 2017/12/21. </remarks>
-	///
-	/// <param name="verts">	The vertices. </param>
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-
-#define CALC_GRAD_VERT_5(verts)                                                \
-  vec4((verts[4]).w - getPoint(i + 2, j + 1, k).w,                             \
-       (verts[1]).w - getPoint(i + 1, j + 2, k).w,                             \
-       (verts[6]).w - getPoint(i + 1, j + 1, k - 1).w,                         \
-       (verts[5]).w);
-
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-	/// <summary>	A macro that defines Calculate Graduated Vertical 6. </summary>
-	///
-	/// <remarks>	Tzwn, 2017/12/21. </remarks>
-	///
-	/// <param name="verts">	The vertices. </param>
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-
-#define CALC_GRAD_VERT_6(verts)                                                \
-  vec4((verts[7]).w - getPoint(i + 2, j + 1, k + 1).w,                         \
-       (verts[2]).w - getPoint(i + 1, j + 2, k + 1).w,                         \
-       getPoint(i + 1, j + 1, k + 2).w - (verts[5]).w,                         \
-       (verts[6]).w);
-
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-	/// <summary>	A macro that defines Calculate Graduated Vertical 7. </summary>
-	///
-	/// <remarks>	Tzwn, 2017/12/21. </remarks>
-	///
-	/// <param name="verts">	The vertices. </param>
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-
-#define CALC_GRAD_VERT_7(verts)                                                \
-  vec4(getPoint(i - 1, j + 1, k + 1).w - (verts[6]).w,                         \
-       (verts[3]).w - getPoint(i, j + 2, k + 1).w,                             \
-       getPoint(i, j + 1, k + 2).w - (verts[4]).w,                             \
-       (verts[7]).w);
-
-
-
-	voxelInfo Chunk::getPoint(int index)
-	{
-		if (index >= 0 &&
-			index < (MAX_BLOCK + 1) * (MAX_BLOCK + 1) * (MAX_BLOCK + 1))
-		{
-			return m_chunkInfo->mcPoints[0][index];
-		}
-		return m_chunkInfo->mcPoints[0][index];
-	}
-
-	voxelInfo
-	Chunk::getPoint(int x, int y, int z)
-	{
-		int size = MAX_BLOCK + 1;
-		int theIndex = x * size * size + y * size + z;
-		if (x >= 0 && x <= MAX_BLOCK && y >= 0 && y <= MAX_BLOCK && z >= 0 &&
-			z <= MAX_BLOCK)
-		{
-			return m_chunkInfo->mcPoints[0][theIndex];
-		}
-		else
-		{
-			int offsetX = 0;
-			int offsetY = 0;
-			int offsetZ = 0;
-			if (x < 0)
-			{
-				offsetX = -1;
-			}
-			if (x > MAX_BLOCK)
-			{
-				offsetX = 1;
-			}
-			if (y < 0)
-			{
-				offsetY = -1;
-			}
-			if (y > MAX_BLOCK)
-			{
-				offsetY = 1;
-			}
-			if (z < 0)
-			{
-				offsetZ = -1;
-			}
-			if (z > MAX_BLOCK)
-			{
-				offsetZ = 1;
-			}
-			auto neighborChunk = GameWorld::shared()->getChunk(
-				this->m_x + offsetX, this->m_y + offsetY, this->m_z + offsetZ);
-			if (neighborChunk)
-			{
-				if (!neighborChunk->m_chunkInfo->isLoaded)
-				{
-					neighborChunk->initData();
-				}
-				int nx = x;
-				int ny = y;
-				int nz = z;
-				if (x < 0)
-					nx += MAX_BLOCK;
-				else if (x > MAX_BLOCK)
-					nx -= MAX_BLOCK;
-				if (y < 0)
-					ny += MAX_BLOCK;
-				else if (y > MAX_BLOCK)
-					ny -= MAX_BLOCK;
-				if (z < 0)
-					nz += MAX_BLOCK;
-				else if (z > MAX_BLOCK)
-					nz -= MAX_BLOCK;
-				int neighborIndex = nx * size * size + ny * size + nz;
-				return neighborChunk->m_chunkInfo->mcPoints[0][neighborIndex];
-			}
-			else
-			{
-				return voxelInfo(1.0, 1.0, 1.0, 1.0);
-			}
-		}
-	}
-
-	voxelInfo Chunk::getPointInner(int x, int y, int z)
-	{
-		int size = MAX_BLOCK + MIN_PADDING + MAX_PADDING;
-		int theIndex = x * size * size + y * size + z;
-		if (x >= 0 && x <= size - 1  && y >= 0 && y <= size - 1 && z >= 0 &&
-			z <= size - 1)
-		{
-			return m_chunkInfo->mcPoints[0][theIndex];
-		}
-		return voxelInfo(0, 0, 0, 0);
+		markDirty(m_x * MAX_BLOCK + (i - offset) + LOD_SHIFT, m_y * MAX_BLOCK + (j - offset) + LOD_SHIFT, m_z * MAX_BLOCK + (k - offset) + LOD_SHIFT);
 	}
 
 	int
@@ -852,28 +597,196 @@ BAAAABB
 		if (!m_mesh[0])
 			return;
 
-		
+		auto chunkInfo = GameMap::shared()->acquireScratchChunkInfo();
 		for(int i = 0; i < 3; i++)
 		{
-			auto chunkInfo = GameMap::shared()->fetchFromSource(m_x, m_y, m_z, i);
-			m_mesh[i]->clear();
-			m_meshTransition[i]->clear();
-			auto VoxelBuffer = chunkInfo->mcPoints;
-			TransVoxel::shared()->generateWithoutNormal(m_basePoint,
-															m_mesh[i], m_meshTransition[i], (MAX_BLOCK>>i) + MIN_PADDING + MAX_PADDING, VoxelBuffer[i],
-															0.0f, i);
+			buildMesh(m_x, m_y, m_z, m_basePoint, i, m_mesh[i], m_meshTransition[i], chunkInfo);
 		}
-		if (m_mesh[0]->isEmpty())
+		GameMap::shared()->releaseScratchChunkInfo(chunkInfo);
+		m_bvh->build(m_mesh[0]);
+	}
+
+	void
+	Chunk::buildMesh(int x, int y, int z, vec3 basePoint, int lodLevel, Mesh * mesh, Mesh * transition, ChunkInfo * chunkInfo)
+	{
+		GameMap::shared()->fetchFromSource(x, y, z, lodLevel, chunkInfo);
+		mesh->clear();
+		transition->clear();
+		auto VoxelBuffer = chunkInfo->mcPoints;
+		TransVoxel::shared()->generateWithoutNormal(basePoint,
+														mesh, transition, (MAX_BLOCK>>lodLevel) + MIN_PADDING + MAX_PADDING, VoxelBuffer[lodLevel],
+														0.0f, lodLevel);
+	}
+
+	void
+	Chunk::markDirty(int x, int y, int z)
+	{
+		if (!m_isDirty)
+		{
+			m_isDirty = true;
+			m_dirtyMin[0] = m_dirtyMax[0] = x;
+			m_dirtyMin[1] = m_dirtyMax[1] = y;
+			m_dirtyMin[2] = m_dirtyMax[2] = z;
+			GameWorld::shared()->markChunkDirty(this);
 			return;
-		loading_mutex.lock();
-		m_isNeedSubmitMesh = true;
-		loading_mutex.unlock();
+		}
+		int pos[3] = {x, y, z};
+		for (int i = 0; i < 3; i++)
+		{
+			m_dirtyMin[i] = std::min(m_dirtyMin[i], pos[i]);
+			m_dirtyMax[i] = std::max(m_dirtyMax[i], pos[i]);
+		}
+	}
+
+	bool
+	Chunk::flushDirty()
+	{
+		if (!m_isDirty)
+			return true;
+		// the edits keep coalescing until the chunk is free
+		if (m_currenState == State::LOADING || m_remeshTicket)
+			return false;
+		m_isDirty = false;
+		// an unloaded chunk reads the edited voxels on the next load anyway
+		if (m_currenState != State::LOADED)
+			return true;
+		for (int i = 1; i < 3; i++)
+		{
+			if (isDirtyInLodRange(i))
+			{
+				m_staleLodMask |= 1u << i;
+			}
+		}
+		if (isDirtyInLodRange(0))
+		{
+			requestRemesh(1);
+		}
+		return true;
+	}
+
+	bool
+	Chunk::isBusy() const
+	{
+		return m_currenState == State::LOADING || m_remeshTicket || m_isDirty;
+	}
+
+	bool
+	Chunk::isDirtyInLodRange(int lodLevel)
+	{
+		// the voxels fetchFromSource samples for this LOD, padding included
+		int stride = 1 << lodLevel;
+		int base[3] = {m_x * MAX_BLOCK + LOD_SHIFT, m_y * MAX_BLOCK + LOD_SHIFT, m_z * MAX_BLOCK + LOD_SHIFT};
+		for (int i = 0; i < 3; i++)
+		{
+			int minV = base[i] - MIN_PADDING * stride;
+			int maxV = base[i] + ((MAX_BLOCK >> lodLevel) + MAX_PADDING - 1) * stride;
+			if (m_dirtyMax[i] < minV || m_dirtyMin[i] > maxV)
+				return false;
+		}
+		return true;
+	}
+
+	void
+	Chunk::requestRemesh(unsigned int lodMask)
+	{
+		// build into new meshes on a worker, the current ones stay on screen until the swap
+		auto ticket = std::make_shared<RemeshTicket>();
+		ticket->m_chunk = this;
+		ticket->m_lodMask = lodMask;
+		for (int i = 0; i < 3; i++)
+		{
+			ticket->m_mesh[i] = (lodMask & (1u << i)) ? new Mesh() : nullptr;
+			ticket->m_meshTransition[i] = (lodMask & (1u << i)) ? new Mesh() : nullptr;
+		}
+		ticket->m_bvh = (lodMask & 1) ? new TriangleBVH() : nullptr;
+		m_remeshTicket = ticket;
+		int x = m_x, y = m_y, z = m_z;
+		vec3 basePoint = m_basePoint;
+		WorkerThreadSystem::shared()->pushOrder(WorkerJob([ticket, x, y, z, basePoint]()
+		{
+			auto chunkInfo = GameMap::shared()->acquireScratchChunkInfo();
+			for (int i = 0; i < 3; i++)
+			{
+				if (ticket->m_lodMask & (1u << i))
+				{
+					buildMesh(x, y, z, basePoint, i, ticket->m_mesh[i], ticket->m_meshTransition[i], chunkInfo);
+				}
+			}
+			GameMap::shared()->releaseScratchChunkInfo(chunkInfo);
+			if (ticket->m_bvh)
+			{
+				ticket->m_bvh->build(ticket->m_mesh[0]);
+			}
+		}, [ticket]()
+		{
+			onRemeshFinished(ticket);
+		}, 0.0f, ticket.get()));
+	}
+
+	void
+	Chunk::onRemeshFinished(std::shared_ptr<RemeshTicket> ticket)
+	{
+		Chunk * chunk = ticket->m_chunk;
+		for (int i = 0; i < 3; i++)
+		{
+			if (!(ticket->m_lodMask & (1u << i)))
+				continue;
+			if (!chunk)
+			{
+				delete ticket->m_mesh[i];
+				delete ticket->m_meshTransition[i];
+				continue;
+			}
+			delete chunk->m_mesh[i];
+			delete chunk->m_meshTransition[i];
+			chunk->m_mesh[i] = ticket->m_mesh[i];
+			chunk->m_meshTransition[i] = ticket->m_meshTransition[i];
+			chunk->m_mesh[i]->finish();
+			chunk->m_meshTransition[i]->finish();
+		}
+		if (!chunk)
+		{
+			delete ticket->m_bvh;
+			return;
+		}
+		if (ticket->m_bvh)
+		{
+			delete chunk->m_bvh;
+			chunk->m_bvh = ticket->m_bvh;
+		}
+		chunk->m_staleLodMask &= ~ticket->m_lodMask;
+		chunk->m_remeshTicket.reset();
+		if (ticket->m_lodMask & 1)
+		{
+			if (chunk->m_rigidBody)
+			{
+				PhysicsMgr::shared()->removeRigidBody(chunk->m_rigidBody);
+				delete chunk->m_rigidBody;
+				chunk->m_rigidBody = nullptr;
+			}
+			if (!chunk->m_mesh[0]->isEmpty())
+			{
+				chunk->m_rigidBody = PhysicsMgr::shared()->createRigidBodyMesh(chunk->m_mesh[0], nullptr);
+				chunk->m_rigidBody->setFriction(10.0);
+				PhysicsMgr::shared()->addRigidBody(chunk->m_rigidBody);
+			}
+		}
+	}
+
+	void
+	Chunk::dropRemesh()
+	{
+		// the finish callback always runs on the main thread, it frees the meshes of a dropped ticket
+		if (m_remeshTicket)
+		{
+			m_remeshTicket->m_chunk = nullptr;
+			m_remeshTicket.reset();
+		}
 	}
 
 	void Chunk::initData()
 	{
 		if (m_chunkInfo->isLoaded) return;
-		m_chunkInfo->initData();
 		// sampleForLod(1, m_chunkInfo->mcPoints_lod1);
 		m_chunkInfo->isEdit = false;
 		m_chunkInfo->isLoaded = true;
@@ -883,12 +796,8 @@ BAAAABB
 	void
 	Chunk::setUpTransFormation(TransformationInfo& info)
 	{
-		auto currCam = g_GetCurrScene()->defaultCamera();
-		info.m_projectMatrix = currCam->projection();
-		info.m_viewMatrix = currCam->getViewMatrix();
-		Matrix44 mat; // mesh it self contain world position
-		mat.setToIdentity();
-		info.m_worldMatrix = mat;
+		// terrain vertices are packed relative to the chunk, see Mesh::setPackedTransform
+		info.m_worldMatrix = m_mesh[m_currentLOD]->getPackedTransform();
 	}
 
 	void
@@ -938,16 +847,24 @@ BAAAABB
 		m_tree->m_instance.clear();
 		m_grass->m_instance.clear();
 		size_t indexCount = m_mesh[0]->m_indices.size();
-		if (indexCount <= 0) return;
+		if (indexCount <= 0)
+		{
+			m_tree->commit();
+			m_grass->commit();
+			return;
+		}
 		float grassDensity = 1.0;
 		float step = 1.0 / grassDensity;
 		vec3 theBasePoint = GameMap::shared()->voxelToWorldPos(this->m_x * MAX_BLOCK + LOD_SHIFT, this->m_y * MAX_BLOCK + LOD_SHIFT, this->m_z * MAX_BLOCK + LOD_SHIFT);
+		// seeded by the chunk coordinate, a chunk gets the same vegetation whenever and on whichever worker it is loaded
+		std::mt19937 random(uint32_t(m_x) * 73856093u ^ uint32_t(m_y) * 19349663u ^ uint32_t(m_z) * 83492791u);
+		std::uniform_real_distribution<float> randFN(-1.0f, 1.0f);
 		for (float x = 0; x <= BLOCK_SIZE * MAX_BLOCK; x += grassDensity)
 		{
 			for (float z = 0; z <= BLOCK_SIZE * MAX_BLOCK; z += grassDensity)
 			{
-				auto ox = TbaseMath::randFN() * 0.4;
-				auto oz = TbaseMath::randFN() * 0.4;
+				auto ox = randFN(random) * 0.4;
+				auto oz = randFN(random) * 0.4;
 				vec3 pos(theBasePoint.x + x + ox, 0, theBasePoint.z + z + oz);
 				auto h = GameMap::shared()->getHeight(pos.xz());
 				pos.y = h;
@@ -960,9 +877,9 @@ BAAAABB
 				{
 					if (grassNoise.GetValue(pos.x * 0.3, pos.z * 0.3, 0.0) > 0.2)
 					{
-						auto ox = TbaseMath::randFN() * 0.5;
-						auto oz = TbaseMath::randFN() * 0.5;
-						auto scale = TbaseMath::randFN() * 0.1;
+						auto ox = randFN(random) * 0.5;
+						auto oz = randFN(random) * 0.5;
+						auto scale = randFN(random) * 0.1;
 						InstanceData instance;
 						vec3 normal = GameMap::shared()->getNormal(vec2(pos.x, pos.z));
 						Matrix44 mat;
@@ -997,17 +914,14 @@ BAAAABB
 
 
 
-		treeNoise.SetSeed(233);
-		treeNoise.SetFrequency(0.02);
-		treeNoise.SetNoiseType(FastNoise::Perlin);
 		int treeCount = 0;
 		
 		for (float x = 0; x <= BLOCK_SIZE * MAX_BLOCK; x += 1.5)
 		{
 			for (float z = 0; z <= BLOCK_SIZE * MAX_BLOCK; z += 1.5)
 			{
-				auto ox = TbaseMath::randFN() * 0.2;
-				auto oz = TbaseMath::randFN() * 0.2;
+				auto ox = randFN(random) * 0.2;
+				auto oz = randFN(random) * 0.2;
 				float value = treeNoise.GetNoise(x + ox, 0, z + oz);
 				// the flat is grass or dirt?
 				// value = value * 0.5 + 0.5;
@@ -1027,6 +941,8 @@ BAAAABB
 				}
 			}
 		}
+		m_tree->commit();
+		m_grass->commit();
 		m_isTreeloaded = true;
 	}
 
@@ -1065,18 +981,13 @@ BAAAABB
 	bool
 	Chunk::hitAny(Ray& ray, vec3& result)
 	{
-		auto size = m_mesh[0]->getIndicesSize();
+		if (m_currenState != State::LOADED)
+			return false;
 		float t = 0;
-		for (size_t i = 0; i < size; i += 3)
+		if (m_bvh->rayCastAny(ray, t))
 		{
-			if (ray.intersectTriangle(m_mesh[0]->m_vertices[m_mesh[0]->m_indices[i]].m_pos,
-									m_mesh[0]->m_vertices[m_mesh[0]->m_indices[i + 1]].m_pos,
-									m_mesh[0]->m_vertices[m_mesh[0]->m_indices[i + 2]].m_pos,
-									&t))
-			{
-				result = ray.origin() + ray.direction() * t;
-				return true;
-			}
+			result = ray.origin() + ray.direction() * t;
+			return true;
 		}
 		return false;
 	}
@@ -1086,26 +997,10 @@ BAAAABB
 	{
 		if (m_currenState != State::LOADED)
 			return false;
-		auto size = m_mesh[0]->getIndicesSize();
 		float t = 0;
-		bool isFind = false;
-		vec3 minP = vec3(-99999, -99999, -99999);
-		for (size_t i = 0; i < size; i += 3)
-		{
-			if (ray.intersectTriangle(m_mesh[0]->m_vertices[m_mesh[0]->m_indices[i + 2]].m_pos,
-									m_mesh[0]->m_vertices[m_mesh[0]->m_indices[i + 1]].m_pos,
-									m_mesh[0]->m_vertices[m_mesh[0]->m_indices[i]].m_pos,
-									&t))
-			{
-				auto tmp = ray.origin() + ray.direction() * t;
-				if (tmp.distance(ray.origin()) < minP.distance(ray.origin()))
-				{
-					minP = tmp;
-					isFind = true;
-				}
-			}
-		}
-		result = minP;
-		return isFind;
+		if (!m_bvh->rayCastFirst(ray, t))
+			return false;
+		result = ray.origin() + ray.direction() * t;
+		return true;
 	}
 }
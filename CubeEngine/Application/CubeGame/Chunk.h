@@ -4,6 +4,7 @@
 #include "3D/Vegetation/Grass.h"
 #include "3D/Vegetation/Tree.h"
 #include "GameMap.h"
+#include <memory>
 
 
 struct vertexInfo
@@ -15,6 +16,7 @@ namespace tzw
 {
 	class PhysicsRigidBody;
 	class ChunkInfo;
+	class TriangleBVH;
 	
 	class Chunk : public Drawable3D
 	{
@@ -26,6 +28,7 @@ namespace tzw
 			LOADED
 		};
 		Chunk(int the_x, int the_y, int the_z);
+		~Chunk();
 	    int m_x;
 	    int m_y;
 	    int m_z;
@@ -33,24 +36,24 @@ namespace tzw
 		bool intersectByAABB(const AABB & other, vec3 &overLap) override;
 		Drawable3D * intersectByRay(const Ray & ray, vec3 &hitPoint) override;
 		bool intersectBySphere(const t_Sphere & sphere, std::vector<vec3> & hitPoint) override;
-		void logicUpdate(float delta) override;
 		bool getIsAccpectOcTtree() const override;
 		void submitDrawCmd(RenderFlag::RenderStageType requirementType, RenderQueues * queues, int requirementArg) override;
-		void load(int lodLevel);
+		void load(int lodLevel, float priority = 0.0f);
 		void unload();
 		void deformSphere(vec3 pos, float value, float range = 1.0f);
 		void deformCube(vec3 pos, float value, float range = 1.0f);
 		void paintSphere(vec3 pos, int matIndex, float range = 1.0f);
 	    void deformWithNeighbor(int X, int Y, int Z, std::function<void(Chunk *, int , int ,int)>neighborTrigger);
 	    void setVoxelScalar(int x, int y, int z, float scalar, bool isAdd = true);
-	    void addVoexlScalar(int x, int y, int z, float scalar);
 		void setVoxelMat(int x, int y, int z, int matIndex, bool isAdd = true);
-		voxelInfo getVoxel(int x, int y, int z);
-	    voxelInfo getPoint(int index);
-	    voxelInfo getPoint(int x, int y, int z);
-		voxelInfo getPointInner(int x, int y, int z);
 	    int getIndex(int x, int y, int z);
 	    void genMesh(int lodLevel);
+		//called by setVoxelScalar and setVoxelMat with the global voxel coordinate, the remesh is deferred to flushDirty
+		void markDirty(int x, int y, int z);
+		//remesh LOD0 for the edits since the last flush, return false if the chunk is busy and should be flushed again next frame
+		bool flushDirty();
+		//a load or remesh job is in flight, or edits wait for one
+		bool isBusy() const;
 	    void initData();
 		void setUpTransFormation(TransformationInfo & info) override;
 		void setLod(unsigned int newLod);
@@ -63,8 +66,25 @@ namespace tzw
 		State m_currenState;
 		ChunkInfo * getChunkInfo();
 		int getCurrentLod();
+		//safe to call from a worker thread with a scratch ChunkInfo, see GameMap::acquireScratchChunkInfo
+		static void buildMesh(int x, int y, int z, vec3 basePoint, int lodLevel, Mesh * mesh, Mesh * transition, ChunkInfo * chunkInfo);
 	private:
 		int m_currentLOD;
+		struct RemeshTicket
+		{
+			//reset to nullptr when the chunk doesn't want the result anymore, the finish callback cleans up the meshes then.
+			Chunk * m_chunk;
+			unsigned int m_lodMask;
+			Mesh * m_mesh[3];
+			Mesh * m_meshTransition[3];
+			//only built when LOD0 is in the mask
+			TriangleBVH * m_bvh;
+		};
+		static void onRemeshFinished(std::shared_ptr<RemeshTicket> ticket);
+		void onLoadFinished();
+		void requestRemesh(unsigned int lodMask);
+		void dropRemesh();
+		bool isDirtyInLodRange(int lodLevel);
 		TreeGroup * m_grass;
 		TreeGroup * m_grass2;
 		TreeGroup * m_tree;
@@ -81,11 +101,20 @@ namespace tzw
 	    bool hitFirst(const Ray &ray, vec3 & result);
 		ChunkInfo * m_chunkInfo;
 	    vec3 m_basePoint;
-	    std::vector<Chunk *> m_tmpNeighborChunk;
 		std::vector<vec4> m_grassPosList;
 		unsigned int m_lod;
-		bool m_isNeedSubmitMesh;
+		//unload was asked while the load job was running, done when it finishes
+		bool m_isUnloadPending;
 		PhysicsRigidBody * m_rigidBody;
 		bool m_isTreeloaded;
+		//global voxel box of the edits which are not remeshed yet
+		int m_dirtyMin[3];
+		int m_dirtyMax[3];
+		bool m_isDirty;
+		//the coarse LODs which are out of date, rebuilt when the camera actually needs them
+		unsigned int m_staleLodMask;
+		std::shared_ptr<RemeshTicket> m_remeshTicket;
+		//picking structure of m_mesh[0], built on the worker with the mesh
+		TriangleBVH * m_bvh;
 	};
 }
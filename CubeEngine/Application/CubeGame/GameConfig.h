@@ -2,7 +2,8 @@
 #define GAMECONFIG_H
 
 
-#define CUBE_MAP_SIZE (256)
+//chunks further than the load range plus this margin are deleted
+#define CHUNK_EVICT_MARGIN (2)
 extern float BLOCK_SIZE;
 extern int MAX_BLOCK;
 extern int GAME_MAP_WIDTH;
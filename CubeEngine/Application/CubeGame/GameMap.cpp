@@ -1,10 +1,16 @@
 #include "GameMap.h"
 #include "Chunk.h"
 #include "GameConfig.h"
+#include "GameWorld.h"
 
 #include "FastNoise/FastNoise.h"
 #include <algorithm>
 #include "3D/Terrain/Transvoxel.h"
+#include "TerrainRegionStore.h"
+#include "Utility/file/Tfile.h"
+#include "rapidjson/filewritestream.h"
+#include "rapidjson/prettywriter.h"
+#include <filesystem>
 namespace tzw {
 GameMap* GameMap::m_instance = nullptr;
 
@@ -115,6 +121,7 @@ GameMap::GameMap()
   , m_ratio(0)
   , m_minHeight(0)
   , m_mapType(MapType::Noise)
+  , m_isTerrainMapped(false)
 {
   m_plane = new noise::model::Plane(myModule);
   myModule.SetPersistence(0.001);
@@ -167,13 +174,9 @@ void GameMap::init(float ratio, int width, int depth, int height)
 	x_offset = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
 	y_offset = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
 	z_offset = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-
-	m_chunkInfo = new ChunkInfo(0, 0, 0);
-    //+1 for neighbor padding used.
-    mapBufferSize_X = ((GAME_MAP_WIDTH * MAX_BLOCK)/GAME_MAX_BUFFER_SIZE) + 1;
-    mapBufferSize_Y = ((GAME_MAP_HEIGHT * MAX_BLOCK)/GAME_MAX_BUFFER_SIZE) + 1;
-    mapBufferSize_Z = ((GAME_MAP_DEPTH * MAX_BLOCK)/GAME_MAX_BUFFER_SIZE) + 1;
-	m_totalBuffer = new GameMapBuffer[(mapBufferSize_X) * (mapBufferSize_Y) * (mapBufferSize_Z)];
+	std::atomic_store(&m_regionStore, std::shared_ptr<TerrainRegionStore>());
+	m_retiredStoreList.clear();
+	clearBuffers();
 	{
 		auto tmpTree = Model::create("treeTest/tzwTree.tzw");
 		auto aabb = tmpTree->localAABB();
@@ -219,12 +222,44 @@ double
 GameMap::getNoiseValue(float x, float y, float z)
 {
 	//double value = finalTerrain.GetValue(x_offset + x, y_offset + y, z_offset + z);
-	auto finalFlatTerrain = baseFlatTerrain.GetNoise(x_offset + x, y_offset + y, z_offset + z)* 8 + 8 + baseBumpyFlatTerrain.GetNoise(x_offset + x, y_offset + y, z_offset + z) * 0.1;
-	auto mountainTerrain = baseMountainTerrain.GetNoise(x_offset + x, y_offset + y, z_offset + z) * 16 + 16;
-	auto highHillTerrain = hightMountainTerrain.GetNoise(x_offset + x, y_offset + y, z_offset + z) * 28 + 28.0;
-	auto finalMountainTerrain = edgeFallOffSelect(0.5, 100, 0.2, mountainTerrain, highHillTerrain, hillSelector.GetNoise(x_offset + x, y_offset + y, z_offset + z));
-	double value = edgeFallOffSelect(0.25, 1.0, 0.27, finalFlatTerrain, finalMountainTerrain, terrainType.GetNoise(x_offset + x, y_offset + y, z_offset + z));//
-	return m_minHeight + value;	
+	float nx = x_offset + x, ny = y_offset + y, nz = z_offset + z;
+	return blendTerrainLayers(baseFlatTerrain.GetNoise(nx, ny, nz), baseBumpyFlatTerrain.GetNoise(nx, ny, nz),
+		baseMountainTerrain.GetNoise(nx, ny, nz), hightMountainTerrain.GetNoise(nx, ny, nz),
+		hillSelector.GetNoise(nx, ny, nz), terrainType.GetNoise(nx, ny, nz));
+}
+
+double
+GameMap::blendTerrainLayers(float flat, float bumpyFlat, float mountain, float highMountain, float hill, float type)
+{
+	auto finalFlatTerrain = flat * 8 + 8 + bumpyFlat * 0.1;
+	auto mountainTerrain = mountain * 16 + 16;
+	auto highHillTerrain = highMountain * 28 + 28.0;
+	auto finalMountainTerrain = edgeFallOffSelect(0.5, 100, 0.2, mountainTerrain, highHillTerrain, hill);
+	double value = edgeFallOffSelect(0.25, 1.0, 0.27, finalFlatTerrain, finalMountainTerrain, type);//
+	return m_minHeight + value;
+}
+
+void
+GameMap::getHeightBatch(const float* posX, const float* posZ, float* outHeight, int count)
+{
+	//same as getHeight, but each noise layer is sampled for the whole batch at once
+	std::vector<float> nx(count), ny(count, y_offset), nz(count);
+	for(int i = 0; i < count; i++)
+	{
+		nx[i] = x_offset + posX[i];
+		nz[i] = z_offset + posZ[i];
+	}
+	std::vector<float> flat(count), bumpyFlat(count), mountain(count), highMountain(count), hill(count), type(count);
+	baseFlatTerrain.GetNoiseSet(nx.data(), ny.data(), nz.data(), flat.data(), count);
+	baseBumpyFlatTerrain.GetNoiseSet(nx.data(), ny.data(), nz.data(), bumpyFlat.data(), count);
+	baseMountainTerrain.GetNoiseSet(nx.data(), ny.data(), nz.data(), mountain.data(), count);
+	hightMountainTerrain.GetNoiseSet(nx.data(), ny.data(), nz.data(), highMountain.data(), count);
+	hillSelector.GetNoiseSet(nx.data(), ny.data(), nz.data(), hill.data(), count);
+	terrainType.GetNoiseSet(nx.data(), ny.data(), nz.data(), type.data(), count);
+	for(int i = 0; i < count; i++)
+	{
+		outHeight[i] = blendTerrainLayers(flat[i], bumpyFlat[i], mountain[i], highMountain[i], hill[i], type[i]) + 32.f;
+	}
 }
 
 bool
@@ -279,21 +314,152 @@ GameMap::isSurface(vec3 pos)
   }
 }
 
-voxelInfo GameMap::getDensityI(int x, int y, int z)
+//rounded down, so the voxels on the negative side of the map are fine too
+static int getBufferID(int v)
+{
+    return v >= 0 ? v / GAME_MAX_BUFFER_SIZE : (v + 1) / GAME_MAX_BUFFER_SIZE - 1;
+}
+
+static int getCellIndex(int x, int y, int z)
+{
+    int currX = x - getBufferID(x) * GAME_MAX_BUFFER_SIZE;
+    int currY = y - getBufferID(y) * GAME_MAX_BUFFER_SIZE;
+    int currZ = z - getBufferID(z) * GAME_MAX_BUFFER_SIZE;
+    return currX * GAME_MAX_BUFFER_SIZE * GAME_MAX_BUFFER_SIZE + currY * GAME_MAX_BUFFER_SIZE + currZ;
+}
+
+//the buffers holding the voxels fetchFromSource reads for a chunk, the coarsest lod reaches the furthest
+static void getChunkBufferRange(int chunkPos, int & first, int & last)
+{
+    int stride = 1 << 2;
+    int base = chunkPos * MAX_BLOCK + LOD_SHIFT;
+    first = getBufferID(base - MIN_PADDING * stride);
+    last = getBufferID(base + ((MAX_BLOCK >> 2) + MAX_PADDING - 1) * stride);
+}
+
+GameMapBuffer* GameMap::getBuffer(int x, int y, int z)
 {
-    int buffIDX = (x/GAME_MAX_BUFFER_SIZE);
-    int buffIDY = (y/GAME_MAX_BUFFER_SIZE);
-    int buffIDZ = (z/GAME_MAX_BUFFER_SIZE);
-    int buffIndex = buffIDX * (mapBufferSize_Z * mapBufferSize_Y) + buffIDY * (mapBufferSize_Z) + buffIDZ;
-    if(!m_totalBuffer[buffIndex].m_buff)
+    int buffIDX = getBufferID(x);
+    int buffIDY = getBufferID(y);
+    int buffIDZ = getBufferID(z);
+    GameMapBuffer * buffer;
     {
-        proceduralGenMapBuffer(buffIDX, buffIDY, buffIDZ);
+        std::lock_guard<std::mutex> lock(m_bufferMutex);
+        buffer = findOrAddBuffer(buffIDX, buffIDY, buffIDZ);
     }
-    int currX = (x%GAME_MAX_BUFFER_SIZE);
-    int currY = (y%GAME_MAX_BUFFER_SIZE);
-    int currZ = (z%GAME_MAX_BUFFER_SIZE);
-    int cellIndex = currX * GAME_MAX_BUFFER_SIZE * GAME_MAX_BUFFER_SIZE + currY * GAME_MAX_BUFFER_SIZE + currZ;
-    return m_totalBuffer[buffIndex].m_buff[cellIndex];
+    //several workers may touch the same buffer at the same time, only one of them generate it, the others wait.
+    std::call_once(buffer->m_genFlag, [&]()
+    {
+        auto store = std::atomic_load(&m_regionStore);
+        if(!buffer->m_buff && store && store->isMapped())
+        {
+            buffer->m_buff = store->map(buffIDX, buffIDY, buffIDZ);
+            buffer->m_isMapped = buffer->m_buff != nullptr;
+        }
+        if(!buffer->m_buff && store)
+        {
+            auto buff = new voxelInfo[GAME_MAX_BUFFER_SIZE* GAME_MAX_BUFFER_SIZE *GAME_MAX_BUFFER_SIZE];
+            if(store->load(buffIDX, buffIDY, buffIDZ, buff))
+            {
+                buffer->m_buff = buff;
+            }
+            else
+            {
+                delete [] buff;
+            }
+        }
+        if(!buffer->m_buff)
+        {
+            proceduralGenMapBuffer(buffer, buffIDX, buffIDY, buffIDZ);
+        }
+    });
+    return buffer;
+}
+
+void GameMap::retainChunkBuffers(int chunkX, int chunkY, int chunkZ)
+{
+    int firstX, lastX, firstY, lastY, firstZ, lastZ;
+    getChunkBufferRange(chunkX, firstX, lastX);
+    getChunkBufferRange(chunkY, firstY, lastY);
+    getChunkBufferRange(chunkZ, firstZ, lastZ);
+    std::lock_guard<std::mutex> lock(m_bufferMutex);
+    for(int x = firstX; x <= lastX; x++)
+    {
+        for(int y = firstY; y <= lastY; y++)
+        {
+            for(int z = firstZ; z <= lastZ; z++)
+            {
+                findOrAddBuffer(x, y, z)->m_chunkRefCount++;
+            }
+        }
+    }
+}
+
+void GameMap::releaseChunkBuffers(int chunkX, int chunkY, int chunkZ)
+{
+    int firstX, lastX, firstY, lastY, firstZ, lastZ;
+    getChunkBufferRange(chunkX, firstX, lastX);
+    getChunkBufferRange(chunkY, firstY, lastY);
+    getChunkBufferRange(chunkZ, firstZ, lastZ);
+    std::lock_guard<std::mutex> lock(m_bufferMutex);
+    for(int x = firstX; x <= lastX; x++)
+    {
+        for(int y = firstY; y <= lastY; y++)
+        {
+            for(int z = firstZ; z <= lastZ; z++)
+            {
+                auto iter = m_bufferMap.find(GameWorld::packChunkKey(x, y, z));
+                if(iter == m_bufferMap.end())
+                    continue;
+                auto buffer = iter->second;
+                buffer->m_chunkRefCount--;
+                //an edited buffer waits for saveTerrain, the others can be loaded or generated again
+                if(!buffer->m_chunkRefCount && !buffer->isEdit)
+                {
+                    deleteBuffer(buffer);
+                    m_bufferMap.erase(iter);
+                }
+            }
+        }
+    }
+}
+
+GameMapBuffer* GameMap::findOrAddBuffer(int buffIDX, int buffIDY, int buffIDZ)
+{
+    auto & buffer = m_bufferMap[GameWorld::packChunkKey(buffIDX, buffIDY, buffIDZ)];
+    if(!buffer)
+    {
+        buffer = new GameMapBuffer();
+        buffer->m_x = buffIDX;
+        buffer->m_y = buffIDY;
+        buffer->m_z = buffIDZ;
+    }
+    return buffer;
+}
+
+void GameMap::deleteBuffer(GameMapBuffer* buffer)
+{
+    if(!buffer->m_isMapped)
+    {
+        delete [] buffer->m_buff;
+    }
+    delete buffer;
+}
+
+void GameMap::clearBuffers()
+{
+    std::lock_guard<std::mutex> lock(m_bufferMutex);
+    for(auto & iter : m_bufferMap)
+    {
+        deleteBuffer(iter.second);
+    }
+    m_bufferMap.clear();
+}
+
+voxelInfo GameMap::getDensityI(int x, int y, int z)
+{
+    auto buffer = getBuffer(x, y, z);
+    return buffer->m_buff[getCellIndex(x, y, z)];
 }
 
 unsigned char GameMap::getDensity(vec3 pos)
@@ -336,49 +502,28 @@ unsigned char GameMap::getDensity(vec3 pos)
 
 unsigned char GameMap::getVoxelW(int x, int y, int z)
 {
-    int buffIDX = (x/GAME_MAX_BUFFER_SIZE);
-    int buffIDY = (y/GAME_MAX_BUFFER_SIZE);
-    int buffIDZ = (z/GAME_MAX_BUFFER_SIZE);
-    int buffIndex = buffIDX * (mapBufferSize_Z * mapBufferSize_Y) + buffIDY * (mapBufferSize_Z) + buffIDZ;
-    int currX = (x%GAME_MAX_BUFFER_SIZE);
-    int currY = (y%GAME_MAX_BUFFER_SIZE);
-    int currZ = (z%GAME_MAX_BUFFER_SIZE);
-    int cellIndex = currX * GAME_MAX_BUFFER_SIZE * GAME_MAX_BUFFER_SIZE + currY * GAME_MAX_BUFFER_SIZE + currZ;
-    return m_totalBuffer[buffIndex].m_buff[cellIndex].w;
+    return getDensityI(x, y, z).w;
 }
 
 voxelInfo*
 GameMap::getVoxel(int x, int y, int z)
 {
-    int buffIDX = (x/GAME_MAX_BUFFER_SIZE);
-    int buffIDY = (y/GAME_MAX_BUFFER_SIZE);
-    int buffIDZ = (z/GAME_MAX_BUFFER_SIZE);
-    int buffIndex = buffIDX * (mapBufferSize_Z * mapBufferSize_Y) + buffIDY * (mapBufferSize_Z) + buffIDZ;
-    int currX = (x%GAME_MAX_BUFFER_SIZE);
-    int currY = (y%GAME_MAX_BUFFER_SIZE);
-    int currZ = (z%GAME_MAX_BUFFER_SIZE);
-    int cellIndex = currX * GAME_MAX_BUFFER_SIZE * GAME_MAX_BUFFER_SIZE + currY * GAME_MAX_BUFFER_SIZE + currZ;
-    return &m_totalBuffer[buffIndex].m_buff[cellIndex];
+    auto buffer = getBuffer(x, y, z);
+    //mutable access, the buffer need to be saved
+    buffer->isEdit = true;
+    return &buffer->m_buff[getCellIndex(x, y, z)];
 }
 
 void GameMap::setVoxel(int x, int y, int z, unsigned char w)
 {
-    int buffIDX = (x/GAME_MAX_BUFFER_SIZE);
-    int buffIDY = (y/GAME_MAX_BUFFER_SIZE);
-    int buffIDZ = (z/GAME_MAX_BUFFER_SIZE);
-    int buffIndex = buffIDX * (mapBufferSize_Z * mapBufferSize_Y) + buffIDY * (mapBufferSize_Z) + buffIDZ;
-    int currX = (x%GAME_MAX_BUFFER_SIZE);
-    int currY = (y%GAME_MAX_BUFFER_SIZE);
-    int currZ = (z%GAME_MAX_BUFFER_SIZE);
-    int cellIndex = currX * GAME_MAX_BUFFER_SIZE * GAME_MAX_BUFFER_SIZE + currY * GAME_MAX_BUFFER_SIZE + currZ;
-    m_totalBuffer[buffIndex].m_buff[cellIndex].w = w;
+    getVoxel(x, y, z)->w = w;
 }
 
 vec3 GameMap::voxelToBuffWorldPos(int x, int y, int z)
 {
-    int buffIDX = (x/GAME_MAX_BUFFER_SIZE);
-    int buffIDY = (y/GAME_MAX_BUFFER_SIZE);
-    int buffIDZ = (z/GAME_MAX_BUFFER_SIZE);
+    int buffIDX = getBufferID(x);
+    int buffIDY = getBufferID(y);
+    int buffIDZ = getBufferID(z);
     return vec3((buffIDX * GAME_MAX_BUFFER_SIZE)  * BLOCK_SIZE, (buffIDY * GAME_MAX_BUFFER_SIZE)  * BLOCK_SIZE, (buffIDZ * GAME_MAX_BUFFER_SIZE)  * BLOCK_SIZE);
 }
 
@@ -390,7 +535,7 @@ vec3 GameMap::voxelToWorldPos(int x, int y, int z)
 vec3 GameMap::worldPosToVoxelPos(vec3 pos)
 {
 	pos -= m_mapOffset;
-	return vec3(int(pos.x / BLOCK_SIZE), int(pos.y / BLOCK_SIZE),int(pos.z / BLOCK_SIZE));
+	return vec3(floor(pos.x / BLOCK_SIZE), floor(pos.y / BLOCK_SIZE),floor(pos.z / BLOCK_SIZE));
 }
 
 float GameMap::getHeight(vec2 posXZ)
@@ -477,7 +622,28 @@ GameMap::minHeight()
 
 ChunkInfo * GameMap::getChunkInfo(int x, int y, int z)
 {
-	return m_chunkInfo;
+	// only hold the state of the chunk, the samples are fetched into a scratch buffer on demand.
+	return new ChunkInfo(x, y, z);
+}
+
+ChunkInfo* GameMap::acquireScratchChunkInfo()
+{
+	std::lock_guard<std::mutex> lock(m_scratchMutex);
+	if(m_scratchPool.empty())
+	{
+		auto info = new ChunkInfo(0, 0, 0);
+		info->initData();
+		return info;
+	}
+	auto info = m_scratchPool.back();
+	m_scratchPool.pop_back();
+	return info;
+}
+
+void GameMap::releaseScratchChunkInfo(ChunkInfo* info)
+{
+	std::lock_guard<std::mutex> lock(m_scratchMutex);
+	m_scratchPool.push_back(info);
 }
   static double LinearInterp (double n0, double n1, double a)
   {
@@ -560,7 +726,7 @@ vec2 GameMap::getCenterOfMap()
 	return vec2(LOD_SHIFT * BLOCK_SIZE, LOD_SHIFT * BLOCK_SIZE);
 }
 
-ChunkInfo* GameMap::fetchFromSource(int chunkX, int chunkY, int chunkZ, int lod)
+void GameMap::fetchFromSource(int chunkX, int chunkY, int chunkZ, int lod, ChunkInfo * out)
 {
 	auto lodList = {0, 1, 2};
 	int YtimeZ = (MAX_BLOCK + MIN_PADDING + MAX_PADDING) * (MAX_BLOCK + MIN_PADDING + MAX_PADDING);
@@ -584,70 +750,196 @@ ChunkInfo* GameMap::fetchFromSource(int chunkX, int chunkY, int chunkZ, int lod)
 				auto w = GameMap::shared()->getDensityI(chunkX * MAX_BLOCK + (i - offset)*stride + LOD_SHIFT, chunkY * MAX_BLOCK + (j - offset)*stride + LOD_SHIFT, chunkZ * MAX_BLOCK + (k - offset)*stride + LOD_SHIFT);
 
 				int ind = i * BlockROW*BlockROW + j * BlockROW + k;
-				m_chunkInfo->mcPoints[lod][ind] = w;
+				out->mcPoints[lod][ind] = w;
 			}
 		}
 	}
-	return m_chunkInfo;
 }
 
-void GameMap::saveTerrain(std::string filePath)
+void GameMap::saveTerrain(std::string folderPath)
 {
-    auto terrainFile = fopen(filePath.c_str(), "wb");
-	size_t count = (mapBufferSize_X) * (mapBufferSize_Y) * (mapBufferSize_Z);
-	size_t writeCount = 0;
-	for(size_t i = 0; i < count; i++)
+	auto store = std::atomic_load(&m_regionStore);
+	if(!store || store->getFolder() != folderPath)
 	{
-		auto buff = m_totalBuffer[i].m_buff;
-		if(buff)
+		//a fresh world or another location, the regions which haven't been loaded yet must come along.
+		auto newStore = std::make_shared<TerrainRegionStore>(folderPath);
+		newStore->clear();
+		newStore->setIsMapped(m_isTerrainMapped);
+		if(store)
 		{
-			fwrite(&i, sizeof(size_t), 1, terrainFile);
-			fwrite(buff, sizeof(voxelInfo) * GAME_MAX_BUFFER_SIZE* GAME_MAX_BUFFER_SIZE *GAME_MAX_BUFFER_SIZE, 1, terrainFile);
-			writeCount += 1;
+			std::error_code err;
+			std::filesystem::copy(store->getFolder(), folderPath, std::filesystem::copy_options::recursive, err);
+			m_retiredStoreList.push_back(store);
 		}
+		store = newStore;
+		std::atomic_store(&m_regionStore, store);
 	}
-    fclose(terrainFile);
-	tlog("write %ld chunk, size of the voxel info %ld (%d %d %d)",writeCount, sizeof(voxelInfo),mapBufferSize_X ,mapBufferSize_Y, mapBufferSize_Z);
-	
+	//the untouched buffers can be generated again from the noise offset.
+	//the buffers are only freed on the main thread, the lock is for the workers adding new ones
+	std::vector<TerrainRegionEntry> entryList;
+	{
+		std::lock_guard<std::mutex> lock(m_bufferMutex);
+		for(auto & iter : m_bufferMap)
+		{
+			auto buffer = iter.second;
+			if(buffer->m_buff && buffer->isEdit)
+			{
+				entryList.push_back(TerrainRegionEntry{buffer->m_x, buffer->m_y, buffer->m_z, buffer->m_buff});
+				buffer->isEdit = false;
+			}
+		}
+	}
+	store->save(entryList);
+	//the edited buffers whose chunks have been evicted are saved now, they can go too
+	std::lock_guard<std::mutex> lock(m_bufferMutex);
+	for(auto iter = m_bufferMap.begin(); iter != m_bufferMap.end();)
+	{
+		if(iter->second->m_chunkRefCount)
+		{
+			++iter;
+			continue;
+		}
+		deleteBuffer(iter->second);
+		iter = m_bufferMap.erase(iter);
+	}
+	saveTerrainMeta(folderPath);
+	tlog("write %ld dirty buffers, size of the voxel info %ld, %ld buffers in memory",entryList.size(), sizeof(voxelInfo), m_bufferMap.size());
 }
 
-void GameMap::loadTerrain(std::string filePath)
+void GameMap::loadTerrain(std::string folderPath)
 {
-	auto terrainFile = fopen(filePath.c_str(), "rb");
-	size_t index;
-	size_t loadCount = 0;
-	fseek(terrainFile, 0, SEEK_END);
-	size_t buffSize = ftell(terrainFile);
-	fseek(terrainFile, 0, SEEK_SET);
-
-	while(ftell(terrainFile) < buffSize)
+	std::filesystem::path folder(folderPath);
+	std::string legacyPath = folderPath + ".bin";
+	if(!std::filesystem::exists(folder / "terrain.json") && std::filesystem::exists(legacyPath))
 	{
-		voxelInfo * buff = new voxelInfo[GAME_MAX_BUFFER_SIZE* GAME_MAX_BUFFER_SIZE *GAME_MAX_BUFFER_SIZE];
-		fread(&index,sizeof(size_t),1,terrainFile);
-		fread(buff, sizeof(voxelInfo) * GAME_MAX_BUFFER_SIZE* GAME_MAX_BUFFER_SIZE *GAME_MAX_BUFFER_SIZE,1 , terrainFile);
-		m_totalBuffer[index].m_buff = buff;
-		loadCount++;
+		convertLegacyTerrain(legacyPath, folderPath);
 	}
-	tlog("loadCount %ld", loadCount);
+	auto metaPath = (folder / "terrain.json").string();
+	if(!std::filesystem::exists(metaPath))
+	{
+		tlogError("no terrain in %s", folderPath.c_str());
+		return;
+	}
+	auto doc = Tfile::shared()->getJsonObject(metaPath);
+	auto & noiseOffset = doc["NoiseOffset"];
+	x_offset = float(noiseOffset[0].GetDouble());
+	y_offset = float(noiseOffset[1].GetDouble());
+	z_offset = float(noiseOffset[2].GetDouble());
+	m_isTerrainMapped = doc.HasMember("Mapped") && doc["Mapped"].GetBool();
+	//the buffers are read on demand, see getBuffer
+	auto store = std::make_shared<TerrainRegionStore>(folderPath);
+	store->setIsMapped(m_isTerrainMapped);
+	std::atomic_store(&m_regionStore, store);
+	tlog("terrain %s attached, mapped %d", folderPath.c_str(), m_isTerrainMapped);
+}
+
+void GameMap::setIsTerrainMapped(bool isMapped)
+{
+	m_isTerrainMapped = isMapped;
+	auto store = std::atomic_load(&m_regionStore);
+	if(store)
+	{
+		store->setIsMapped(isMapped);
+	}
+}
+
+bool GameMap::isTerrainMapped() const
+{
+	return m_isTerrainMapped;
 }
 
-void GameMap::proceduralGenMapBuffer(size_t buffIDX, size_t buffIDY, size_t buffIDZ)
+bool GameMap::convertLegacyTerrain(std::string legacyPath, std::string folderPath)
 {
-	int buffIndex = buffIDX * (mapBufferSize_Z * mapBufferSize_Y) + buffIDY * (mapBufferSize_Z) + buffIDZ;
-	m_totalBuffer[buffIndex].m_buff = new voxelInfo[GAME_MAX_BUFFER_SIZE* GAME_MAX_BUFFER_SIZE *GAME_MAX_BUFFER_SIZE];
+	auto terrainFile = fopen(legacyPath.c_str(), "rb");
+	if(!terrainFile)
+	{
+		return false;
+	}
+	fseek(terrainFile, 0, SEEK_END);
+	size_t fileSize = ftell(terrainFile);
+	fseek(terrainFile, 0, SEEK_SET);
+	//old layout : (size_t index, raw voxelInfo[64^3]) ...
+	std::vector<TerrainRegionEntry> entryList;
+	std::vector<voxelInfo *> buffList;
+	size_t index;
+	//the old file was a dense array sized by the map
+	int legacySize_Y = ((GAME_MAP_HEIGHT * MAX_BLOCK)/GAME_MAX_BUFFER_SIZE) + 1;
+	int legacySize_Z = ((GAME_MAP_DEPTH * MAX_BLOCK)/GAME_MAX_BUFFER_SIZE) + 1;
+	while(ftell(terrainFile) < fileSize && fread(&index, sizeof(size_t), 1, terrainFile) == 1)
+	{
+		voxelInfo * buff = new voxelInfo[GAME_MAX_BUFFER_SIZE* GAME_MAX_BUFFER_SIZE *GAME_MAX_BUFFER_SIZE];
+		fread(buff, sizeof(voxelInfo) * GAME_MAX_BUFFER_SIZE* GAME_MAX_BUFFER_SIZE *GAME_MAX_BUFFER_SIZE, 1, terrainFile);
+		int x = int(index / (legacySize_Z * legacySize_Y));
+		int y = int((index / legacySize_Z) % legacySize_Y);
+		int z = int(index % legacySize_Z);
+		entryList.push_back(TerrainRegionEntry{x, y, z, buff});
+		buffList.push_back(buff);
+	}
+	fclose(terrainFile);
+	TerrainRegionStore store(folderPath);
+	store.clear();
+	store.setIsMapped(m_isTerrainMapped);
+	store.save(entryList);
+	for(auto buff : buffList)
+	{
+		delete [] buff;
+	}
+	//the old file has no noise offset, keep the current one like the old loader did.
+	saveTerrainMeta(folderPath);
+	tlog("convert %s, %ld buffers", legacyPath.c_str(), buffList.size());
+	return true;
+}
+
+void GameMap::saveTerrainMeta(std::string folderPath)
+{
+	rapidjson::Document doc;
+	doc.SetObject();
+	auto& aloc = doc.GetAllocator();
+	doc.AddMember("Version", 1, aloc);
+	rapidjson::Value noiseOffset(rapidjson::kArrayType);
+	noiseOffset.PushBack(double(x_offset), aloc);
+	noiseOffset.PushBack(double(y_offset), aloc);
+	noiseOffset.PushBack(double(z_offset), aloc);
+	doc.AddMember("NoiseOffset", noiseOffset, aloc);
+	doc.AddMember("Mapped", m_isTerrainMapped, aloc);
+	auto file = fopen((std::filesystem::path(folderPath) / "terrain.json").string().c_str(), "w");
+	size_t buffSize = 65536;
+	char * writeBuffer = static_cast<char*>(malloc(buffSize));
+	rapidjson::FileWriteStream stream(file, writeBuffer, buffSize);
+	rapidjson::PrettyWriter<rapidjson::FileWriteStream> writer(stream);
+	writer.SetIndent('\t', 1);
+	doc.Accept(writer);
+	fclose(file);
+	free(writeBuffer);
+}
+
+void GameMap::proceduralGenMapBuffer(GameMapBuffer * buffer, int buffIDX, int buffIDY, int buffIDZ)
+{
+	buffer->m_buff = new voxelInfo[GAME_MAX_BUFFER_SIZE* GAME_MAX_BUFFER_SIZE *GAME_MAX_BUFFER_SIZE];
+	//the height plane of the whole buffer in one batch
+	std::vector<float> posX(GAME_MAX_BUFFER_SIZE * GAME_MAX_BUFFER_SIZE), posZ(GAME_MAX_BUFFER_SIZE * GAME_MAX_BUFFER_SIZE), heightPlane(GAME_MAX_BUFFER_SIZE * GAME_MAX_BUFFER_SIZE);
+	for(int i = 0; i <GAME_MAX_BUFFER_SIZE;i++) //X
+	{
+		for(int k = 0; k <GAME_MAX_BUFFER_SIZE;k++) //Z
+		{
+			posX[i * GAME_MAX_BUFFER_SIZE + k] = (i + buffIDX * GAME_MAX_BUFFER_SIZE)  * BLOCK_SIZE + m_mapOffset.x;
+			posZ[i * GAME_MAX_BUFFER_SIZE + k] = (k + buffIDZ * GAME_MAX_BUFFER_SIZE)  * BLOCK_SIZE + m_mapOffset.z;
+		}
+	}
+	getHeightBatch(posX.data(), posZ.data(), heightPlane.data(), GAME_MAX_BUFFER_SIZE * GAME_MAX_BUFFER_SIZE);
     //init data
     for(int i = 0; i <GAME_MAX_BUFFER_SIZE;i++) //X
     {
         for(int k = 0; k <GAME_MAX_BUFFER_SIZE;k++) //Z
         {
-            auto targetH = getHeight(vec2((i + buffIDX * GAME_MAX_BUFFER_SIZE)  * BLOCK_SIZE, (k + buffIDZ * GAME_MAX_BUFFER_SIZE)  * BLOCK_SIZE)+ vec2(m_mapOffset.x, m_mapOffset.z));
+            auto targetH = heightPlane[i * GAME_MAX_BUFFER_SIZE + k];
             for(int j = 0; j <GAME_MAX_BUFFER_SIZE;j++) //Y
             {
                 auto currH = (j+ buffIDY * GAME_MAX_BUFFER_SIZE)  * BLOCK_SIZE;
                 float delta = std::clamp ((currH - targetH)  * 0.1f, -1.f, 1.f);
                 unsigned char w =  (delta * 0.5f + 0.5f) * 255.f;
                 int cellIndex = i * GAME_MAX_BUFFER_SIZE * GAME_MAX_BUFFER_SIZE + j * GAME_MAX_BUFFER_SIZE + k;
-                m_totalBuffer[buffIndex].m_buff[cellIndex].w = w;
+                buffer->m_buff[cellIndex].w = w;
             }
         }
     }
@@ -664,12 +956,12 @@ void GameMap::proceduralGenMapBuffer(size_t buffIDX, size_t buffIDY, size_t buff
 				int cellIndex = i * GAME_MAX_BUFFER_SIZE * GAME_MAX_BUFFER_SIZE + j * GAME_MAX_BUFFER_SIZE + k;
 				if (true)
 				{
-					auto x1 = m_totalBuffer[buffIndex].get(i - 1, j, k).w;
-					auto x2 = m_totalBuffer[buffIndex].get(i + 1, j, k).w;
-					auto y1 = m_totalBuffer[buffIndex].get(i, j - 1, k).w;
-					auto y2 = m_totalBuffer[buffIndex].get(i, j + 1, k).w;
-					auto z1 = m_totalBuffer[buffIndex].get(i, j, k - 1).w;
-					auto z2 = m_totalBuffer[buffIndex].get(i, j, k + 1).w;
+					auto x1 = buffer->get(i - 1, j, k).w;
+					auto x2 = buffer->get(i + 1, j, k).w;
+					auto y1 = buffer->get(i, j - 1, k).w;
+					auto y2 = buffer->get(i, j + 1, k).w;
+					auto z1 = buffer->get(i, j, k - 1).w;
+					auto z2 = buffer->get(i, j, k + 1).w;
 					auto gradientVec = vec3(x1 - x2,
 											y1 - y2,
 											z1 - z2);
@@ -677,7 +969,7 @@ void GameMap::proceduralGenMapBuffer(size_t buffIDX, size_t buffIDY, size_t buff
 						vec3::DotProduct(gradientVec.normalized(), vec3(0, -1, 0)), 0.0f, 1.0f);
 					vec3 tmpV3((i + buffIDX * GAME_MAX_BUFFER_SIZE)  * BLOCK_SIZE, (j + buffIDY * GAME_MAX_BUFFER_SIZE)  * BLOCK_SIZE, (k + buffIDZ * GAME_MAX_BUFFER_SIZE)  * BLOCK_SIZE);
 					auto matID = GameMap::shared()->getMat(tmpV3, slope);
-					m_totalBuffer[buffIndex].m_buff[cellIndex].setMat(matID, 0, 0, vec3(1,0, 0));
+					buffer->m_buff[cellIndex].setMat(matID, 0, 0, vec3(1,0, 0));
 				}
 			}
 		}
@@ -693,6 +985,11 @@ GameMapBuffer::GameMapBuffer()
 {
     m_buff = nullptr;
 	isEdit = false;
+	m_isMapped = false;
+	m_chunkRefCount = 0;
+	m_x = 0;
+	m_y = 0;
+	m_z = 0;
 }
 
 voxelInfo GameMapBuffer::get(int theX, int theY, int theZ)
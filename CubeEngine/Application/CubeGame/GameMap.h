@@ -9,8 +9,13 @@
 #include "EngineSrc/Math/vec3.h"
 #include "Math/vec4.h"
 #include "Mesh/VertexData.h"
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <unordered_map>
 namespace tzw {
 class Chunk;
+class TerrainRegionStore;
 
 struct voxelInfo
 {
@@ -44,7 +49,11 @@ struct GameMapBuffer
 	GameMapBuffer();
 	voxelInfo get(int theX, int theY, int theZ);
 	voxelInfo * m_buff;
-	bool isEdit;
+	bool isEdit;//modified since the last save or load
+	bool m_isMapped;//m_buff points into the copy-on-write mapping of the region file, not owned
+	int m_chunkRefCount;//the registered chunks reading it, see retainChunkBuffers
+	int m_x, m_y, m_z;//buffer coordinate
+	std::once_flag m_genFlag;
 };
 class GameMap
 {
@@ -71,6 +80,7 @@ public:
 	vec3 voxelToWorldPos(int x, int y, int z);
 	vec3 worldPosToVoxelPos(vec3 pos);
 	float getHeight(vec2 posXZ);
+	void getHeightBatch(const float * posX, const float * posZ, float * outHeight, int count);
 	vec3 getNormal(vec2 posXZ);
 	int getMat(vec3 pos, float slope);
     MapType getMapType() const;
@@ -78,17 +88,26 @@ public:
 	void setMinHeight(float minHeight);
 	float minHeight();
 	ChunkInfo * getChunkInfo(int x, int y, int z);
+	ChunkInfo * acquireScratchChunkInfo();
+	void releaseScratchChunkInfo(ChunkInfo * info);
 	float edgeFallOffSelect(float lowBound, float upBound, float edgeVal, float val1, float val2, float selectVal);
 	int getTreeId();
 	int getGrassId();
-	GameMapBuffer * m_totalBuffer;
 	vec2 getCenterOfMap();
-	ChunkInfo* fetchFromSource(int chunkX, int chunkY, int chunkZ, int lod);
-	void saveTerrain(std::string filePath);
-	void loadTerrain(std::string filePath);
-	void proceduralGenMapBuffer(size_t buffID_x, size_t buffID_y, size_t buffID_z);
+	void fetchFromSource(int chunkX, int chunkY, int chunkZ, int lod, ChunkInfo * out);
+	void saveTerrain(std::string folderPath);
+	void loadTerrain(std::string folderPath);
+	bool convertLegacyTerrain(std::string legacyPath, std::string folderPath);
+	//read-mostly worlds, the saved buffers are used straight from the mapped region files, see TerrainRegionStore
+	void setIsTerrainMapped(bool isMapped);
+	bool isTerrainMapped() const;
+	//a chunk keeps the buffers it reads on every lod, they are released with its last chunk unless they are edited and not saved yet
+	void retainChunkBuffers(int chunkX, int chunkY, int chunkZ);
+	void releaseChunkBuffers(int chunkX, int chunkY, int chunkZ);
+	void proceduralGenMapBuffer(GameMapBuffer * buffer, int buffID_x, int buffID_y, int buffID_z);
 	vec3 getMapOffset() const;
 private:
+	double blendTerrainLayers(float flat, float bumpyFlat, float mountain, float highMountain, float hill, float type);
     float x_offset,y_offset,z_offset;
     float m_maxHeight;
     float m_ratio;
@@ -100,10 +119,22 @@ private:
     static GameMap * m_instance;
 	int m_treeID;
 	int m_grassID;
-	int mapBufferSize_X;
-	int mapBufferSize_Y;
-	int mapBufferSize_Z;
-	ChunkInfo * m_chunkInfo;
+	GameMapBuffer * getBuffer(int x, int y, int z);
+	//m_bufferMutex has to be held
+	GameMapBuffer * findOrAddBuffer(int buffIDX, int buffIDY, int buffIDZ);
+	static void deleteBuffer(GameMapBuffer * buffer);
+	void clearBuffers();
+	//only the buffers which has been touched, keyed by GameWorld::packChunkKey of the buffer coordinate
+	std::unordered_map<uint64_t, GameMapBuffer *> m_bufferMap;
+	std::mutex m_bufferMutex;
+	void saveTerrainMeta(std::string folderPath);
+	//shared with the workers, swapped by atomic_load/atomic_store
+	std::shared_ptr<TerrainRegionStore> m_regionStore;
+	//the buffers may still point into their mappings
+	std::vector<std::shared_ptr<TerrainRegionStore>> m_retiredStoreList;
+	bool m_isTerrainMapped;
+	std::vector<ChunkInfo *> m_scratchPool;
+	std::mutex m_scratchMutex;
 	vec3 m_mapOffset;
 };
 
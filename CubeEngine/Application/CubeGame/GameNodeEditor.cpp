@@ -65,7 +65,7 @@ enum class PinType
 	static Texture* s_SaveIcon;
 	static Texture * s_HeaderBackground;
 	static Texture * s_RestoreIcon;
-	GameNodeEditor::GameNodeEditor():m_pasteBinNode(nullptr)
+	GameNodeEditor::GameNodeEditor():m_isGraphDirty(true),m_pasteBinNode(nullptr)
 	{
 		m_context = ed::CreateEditor();
 		ed::SetCurrentEditor(m_context);
@@ -85,6 +85,7 @@ enum class PinType
 	{
 		newNode->setNodeEditor(this);
 		m_gameNodes.push_back(newNode);
+		markGraphDirty();
 		if(newNode->getType() == Node_TYPE_TRIGGER)
 		{
 			m_triggerList.push_back(static_cast<KeyTriggerNode *> (newNode));
@@ -130,6 +131,7 @@ void GameNodeEditor::removeNode(GraphNode* node)
 				++i;
 			}
 		}
+		markGraphDirty();
 	}
 
 	void GameNodeEditor::raiseEventToNode(int startAttr, int endAttr)
@@ -322,6 +324,7 @@ void GameNodeEditor::removeNode(GraphNode* node)
 		info.InputId = start_attr;
 		info.OutputId = end_attr;
 		m_links.push_back(info);
+		markGraphDirty();
 		raiseEventToNode(start_attr, end_attr);
 	}
 	void GameNodeEditor::ShowLeftPane(float paneWidth)
@@ -480,13 +483,7 @@ bool GameNodeEditor::onKeyPress(int keyCode)
 
 		}
 	}
-	while(!m_rt_exe_chain.empty())
-	{
-		auto node = m_rt_exe_chain.front();
-		m_rt_exe_chain.pop();
-		node->execute();
-		node->handleExeOut();
-	}
+	runExeChain();
 	return false;
 }
 
@@ -500,13 +497,7 @@ bool GameNodeEditor::onKeyRelease(int keyCode)
 			static_cast<TriggerNode *>(trigger)->handleKeyRelease(keyCode);
 		}
 	}
-	while(!m_rt_exe_chain.empty())
-	{
-		auto node = m_rt_exe_chain.front();
-		m_rt_exe_chain.pop();
-		node->execute();
-		node->handleExeOut();
-	}
+	runExeChain();
 	return false;
 }
 
@@ -584,7 +575,38 @@ std::vector<NodeAttr*> GameNodeEditor::findAllAttrLinksFromAttr(NodeAttr* attr)
 
 void GameNodeEditor::pushToStack(GraphNode* node)
 {
-	m_rt_exe_chain.push(node);
+	if(m_isGraphDirty) compileGraph();
+	int block = m_program.findBlock(node);
+	if(block < 0)
+	{
+		tlogError("node graph: %s is linked from an execute pin and only runs from there", node->name.c_str());
+		return;
+	}
+	m_program.push(block);
+}
+
+void GameNodeEditor::pushExeOutToStack(NodeAttr* exeOut)
+{
+	if(m_isGraphDirty) compileGraph();
+	int block = m_program.findBlock(exeOut);
+	if(block >= 0) m_program.push(block);
+}
+
+void GameNodeEditor::runExeChain()
+{
+	m_program.run();
+}
+
+void GameNodeEditor::markGraphDirty()
+{
+	m_isGraphDirty = true;
+}
+
+void GameNodeEditor::compileGraph()
+{
+	m_isGraphDirty = false;
+	NodeProgramBuilder builder(m_program, m_gameNodes, m_links);
+	builder.build();
 }
 
 void GameNodeEditor::clearAll()
@@ -600,6 +622,9 @@ void GameNodeEditor::clearAll()
 	m_gameNodes.clear();
 	m_links.clear();
 	m_triggerList.clear();
+	//the program points at the deleted attrs
+	m_program.clear();
+	markGraphDirty();
 }
 
 void GameNodeEditor::onPressButtonNode(GraphNode* buttonNode)
@@ -608,13 +633,7 @@ void GameNodeEditor::onPressButtonNode(GraphNode* buttonNode)
 	{
 		static_cast<ButtonPartNode *>(buttonNode)->triggerPress();
 	}
-	while(!m_rt_exe_chain.empty())
-	{
-		auto node = m_rt_exe_chain.front();
-		m_rt_exe_chain.pop();
-		node->execute();
-		node->handleExeOut();
-	}
+	runExeChain();
 }
 
 void GameNodeEditor::onReleaseButtonNode(GraphNode* buttonNode)
@@ -623,13 +642,7 @@ void GameNodeEditor::onReleaseButtonNode(GraphNode* buttonNode)
 	{
 		static_cast<ButtonPartNode *>(buttonNode)->triggerRelease();
 	}
-	while(!m_rt_exe_chain.empty())
-	{
-		auto node = m_rt_exe_chain.front();
-		m_rt_exe_chain.pop();
-		node->execute();
-		node->handleExeOut();
-	}
+	runExeChain();
 }
 
 void GameNodeEditor::onReleaseSwitchNode(GraphNode* buttonNode)
@@ -638,13 +651,7 @@ void GameNodeEditor::onReleaseSwitchNode(GraphNode* buttonNode)
 	{
 		static_cast<SwitchNode *>(buttonNode)->triggerRelease();
 	}
-	while(!m_rt_exe_chain.empty())
-	{
-		auto node = m_rt_exe_chain.front();
-		m_rt_exe_chain.pop();
-		node->execute();
-		node->handleExeOut();
-	}
+	runExeChain();
 }
 
 	GraphNode* GameNodeEditor::createNodeByClass(int classID)
@@ -775,6 +782,7 @@ void GameNodeEditor::newNodeEditorDraw(bool* isOpen)
 							if(ImGui::InputInt(u8"Ĭֵ", &value))
 							{
 								attr->m_localAttrValue.setInt(value);
+								markGraphDirty();
 							}
                         	ImGui::PopItemWidth();
                         }
@@ -786,6 +794,7 @@ void GameNodeEditor::newNodeEditorDraw(bool* isOpen)
 							if(ImGui::InputFloat(u8"Ĭֵ", &value))
 							{
 								attr->m_localAttrValue.setFloat(value);
+								markGraphDirty();
 							}
                         	ImGui::PopItemWidth();
                         }
@@ -800,6 +809,7 @@ void GameNodeEditor::newNodeEditorDraw(bool* isOpen)
 							if(isInputName)
 							{
 								attr->m_localAttrValue.setString(a);
+								markGraphDirty();
 							}
                         }
 						break;
@@ -824,6 +834,7 @@ void GameNodeEditor::newNodeEditorDraw(bool* isOpen)
                         	if(isClicked)
                         	{
                         		attr->m_localAttrValue.setInt(value);
+                        		markGraphDirty();
                         	}
                         }
 						break;
@@ -913,6 +924,7 @@ void GameNodeEditor::newNodeEditorDraw(bool* isOpen)
                 		
 	                    // Since we accepted new link, lets add one to our list of links.
 	                    m_links.push_back(info);
+	                    markGraphDirty();
 
 	                    // Draw new link.
 	                    ed::Link(m_links.back().Id, m_links.back().InputId, m_links.back().OutputId);
@@ -953,6 +965,7 @@ void GameNodeEditor::newNodeEditorDraw(bool* isOpen)
                     if (m_links[i].Id == deletedLinkId.Get())
                     {
                         m_links.erase(m_links.begin() + i);
+                        markGraphDirty();
                         break;
                     }
                 }
@@ -4,7 +4,7 @@
 #include "rapidjson/document.h"
 #include "Base/GuidObj.h"
 #include "TriggerNode.h"
-#include <queue>
+#include "NodeProgram.h"
 #include "NodeEditor/Include/imgui_node_editor.h"
 namespace tzw {
 
@@ -44,7 +44,15 @@ public:
 	GraphNode * findNodeLinksFromAttr(NodeAttr * attr);
 	NodeAttr * findAttrLinksFromAttr(NodeAttr * attr);
 	std::vector<NodeAttr *> findAllAttrLinksFromAttr(NodeAttr * attr);
+	//queue a behaviour which no execute pin links to
 	void pushToStack(GraphNode * node);
+	//queue the behaviours linked to an execute pin of a trigger or a part
+	void pushExeOutToStack(NodeAttr * exeOut);
+	//run the queued behaviours and the ones they lead to, in the order of the old execution queue
+	void runExeChain();
+	//the graph runs as a NodeProgram built by compileGraph, any edit of the nodes, links or local values marks it stale
+	void markGraphDirty();
+	void compileGraph();
 	void clearAll();
 	void navigateToContent();
 	void onPressButtonNode(GraphNode * buttonNode);
@@ -52,7 +60,8 @@ public:
 	void onReleaseSwitchNode(GraphNode * buttonNode);
 	GraphNode * createNodeByClass(int classID);
 protected:
-	std::queue<GraphNode *> m_rt_exe_chain;
+	NodeProgram m_program;
+	bool m_isGraphDirty;
 	std::vector<GraphNode * > m_gameNodes;
 	std::vector<LinkInfo> m_links;
 	std::vector<TriggerNode * > m_triggerList;
@@ -5,12 +5,18 @@
 #include "3D/Model/Model.h"
 #include "3D/Primitive/CubePrimitive.h"
 #include "Rendering/Renderer.h"
+#include "Rendering/InstancingMgr.h"
+#include "Mesh/InstancedMesh.h"
+#include "GamePart.h"
 
 namespace tzw
 {
 	GamePartRenderNode::GamePartRenderNode(GameItem * item, GamePart * partInstance)
 	{
 		m_isHovering = false;
+		m_isSlotAcquired = false;
+		m_slotGroup = nullptr;
+		m_isInstanceDirty = false;
 		m_state = "default";
 		m_isNeedUpdateRenderInfo = true;
 		m_item = item;
@@ -23,23 +29,25 @@ namespace tzw
 		m_localAABB = GamePartRenderMgr::shared()->getPartLocalAABB(m_visualInfo);
 	}
 
+	GamePartRenderNode::~GamePartRenderNode()
+	{
+		releaseInstanceSlots();
+	}
+
 	void GamePartRenderNode::getCommandForInstanced(std::vector<InstanceRendereData> & commandList)
 	{
 		if(!m_isVisible) return;
 		if(m_infoList.empty() || m_isNeedUpdateRenderInfo)
 		{
+			//the slots were made from the old list
+			releaseInstanceSlots();
 			m_infoList.clear();
 			m_isNeedUpdateRenderInfo = false;
 			GamePartRenderMgr::shared()->getRenderInfo(true, this, m_visualInfo, m_partSurface, m_infoList);
 		}
+		InstanceData instance = getInstanceData();
 		for(auto info : m_infoList)
 		{
-		
-			InstanceData instance;
-			vec3 normal = vec3(0, 1,0);
-			auto mat = getTransform();
-			instance.transform = mat;
-			instance.extraInfo = (m_isHovering?vec4(0.9, 0.8, 0.1, 1.0): m_color);
 			auto data = InstanceRendereData();
 			data.m_mesh = info.mesh;
 			data.material = info.material;
@@ -48,10 +56,37 @@ namespace tzw
 		}
 	}
 
+	void GamePartRenderNode::visit(std::vector<Node*>& directDrawList)
+	{
+		Node::visit(directDrawList);
+		updateInstanceSlots();
+	}
+
+	void GamePartRenderNode::onTransformChanged()
+	{
+		Drawable3D::onTransformChanged();
+		m_isInstanceDirty = true;
+	}
+
+	void GamePartRenderNode::setIsVisible(bool isVisible)
+	{
+		Drawable3D::setIsVisible(isVisible);
+		//a hidden node is not visited any more, so give the slots back right now
+		if(!isVisible)
+		{
+			releaseInstanceSlots();
+		}
+	}
+
+	void GamePartRenderNode::onRemovedFromOctree()
+	{
+		releaseInstanceSlots();
+	}
+
 	void GamePartRenderNode::setColor(vec4 newColor)
 	{
 		m_color = newColor;
-		m_isNeedUpdateRenderInfo;
+		m_isInstanceDirty = true;
 	}
 
 	void GamePartRenderNode::submitDrawCmd(RenderFlag::RenderStageType requirementType, RenderQueues * queues, int requirementArg)
@@ -101,6 +136,10 @@ namespace tzw
 		m_renderMode = mode;
 		updateRenderMode();
 		m_isNeedUpdateRenderInfo = true;
+		if(m_renderMode != RenderMode::COMMON)
+		{
+			releaseInstanceSlots();
+		}
 	}
 	void GamePartRenderNode::setSpecifiedMat(Material* mat)
 	{
@@ -132,7 +171,11 @@ namespace tzw
 	}
 	void GamePartRenderNode::setIsHovering(bool hovering)
 	{
-		m_isHovering = hovering;
+		if(m_isHovering != hovering)
+		{
+			m_isHovering = hovering;
+			m_isInstanceDirty = true;
+		}
 	}
 	void GamePartRenderNode::updateRenderMode()
 	{
@@ -150,5 +193,57 @@ namespace tzw
 		}
 		
 	}
+
+	InstanceData GamePartRenderNode::getInstanceData()
+	{
+		InstanceData instance;
+		instance.transform = getTransform();
+		instance.extraInfo = (m_isHovering?vec4(0.9, 0.8, 0.1, 1.0): m_color);
+		return instance;
+	}
+
+	void GamePartRenderNode::updateInstanceSlots()
+	{
+		if(!m_isVisible || !m_isValid || m_renderMode != RenderMode::COMMON || getOctNodeIndex() < 0)
+		{
+			releaseInstanceSlots();
+			return;
+		}
+		const void * group = m_partParent ? m_partParent->m_parent : nullptr;
+		if(!m_isSlotAcquired || m_isNeedUpdateRenderInfo || group != m_slotGroup)
+		{
+			releaseInstanceSlots();
+			m_infoList.clear();
+			m_isNeedUpdateRenderInfo = false;
+			GamePartRenderMgr::shared()->getRenderInfo(true, this, m_visualInfo, m_partSurface, m_infoList);
+			InstanceData instance = getInstanceData();
+			for(auto & info : m_infoList)
+			{
+				m_slotList.push_back(InstancingMgr::shared()->addSlot(group, info.material, info.mesh, instance));
+			}
+			m_isSlotAcquired = true;
+			m_slotGroup = group;
+			m_isInstanceDirty = false;
+		}
+		else if(m_isInstanceDirty)
+		{
+			InstanceData instance = getInstanceData();
+			for(auto slot : m_slotList)
+			{
+				InstancingMgr::shared()->updateSlot(slot, instance);
+			}
+			m_isInstanceDirty = false;
+		}
+	}
+
+	void GamePartRenderNode::releaseInstanceSlots()
+	{
+		for(auto slot : m_slotList)
+		{
+			InstancingMgr::shared()->removeSlot(slot);
+		}
+		m_slotList.clear();
+		m_isSlotAcquired = false;
+	}
 }
 
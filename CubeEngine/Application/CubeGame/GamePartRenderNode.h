@@ -6,6 +6,7 @@ namespace tzw
 {
 class PartSurface;
 class GamePart;
+struct InstanceSlot;
 class GamePartRenderNode : public Drawable3D
 	{
 	public:
@@ -16,7 +17,12 @@ class GamePartRenderNode : public Drawable3D
 			NO_INSTANCING,
 		};
 		GamePartRenderNode(GameItem * item, GamePart * partInstance);
+		~GamePartRenderNode();
 		void getCommandForInstanced(std::vector<InstanceRendereData> & commandList) override;
+		void visit(std::vector<Node*>&directDrawList) override;
+		void onTransformChanged() override;
+		void setIsVisible(bool isVisible) override;
+		void onRemovedFromOctree() override;
 		void setColor(vec4 newColor) override;
 		void submitDrawCmd(RenderFlag::RenderStageType requirementType, RenderQueues * queues, int requirementArg) override;
 		VisualInfo * getVisualInfo();
@@ -35,6 +41,10 @@ class GamePartRenderNode : public Drawable3D
 	private:
 		std::string m_state;
 		void updateRenderMode();
+		InstanceData getInstanceData();
+		//keep the persistent instances of the COMMON mode in sync, only touch them when something changed
+		void updateInstanceSlots();
+		void releaseInstanceSlots();
 		GameItem * m_item;
 		RenderMode m_renderMode;
 		VisualInfo m_visualInfo;
@@ -45,7 +55,11 @@ class GamePartRenderNode : public Drawable3D
 		Material * m_specifiedMat;
 		GamePart * m_partParent;
 		bool m_isHovering;
-		
+		std::vector<InstanceSlot *> m_slotList;
+		bool m_isSlotAcquired;
+		//the island the slots were acquired for, the pools are grouped by island
+		const void * m_slotGroup;
+		bool m_isInstanceDirty;
 	};
 
 }
@@ -26,6 +26,7 @@
 #include "Engine/WorkerThreadSystem.h"
 #include "LoadingUI.h"
 #include "Shader/ShaderMgr.h"
+#include "Scene/OctreeScene.h"
 #include <filesystem>
 
 #include "Utility/file/JsonUtility.h"
@@ -91,8 +92,6 @@ void GameWorld::createWorld(Scene *scene, int width, int depth, int height, floa
 	float offsetZ =  depth * MAX_BLOCK * BLOCK_SIZE / 2; // notice the signed!
 	 
 	//m_mapOffset = vec3(offsetX, 0 ,offsetZ);
-	 
-	initChunk();
     
 	 
 }
@@ -107,8 +106,7 @@ void GameWorld::createWorldFromFile(Scene* scene, int width, int depth, int heig
     m_height = height;
 	GameMap::shared()->init(ratio, m_width, m_depth, m_height);
 	auto worldLocation = getWorldLocation();
-	GameMap::shared()->loadTerrain((worldLocation / "Terrain.bin").string());
-	initChunk();
+	GameMap::shared()->loadTerrain((worldLocation / "Terrain").string());
 }
 
 vec3 GameWorld::worldToGrid(vec3 world)
@@ -148,14 +146,35 @@ void GameWorld::onFrameUpdate(float delta)
 	BuildingSystem::shared()->update(delta);
 	AssistDrawSystem::shared()->handleDraw(delta);
 	BulletMgr::shared()->handleDraw(delta);
+	flushDirtyChunks();
+}
+
+void GameWorld::markChunkDirty(Chunk *chunk)
+{
+    m_dirtyChunkList.insert(chunk);
+}
+
+void GameWorld::flushDirtyChunks()
+{
+    for(auto iter = m_dirtyChunkList.begin(); iter != m_dirtyChunkList.end();)
+    {
+        if((*iter)->flushDirty())
+        {
+            iter = m_dirtyChunkList.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
 }
 
 Chunk *GameWorld::createChunk(int x, int y, int z)
 {
-    auto chunkA = new Chunk(x,0,z);
-    m_scene->addNode(chunkA);
-    m_chunkList.push_back(chunkA);
-    return chunkA;
+    auto chunk = new Chunk(x,y,z);
+    m_chunkMap[packChunkKey(x, y, z)] = chunk;
+    GameMap::shared()->retainChunkBuffers(x, y, z);
+    return chunk;
 }
 
 void GameWorld::startGame(WorldInfo worldInfo)
@@ -268,7 +287,7 @@ void GameWorld::saveGame(std::string filePath)
 	savePlayerInfo();
 
 	//save terrain
-	GameMap::shared()->saveTerrain((worldLocation / "Terrain.bin").string());
+	GameMap::shared()->saveTerrain((worldLocation / "Terrain").string());
 }
 
 bool GameWorld::onKeyPress(int keyCode)
@@ -312,9 +331,9 @@ void GameWorld::loadChunksAroundPlayer()
     auto pos = m_player->getPos();
 	auto vPos = GameMap::shared()->worldPosToVoxelPos(pos);
 	auto chunkPos = vPos - vec3(LOD_SHIFT);//chunk Pos Voxel posһLODƫ
-    int posX = (chunkPos.x) / (MAX_BLOCK);
+    int posX = floor(chunkPos.x / MAX_BLOCK);
 	 
-    int posZ = (chunkPos.z) / (MAX_BLOCK);
+    int posZ = floor(chunkPos.z / MAX_BLOCK);
 	int range = ceil(150.0f / (MAX_BLOCK * BLOCK_SIZE));
     for(int i =posX - range;i<=posX + range;i++)
     {
@@ -322,10 +341,7 @@ void GameWorld::loadChunksAroundPlayer()
         {
             for( int k = posZ - range; k <= posZ + range; k++)
             {
-                if(i < 0 || i >= m_width || j < 0 || j >= m_height || k < 0 || k >= m_depth)
-                    continue;
-				 
-                auto targetChunk = m_chunkArray[i][j][k];
+                auto targetChunk = getOrCreateChunk(i, j, k);
 				m_readyToLoadArray.push_back(targetChunk);
 				 
                 auto findResult = m_tempArray.find(targetChunk);
@@ -335,19 +351,21 @@ void GameWorld::loadChunksAroundPlayer()
                     m_tempArray.erase(findResult);
                 }else
                 {
-                    m_activedChunkList.insert(m_chunkArray[i][j][k]);
+                    m_activedChunkList.insert(targetChunk);
                 }
             }
         }
     }
     for(Chunk* i:m_tempArray)
     {
-        i->unload();
     	if(i->getParent())
     	{
     		i->removeFromParent();
     	}
+        i->unload();
+        m_activedChunkList.erase(i);
     }
+    evictFarChunks(posX, posZ, range + CHUNK_EVICT_MARGIN);
 	std::sort(m_readyToLoadArray.begin(), m_readyToLoadArray.end(),[&](Chunk * left, Chunk * right)
 	{
 		float distl = left->getPos().distance(m_player->getPos());
@@ -357,13 +375,14 @@ void GameWorld::loadChunksAroundPlayer()
 	);
 	for(Chunk * i :m_readyToLoadArray)
 	{
-		if(i->getPos().distance(m_player->getPos()) > 50)
+		float dist = i->getPos().distance(m_player->getPos());
+		if(dist > 50)
 		{
-			i->load(1);	
+			i->load(1, dist);
 		}
 		else
 		{
-			i->load(0);
+			i->load(0, dist);
 		}
 		if(!i->getParent())
 		{
@@ -388,9 +407,10 @@ void GameWorld::init()
 
 Chunk *GameWorld::getChunk(int x, int y, int z)
 {
-    if(x >=0 && x <m_width && z >=0 && z <m_depth && y >=0 && y < m_height)
+    auto iter = m_chunkMap.find(packChunkKey(x, y, z));
+    if(iter != m_chunkMap.end())
     {
-        return m_chunkArray[x][y][z];
+        return iter->second;
     }
     else
     {
@@ -398,10 +418,55 @@ Chunk *GameWorld::getChunk(int x, int y, int z)
     }
 }
 
+Chunk *GameWorld::getNeighborChunk(const Chunk *chunk, int offsetX, int offsetY, int offsetZ)
+{
+    return getChunk(chunk->m_x + offsetX, chunk->m_y + offsetY, chunk->m_z + offsetZ);
+}
+
+uint64_t GameWorld::packChunkKey(int x, int y, int z)
+{
+    //21 bits per axis, biased so the negative coordinates are fine too.
+    const uint64_t mask = (1 << 21) - 1;
+    const int bias = 1 << 20;
+    return (uint64_t(x + bias) & mask) << 42 | (uint64_t(y + bias) & mask) << 21 | (uint64_t(z + bias) & mask);
+}
+
+void GameWorld::evictFarChunks(int centerX, int centerZ, int range)
+{
+    std::vector<Chunk *> evictList;
+    for(auto & iter : m_chunkMap)
+    {
+        Chunk * chunk = iter.second;
+        //the chunk whose job is still on a worker can't be deleted, try again next time.
+        if(chunk->m_currenState != Chunk::State::INVALID || m_activedChunkList.count(chunk))
+            continue;
+        if(abs(chunk->m_x - centerX) > range || abs(chunk->m_z - centerZ) > range)
+        {
+            evictList.push_back(chunk);
+        }
+    }
+    for(Chunk * chunk : evictList)
+    {
+        m_chunkMap.erase(packChunkKey(chunk->m_x, chunk->m_y, chunk->m_z));
+        releaseChunk(chunk);
+    }
+}
+
+void GameWorld::releaseChunk(Chunk *chunk)
+{
+    if(chunk->getParent())
+    {
+        chunk->removeFromParent();
+    }
+    g_GetCurrScene()->getOctreeScene()->removeObj(chunk);
+    m_dirtyChunkList.erase(chunk);
+    GameMap::shared()->releaseChunkBuffers(chunk->m_x, chunk->m_y, chunk->m_z);
+    delete chunk;
+}
+
 GameWorld::GameWorld()
 {
     EventMgr::shared()->addFixedPiorityListener(this);
-    memset(m_chunkArray, 0, 128 * 128 * 16 * sizeof(Chunk *));
     m_currentState = GAME_STATE_SPLASH;
 }
 
@@ -480,23 +545,6 @@ void GameWorld::prepare()
 	}));
 }
 
-void GameWorld::initChunk()
-{
-    for(int i = 0;i< m_width;i++)
-    {
-        for(int j=0;j<m_height;j++)
-        {
-            for(int k = 0; k < m_depth; k++)
-            {
-                auto chunk = new Chunk(i,j,k);
-                m_chunkList.push_back(chunk);
-				 
-                m_chunkArray[i][j][k] = chunk;	 
-            }
-        }
-    }
-}
-
 GameUISystem *GameWorld::getMainMenu() const
 {
     return m_mainMenu;
@@ -504,10 +552,27 @@ GameUISystem *GameWorld::getMainMenu() const
 
 void GameWorld::unloadGame()
 {
+    //take the chunks out before purge, a load job still on a worker is waited for, the remesh ones let go of the chunk.
+    for(auto & iter : m_chunkMap)
+    {
+        Chunk * chunk = iter.second;
+        WorkerThreadSystem::shared()->waitOrder(chunk);
+        releaseChunk(chunk);
+    }
+    m_chunkMap.clear();
+    m_dirtyChunkList.clear();
     m_mainRoot->purgeAllChildren();
     m_activedChunkList.clear();
-    m_chunkList.clear();
-	memset(m_chunkArray, 0, 128 * 128 * 16 * sizeof(Chunk *));
+}
+
+bool GameWorld::isAnyChunkBusy() const
+{
+    for(auto & iter : m_chunkMap)
+    {
+        if(iter.second->isBusy())
+            return true;
+    }
+    return false;
 }
 
 int GameWorld::getCurrentState() const
@@ -9,6 +9,7 @@
 #include "GameUISystem.h"
 #include "GameConfig.h"
 #include <set>
+#include <unordered_map>
 namespace tzw {
 
 #define GAME_STATE_MAIN_MENU 0
@@ -35,9 +36,14 @@ public:
     vec3 worldToGrid(vec3 world);
     vec3 gridToChunk(vec3 grid);
     Chunk * getChunk(int x,int y,int z);
+    Chunk * getNeighborChunk(const Chunk * chunk, int offsetX, int offsetY, int offsetZ);
+	//21 bits per axis, the map buffers are keyed the same way
+	static uint64_t packChunkKey(int x, int y, int z);
     CubePlayer *getPlayer() const;
     void setPlayer(CubePlayer *player);
     Chunk * getOrCreateChunk(int x,int y, int z);
+    //the dirty chunks are remeshed once per frame, so all the edits in one frame share a single remesh
+    void markChunkDirty(Chunk * chunk);
 	void onFrameUpdate(float delta) override;
     Chunk * createChunk(int x,int y,int z);
     void startGame(WorldInfo worldInfo);
@@ -48,6 +54,7 @@ public:
     GameUISystem *getMainMenu() const;
     void unloadGame();
     int getCurrentState() const;
+    bool isAnyChunkBusy() const;
     void setCurrentState(const int &currentState);
     Node *getMainRoot() const;
     void setMainRoot(Node *mainRoot);
@@ -61,16 +68,19 @@ private:
     Node * m_mainRoot;
     int m_currentState;
     int m_width, m_depth, m_height;
-    Chunk * m_chunkArray[CUBE_MAP_SIZE][16][CUBE_MAP_SIZE];
+    //only the chunks which has been visited, keyed by packChunkKey
+    std::unordered_map<uint64_t, Chunk *> m_chunkMap;
     Scene  * m_scene;
     CubePlayer * m_player;
-    std::vector<Chunk*> m_chunkList;
     static GameWorld *m_instance;
     GameWorld();
     std::set<Chunk*> m_activedChunkList;
+    std::set<Chunk*> m_dirtyChunkList;
     GameUISystem * m_mainMenu;
 	void prepare();
-	void initChunk();
+	void evictFarChunks(int centerX, int centerZ, int range);
+	void releaseChunk(Chunk * chunk);
+	void flushDirtyChunks();
 	WorldInfo m_currWorldInfo;
 };
 
@@ -29,14 +29,15 @@ namespace tzw
 		m_type = Type::USER_PTR;
 	}
 
-	NodeAttrValuePrimitive::NodeAttrValuePrimitive(std::string val)
+	NodeAttrValuePrimitive::NodeAttrValuePrimitive(const std::string* val)
 	{
-		m_strVal = val;
+		str_val = val;
 		m_type = Type::STRING;
 	}
 
 	NodeAttrValuePrimitive::NodeAttrValuePrimitive()
 	{
+		usrPtr = nullptr;
 		m_type = Type::VOID;
 	}
 
@@ -57,7 +58,7 @@ namespace tzw
 
 	std::string& NodeAttrValue::getStr()
 	{
-		return m_list[0].m_strVal;
+		return m_strVal;
 	}
 
 	void* NodeAttrValue::getUsrPtr()
@@ -99,8 +100,9 @@ namespace tzw
 
 	void NodeAttrValue::setString(std::string newStr)
 	{
+		m_strVal = newStr;
 		m_list.clear();
-		m_list.push_back(NodeAttrValuePrimitive(newStr));
+		m_list.push_back(NodeAttrValuePrimitive(&m_strVal));
 	}
 
 	NodeAttrValuePrimitive NodeAttrValue::getFirst()
@@ -111,56 +113,8 @@ namespace tzw
 	NodeAttr::NodeAttr()
 	{
 		dataType = DataType::DATA;
-		m_localAttrValue = NodeAttrValue();
 		acceptValueType = AcceptValueType::ANY;
 	}
-	//ֵ
-	NodeAttrValue NodeAttr::eval()
-	{
-		auto nodeEditor = m_parent->getNodeEditor();
-		
-		if(this->dataType ==DataType::RETURN_VALUE)//is a return value, must execute
-		{
-			//all pass
-			return (m_parent)->execute();
-		}
-		else
-		{
-			auto attr = nodeEditor->findAttrLinksFromAttr(this);
-			if(attr)
-			{
-				return attr->eval();
-			}
-			else 
-			{
-				return m_localAttrValue;
-			}
-		}
-
-	}
-
-	NodeAttr* NodeAttr::evalRef()
-	{
-		auto nodeEditor = m_parent->getNodeEditor();
-		
-		if(this->dataType ==DataType::RETURN_VALUE)//is a return value, must execute
-		{
-			//all pass
-			return this;
-		}
-		else
-		{
-			auto attr = nodeEditor->findAttrLinksFromAttr(this);
-			if(attr)
-			{
-				return attr->evalRef();
-			}
-			else 
-			{
-				return this;
-			}
-		}
-	}
 
 	NodeAttr* GraphNode::addIn(std::string attrName)
 	{
@@ -171,6 +125,7 @@ namespace tzw
 		attr->type = NodeAttr::Type::INPUT_ATTR;
 		attr->m_parent = this;
 		m_inAttr.push_back(attr);
+		if(m_nodeEditor) m_nodeEditor->markGraphDirty();
 		return attr;
 	}
 
@@ -190,6 +145,7 @@ namespace tzw
 		attr->type = NodeAttr::Type::OUTPUT_ATTR;
 		m_outAttr.push_back(attr);
 		attr->m_parent = this;
+		if(m_nodeEditor) m_nodeEditor->markGraphDirty();
 		return attr;
 	}
 
@@ -455,14 +411,8 @@ namespace tzw
 		partDocObj.AddMember("InAttrList",inAttrListObj, allocator);
 	}
 
-	NodeAttrValue GraphNode::execute()
+	void GraphNode::compile(NodeProgramBuilder& builder)
 	{
-		return NodeAttrValue();
-	}
-
-	void GraphNode::handleExeOut()
-	{
-		
 	}
 
 	int GraphNode::getType()
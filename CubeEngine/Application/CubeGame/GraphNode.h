@@ -12,6 +12,7 @@
 #include "GraphNodeInfo.h"
 namespace tzw {
 struct GraphNode;
+class NodeProgramBuilder;
 
 struct NodeAttrValuePrimitive
 {
@@ -26,17 +27,24 @@ struct NodeAttrValuePrimitive
 	NodeAttrValuePrimitive(int val);
 	NodeAttrValuePrimitive(float val);
 	NodeAttrValuePrimitive(void * val);
-	NodeAttrValuePrimitive(std::string val);
+	NodeAttrValuePrimitive(const std::string * val);
 	NodeAttrValuePrimitive();
 	Type m_type;
-	int int_val;
-	float float_val;
-	void * usrPtr;
-	std::string m_strVal;
+	union
+	{
+		int int_val;
+		float float_val;
+		void * usrPtr;
+		//the text is owned by the NodeAttrValue it was set on
+		const std::string * str_val;
+	};
 };
 struct NodeAttrValue
 {
 	NodeAttrValue();
+	//a string primitive points into m_strVal, so a value is never copied
+	NodeAttrValue(const NodeAttrValue &) = delete;
+	NodeAttrValue & operator=(const NodeAttrValue &) = delete;
 	int getInt();
 	float getFloat();
 	std::string& getStr();
@@ -48,6 +56,8 @@ struct NodeAttrValue
 	void setString(std::string newStr);
 	NodeAttrValuePrimitive getFirst();
 	std::vector<NodeAttrValuePrimitive> m_list;
+private:
+	std::string m_strVal;
 };
 	
 struct NodeAttr
@@ -81,8 +91,6 @@ struct NodeAttr
 	DataType dataType;
 	AcceptValueType acceptValueType;
 	NodeAttr();
-	NodeAttrValue eval();
-	NodeAttr* evalRef();
 	NodeAttrValue m_localAttrValue{};
 	GraphNode * m_parent;
 };
@@ -128,8 +136,8 @@ public:
 	virtual void load(rapidjson::Value& partData);
 	virtual void dump(rapidjson::Value& partDocObj,
 	                rapidjson::Document::AllocatorType& allocator);
-	virtual NodeAttrValue execute();
-	virtual void handleExeOut();
+	//emit the instructions of the node when it is reached through an execute pin
+	virtual void compile(NodeProgramBuilder & builder);
 	int m_nodeID;
 	vec2 m_origin;
 	bool isShowed;
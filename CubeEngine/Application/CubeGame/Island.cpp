@@ -45,6 +45,10 @@ Island::Island(vec3 pos, Vehicle * vehicle)
 	m_buildingRotate = Quaternion();
 	m_enablePhysics = false;
 	m_isStatic = false;
+	m_mass = 0.0f;
+	m_isPrincipalDirty = false;
+	m_isLocalAABBDirty = false;
+	m_isPhysicsDirty = false;
 	setVehicle(vehicle);
 }
 
@@ -59,6 +63,7 @@ Island::~Island()
 	{
 		PhysicsMgr::shared()->removeRigidBody(m_rigid);
 	}
+	BuildingSystem::shared()->removePhysicsDirtyIsland(this);
 	delete m_rigid;
 }
 
@@ -71,6 +76,12 @@ Island::insertNoUpdatePhysics(GamePart* part)
 	m_partList.push_back(part);
 	part->m_parent = this;
 	m_node->addChild(part->getNode());
+	m_attachmentGrid.add(part);
+	if(part->getType() != GamePartType::GAME_PART_LIFT)
+	{
+		m_mass += part->getMass();
+	}
+	addPartShape(part);
 	part->setVehicle(m_vehicle);
 	if(part->isConstraint())
 	{
@@ -83,47 +94,25 @@ void Island::insert(GamePart* part)
 {
 	insertNoUpdatePhysics(part);
 	//ԣĽҲ趼ס
-	std::vector<Attachment * > attachmentList;
-	for(auto anyPart :m_partList)
-	{
-		if(part != anyPart) 
-		{
-			for(int i = 0; i< anyPart->getAttachmentCount(); i++)
-			{
-				auto attach = anyPart->getAttachment(i);
-				if(!attach->m_connected) 
-				{
-					attachmentList.push_back(attach);
-				}
-			}
-		}
-	}
 	int count = 0;
 	for(int i = 0; i < part->getAttachmentCount(); i++)
 	{
 		auto selfAttach = part->getAttachment(i);
 		if(!selfAttach->m_connected)
 		{
-			for(auto attach : attachmentList)
+			vec3 p1,n1,u1;
+			selfAttach->getAttachmentInfo(p1, n1, u1);
+			auto attach = m_attachmentGrid.findFree(p1, part);
+			if(attach)
 			{
-				if(!attach->m_connected)
-				{
-					vec3 p1,n1,u1;
-					selfAttach->getAttachmentInfo(p1, n1, u1);
-					vec3 p2,n2,u2;
-					attach->getAttachmentInfo(p2, n2, u2);
-					if(p1.distance(p2) < 0.001)
-					{
-						selfAttach->m_connected = attach;
-						attach->m_connected = selfAttach;
-						count += 1;
-					}
-				}
+				selfAttach->m_connected = attach;
+				attach->m_connected = selfAttach;
+				count += 1;
 			}
 		}
 	}
 	tlog("extra connected Num %d", count);
-	updatePhysics();
+	requestUpdatePhysics();
 	updateNeighborConstraintPhysics();
 }
 
@@ -131,17 +120,27 @@ void Island::insertAndAdjustAttach(GamePart * part, Attachment * attach, int att
 {
 	insertNoUpdatePhysics(part);
 	part->attachToOtherIslandByAlterSelfPart(attach, attachIndex);
+	m_attachmentGrid.update(part);
+	removePartShape(part);
+	addPartShape(part);
 	//we need update self physics rigidbody and connected constraint
-	updatePhysics();
+	requestUpdatePhysics();
 	updateNeighborConstraintPhysics();
 }
 
 void Island::remove(GamePart* part)
 {
 	auto result = std::find(m_partList.begin(), m_partList.end(), part);
-	if (result != m_partList.end()) {
+	bool found = result != m_partList.end();
+	if (found) {
 	m_partList.erase(result);
 	}
+	m_attachmentGrid.remove(part);
+	if (found && part->getType() != GamePartType::GAME_PART_LIFT)
+	{
+		m_mass -= part->getMass();
+	}
+	removePartShape(part);
 	part->m_parent = this;
 	//break the connect
 	for(int i =0; i< part->getAttachmentCount(); i++)
@@ -184,7 +183,7 @@ void Island::remove(GamePart* part)
 	//we need update self rigid body physics related
 	if(!m_partList.empty())
 	{
-		updatePhysics();
+		requestUpdatePhysics();
 	}
 	updateNeighborConstraintPhysics();
 }
@@ -192,6 +191,18 @@ void Island::remove(GamePart* part)
 void Island::removeAll()
 {
 	m_partList.clear();
+	m_attachmentGrid.clear();
+	m_mass = 0.0f;
+	if(m_compound_shape)
+	{
+		for(int i = m_compound_shape->getChildCount() - 1; i >= 0; i--)
+		{
+			m_compound_shape->removeChildShape(i);
+		}
+		m_isLocalAABBDirty = true;
+	}
+	m_shapePartList.clear();
+	m_shapeIndexMap.clear();
 }
 
 PhysicsCompoundShape*
@@ -218,35 +229,80 @@ Island::recalculateCompound()
 		printf("aaa");
 		return;
 	}
-	for (auto part : m_partList) {
-	if (part->getType() != GamePartType::GAME_PART_LIFT) {
-	  auto mat = part->getNode()->getLocalTransform();
-	  m_compound_shape->addChildShape(&mat, part->getShape()->getRawShape());
-	} else 
+	// start from an empty compound, updatePhysics hands the new one to the rigid body
+	delete m_compound_shape;
+	setCompoundShape(new PhysicsCompoundShape());
+	m_shapePartList.clear();
+	m_shapeIndexMap.clear();
+	m_isLocalAABBDirty = false;
+	for (auto part : m_partList)
 	{
-		
+		addPartShape(part);
 	}
+	rebaseToPrincipalAxis();
+}
+
+void Island::updatePrincipalAxis()
+{
+	if(m_isPrincipalDirty && !m_isStatic && !m_isSpecial)
+	{
+		rebaseToPrincipalAxis();
+		m_isPhysicsDirty = true;
+	}
+}
+
+void Island::addPartShape(GamePart* part)
+{
+	if(!m_compound_shape || m_isSpecial || part->getType() == GamePartType::GAME_PART_LIFT)
+		return;
+	auto mat = part->getNode()->getLocalTransform();
+	m_shapeIndexMap[part] = int(m_shapePartList.size());
+	m_shapePartList.push_back(part);
+	m_compound_shape->addChildShape(&mat, part->getShape()->getRawShape());
+	m_isPrincipalDirty = true;
+}
+
+void Island::removePartShape(GamePart* part)
+{
+	auto iter = m_shapeIndexMap.find(part);
+	if(iter == m_shapeIndexMap.end())
+		return;
+	int index = iter->second;
+	m_shapeIndexMap.erase(iter);
+	//bullet moves the last child into the hole, do the same
+	m_compound_shape->removeChildShape(index);
+	GamePart * last = m_shapePartList.back();
+	m_shapePartList[index] = last;
+	m_shapePartList.pop_back();
+	if(last != part)
+	{
+		m_shapeIndexMap[last] = index;
 	}
+	m_isPrincipalDirty = true;
+	m_isLocalAABBDirty = true;
+}
 
+void Island::rebaseToPrincipalAxis()
+{
+	m_isPrincipalDirty = false;
+	if(m_shapePartList.empty())
+		return;
 	//!!!ATTENTION
 	//After adjustPrincipalAxis
 	//All parts' LocalMat = inverse(principleMat) * localMat
 	//The island's islandMat = islandMat * principleMat
 	AABB localAABB;
-	auto principleMat = m_compound_shape->adjustPrincipalAxis([this](int index) { return m_partList[index]->getMass(); });
-	for (auto part : m_partList) 
+	auto principleMat = m_compound_shape->adjustPrincipalAxis([this](int index) { return m_shapePartList[index]->getMass(); });
+	auto invPrincipleMat = principleMat.inverted();
+	for (auto part : m_shapePartList) 
 	{
-		if (part->getType() != GamePartType::GAME_PART_LIFT) 
-		{
-		  auto mat = part->getNode()->getLocalTransform();
-		  mat = principleMat.inverted() * mat;
-		  part->getNode()->setPos(mat.getTranslation());
-		  Quaternion q;
-		  q.fromRotationMatrix(&mat);
-		  part->getNode()->setRotateQ(q);
-		}
+		auto mat = part->getNode()->getLocalTransform();
+		mat = invPrincipleMat * mat;
+		part->getNode()->setPos(mat.getTranslation());
+		Quaternion q;
+		q.fromRotationMatrix(&mat);
+		part->getNode()->setRotateQ(q);
 	}
-	m_compound_shape->calculateLocalInertia(getMass());
 	auto mat = m_node->getLocalTransform();
 	mat =  mat * principleMat;
 	m_node->setPos(mat.getTranslation());
@@ -255,6 +311,12 @@ Island::recalculateCompound()
 	m_node->setRotateQ(q);
 	m_node->reCache();
 	m_node->setLocalAABB(localAABB);
+	//the attachments moved in the island space
+	m_attachmentGrid.clear();
+	for (auto part : m_partList)
+	{
+		m_attachmentGrid.add(part);
+	}
 }
 
 void
@@ -271,6 +333,14 @@ Island::enablePhysics(bool isEnable)
 	{
 		if(isEnable) 
 		{
+			//catch up with the rebasing and the refresh skipped while building
+			updatePrincipalAxis();
+			if(m_isPhysicsDirty)
+			{
+				//the rigid body is added to the world there
+				updatePhysics();
+				return;
+			}
 			auto mat = m_node->getTransform();
 			m_rigid->setWorldTransform(mat);
 			PhysicsMgr::shared()->addRigidBody(m_rigid);
@@ -298,13 +368,7 @@ Island::enablePhysics(bool isEnable)
 	{
 		if(m_isStatic)
 			return 0.0f;
-	  float mass = 0.0f;
-	  for (auto part : m_partList) {
-	    if (part->getType() != GamePartType::GAME_PART_LIFT) {
-	      mass += part->getMass();
-	    }
-	  }
-	  return mass;
+	  return m_mass;
 	}
 
 void
@@ -319,7 +383,7 @@ Island::cook()
 	auto partMat = m_node->getTransform();
 	float theMass = getMass();
 	auto rig = PhysicsMgr::shared()->createRigidBodyFromCompund(
-	theMass, &partMat, compoundShape);
+	theMass, &partMat, getCompoundShape());
 	rig->attach(m_node);
 	m_rigid = rig;
 	m_rigid->m_onHitCallBack = std::bind(&Island::onHitCallBack, this,std::placeholders::_1);
@@ -478,6 +542,7 @@ void Island::killAllParts()
 
 void Island::updatePhysics()
 {
+	m_isPhysicsDirty = false;
 	if(!m_rigid)
 	{
 		cook();
@@ -485,29 +550,22 @@ void Island::updatePhysics()
 	if(m_enablePhysics)
 	{
 		PhysicsMgr::shared()->removeRigidBody(m_rigid);
+		updatePrincipalAxis();
 	}
-	if (getCompoundShape()) 
-	{
-		//delete old compound shape, there may be a better performance method.
-		delete m_compound_shape;
-	    setCompoundShape(new PhysicsCompoundShape());
-		recalculateCompound();
-		m_rigid->setMass(getMass(), getCompoundShape()->calculateLocalInertia(getMass()));
-		m_rigid->updateInertiaTensor();
-		// recalculate will modify the transform position, though the final
-		// islandMatrix * childMatrix will remain the same, we need to recalculate
-		// the rigid-body position
-		auto startTransform = m_node->getTransform();
-		m_rigid->setWorldTransform(startTransform);
-		tlog("update compound!");
+	//the child shapes are already added or removed one by one, only the shrinking AABB is left
+	if(m_isLocalAABBDirty)
+	{
+		m_compound_shape->recalculateLocalAABB();
+		m_isLocalAABBDirty = false;
 	}
 	m_rigid->setCollisionShape(getCompoundShape());
+	m_rigid->setMass(getMass(), getCompoundShape()->calculateLocalInertia(getMass()));
 	m_rigid->updateInertiaTensor();
-	btTransform ident;
-	ident.setIdentity();
-	btVector3 aabbMin,aabbMax;
-	getCompoundShape()->getRawShape()->getAabb(ident,aabbMin,aabbMax);
-	float radius = std::max(std::max(aabbMax.getX() - aabbMin.getX(), aabbMax.getY() - aabbMin.getY()),aabbMax.getZ() - aabbMin.getZ());
+	// the rebasing modifies the island transform, though the final
+	// islandMatrix * childMatrix will remain the same, we need to recalculate
+	// the rigid-body position
+	auto startTransform = m_node->getTransform();
+	m_rigid->setWorldTransform(startTransform);
 	m_rigid->setCcdSweptSphereRadius(0.00001);
 	m_rigid->setCcdMotionThreshold(0.5);
 	if(m_enablePhysics)
@@ -518,6 +576,23 @@ void Island::updatePhysics()
 	}
 }
 
+void Island::requestUpdatePhysics()
+{
+	//a simulated dynamic island can't wait, its principal axis and the neighbor constraints depend on it
+	if(!m_rigid || (m_enablePhysics && !m_isStatic))
+	{
+		updatePhysics();
+		return;
+	}
+	m_isPhysicsDirty = true;
+	BuildingSystem::shared()->addPhysicsDirtyIsland(this);
+}
+
+bool Island::isPhysicsDirty() const
+{
+	return m_isPhysicsDirty;
+}
+
 void Island::recordBuildingRotate()
 {
 	m_buildingRotate = m_node->getRotateQ();
@@ -3,10 +3,12 @@
 #include "Base/Node.h"
 #include "GamePart.h"
 #include <set>
+#include <unordered_map>
 #include <vector>
 #include "rapidjson/document.h"
 #include "Base/GuidObj.h"
 #include "Vehicle.h"
+#include "AttachmentGrid.h"
 namespace tzw
 {
 	class PhysicsCompoundShape;
@@ -30,6 +32,8 @@ public:
 	PhysicsCompoundShape * getCompoundShape() const;
 	void setCompoundShape(PhysicsCompoundShape * compoundShape);
 	void recalculateCompound();
+	//rebase the island to the principal axis of its parts if they changed, skipped while building
+	void updatePrincipalAxis();
 	void enablePhysics(bool isEnable);
 	bool isEnablePhysics();
 	float getMass();
@@ -46,6 +50,9 @@ public:
 	void genIslandGroup();
 	void killAllParts();
 	void updatePhysics();
+	//refresh the rigid body now if the simulation needs it, otherwise once in the next BuildingSystem::update
+	void requestUpdatePhysics();
+	bool isPhysicsDirty() const;
 	void recordBuildingRotate();
 	void recoverFromBuildingRotate();
 	void updateNeighborConstraintPhysics();
@@ -56,6 +63,9 @@ public:
 	bool isIsStatic() const;
 	void setIsStatic(const bool isStatic);
 private:
+	void addPartShape(GamePart * part);
+	void removePartShape(GamePart * part);
+	void rebaseToPrincipalAxis();
 	bool m_isStatic;
 	std::string m_islandGroup;
 	bool m_enablePhysics;
@@ -65,6 +75,15 @@ private:
 	std::set<Island *> m_neighborIslands;
 	PhysicsCompoundShape * m_compound_shape;
 	Vehicle * m_vehicle;
+	//attachments of m_partList, lets insert find the touching ones without scanning the whole island
+	AttachmentGrid m_attachmentGrid;
+	//the part of each child shape in the compound, in the same order
+	std::vector<GamePart *> m_shapePartList;
+	std::unordered_map<GamePart *, int> m_shapeIndexMap;
+	float m_mass;
+	bool m_isPrincipalDirty;
+	bool m_isLocalAABBDirty;
+	bool m_isPhysicsDirty;
 };
 
 
@@ -2,6 +2,7 @@
 #include "CubeGame/ResNode.h"
 #include "../BearPart.h"
 #include "VarNode.h"
+#include "CubeGame/NodeProgram.h"
 
 namespace tzw
 {
@@ -12,14 +13,10 @@ namespace tzw
 		m_rightValAttr = addIn(TR(u8"ֵ"));
 	}
 
-	NodeAttrValue AssignNode::execute()
+	void AssignNode::compile(NodeProgramBuilder& builder)
 	{
-		auto attrRef = m_leftValAttr->evalRef();
-		auto value = m_rightValAttr->eval();
-		auto var = static_cast<VarNode *>(attrRef->m_parent);
-		tlog("the var %s has been set to %d by %s", var->getVarName().c_str(),value.getInt(), m_rightValAttr->evalRef()->m_parent->name.c_str());
-		attrRef->m_localAttrValue = value;
-		return NodeAttrValue();
+		builder.emit(NodeOp::ASSIGN, builder.getSlot(m_leftValAttr), builder.getSlot(m_rightValAttr));
+		BehaviorNode::compile(builder);
 	}
 
 	int AssignNode::getNodeClass()
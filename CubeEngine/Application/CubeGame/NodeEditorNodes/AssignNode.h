@@ -7,7 +7,7 @@ struct AssignNode: public BehaviorNode
 {
 public:
 	AssignNode();
-	NodeAttrValue execute() override;
+	void compile(NodeProgramBuilder & builder) override;
 	int getNodeClass() override;
 protected:
 	NodeAttr * m_leftValAttr;
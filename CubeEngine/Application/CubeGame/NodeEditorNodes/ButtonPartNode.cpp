@@ -39,31 +39,13 @@ namespace tzw
 	void ButtonPartNode::triggerPress()
 	{
 		m_stateAttr->m_localAttrValue.setInt(1);
-		auto nodeEditor = getNodeEditor();
-		std::vector<GraphNode * > node_list;
-		nodeEditor->findNodeLinksToAttr(m_pressedAttr, node_list);
-		for(auto node : node_list)
-		{
-			if(node->getType() == Node_TYPE_BEHAVIOR)
-			{
-				nodeEditor->pushToStack(node);
-			}
-		}
+		getNodeEditor()->pushExeOutToStack(m_pressedAttr);
 	}
 
 	void ButtonPartNode::triggerRelease()
 	{
 		m_stateAttr->m_localAttrValue.setInt(0);
-		auto nodeEditor = getNodeEditor();
-		std::vector<GraphNode * > node_list;
-		nodeEditor->findNodeLinksToAttr(m_releasedAttr, node_list);
-		for(auto node : node_list)
-		{
-			if(node->getType() == Node_TYPE_BEHAVIOR)
-			{
-				nodeEditor->pushToStack(node);
-			}
-		}
+		getNodeEditor()->pushExeOutToStack(m_releasedAttr);
 	}
 
 	std::string ButtonPartNode::getResType()
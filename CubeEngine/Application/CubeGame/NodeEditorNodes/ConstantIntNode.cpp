@@ -1,5 +1,6 @@
 #include "ConstantIntNode.h"
 #include "CubeGame/CannonPart.h"
+#include "CubeGame/GameNodeEditor.h"
 
 
 namespace tzw
@@ -20,6 +21,7 @@ namespace tzw
 		if(isInput)
 		{ 
 			m_attr->m_localAttrValue.setInt(intValue);
+			m_nodeEditor->markGraphDirty();
 		}
 	}
 
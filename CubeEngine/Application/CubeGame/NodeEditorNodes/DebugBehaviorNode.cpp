@@ -9,10 +9,4 @@ namespace tzw
 
 	}
 
-	NodeAttrValue DebugBehaviorNode::execute()
-	{
-		printf("test test test!!!!!\n");
-		return NodeAttrValue();
-	}
-
 }
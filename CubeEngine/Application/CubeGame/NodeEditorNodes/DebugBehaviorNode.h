@@ -7,7 +7,6 @@ struct DebugBehaviorNode: public BehaviorNode
 {
 public:
 	DebugBehaviorNode();
-	NodeAttrValue execute() override;
 };
 
 }
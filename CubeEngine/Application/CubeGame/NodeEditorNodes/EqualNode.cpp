@@ -2,6 +2,7 @@
 #include "CubeGame/ResNode.h"
 #include "../BearPart.h"
 #include "VarNode.h"
+#include "CubeGame/NodeProgram.h"
 
 namespace tzw
 {
@@ -13,19 +14,10 @@ namespace tzw
 		m_out = addOut("Return");
 	}
 
-	NodeAttrValue EqualNode::execute()
+	void EqualNode::compile(NodeProgramBuilder& builder)
 	{
-		auto valueA = m_leftValAttr->eval();
-		auto valueB = m_rightValAttr->eval();
-		if(valueA.getInt() == valueB.getInt())
-		{
-			m_out->m_localAttrValue.setInt(1);
-		}else
-		{
-			m_out->m_localAttrValue.setInt(0);
-		}
-		
-		return m_out->m_localAttrValue;
+		builder.emit(NodeOp::EQUAL, builder.getSlot(m_leftValAttr), builder.getSlot(m_rightValAttr), builder.getSlot(m_out));
+		BehaviorNode::compile(builder);
 	}
 
 
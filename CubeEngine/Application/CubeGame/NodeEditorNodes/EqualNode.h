@@ -7,7 +7,7 @@ struct EqualNode: public BehaviorNode
 {
 public:
 	EqualNode();
-	NodeAttrValue execute() override;
+	void compile(NodeProgramBuilder & builder) override;
 	int getNodeClass() override;
 protected:
 	NodeAttr * m_leftValAttr;
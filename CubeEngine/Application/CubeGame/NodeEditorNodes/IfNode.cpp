@@ -3,6 +3,7 @@
 #include "../BearPart.h"
 #include "VarNode.h"
 #include "CubeGame/GameUISystem.h"
+#include "CubeGame/NodeProgram.h"
 
 namespace tzw
 {
@@ -14,35 +15,13 @@ namespace tzw
 		m_cond =addIn(TR(u8"Condition"));
 	}
 
-	NodeAttrValue IfNode::execute()
+	void IfNode::compile(NodeProgramBuilder& builder)
 	{
-		auto nodeEditor = getNodeEditor();
-		std::vector<GraphNode * > node_listtrue, node_listfalse;
-		nodeEditor->findNodeLinksToAttr(m_leftValAttr, node_listtrue);
-		nodeEditor->findNodeLinksToAttr(m_rightValAttr, node_listfalse);
-		auto valueA = m_cond->eval();
-		if(valueA.getInt() ==1)
-		{
-			for(auto node : node_listtrue)
-			{
-				if(node->getType() == Node_TYPE_BEHAVIOR)
-				{
-					nodeEditor->pushToStack(node);
-					//static_cast<BehaviorNode *>(node)->execute();
-				}
-			}
-		}
-		else if(valueA.getInt() == 0)
-		{
-			for(auto node : node_listfalse)
-			{
-				if(node->getType() == Node_TYPE_BEHAVIOR)
-				{
-					nodeEditor->pushToStack(node);
-				}
-			}
-		}
-		return m_out->m_localAttrValue;
+		int cond = builder.getSlot(m_cond);
+		int thenFlag = builder.addBranch(m_leftValAttr);
+		int elseFlag = builder.addBranch(m_rightValAttr);
+		builder.emit(NodeOp::IF, cond, thenFlag, elseFlag);
+		BehaviorNode::compile(builder);
 	}
 
 	int IfNode::getNodeClass()
@@ -7,7 +7,7 @@ struct IfNode: public BehaviorNode
 {
 public:
 	IfNode();
-	NodeAttrValue execute() override;
+	void compile(NodeProgramBuilder & builder) override;
 	int getNodeClass() override;
 protected:
 	NodeAttr * m_leftValAttr;
@@ -80,17 +80,7 @@ namespace tzw
 		{
 			if(!isPlayerOnSeat()) return;
 		}
-		auto nodeEditor = getNodeEditor();
-		std::vector<GraphNode * > node_list;
-		nodeEditor->findNodeLinksToAttr(m_pressedAttr, node_list);
-		for(auto node : node_list)
-		{
-			if(node->getType() == Node_TYPE_BEHAVIOR)
-			{
-				nodeEditor->pushToStack(node);
-				//static_cast<BehaviorNode *>(node)->execute();
-			}
-		}
+		getNodeEditor()->pushExeOutToStack(m_pressedAttr);
 	}
 
 	void KeyAnyTriggerNode::triggerRelease()
@@ -99,15 +89,6 @@ namespace tzw
 		{
 			if(!isPlayerOnSeat()) return;
 		}
-		auto nodeEditor = getNodeEditor();
-		std::vector<GraphNode * > node_list;
-		nodeEditor->findNodeLinksToAttr(m_ReleasedAttr, node_list);
-		for(auto node : node_list)
-		{
-			if(node->getType() == Node_TYPE_BEHAVIOR)
-			{
-				nodeEditor->pushToStack(node);
-			}
-		}
+		getNodeEditor()->pushExeOutToStack(m_ReleasedAttr);
 	}
 }
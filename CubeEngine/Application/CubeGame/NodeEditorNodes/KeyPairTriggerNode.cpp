@@ -129,15 +129,6 @@ namespace tzw
 		{
 			if(!isPlayerOnSeat()) return;
 		}
-		auto nodeEditor = getNodeEditor();
-		std::vector<GraphNode * > node_list;
-		nodeEditor->findNodeLinksToAttr(m_onSignalChangedAttr, node_list);
-		for(auto node : node_list)
-		{
-			if(node->getType() == Node_TYPE_BEHAVIOR)
-			{
-				nodeEditor->pushToStack(node);
-			}
-		}
+		getNodeEditor()->pushExeOutToStack(m_onSignalChangedAttr);
 	}
 }
@@ -139,48 +139,18 @@ namespace tzw
 	void KeyTriggerNode::triggerForward()
 	{
 		if(!isPlayerOnSeat()) return;
-		auto nodeEditor = getNodeEditor();
-		std::vector<GraphNode * > node_list;
-		nodeEditor->findNodeLinksToAttr(m_forwardAttr, node_list);
-		for(auto node : node_list)
-		{
-			if(node->getType() == Node_TYPE_BEHAVIOR)
-			{
-				nodeEditor->pushToStack(node);
-				//static_cast<BehaviorNode *>(node)->execute();
-			}
-		}
+		getNodeEditor()->pushExeOutToStack(m_forwardAttr);
 	}
 
 	void KeyTriggerNode::triggerSide()
 	{
 		if(!isPlayerOnSeat()) return;
-		auto nodeEditor = getNodeEditor();
-		std::vector<GraphNode * > node_list;
-		nodeEditor->findNodeLinksToAttr(m_sideAttr, node_list);
-		for(auto node : node_list)
-		{
-			if(node->getType() == Node_TYPE_BEHAVIOR)
-			{
-				nodeEditor->pushToStack(node);
-				//static_cast<BehaviorNode *>(node)->execute();
-			}
-		}
+		getNodeEditor()->pushExeOutToStack(m_sideAttr);
 	}
 
 	void KeyTriggerNode::triggerZ()
 	{
-		auto nodeEditor = getNodeEditor();
-		std::vector<GraphNode * > node_list;
-		nodeEditor->findNodeLinksToAttr(m_zKeyAttr, node_list);
-		for(auto node : node_list)
-		{
-			if(node->getType() == Node_TYPE_BEHAVIOR)
-			{
-				nodeEditor->pushToStack(node);
-				//static_cast<BehaviorNode *>(node)->execute();
-			}
-		}
+		getNodeEditor()->pushExeOutToStack(m_zKeyAttr);
 	}
 
 	void KeyTriggerNode::triggerX()
@@ -3,6 +3,7 @@
 #include "../BearPart.h"
 #include "VarNode.h"
 #include "CubeGame/UIHelper.h"
+#include "CubeGame/NodeProgram.h"
 
 namespace tzw
 {
@@ -12,10 +13,10 @@ namespace tzw
 		m_strAttrVal = addInStr(TR(u8"ַ"), "let me do that shit");
 	}
 
-	NodeAttrValue PrintNode::execute()
+	void PrintNode::compile(NodeProgramBuilder& builder)
 	{
-		UIHelper::shared()->showFloatTips(m_strAttrVal->eval().getStr());
-		return NodeAttrValue();
+		builder.emit(NodeOp::PRINT, builder.getSlot(m_strAttrVal));
+		BehaviorNode::compile(builder);
 	}
 
 
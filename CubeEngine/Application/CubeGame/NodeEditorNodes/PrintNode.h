@@ -7,7 +7,7 @@ struct PrintNode: public BehaviorNode
 {
 public:
 	PrintNode();
-	NodeAttrValue execute() override;
+	void compile(NodeProgramBuilder & builder) override;
 	int getNodeClass() override;
 protected:
 	NodeAttr * m_strAttrVal;
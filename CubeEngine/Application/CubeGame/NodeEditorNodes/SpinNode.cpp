@@ -1,6 +1,7 @@
 #include "SpinNode.h"
 #include "CubeGame/ResNode.h"
 #include "../BearPart.h"
+#include "CubeGame/NodeProgram.h"
 
 namespace tzw
 {
@@ -12,40 +13,10 @@ namespace tzw
 		m_rotateSpeedAttr = addInFloat(TR(u8"ת"), 10.0f);
 	}
 
-	NodeAttrValue SpinNode::execute()
+	void SpinNode::compile(NodeProgramBuilder& builder)
 	{
-		auto attrVal = m_bearingAttr->eval();
-		for(auto val : attrVal.m_list)
-		{
-			auto node = static_cast<ResNode *>(val.usrPtr);
-			auto constraint = dynamic_cast<BearPart *>(node->getProxy());
-
-			int signal = m_signalAttr->eval().getInt();
-			float speedResult = m_rotateSpeedAttr->eval().getNumber();
-			if(constraint)
-			{
-				if(constraint->getIsSteering())
-				{
-					if(signal!= 0)
-					{
-						constraint->enableAngularMotor(true, speedResult * signal, 50);
-					}else
-					{
-						constraint->enableAngularMotor(true, 0, 10000000.0f);
-					}
-				}else
-				{
-					if(signal!= 0)
-					{
-						constraint->enableAngularMotor(true, speedResult * signal, 50);
-					}else
-					{
-						constraint->enableAngularMotor(false, speedResult, 50);
-					}
-				}
-			}
-		}
-		return NodeAttrValue();
+		builder.emit(NodeOp::SPIN, builder.getSlot(m_bearingAttr), builder.getSlot(m_signalAttr), builder.getSlot(m_rotateSpeedAttr));
+		BehaviorNode::compile(builder);
 	}
 
 	int SpinNode::getNodeClass()
@@ -7,7 +7,7 @@ struct SpinNode: public BehaviorNode
 {
 public:
 	SpinNode();
-	NodeAttrValue execute() override;
+	void compile(NodeProgramBuilder & builder) override;
 	int getNodeClass() override;
 protected:
 	NodeAttr * m_bearingAttr;
@@ -52,16 +52,7 @@ namespace tzw
 			effectedAttr = m_onOff;
 		}
 
-		auto nodeEditor = getNodeEditor();
-		std::vector<GraphNode * > node_list;
-		nodeEditor->findNodeLinksToAttr(effectedAttr, node_list);
-		for(auto node : node_list)
-		{
-			if(node->getType() == Node_TYPE_BEHAVIOR)
-			{
-				nodeEditor->pushToStack(node);
-			}
-		}
+		getNodeEditor()->pushExeOutToStack(effectedAttr);
 	}
 	bool SwitchNode::isPlayerOnSeat()
 	{
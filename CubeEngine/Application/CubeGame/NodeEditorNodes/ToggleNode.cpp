@@ -1,6 +1,7 @@
 #include "ToggleNode.h"
 #include "CubeGame/ResNode.h"
 #include "../ThrusterPart.h"
+#include "CubeGame/NodeProgram.h"
 
 namespace tzw
 {
@@ -11,18 +12,10 @@ namespace tzw
 		m_signalAttr = addIn(TR(u8"ź"));
 	}
 
-	NodeAttrValue ToggleNode::execute()
+	void ToggleNode::compile(NodeProgramBuilder& builder)
 	{
-		auto attrVal = m_bearingAttr->eval();
-		for(auto val : attrVal.m_list)
-		{
-			auto node = static_cast<ResNode *>(val.usrPtr);
-			auto constraint = dynamic_cast<GamePart *>(node->getProxy());
-
-			int signal = m_signalAttr->eval().getInt();
-			constraint->toggle(signal);
-		}
-		return NodeAttrValue();
+		builder.emit(NodeOp::TOGGLE, builder.getSlot(m_bearingAttr), builder.getSlot(m_signalAttr));
+		BehaviorNode::compile(builder);
 	}
 
 	int ToggleNode::getNodeClass()
@@ -7,7 +7,7 @@ struct ToggleNode: public BehaviorNode
 {
 public:
 	ToggleNode();
-	NodeAttrValue execute() override;
+	void compile(NodeProgramBuilder & builder) override;
 	int getNodeClass() override;
 protected:
 	NodeAttr * m_bearingAttr;
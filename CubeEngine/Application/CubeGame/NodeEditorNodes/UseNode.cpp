@@ -2,6 +2,7 @@
 #include "CubeGame/ResNode.h"
 #include "../BearPart.h"
 #include "SpinNode.h"
+#include "CubeGame/NodeProgram.h"
 
 namespace tzw
 {
@@ -11,16 +12,10 @@ namespace tzw
 		m_bearingAttr = addIn(u8"ڵ");
 	}
 
-	NodeAttrValue UseNode::execute()
+	void UseNode::compile(NodeProgramBuilder& builder)
 	{
-		auto attrVal = m_bearingAttr->eval();
-		for(auto val : attrVal.m_list)
-		{
-			auto node = static_cast<ResNode *>(val.usrPtr);
-			auto part = dynamic_cast<GamePart *>(node->getProxy());
-			part->use();
-		}
-		return NodeAttrValue();
+		builder.emit(NodeOp::USE, builder.getSlot(m_bearingAttr));
+		BehaviorNode::compile(builder);
 	}
 
 	int UseNode::getNodeClass()
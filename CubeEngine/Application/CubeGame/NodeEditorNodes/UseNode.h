@@ -7,7 +7,7 @@ struct UseNode: public BehaviorNode
 {
 public:
 	UseNode();
-	NodeAttrValue execute() override;
+	void compile(NodeProgramBuilder & builder) override;
 	int getNodeClass() override;
 protected:
 	NodeAttr * m_bearingAttr;
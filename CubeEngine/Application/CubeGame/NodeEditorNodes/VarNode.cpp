@@ -1,5 +1,6 @@
 #include "VarNode.h"
 #include "CubeGame/CannonPart.h"
+#include "CubeGame/GameNodeEditor.h"
 
 
 namespace tzw
@@ -23,7 +24,7 @@ namespace tzw
 		ImGui::PopItemWidth();
 		if(isInput)
 		{ 
-			m_attr->m_localAttrValue.setInt(intValue);
+			setInt(intValue);
 		}
 		if(isInputName)
 		{
@@ -53,11 +54,13 @@ namespace tzw
 	void VarNode::setInt(int value)
 	{
 		m_attr->m_localAttrValue.setInt(value);
+		if(m_nodeEditor) m_nodeEditor->markGraphDirty();
 	}
 
 	void VarNode::setFloat(float value)
 	{
 		m_attr->m_localAttrValue.setInt(value);
+		if(m_nodeEditor) m_nodeEditor->markGraphDirty();
 	}
 
 	int VarNode::getInt()
@@ -70,7 +73,7 @@ namespace tzw
 		return m_attr->m_localAttrValue.getFloat();
 	}
 
-	std::string VarNode::getVarName()
+	const std::string& VarNode::getVarName()
 	{
 		return m_varName;
 	}
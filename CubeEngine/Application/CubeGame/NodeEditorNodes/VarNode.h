@@ -15,7 +15,7 @@ public:
 	void setFloat(float value);
 	int getInt();
 	float getFloat();
-	std::string getVarName();
+	const std::string & getVarName();
 private:
 	NodeAttr * m_attr;
 	std::string m_varName;
@@ -1,6 +1,7 @@
 #include "VectorNode.h"
 #include "CubeGame/ResNode.h"
 #include "CubeGame/GameUISystem.h"
+#include "CubeGame/NodeProgram.h"
 
 namespace tzw
 {
@@ -11,17 +12,19 @@ namespace tzw
 		m_out = addOut("Result");
 	}
 
-	NodeAttrValue VectorNode::execute()
+	void VectorNode::compile(NodeProgramBuilder& builder)
 	{
-		auto nodeEditor = getNodeEditor();
-		auto theList = nodeEditor->findAllAttrLinksFromAttr(m_composite);
-		auto& value = m_out->m_localAttrValue;
-		value.m_list.clear();
-		for(auto attr : theList)
+		auto& theList = builder.getLinksFrom(m_composite);
+		int result = builder.getSlot(m_out);
+		builder.reserveSlot(result, int(theList.size()));
+		int first = 0;
+		for(size_t i = 0; i < theList.size(); i++)
 		{
-			value.m_list.push_back(attr->eval().getFirst());
+			int operand = builder.addOperand(builder.getSlot(theList[i]));
+			if(i == 0) first = operand;
 		}
-		return value;
+		builder.emit(NodeOp::VECTOR, first, int(theList.size()), result);
+		BehaviorNode::compile(builder);
 	}
 
 	int VectorNode::getNodeClass()
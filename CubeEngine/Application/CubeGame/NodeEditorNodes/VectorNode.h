@@ -7,7 +7,7 @@ struct VectorNode: public BehaviorNode
 {
 public:
 	VectorNode();
-	NodeAttrValue execute() override;
+	void compile(NodeProgramBuilder & builder) override;
 	int getNodeClass() override;
 protected:
 	NodeAttr * m_composite;
@@ -0,0 +1,439 @@
+#include "NodeProgram.h"
+#include "GameNodeEditor.h"
+#include "ResNode.h"
+#include "BearPart.h"
+#include "UIHelper.h"
+#include "NodeEditorNodes/VarNode.h"
+#include <algorithm>
+
+namespace tzw
+{
+	static float getNumber(const NodeAttrValuePrimitive & value)
+	{
+		switch(value.m_type)
+		{
+            case NodeAttrValuePrimitive::Type::FLOAT:
+			return value.float_val;
+            case NodeAttrValuePrimitive::Type::INT:
+			return value.int_val;
+            default:
+			assert(0);
+			return 0.0f;
+		}
+	}
+
+	NodeProgram::NodeProgram()
+	{
+	}
+
+	void NodeProgram::clear()
+	{
+		m_instructionList.clear();
+		m_operandList.clear();
+		m_levelList.clear();
+		m_blockList.clear();
+		m_slotList.clear();
+		m_registerList.clear();
+		m_flagList.clear();
+		m_inputSlotList.clear();
+		m_exeOutBlockMap.clear();
+		m_nodeBlockMap.clear();
+		m_pushedList.clear();
+	}
+
+	int NodeProgram::findBlock(NodeAttr* exeOut)
+	{
+		auto iter = m_exeOutBlockMap.find(exeOut);
+		return iter != m_exeOutBlockMap.end() ? iter->second : -1;
+	}
+
+	int NodeProgram::findBlock(GraphNode* node)
+	{
+		auto iter = m_nodeBlockMap.find(node);
+		return iter != m_nodeBlockMap.end() ? iter->second : -1;
+	}
+
+	void NodeProgram::push(int blockIndex)
+	{
+		m_pushedList.push_back(blockIndex);
+	}
+
+	void NodeProgram::run()
+	{
+		if(m_pushedList.empty()) return;
+		std::fill(m_flagList.begin(), m_flagList.end(), 0);
+		for(auto slotIndex : m_inputSlotList)
+		{
+			loadSlot(m_slotList[slotIndex]);
+		}
+		//one level of every pushed block after the other, the order the execution queue used to run them in
+		for(int level = 0; ; level++)
+		{
+			bool isRunning = false;
+			for(auto blockIndex : m_pushedList)
+			{
+				auto & block = m_blockList[blockIndex];
+				if(level >= block.m_levelCount) continue;
+				isRunning = true;
+				execute(m_levelList[block.m_firstLevel + level], m_levelList[block.m_firstLevel + level + 1]);
+			}
+			if(!isRunning) break;
+		}
+		m_pushedList.clear();
+	}
+
+	void NodeProgram::execute(int begin, int end)
+	{
+		for(int i = begin; i < end; i++)
+		{
+			auto & instruction = m_instructionList[i];
+			switch(instruction.m_op)
+			{
+			case NodeOp::JUMP_IF_ZERO:
+				{
+					if(!m_flagList[instruction.m_a]) i = instruction.m_b - 1;
+				}
+				break;
+			case NodeOp::IF:
+				{
+					int cond = getFirst(instruction.m_a).int_val;
+					m_flagList[instruction.m_b] = cond == 1;
+					m_flagList[instruction.m_c] = cond == 0;
+				}
+				break;
+			case NodeOp::EQUAL:
+				{
+					auto & result = m_slotList[instruction.m_c];
+					int isEqual = getFirst(instruction.m_a).int_val == getFirst(instruction.m_b).int_val ? 1 : 0;
+					m_registerList[result.m_begin] = NodeAttrValuePrimitive(isEqual);
+					result.m_count = 1;
+					storeSlot(result);
+				}
+				break;
+			case NodeOp::ASSIGN:
+				{
+					auto & target = m_slotList[instruction.m_a];
+					auto & source = m_slotList[instruction.m_b];
+					if(&target == &source) break;
+					target.m_count = std::min(source.m_count, target.m_capacity);
+					std::copy(m_registerList.begin() + source.m_begin, m_registerList.begin() + source.m_begin + target.m_count, m_registerList.begin() + target.m_begin);
+					storeSlot(target);
+					if(target.m_attr->m_parent->getNodeClass() == Node_CLASS_VAR)
+					{
+						auto var = static_cast<VarNode *>(target.m_attr->m_parent);
+						tlog("the var %s has been set to %d by %s", var->getVarName().c_str(), getFirst(instruction.m_b).int_val, source.m_attr->m_parent->name.c_str());
+					}
+				}
+				break;
+			case NodeOp::VECTOR:
+				{
+					auto & result = m_slotList[instruction.m_c];
+					for(int k = 0; k < instruction.m_b; k++)
+					{
+						m_registerList[result.m_begin + k] = getFirst(m_operandList[instruction.m_a + k]);
+					}
+					result.m_count = instruction.m_b;
+					storeSlot(result);
+				}
+				break;
+			case NodeOp::SPIN:
+				{
+					auto & parts = m_slotList[instruction.m_a];
+					for(int k = 0; k < parts.m_count; k++)
+					{
+						auto node = static_cast<ResNode *>(m_registerList[parts.m_begin + k].usrPtr);
+						auto constraint = dynamic_cast<BearPart *>(node->getProxy());
+						int signal = getFirst(instruction.m_b).int_val;
+						float speedResult = getNumber(getFirst(instruction.m_c));
+						if(!constraint) continue;
+						if(signal != 0)
+						{
+							constraint->enableAngularMotor(true, speedResult * signal, 50);
+						}
+						else if(constraint->getIsSteering())
+						{
+							constraint->enableAngularMotor(true, 0, 10000000.0f);
+						}
+						else
+						{
+							constraint->enableAngularMotor(false, speedResult, 50);
+						}
+					}
+				}
+				break;
+			case NodeOp::TOGGLE:
+				{
+					auto & parts = m_slotList[instruction.m_a];
+					for(int k = 0; k < parts.m_count; k++)
+					{
+						auto node = static_cast<ResNode *>(m_registerList[parts.m_begin + k].usrPtr);
+						auto part = dynamic_cast<GamePart *>(node->getProxy());
+						part->toggle(getFirst(instruction.m_b).int_val);
+					}
+				}
+				break;
+			case NodeOp::USE:
+				{
+					auto & parts = m_slotList[instruction.m_a];
+					for(int k = 0; k < parts.m_count; k++)
+					{
+						auto node = static_cast<ResNode *>(m_registerList[parts.m_begin + k].usrPtr);
+						auto part = dynamic_cast<GamePart *>(node->getProxy());
+						part->use();
+					}
+				}
+				break;
+			case NodeOp::PRINT:
+				{
+					auto & value = getFirst(instruction.m_a);
+					if(value.m_type == NodeAttrValuePrimitive::Type::STRING)
+					{
+						UIHelper::shared()->showFloatTips(*value.str_val);
+					}
+				}
+				break;
+			}
+		}
+	}
+
+	NodeAttrValuePrimitive& NodeProgram::getFirst(int slotIndex)
+	{
+		return m_registerList[m_slotList[slotIndex].m_begin];
+	}
+
+	void NodeProgram::loadSlot(NodeSlot& slot)
+	{
+		auto & list = slot.m_attr->m_localAttrValue.m_list;
+		slot.m_count = std::min(int(list.size()), slot.m_capacity);
+		std::copy(list.begin(), list.begin() + slot.m_count, m_registerList.begin() + slot.m_begin);
+	}
+
+	void NodeProgram::storeSlot(NodeSlot& slot)
+	{
+		//written through, so the editor shows and saves the value, and a recompile starts from it
+		auto begin = m_registerList.begin() + slot.m_begin;
+		slot.m_attr->m_localAttrValue.m_list.assign(begin, begin + slot.m_count);
+	}
+
+	NodeProgramBuilder::NodeProgramBuilder(NodeProgram& program, const std::vector<GraphNode*>& nodeList, const std::vector<LinkInfo>& linkList)
+		:m_program(program),m_nodeList(nodeList),m_currentItem(-1),m_isLoopFound(false)
+	{
+		std::unordered_map<int, NodeAttr *> attrMap;
+		for(auto node : m_nodeList)
+		{
+			for(auto attr : node->getInAttrs())
+			{
+				attrMap[attr->gID] = attr;
+			}
+			for(auto attr : node->getOuAttrs())
+			{
+				attrMap[attr->gID] = attr;
+			}
+		}
+		for(auto & link : linkList)
+		{
+			auto startIter = attrMap.find(link.InputId);
+			auto endIter = attrMap.find(link.OutputId);
+			if(startIter == attrMap.end() || endIter == attrMap.end()) continue;
+			m_linkFromMap[endIter->second].push_back(startIter->second);
+			m_linkToMap[startIter->second].push_back(endIter->second->m_parent);
+			if(startIter->second->dataType == NodeAttr::DataType::EXECUTE)
+			{
+				m_exeTargetSet.insert(endIter->second->m_parent);
+			}
+		}
+	}
+
+	void NodeProgramBuilder::build()
+	{
+		m_program.clear();
+		//the entries are the execute pins of the triggers and parts, and the behaviours no execute pin links to
+		for(auto node : m_nodeList)
+		{
+			if(node->getType() == Node_TYPE_BEHAVIOR) continue;
+			for(auto attr : node->getOuAttrs())
+			{
+				if(attr->dataType != NodeAttr::DataType::EXECUTE) continue;
+				auto iter = m_linkToMap.find(attr);
+				if(iter == m_linkToMap.end()) continue;
+				m_program.m_exeOutBlockMap[attr] = addBlock(iter->second);
+			}
+		}
+		std::vector<GraphNode *> rootList;
+		for(auto node : m_nodeList)
+		{
+			if(node->getType() != Node_TYPE_BEHAVIOR || m_exeTargetSet.count(node)) continue;
+			rootList.assign(1, node);
+			m_program.m_nodeBlockMap[node] = addBlock(rootList);
+		}
+		finish();
+	}
+
+	int NodeProgramBuilder::getSlot(NodeAttr* attr)
+	{
+		//the first link wins, links always start at an output, so there is only one step
+		auto linkIter = m_linkFromMap.find(attr);
+		if(linkIter != m_linkFromMap.end() && !linkIter->second.empty())
+		{
+			attr = linkIter->second[0];
+		}
+		auto iter = m_slotMap.find(attr);
+		if(iter != m_slotMap.end()) return iter->second;
+		NodeSlot slot;
+		slot.m_attr = attr;
+		slot.m_begin = 0;
+		slot.m_count = 0;
+		slot.m_capacity = std::max(int(attr->m_localAttrValue.m_list.size()), 1);
+		int slotIndex = int(m_program.m_slotList.size());
+		m_program.m_slotList.push_back(slot);
+		m_slotMap[attr] = slotIndex;
+		int type = attr->m_parent->getType();
+		if(type == Node_TYPE_TRIGGER || type == Node_TYPE_RES)
+		{
+			m_program.m_inputSlotList.push_back(slotIndex);
+		}
+		return slotIndex;
+	}
+
+	void NodeProgramBuilder::reserveSlot(int slotIndex, int capacity)
+	{
+		auto & slot = m_program.m_slotList[slotIndex];
+		slot.m_capacity = std::max(slot.m_capacity, capacity);
+	}
+
+	int NodeProgramBuilder::addBranch(NodeAttr* exeOut)
+	{
+		int flag = int(m_program.m_flagList.size());
+		m_program.m_flagList.push_back(0);
+		addChildren(exeOut, flag);
+		return flag;
+	}
+
+	void NodeProgramBuilder::addFollow(NodeAttr* exeOut)
+	{
+		addChildren(exeOut, m_itemList[m_currentItem].m_guard);
+	}
+
+	void NodeProgramBuilder::emit(NodeOp op, int a, int b, int c)
+	{
+		NodeInstruction instruction;
+		instruction.m_op = op;
+		instruction.m_a = a;
+		instruction.m_b = b;
+		instruction.m_c = c;
+		m_program.m_instructionList.push_back(instruction);
+	}
+
+	int NodeProgramBuilder::addOperand(int slotIndex)
+	{
+		m_program.m_operandList.push_back(slotIndex);
+		return int(m_program.m_operandList.size()) - 1;
+	}
+
+	const std::vector<NodeAttr*>& NodeProgramBuilder::getLinksFrom(NodeAttr* attr)
+	{
+		static const std::vector<NodeAttr *> emptyList;
+		auto iter = m_linkFromMap.find(attr);
+		return iter != m_linkFromMap.end() ? iter->second : emptyList;
+	}
+
+	int NodeProgramBuilder::addBlock(const std::vector<GraphNode*>& rootList)
+	{
+		auto & instructionList = m_program.m_instructionList;
+		NodeBlock block;
+		block.m_firstLevel = int(m_program.m_levelList.size());
+		m_itemList.clear();
+		for(auto node : rootList)
+		{
+			if(node->getType() != Node_TYPE_BEHAVIOR) continue;
+			m_itemList.push_back(Item{node, -1, -1});
+		}
+		//breadth first like the execution queue, the items of a level are followed by the ones they lead to
+		size_t levelBegin = 0;
+		while(levelBegin < m_itemList.size())
+		{
+			size_t levelEnd = m_itemList.size();
+			m_program.m_levelList.push_back(int(instructionList.size()));
+			//the items in a row which wait for the same flag are skipped by one jump
+			int lastGuard = -1;
+			int jump = -1;
+			for(size_t i = levelBegin; i < levelEnd; i++)
+			{
+				int guard = m_itemList[i].m_guard;
+				if(guard != lastGuard)
+				{
+					if(jump >= 0) instructionList[jump].m_b = int(instructionList.size());
+					jump = -1;
+					if(guard >= 0)
+					{
+						jump = int(instructionList.size());
+						emit(NodeOp::JUMP_IF_ZERO, guard);
+					}
+					lastGuard = guard;
+				}
+				m_currentItem = int(i);
+				m_itemList[i].m_node->compile(*this);
+			}
+			if(jump >= 0) instructionList[jump].m_b = int(instructionList.size());
+			levelBegin = levelEnd;
+		}
+		m_program.m_levelList.push_back(int(instructionList.size()));
+		block.m_levelCount = int(m_program.m_levelList.size()) - block.m_firstLevel - 1;
+		m_program.m_blockList.push_back(block);
+		return int(m_program.m_blockList.size()) - 1;
+	}
+
+	void NodeProgramBuilder::addChildren(NodeAttr* exeOut, int guard)
+	{
+		auto iter = m_linkToMap.find(exeOut);
+		if(iter == m_linkToMap.end()) return;
+		for(auto node : iter->second)
+		{
+			if(node->getType() != Node_TYPE_BEHAVIOR) continue;
+			//a behaviour which leads back to itself used to run forever, the loop is cut there
+			bool isLoop = false;
+			for(int item = m_currentItem; item >= 0 && !isLoop; item = m_itemList[item].m_parent)
+			{
+				isLoop = m_itemList[item].m_node == node;
+			}
+			if(isLoop)
+			{
+				if(!m_isLoopFound) tlogError("node graph: %s leads back to itself, the loop is cut", node->name.c_str());
+				m_isLoopFound = true;
+				continue;
+			}
+			m_itemList.push_back(Item{node, guard, m_currentItem});
+		}
+	}
+
+	void NodeProgramBuilder::finish()
+	{
+		auto & slotList = m_program.m_slotList;
+		//an assigned slot has to hold whatever it can be assigned, passed on until nothing grows
+		bool isGrown = true;
+		while(isGrown)
+		{
+			isGrown = false;
+			for(auto & instruction : m_program.m_instructionList)
+			{
+				if(instruction.m_op != NodeOp::ASSIGN) continue;
+				auto & target = slotList[instruction.m_a];
+				auto & source = slotList[instruction.m_b];
+				if(target.m_capacity >= source.m_capacity) continue;
+				target.m_capacity = source.m_capacity;
+				isGrown = true;
+			}
+		}
+		int registerCount = 0;
+		for(auto & slot : slotList)
+		{
+			slot.m_begin = registerCount;
+			registerCount += slot.m_capacity;
+		}
+		m_program.m_registerList.assign(registerCount, NodeAttrValuePrimitive());
+		for(auto & slot : slotList)
+		{
+			m_program.loadSlot(slot);
+		}
+	}
+}
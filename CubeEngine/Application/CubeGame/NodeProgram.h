@@ -0,0 +1,118 @@
+#pragma once
+#include "GraphNode.h"
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace tzw {
+struct LinkInfo;
+
+// the operations of a compiled node graph, a slot is a range of the register file, a flag is one int
+enum class NodeOp
+{
+	JUMP_IF_ZERO,//a flag, b instruction to go on with when the flag is 0
+	IF,//a condition slot, b flag set when it is 1, c flag set when it is 0
+	EQUAL,//a left slot, b right slot, c result slot
+	ASSIGN,//a target slot, b source slot
+	VECTOR,//a first operand, b operand count, c result slot
+	SPIN,//a parts slot, b signal slot, c speed slot
+	TOGGLE,//a parts slot, b signal slot
+	USE,//a parts slot
+	PRINT,//a string slot
+};
+
+struct NodeInstruction
+{
+	NodeOp m_op;
+	int m_a;
+	int m_b;
+	int m_c;
+};
+
+// the registers holding the value of one attr, m_count of them are in use
+struct NodeSlot
+{
+	NodeAttr * m_attr;
+	int m_begin;
+	int m_count;
+	int m_capacity;
+};
+
+// the behaviours reached from one entry, level i is the i-th round of the old execution queue
+struct NodeBlock
+{
+	int m_firstLevel;
+	int m_levelCount;
+};
+
+class NodeProgram
+{
+public:
+	NodeProgram();
+	void clear();
+	//-1 when nothing runs from there
+	int findBlock(NodeAttr * exeOut);
+	int findBlock(GraphNode * node);
+	void push(int blockIndex);
+	void run();
+private:
+	friend class NodeProgramBuilder;
+	void execute(int begin, int end);
+	NodeAttrValuePrimitive & getFirst(int slotIndex);
+	void loadSlot(NodeSlot & slot);
+	void storeSlot(NodeSlot & slot);
+	std::vector<NodeInstruction> m_instructionList;
+	//slots read by the VECTOR instructions
+	std::vector<int> m_operandList;
+	//instruction offsets, a block of n levels uses n + 1 of them
+	std::vector<int> m_levelList;
+	std::vector<NodeBlock> m_blockList;
+	std::vector<NodeSlot> m_slotList;
+	std::vector<NodeAttrValuePrimitive> m_registerList;
+	std::vector<int> m_flagList;
+	//slots of the trigger and part outputs, they are written outside of the program and latched before every run
+	std::vector<int> m_inputSlotList;
+	std::unordered_map<NodeAttr *, int> m_exeOutBlockMap;
+	std::unordered_map<GraphNode *, int> m_nodeBlockMap;
+	std::vector<int> m_pushedList;
+};
+
+// flattens the nodes and links of a GameNodeEditor into a NodeProgram, every behaviour emits its own instructions by GraphNode::compile
+class NodeProgramBuilder
+{
+public:
+	NodeProgramBuilder(NodeProgram & program, const std::vector<GraphNode *> & nodeList, const std::vector<LinkInfo> & linkList);
+	void build();
+	//an input shares the slot of the output it is linked from
+	int getSlot(NodeAttr * attr);
+	void reserveSlot(int slotIndex, int capacity);
+	//flag for an instruction to set, the behaviours linked to the pin run only when it is 1
+	int addBranch(NodeAttr * exeOut);
+	//the behaviours linked to the pin run whenever the current one does
+	void addFollow(NodeAttr * exeOut);
+	void emit(NodeOp op, int a = 0, int b = 0, int c = 0);
+	int addOperand(int slotIndex);
+	const std::vector<NodeAttr *> & getLinksFrom(NodeAttr * attr);
+private:
+	struct Item
+	{
+		GraphNode * m_node;
+		//flag which has to be 1 for the item to run, -1 for none
+		int m_guard;
+		int m_parent;
+	};
+	int addBlock(const std::vector<GraphNode *> & rootList);
+	void addChildren(NodeAttr * exeOut, int guard);
+	void finish();
+	NodeProgram & m_program;
+	const std::vector<GraphNode *> & m_nodeList;
+	std::unordered_map<NodeAttr *, std::vector<NodeAttr *>> m_linkFromMap;
+	std::unordered_map<NodeAttr *, std::vector<GraphNode *>> m_linkToMap;
+	//behaviours some execute pin links to
+	std::unordered_set<GraphNode *> m_exeTargetSet;
+	std::unordered_map<NodeAttr *, int> m_slotMap;
+	std::vector<Item> m_itemList;
+	int m_currentItem;
+	bool m_isLoopFound;
+};
+}
@@ -0,0 +1,474 @@
+#include "TerrainRegionStore.h"
+#include "GameConfig.h"
+#include "Utility/log/Log.h"
+#include <stdio.h>
+#include <string.h>
+#include <filesystem>
+#define MINIZ_HEADER_FILE_ONLY
+#include "zip/miniz.h"
+
+namespace tzw
+{
+	static const char TERRAIN_REGION_MAGIC[4] = {'T', 'Z', 'R', 'G'};
+	//version 2 : every buffer starts with its codec
+	static const uint32_t TERRAIN_REGION_VERSION = 2;
+	static const size_t TERRAIN_VOXEL_COUNT = GAME_MAX_BUFFER_SIZE * GAME_MAX_BUFFER_SIZE * GAME_MAX_BUFFER_SIZE;
+	static const uint32_t TERRAIN_PAGE_SIZE = 4096;
+
+	enum TerrainCodec : uint32_t
+	{
+		TERRAIN_CODEC_DEFLATE = 0,
+		TERRAIN_CODEC_RAW = 1,
+	};
+
+	struct TerrainRegionHeader
+	{
+		char m_magic[4];
+		uint32_t m_version;
+		int32_t m_regionX;
+		int32_t m_regionY;
+		int32_t m_regionZ;
+	};
+
+	//21 bits per axis, biased for the negative regions
+	static const int REGION_KEY_BIAS = 1 << 20;
+	static const uint64_t REGION_KEY_MASK = (1 << 21) - 1;
+
+	static uint64_t regionKey(int regionX, int regionY, int regionZ)
+	{
+		return (uint64_t(regionX + REGION_KEY_BIAS) & REGION_KEY_MASK) << 42 | (uint64_t(regionY + REGION_KEY_BIAS) & REGION_KEY_MASK) << 21 | (uint64_t(regionZ + REGION_KEY_BIAS) & REGION_KEY_MASK);
+	}
+
+	static int regionKeyAxis(uint64_t key, int shift)
+	{
+		return int((key >> shift) & REGION_KEY_MASK) - REGION_KEY_BIAS;
+	}
+
+	//rounded down, the map has buffers on the negative side too
+	static int regionOf(int v)
+	{
+		return v >= 0 ? v / TERRAIN_REGION_SIZE : (v + 1) / TERRAIN_REGION_SIZE - 1;
+	}
+
+	static int slotIndex(int x, int y, int z)
+	{
+		int slotX = x - regionOf(x) * TERRAIN_REGION_SIZE, slotY = y - regionOf(y) * TERRAIN_REGION_SIZE, slotZ = z - regionOf(z) * TERRAIN_REGION_SIZE;
+		return (slotX * TERRAIN_REGION_SIZE + slotY) * TERRAIN_REGION_SIZE + slotZ;
+	}
+
+	TerrainRegionStore::TerrainRegionStore(std::string folder):m_folder(folder),m_isMapped(false)
+	{
+
+	}
+
+	TerrainRegionStore::~TerrainRegionStore()
+	{
+		for(auto & iter : m_tableCache)
+		{
+			delete iter.second;
+		}
+		for(auto & iter : m_mappingCache)
+		{
+			delete iter.second;
+		}
+	}
+
+	bool TerrainRegionStore::load(int x, int y, int z, voxelInfo* out)
+	{
+		int regionX = regionOf(x), regionY = regionOf(y), regionZ = regionOf(z);
+		int slot = slotIndex(x, y, z);
+		std::vector<unsigned char> data;
+		uint32_t version;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto table = getTable(regionX, regionY, regionZ);
+			if(!table->m_size[slot])
+			{
+				return false;
+			}
+			version = table->m_version;
+			auto file = fopen(getRegionPath(regionX, regionY, regionZ).c_str(), "rb");
+			if(!file)
+			{
+				return false;
+			}
+			data.resize(table->m_size[slot]);
+			fseek(file, table->m_offset[slot], SEEK_SET);
+			size_t readSize = fread(data.data(), 1, data.size(), file);
+			fclose(file);
+			if(readSize != data.size())
+			{
+				tlogError("terrain region (%d %d %d) is truncated", regionX, regionY, regionZ);
+				return false;
+			}
+		}
+		if(!decodeBlob(version, data.data(), data.size(), out))
+		{
+			tlogError("terrain buffer (%d %d %d) is corrupted", x, y, z);
+			return false;
+		}
+		return true;
+	}
+
+	voxelInfo* TerrainRegionStore::map(int x, int y, int z)
+	{
+		int regionX = regionOf(x), regionY = regionOf(y), regionZ = regionOf(z);
+		int slot = slotIndex(x, y, z);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto table = getTable(regionX, regionY, regionZ);
+		if(!table->m_size[slot] || table->m_version < 2)
+		{
+			return nullptr;
+		}
+		uint64_t key = regionKey(regionX, regionY, regionZ);
+		auto iter = m_mappingCache.find(key);
+		if(iter == m_mappingCache.end())
+		{
+			auto mapping = new MappedFile();
+			if(!mapping->open(getRegionPath(regionX, regionY, regionZ)))
+			{
+				delete mapping;
+				return nullptr;
+			}
+			iter = m_mappingCache.insert(std::make_pair(key, mapping)).first;
+		}
+		auto mapping = iter->second;
+		size_t offset = table->m_offset[slot];
+		if(offset + table->m_size[slot] > mapping->getSize() || table->m_size[slot] != sizeof(uint32_t) + TERRAIN_VOXEL_COUNT * sizeof(voxelInfo))
+		{
+			return nullptr;
+		}
+		uint32_t codec;
+		memcpy(&codec, mapping->getBytes() + offset, sizeof(codec));
+		if(codec != TERRAIN_CODEC_RAW)
+		{
+			return nullptr;
+		}
+		return reinterpret_cast<voxelInfo *>(mapping->getBytes() + offset + sizeof(uint32_t));
+	}
+
+	void TerrainRegionStore::save(const std::vector<TerrainRegionEntry>& entryList)
+	{
+		//encode first, out of the lock
+		std::unordered_map<uint64_t, std::vector<std::pair<int, std::vector<unsigned char>>>> regionMap;
+		for(auto & entry : entryList)
+		{
+			uint64_t key = regionKey(regionOf(entry.x), regionOf(entry.y), regionOf(entry.z));
+			auto & slotList = regionMap[key];
+			slotList.emplace_back(slotIndex(entry.x, entry.y, entry.z), std::vector<unsigned char>());
+			auto & blob = slotList.back().second;
+			uint32_t codec = m_isMapped ? TERRAIN_CODEC_RAW : TERRAIN_CODEC_DEFLATE;
+			if(m_isMapped)
+			{
+				blob.resize(sizeof(uint32_t) + TERRAIN_VOXEL_COUNT * sizeof(voxelInfo));
+				memcpy(blob.data() + sizeof(uint32_t), entry.m_buff, TERRAIN_VOXEL_COUNT * sizeof(voxelInfo));
+			}
+			else
+			{
+				std::vector<unsigned char> payload;
+				compressBuffer(entry.m_buff, payload);
+				blob.resize(sizeof(uint32_t) + payload.size());
+				memcpy(blob.data() + sizeof(uint32_t), payload.data(), payload.size());
+			}
+			memcpy(blob.data(), &codec, sizeof(codec));
+		}
+		std::filesystem::create_directories(m_folder);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for(auto & region : regionMap)
+		{
+			int regionX = regionKeyAxis(region.first, 42), regionY = regionKeyAxis(region.first, 21), regionZ = regionKeyAxis(region.first, 0);
+			std::string path = getRegionPath(regionX, regionY, regionZ);
+			auto table = getTable(regionX, regionY, regionZ);
+			//the mapped file can't be replaced, the new one waits aside as .pending until the next time the region is opened.
+			//the untouched slots in the old file are still right for this session, the touched ones are in memory already.
+			bool isRegionMapped = m_mappingCache.find(region.first) != m_mappingCache.end();
+			std::string pendingPath = path + ".pending";
+			std::string sourcePath = path;
+			RegionTable sourceTable = *table;
+			if(isRegionMapped && std::filesystem::exists(pendingPath))
+			{
+				sourcePath = pendingPath;
+				readTable(pendingPath, &sourceTable);
+			}
+
+			//keep the slots which are not touched this time, in the codec they were
+			std::vector<std::vector<unsigned char>> blobList(TERRAIN_REGION_SLOT_COUNT);
+			auto oldFile = fopen(sourcePath.c_str(), "rb");
+			if(oldFile)
+			{
+				for(int i = 0; i < TERRAIN_REGION_SLOT_COUNT; i++)
+				{
+					if(!sourceTable.m_size[i]) continue;
+					size_t headSize = sourceTable.m_version < 2 ? sizeof(uint32_t) : 0;
+					blobList[i].resize(headSize + sourceTable.m_size[i]);
+					if(headSize)
+					{
+						uint32_t codec = TERRAIN_CODEC_DEFLATE;
+						memcpy(blobList[i].data(), &codec, sizeof(codec));
+					}
+					fseek(oldFile, sourceTable.m_offset[i], SEEK_SET);
+					fread(blobList[i].data() + headSize, 1, sourceTable.m_size[i], oldFile);
+				}
+				fclose(oldFile);
+			}
+			for(auto & slot : region.second)
+			{
+				blobList[slot.first] = std::move(slot.second);
+			}
+
+			RegionTable newTable = {};
+			newTable.m_version = TERRAIN_REGION_VERSION;
+			uint32_t offset = sizeof(TerrainRegionHeader) + sizeof(newTable.m_offset) + sizeof(newTable.m_size);
+			for(int i = 0; i < TERRAIN_REGION_SLOT_COUNT; i++)
+			{
+				if(blobList[i].empty()) continue;
+				uint32_t codec;
+				memcpy(&codec, blobList[i].data(), sizeof(codec));
+				if(codec == TERRAIN_CODEC_RAW)
+				{
+					//the voxels start on a page, copy-on-write of one buffer never touches the neighbors.
+					uint32_t dataOffset = (offset + sizeof(uint32_t) + TERRAIN_PAGE_SIZE - 1) / TERRAIN_PAGE_SIZE * TERRAIN_PAGE_SIZE;
+					offset = dataOffset - sizeof(uint32_t);
+				}
+				newTable.m_offset[i] = offset;
+				newTable.m_size[i] = uint32_t(blobList[i].size());
+				offset += newTable.m_size[i];
+			}
+			TerrainRegionHeader header;
+			memcpy(header.m_magic, TERRAIN_REGION_MAGIC, sizeof(header.m_magic));
+			header.m_version = TERRAIN_REGION_VERSION;
+			header.m_regionX = regionX;
+			header.m_regionY = regionY;
+			header.m_regionZ = regionZ;
+
+			//write aside then replace, a crash while saving won't ruin the old one.
+			std::string tmpPath = isRegionMapped ? pendingPath : path + ".tmp";
+			auto file = fopen(tmpPath.c_str(), "wb");
+			if(!file)
+			{
+				tlogError("can not write terrain region %s", tmpPath.c_str());
+				continue;
+			}
+			fwrite(&header, sizeof(header), 1, file);
+			fwrite(newTable.m_offset, sizeof(newTable.m_offset), 1, file);
+			fwrite(newTable.m_size, sizeof(newTable.m_size), 1, file);
+			for(int i = 0; i < TERRAIN_REGION_SLOT_COUNT; i++)
+			{
+				if(!blobList[i].empty())
+				{
+					fseek(file, newTable.m_offset[i], SEEK_SET);
+					fwrite(blobList[i].data(), 1, blobList[i].size(), file);
+				}
+			}
+			fclose(file);
+			if(isRegionMapped)
+			{
+				continue;
+			}
+			std::error_code err;
+			std::filesystem::rename(tmpPath, path, err);
+			if(err)
+			{
+				tlogError("can not replace terrain region %s : %s", path.c_str(), err.message().c_str());
+				continue;
+			}
+			*table = newTable;
+		}
+		tlog("terrain region save %ld buffers in %ld regions", entryList.size(), regionMap.size());
+	}
+
+	void TerrainRegionStore::clear()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::error_code err;
+		for(auto & iter : m_mappingCache)
+		{
+			delete iter.second;
+		}
+		m_mappingCache.clear();
+		std::filesystem::remove_all(m_folder, err);
+		for(auto & iter : m_tableCache)
+		{
+			delete iter.second;
+		}
+		m_tableCache.clear();
+	}
+
+	const std::string& TerrainRegionStore::getFolder() const
+	{
+		return m_folder;
+	}
+
+	void TerrainRegionStore::setIsMapped(bool isMapped)
+	{
+		m_isMapped = isMapped;
+	}
+
+	bool TerrainRegionStore::isMapped() const
+	{
+		return m_isMapped;
+	}
+
+	void TerrainRegionStore::compressBuffer(const voxelInfo* buff, std::vector<unsigned char>& out)
+	{
+		const size_t stride = sizeof(voxelInfo);
+		auto src = reinterpret_cast<const unsigned char *>(buff);
+		std::vector<unsigned char> planes(TERRAIN_VOXEL_COUNT * stride);
+		for(size_t i = 0; i < TERRAIN_VOXEL_COUNT; i++)
+		{
+			for(size_t b = 0; b < stride; b++)
+			{
+				planes[b * TERRAIN_VOXEL_COUNT + i] = src[i * stride + b];
+			}
+		}
+		//(run length, value) pairs
+		std::vector<unsigned char> rle;
+		rle.reserve(planes.size() / 8);
+		for(size_t i = 0; i < planes.size();)
+		{
+			unsigned char value = planes[i];
+			size_t run = 1;
+			while(run < 255 && i + run < planes.size() && planes[i + run] == value)
+			{
+				run++;
+			}
+			rle.push_back(static_cast<unsigned char>(run));
+			rle.push_back(value);
+			i += run;
+		}
+		mz_ulong compressedSize = mz_compressBound(mz_ulong(rle.size()));
+		out.resize(sizeof(uint32_t) + compressedSize);
+		uint32_t rleSize = uint32_t(rle.size());
+		memcpy(out.data(), &rleSize, sizeof(rleSize));
+		mz_compress2(out.data() + sizeof(uint32_t), &compressedSize, rle.data(), mz_ulong(rle.size()), MZ_BEST_SPEED);
+		out.resize(sizeof(uint32_t) + compressedSize);
+	}
+
+	bool TerrainRegionStore::decompressBuffer(const unsigned char* data, size_t size, voxelInfo* out)
+	{
+		if(size < sizeof(uint32_t))
+		{
+			return false;
+		}
+		uint32_t rleSize;
+		memcpy(&rleSize, data, sizeof(rleSize));
+		std::vector<unsigned char> rle(rleSize);
+		mz_ulong destSize = rleSize;
+		if(mz_uncompress(rle.data(), &destSize, data + sizeof(uint32_t), mz_ulong(size - sizeof(uint32_t))) != MZ_OK || destSize != rleSize)
+		{
+			return false;
+		}
+		const size_t stride = sizeof(voxelInfo);
+		std::vector<unsigned char> planes(TERRAIN_VOXEL_COUNT * stride);
+		size_t pos = 0;
+		for(size_t i = 0; i + 1 < rle.size(); i += 2)
+		{
+			size_t run = rle[i];
+			if(pos + run > planes.size())
+			{
+				return false;
+			}
+			memset(planes.data() + pos, rle[i + 1], run);
+			pos += run;
+		}
+		if(pos != planes.size())
+		{
+			return false;
+		}
+		auto dst = reinterpret_cast<unsigned char *>(out);
+		for(size_t i = 0; i < TERRAIN_VOXEL_COUNT; i++)
+		{
+			for(size_t b = 0; b < stride; b++)
+			{
+				dst[i * stride + b] = planes[b * TERRAIN_VOXEL_COUNT + i];
+			}
+		}
+		return true;
+	}
+
+	bool TerrainRegionStore::decodeBlob(uint32_t version, const unsigned char* data, size_t size, voxelInfo* out)
+	{
+		uint32_t codec = TERRAIN_CODEC_DEFLATE;
+		if(version >= 2)
+		{
+			if(size < sizeof(uint32_t))
+			{
+				return false;
+			}
+			memcpy(&codec, data, sizeof(codec));
+			data += sizeof(uint32_t);
+			size -= sizeof(uint32_t);
+		}
+		if(codec == TERRAIN_CODEC_RAW)
+		{
+			if(size != TERRAIN_VOXEL_COUNT * sizeof(voxelInfo))
+			{
+				return false;
+			}
+			memcpy(out, data, size);
+			return true;
+		}
+		return decompressBuffer(data, size, out);
+	}
+
+	TerrainRegionStore::RegionTable* TerrainRegionStore::getTable(int regionX, int regionY, int regionZ)
+	{
+		uint64_t key = regionKey(regionX, regionY, regionZ);
+		auto iter = m_tableCache.find(key);
+		if(iter != m_tableCache.end())
+		{
+			return iter->second;
+		}
+		std::string path = getRegionPath(regionX, regionY, regionZ);
+		//saved while it was mapped last time, it is safe to take it now.
+		std::string pendingPath = path + ".pending";
+		if(std::filesystem::exists(pendingPath))
+		{
+			std::error_code err;
+			std::filesystem::rename(pendingPath, path, err);
+			if(err)
+			{
+				tlogError("can not apply terrain region %s : %s", pendingPath.c_str(), err.message().c_str());
+			}
+		}
+		//a missing region is cached as an empty table too
+		auto table = new RegionTable();
+		if(std::filesystem::exists(path) && !readTable(path, table))
+		{
+			tlogError("bad terrain region (%d %d %d), ignored", regionX, regionY, regionZ);
+		}
+		m_tableCache[key] = table;
+		return table;
+	}
+
+	bool TerrainRegionStore::readTable(std::string path, RegionTable* table)
+	{
+		memset(table, 0, sizeof(RegionTable));
+		auto file = fopen(path.c_str(), "rb");
+		if(!file)
+		{
+			return false;
+		}
+		TerrainRegionHeader header;
+		bool isValid = fread(&header, sizeof(header), 1, file) == 1
+			&& !memcmp(header.m_magic, TERRAIN_REGION_MAGIC, sizeof(header.m_magic))
+			&& header.m_version >= 1 && header.m_version <= TERRAIN_REGION_VERSION
+			&& fread(table->m_offset, sizeof(table->m_offset), 1, file) == 1
+			&& fread(table->m_size, sizeof(table->m_size), 1, file) == 1;
+		fclose(file);
+		if(!isValid)
+		{
+			memset(table, 0, sizeof(RegionTable));
+			return false;
+		}
+		table->m_version = header.m_version;
+		return true;
+	}
+
+	std::string TerrainRegionStore::getRegionPath(int regionX, int regionY, int regionZ) const
+	{
+		char name[64];
+		sprintf(name, "r.%d.%d.%d.region", regionX, regionY, regionZ);
+		return (std::filesystem::path(m_folder) / name).string();
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "GameMap.h"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+#include "Utility/file/MappedFile.h"
+
+//map buffers per axis in one region file
+#define TERRAIN_REGION_SIZE 8
+#define TERRAIN_REGION_SLOT_COUNT (TERRAIN_REGION_SIZE * TERRAIN_REGION_SIZE * TERRAIN_REGION_SIZE)
+
+namespace tzw
+{
+	struct TerrainRegionEntry
+	{
+		//buffer coordinate
+		int x;
+		int y;
+		int z;
+		const voxelInfo * m_buff;
+	};
+
+	// Random-access terrain storage, every TERRAIN_REGION_SIZE^3 map buffers share one file:
+	// header | offset table | buffers.
+	// A buffer is split into the byte planes of voxelInfo, run-length encoded (most of w is pure air or solid), then deflated.
+	// In mapped mode buffers are saved raw and page aligned instead, so they can be used straight from a copy-on-write mapping.
+	class TerrainRegionStore
+	{
+	public:
+		explicit TerrainRegionStore(std::string folder);
+		~TerrainRegionStore();
+		//thread safe, return false if the buffer has never been saved
+		bool load(int x, int y, int z, voxelInfo * out);
+		//thread safe, return the buffer inside the copy-on-write mapping of its region, or nullptr if it is not saved raw
+		voxelInfo * map(int x, int y, int z);
+		//only the given buffers are rewritten, the others in the same region are kept
+		void save(const std::vector<TerrainRegionEntry> & entryList);
+		void clear();
+		const std::string & getFolder() const;
+		void setIsMapped(bool isMapped);
+		bool isMapped() const;
+		static void compressBuffer(const voxelInfo * buff, std::vector<unsigned char> & out);
+		static bool decompressBuffer(const unsigned char * data, size_t size, voxelInfo * out);
+	private:
+		struct RegionTable
+		{
+			uint32_t m_version;
+			uint32_t m_offset[TERRAIN_REGION_SLOT_COUNT];
+			uint32_t m_size[TERRAIN_REGION_SLOT_COUNT];
+		};
+		RegionTable * getTable(int regionX, int regionY, int regionZ);
+		static bool readTable(std::string path, RegionTable * table);
+		static bool decodeBlob(uint32_t version, const unsigned char * data, size_t size, voxelInfo * out);
+		std::string getRegionPath(int regionX, int regionY, int regionZ) const;
+		std::string m_folder;
+		std::unordered_map<uint64_t, RegionTable *> m_tableCache;
+		//a mapped region file is never replaced while it is open, see save
+		std::unordered_map<uint64_t, MappedFile *> m_mappingCache;
+		std::mutex m_mutex;
+		bool m_isMapped;
+	};
+}
@@ -127,6 +127,8 @@ void Vehicle::enablePhysics()
 		// each island, for normal island we create a rigid, for constraint island, we create a constraint
 	for (auto island : m_islandList)
 	{
+		//the rebasing skipped while building rotates the island, do it before recording
+		island->updatePrincipalAxis();
 		//we need record the building rotation!!!!!
 		island->recordBuildingRotate();
 		island->enablePhysics(true);
@@ -1,6 +1,7 @@
 #include "Application/GameEntry.h"
 #include "CubeGame/GameWorld.h"
 #include "Application/CubeGame/GameScriptBinding.h"
+#include "Application/CubeGame/BenchmarkReplay.h"
 #include "Action/TintTo.h"
 #include "Action/ActionSequence.h"
 #include "Action/ActionCalFunc.h"
@@ -102,3 +103,32 @@ void TestVulkanEntry::onExit()
 void TestVulkanEntry::onUpdate(float delta)
 {
 }
+
+BenchmarkEntry::BenchmarkEntry(std::string scriptPath):
+	m_scriptPath(scriptPath)
+{
+}
+
+void BenchmarkEntry::onStart()
+{
+	g_binding_game_objects();
+	GameWorld::shared();
+	GameWorld::shared()->init();
+	if(!BenchmarkReplay::shared()->loadScript(m_scriptPath))
+	{
+		EngineDef::headlessExitCode = EXIT_FAILURE;
+		Engine::shared()->requestClose();
+		return;
+	}
+	EngineDef::headlessDeltaTime = BenchmarkReplay::shared()->getDelta();
+	BenchmarkReplay::shared()->start();
+}
+
+void BenchmarkEntry::onExit()
+{
+}
+
+void BenchmarkEntry::onUpdate(float delta)
+{
+	BenchmarkReplay::shared()->update(delta);
+}
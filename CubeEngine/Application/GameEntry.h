@@ -1,6 +1,7 @@
 #ifndef MYAPPDELEGATE_H
 #define MYAPPDELEGATE_H
 #include "EngineSrc/Engine/AppEntry.h"
+#include <string>
 
 #define GAME_MODE_PLAYGROUND 1
 #define GAME_MODE_SIM 2
@@ -29,4 +30,16 @@ public:
 private:
 	float m_ticks;
 };
+
+//headless replay of a benchmark script, see BenchmarkReplay
+class BenchmarkEntry :public tzw::AppEntry
+{
+public:
+	BenchmarkEntry(std::string scriptPath);
+	void onStart() override;
+	void onExit() override;
+	void onUpdate(float delta) override;
+private:
+	std::string m_scriptPath;
+};
 #endif // MYAPPDELEGATE_H
@@ -170,7 +170,7 @@ namespace tzw
 		io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);   // Load as RGBA 32-bits (75% of the memory is wasted, but default font is so small) because it is more likely to be compatible with user's existing shaders. If your ImTextureId represent a higher-level concept than just a GL texture id, consider calling GetTexDataAsAlpha8() instead to save on GPU memory.
 																  // Upload texture to graphics system
 		GLint last_texture;
-		if (Engine::shared()->getRenderDeviceType() != RenderDeviceType::Vulkan_Device)
+		if (Engine::shared()->getRenderDeviceType() == RenderDeviceType::OpenGl_Device)
 		{
 			
 			glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
@@ -192,7 +192,7 @@ namespace tzw
 		// Store our identifier
 		io.Fonts->TexID = reinterpret_cast<void *>(static_cast<intptr_t>(g_FontTexture));
 
-		if (Engine::shared()->getRenderDeviceType() != RenderDeviceType::Vulkan_Device)
+		if (Engine::shared()->getRenderDeviceType() == RenderDeviceType::OpenGl_Device)
 		{
 			// Restore state
 			glBindTexture(GL_TEXTURE_2D, last_texture);
@@ -166,9 +166,6 @@ void Sprite::setUpTechnique()
 
 void Sprite::setUpTransFormation(TransformationInfo& info)
 {
-	auto currCam = g_GetCurrScene()->defaultGUICamera();
-    info.m_projectMatrix = currCam->projection();
-    info.m_viewMatrix = currCam->getViewMatrix();
     info.m_worldMatrix = getTransform();
 }
 } // namespace tzw
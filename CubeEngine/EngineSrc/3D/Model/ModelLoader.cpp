@@ -4,11 +4,247 @@
 #include "../Effect/Effect.h"
 #include "EngineSrc/Technique/MaterialPool.h"
 #include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
 #include "Utility/file/Tfile.h"
 #include "Utility/misc/Tmisc.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
 
 namespace tzw {
 
+// .tzwb layout: header | material table | mesh table | material json texts | material file path | vertex blobs | index blobs
+// every blob starts on a 16 byte boundary, so the vertices can be used straight from the read buffer.
+#define MODEL_BINARY_VERSION 2
+#define MODEL_BINARY_ALIGN 16
+//size and modification time of a source file when the model was converted
+struct ModelBinarySource
+{
+	uint64_t m_size;
+	uint64_t m_time;
+};
+
+struct ModelBinaryHeader
+{
+	char m_magic[4];
+	uint32_t m_version;
+	//sizeof(VertexData) of the writer, the file is ignored if the engine layout changed since
+	uint32_t m_vertexSize;
+	//1 for the entries of a MaterialsFileName file, 0 for the old materialList entries
+	uint32_t m_materialKind;
+	uint32_t m_materialCount;
+	uint32_t m_meshCount;
+	uint32_t m_materialTableOffset;
+	uint32_t m_meshTableOffset;
+	//the binary is stale once the .tzw or its MaterialsFileName file differ from these
+	ModelBinarySource m_source;
+	ModelBinarySource m_materialSource;
+	//null terminated path of the MaterialsFileName file, m_materialPathSize is 0 for the old materialList entries
+	uint32_t m_materialPathOffset;
+	uint32_t m_materialPathSize;
+};
+
+struct ModelBinaryMaterial
+{
+	//null terminated json text of the material entry
+	uint32_t m_offset;
+	uint32_t m_size;
+};
+
+struct ModelBinaryMesh
+{
+	uint32_t m_matIndex;
+	uint32_t m_vertexCount;
+	uint32_t m_indexCount;
+	uint32_t m_vertexOffset;
+	uint32_t m_indexOffset;
+	float m_aabbMin[3];
+	float m_aabbMax[3];
+};
+
+static bool parseJsonFile(std::string filePath, rapidjson::Document & doc)
+{
+	auto data = Tfile::shared()->getData(Tmisc::getUserPath(filePath),true);
+	doc.Parse<rapidjson::kParseDefaultFlags>(data.getString().c_str());
+	if (doc.HasParseError())
+	{
+		tlog("[error] get json data err! %s %d offset %d",
+			filePath.c_str(),
+			doc.GetParseError(),
+			doc.GetErrorOffset());
+		return false;
+	}
+	return true;
+}
+
+//the tangents and the bounding box are calculated, but nothing is passed to the GPU
+static Mesh * createJsonMesh(rapidjson::Value & meshData)
+{
+	auto theMesh = new Mesh();
+	//get vertices
+	auto &verticesData = meshData["vertices"];
+	theMesh->m_vertices.reserve(verticesData.Size());
+	for(unsigned int k = 0; k < verticesData.Size();k++)
+	{
+		auto& v = verticesData[k];
+		theMesh->addVertex(VertexData(vec3(v[0].GetDouble(),v[1].GetDouble(),v[2].GetDouble()),
+				vec3(v[3].GetDouble(),v[4].GetDouble(),v[5].GetDouble()),
+				vec2(v[6].GetDouble(),v[7].GetDouble())));
+	}
+	//get indices
+	auto &indicesData = meshData["indices"];
+	theMesh->m_indices.reserve(indicesData.Size());
+	for(unsigned int k = 0; k < indicesData.Size();k++)
+	{
+		theMesh->addIndex(indicesData[k].GetInt());
+	}
+	//material
+	theMesh->setMatIndex(meshData["materialIndex"].GetInt());
+	theMesh->finish(false);
+	return theMesh;
+}
+
+static bool isInFile(uint64_t offset, uint64_t size, size_t fileSize)
+{
+	return offset + size <= fileSize;
+}
+
+//only loose files have a size and a time to compare, a packed model is trusted as it is built with its binary
+static bool findLooseSource(std::string filePath, std::string & realPath)
+{
+	for(auto & path : Tfile::shared()->getAbsolutlyFilePath(filePath))
+	{
+		if(std::filesystem::exists(path))
+		{
+			realPath = path;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool getSourceStamp(std::string filePath, ModelBinarySource & source)
+{
+	std::string realPath;
+	if(!findLooseSource(filePath, realPath)) return false;
+	std::error_code error;
+	source.m_size = uint64_t(std::filesystem::file_size(realPath, error));
+	if(error) return false;
+	source.m_time = uint64_t(std::filesystem::last_write_time(realPath, error).time_since_epoch().count());
+	return !error;
+}
+
+static bool isSourceChanged(std::string filePath, const ModelBinarySource & stamp)
+{
+	ModelBinarySource source;
+	if(!getSourceStamp(filePath, source)) return false;
+	return source.m_size != stamp.m_size || source.m_time != stamp.m_time;
+}
+
+static std::string getMaterialPath(const unsigned char * bytes, const ModelBinaryHeader * header)
+{
+	if(!header->m_materialPathSize) return "";
+	return reinterpret_cast<const char *>(bytes + header->m_materialPathOffset);
+}
+
+static bool isNullTerminated(const unsigned char * bytes, size_t size, uint32_t offset, uint32_t length)
+{
+	return length != 0 && isInFile(offset, length, size) && bytes[offset + length - 1] == '\0';
+}
+
+//check every table and blob against the file size, returns nullptr if the file can't be used
+static const ModelBinaryHeader * checkBinary(const unsigned char * bytes, size_t size, std::string filePath)
+{
+	if(size < sizeof(ModelBinaryHeader))
+	{
+		tlogError("bad model binary %s", filePath.c_str());
+		return nullptr;
+	}
+	auto header = reinterpret_cast<const ModelBinaryHeader *>(bytes);
+	if(memcmp(header->m_magic, "TZWB", 4) != 0 || header->m_version != MODEL_BINARY_VERSION || header->m_vertexSize != sizeof(VertexData))
+	{
+		tlogError("outdated model binary %s, convert it again", filePath.c_str());
+		return nullptr;
+	}
+	if(!isInFile(header->m_materialTableOffset, uint64_t(header->m_materialCount) * sizeof(ModelBinaryMaterial), size)
+		|| !isInFile(header->m_meshTableOffset, uint64_t(header->m_meshCount) * sizeof(ModelBinaryMesh), size))
+	{
+		tlogError("bad model binary %s", filePath.c_str());
+		return nullptr;
+	}
+	auto materialTable = reinterpret_cast<const ModelBinaryMaterial *>(bytes + header->m_materialTableOffset);
+	for(uint32_t i = 0; i < header->m_materialCount; i++)
+	{
+		auto & mat = materialTable[i];
+		if(!isNullTerminated(bytes, size, mat.m_offset, mat.m_size))
+		{
+			tlogError("bad model binary %s", filePath.c_str());
+			return nullptr;
+		}
+	}
+	if(header->m_materialPathSize && !isNullTerminated(bytes, size, header->m_materialPathOffset, header->m_materialPathSize))
+	{
+		tlogError("bad model binary %s", filePath.c_str());
+		return nullptr;
+	}
+	auto meshTable = reinterpret_cast<const ModelBinaryMesh *>(bytes + header->m_meshTableOffset);
+	for(uint32_t i = 0; i < header->m_meshCount; i++)
+	{
+		auto & mesh = meshTable[i];
+		if(mesh.m_vertexOffset % MODEL_BINARY_ALIGN != 0 || mesh.m_indexOffset % MODEL_BINARY_ALIGN != 0
+			|| !isInFile(mesh.m_vertexOffset, uint64_t(mesh.m_vertexCount) * sizeof(VertexData), size)
+			|| !isInFile(mesh.m_indexOffset, uint64_t(mesh.m_indexCount) * sizeof(short_u), size)
+			|| mesh.m_matIndex >= header->m_materialCount)
+		{
+			tlogError("bad model binary %s", filePath.c_str());
+			return nullptr;
+		}
+		auto indices = reinterpret_cast<const short_u *>(bytes + mesh.m_indexOffset);
+		for(uint32_t k = 0; k < mesh.m_indexCount; k++)
+		{
+			if(indices[k] >= mesh.m_vertexCount)
+			{
+				tlogError("bad model binary %s, index out of range in mesh %u", filePath.c_str(), i);
+				return nullptr;
+			}
+		}
+	}
+	return header;
+}
+
+static Mesh * createBinaryMesh(const unsigned char * bytes, const ModelBinaryMesh & meshInfo)
+{
+	auto theMesh = new Mesh();
+	auto vertices = reinterpret_cast<const VertexData *>(bytes + meshInfo.m_vertexOffset);
+	auto indices = reinterpret_cast<const short_u *>(bytes + meshInfo.m_indexOffset);
+	theMesh->m_vertices.assign(vertices, vertices + meshInfo.m_vertexCount);
+	theMesh->m_indices.assign(indices, indices + meshInfo.m_indexCount);
+	theMesh->setMatIndex(meshInfo.m_matIndex);
+	AABB aabb;
+	aabb.setMin(vec3(meshInfo.m_aabbMin[0], meshInfo.m_aabbMin[1], meshInfo.m_aabbMin[2]));
+	aabb.setMax(vec3(meshInfo.m_aabbMax[0], meshInfo.m_aabbMax[1], meshInfo.m_aabbMax[2]));
+	theMesh->setAabb(aabb);
+	return theMesh;
+}
+
+static uint32_t appendBlob(std::vector<unsigned char> & buffer, const void * bytes, size_t size)
+{
+	buffer.resize((buffer.size() + MODEL_BINARY_ALIGN - 1) / MODEL_BINARY_ALIGN * MODEL_BINARY_ALIGN, 0);
+	auto offset = uint32_t(buffer.size());
+	auto begin = static_cast<const unsigned char *>(bytes);
+	buffer.insert(buffer.end(), begin, begin + size);
+	return offset;
+}
+
+static std::string toJsonText(rapidjson::Value & value)
+{
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+	value.Accept(writer);
+	return buffer.GetString();
+}
+
 ModelLoader::ModelLoader()
 {
 
@@ -27,37 +263,186 @@ void ModelLoader::loadModel(Model *model, std::string filePath, bool useCache)
 		}
 	}
 	model->filePath = filePath;
+	auto binaryPath = getBinaryPath(filePath);
+	bool isLoaded = false;
+	if(Tfile::shared()->isExist(binaryPath))
+	{
+		isLoaded = loadBinary(model, filePath, binaryPath);
+	}
+	if(!isLoaded)
+	{
+		isLoaded = loadJson(model, filePath);
+		//write the binary for the next load, a missing, stale or broken one is replaced
+		std::string sourcePath;
+		if(isLoaded && findLooseSource(filePath, sourcePath))
+		{
+			convertToBinary(filePath);
+		}
+	}
+	if(isLoaded && useCache)
+	{
+		m_modelCache[filePath] = model;
+	}
+}
+
+bool ModelLoader::convertToBinary(std::string filePath, std::string outPath)
+{
+	std::string sourcePath;
+	ModelBinaryHeader header;
+	memset(&header, 0, sizeof(ModelBinaryHeader));
+	if(!findLooseSource(filePath, sourcePath) || !getSourceStamp(filePath, header.m_source))
+	{
+		tlogError("can't convert %s, only loose model files are supported", filePath.c_str());
+		return false;
+	}
+	if(outPath.empty())
+	{
+		outPath = getBinaryPath(sourcePath);
+	}
 	rapidjson::Document doc;
-	auto data = Tfile::shared()->getData(Tmisc::getUserPath(filePath),true);
-	auto relativeFilePath = Tfile::shared()->getReleativePath(filePath);
-	auto folder = Tfile::shared()->getFolder(filePath);
-	doc.Parse<rapidjson::kParseDefaultFlags>(data.getString().c_str());
-	if (doc.HasParseError())
+	if(!parseJsonFile(filePath, doc)) return false;
+
+	memcpy(header.m_magic, "TZWB", 4);
+	header.m_version = MODEL_BINARY_VERSION;
+	header.m_vertexSize = sizeof(VertexData);
+	std::vector<std::string> materialTextList;
+	std::string materialPath;
+	if(doc.HasMember("MaterialsFileName"))
 	{
-		tlog("[error] get json data err! %s %d offset %d",
-			filePath.c_str(),
-			doc.GetParseError(),
-			doc.GetErrorOffset());
-		return;
+		rapidjson::Document matDoc;
+		auto folder = Tfile::shared()->getFolder(filePath);
+		materialPath = Tfile::shared()->toAbsFilePath(doc["MaterialsFileName"].GetString(), folder);
+		if(!parseJsonFile(materialPath, matDoc)) return false;
+		getSourceStamp(materialPath, header.m_materialSource);
+		auto& matList = matDoc["MaterialList"];
+		for(unsigned int i = 0; i < matList.Size(); i++)
+		{
+			materialTextList.push_back(toJsonText(matList[i]));
+		}
+		header.m_materialKind = 1;
+	}
+	else
+	{
+		auto& materialList = doc["materialList"];
+		for(unsigned int i = 0; i < materialList.Size(); i++)
+		{
+			materialTextList.push_back(toJsonText(materialList[i]));
+		}
+		header.m_materialKind = 0;
+	}
+	std::vector<Mesh *> meshList;
+	auto& meshListData = doc["MeshList"];
+	for(unsigned int i = 0; i < meshListData.Size(); i++)
+	{
+		meshList.push_back(createJsonMesh(meshListData[i]));
 	}
+	header.m_materialCount = uint32_t(materialTextList.size());
+	header.m_meshCount = uint32_t(meshList.size());
+
+	//the tables are filled in once the blob offsets are known
+	std::vector<ModelBinaryMaterial> materialTable(materialTextList.size());
+	std::vector<ModelBinaryMesh> meshTable(meshList.size());
+	std::vector<unsigned char> buffer(sizeof(ModelBinaryHeader), 0);
+	header.m_materialTableOffset = appendBlob(buffer, materialTable.data(), materialTable.size() * sizeof(ModelBinaryMaterial));
+	header.m_meshTableOffset = appendBlob(buffer, meshTable.data(), meshTable.size() * sizeof(ModelBinaryMesh));
+	for(size_t i = 0; i < materialTextList.size(); i++)
+	{
+		auto & text = materialTextList[i];
+		materialTable[i].m_size = uint32_t(text.size() + 1);
+		materialTable[i].m_offset = appendBlob(buffer, text.c_str(), text.size() + 1);
+	}
+	if(!materialPath.empty())
+	{
+		header.m_materialPathSize = uint32_t(materialPath.size() + 1);
+		header.m_materialPathOffset = appendBlob(buffer, materialPath.c_str(), materialPath.size() + 1);
+	}
+	for(size_t i = 0; i < meshList.size(); i++)
+	{
+		auto mesh = meshList[i];
+		auto & meshInfo = meshTable[i];
+		meshInfo.m_matIndex = mesh->getMatIndex();
+		meshInfo.m_vertexCount = uint32_t(mesh->m_vertices.size());
+		meshInfo.m_indexCount = uint32_t(mesh->m_indices.size());
+		meshInfo.m_vertexOffset = appendBlob(buffer, mesh->m_vertices.data(), mesh->m_vertices.size() * sizeof(VertexData));
+		meshInfo.m_indexOffset = appendBlob(buffer, mesh->m_indices.data(), mesh->m_indices.size() * sizeof(short_u));
+		auto aabb = mesh->getAabb();
+		meshInfo.m_aabbMin[0] = aabb.min().x;
+		meshInfo.m_aabbMin[1] = aabb.min().y;
+		meshInfo.m_aabbMin[2] = aabb.min().z;
+		meshInfo.m_aabbMax[0] = aabb.max().x;
+		meshInfo.m_aabbMax[1] = aabb.max().y;
+		meshInfo.m_aabbMax[2] = aabb.max().z;
+		delete mesh;
+	}
+	memcpy(buffer.data(), &header, sizeof(ModelBinaryHeader));
+	memcpy(buffer.data() + header.m_materialTableOffset, materialTable.data(), materialTable.size() * sizeof(ModelBinaryMaterial));
+	memcpy(buffer.data() + header.m_meshTableOffset, meshTable.data(), meshTable.size() * sizeof(ModelBinaryMesh));
+
+	FILE * fp = fopen(outPath.c_str(), "wb");
+	if(!fp)
+	{
+		tlogError("can't write %s", outPath.c_str());
+		return false;
+	}
+	fwrite(buffer.data(), 1, buffer.size(), fp);
+	fclose(fp);
+	tlog("model %s converted to %s, %zu bytes", filePath.c_str(), outPath.c_str(), buffer.size());
+	return true;
+}
+
+bool ModelLoader::readMeshes(std::string filePath, std::vector<Mesh*>& meshList)
+{
+	if(Tfile::shared()->getExtension(filePath) == "tzwb")
+	{
+		//a plain path, the binary may live outside the search paths
+		FILE * fp = fopen(filePath.c_str(), "rb");
+		if(!fp) return false;
+		fseek(fp, 0, SEEK_END);
+		std::vector<unsigned char> bytes(size_t(ftell(fp)));
+		fseek(fp, 0, SEEK_SET);
+		bool isRead = fread(bytes.data(), 1, bytes.size(), fp) == bytes.size();
+		fclose(fp);
+		if(!isRead) return false;
+		auto header = checkBinary(bytes.data(), bytes.size(), filePath);
+		if(!header) return false;
+		auto meshTable = reinterpret_cast<const ModelBinaryMesh *>(bytes.data() + header->m_meshTableOffset);
+		for(uint32_t i = 0; i < header->m_meshCount; i++)
+		{
+			meshList.push_back(createBinaryMesh(bytes.data(), meshTable[i]));
+		}
+		return true;
+	}
+	rapidjson::Document doc;
+	if(!parseJsonFile(filePath, doc)) return false;
+	auto& meshListData = doc["MeshList"];
+	for(unsigned int i = 0; i < meshListData.Size(); i++)
+	{
+		meshList.push_back(createJsonMesh(meshListData[i]));
+	}
+	return true;
+}
+
+std::string ModelLoader::getBinaryPath(std::string filePath)
+{
+	return Tfile::shared()->getFileNameWithOutExtension(filePath) + ".tzwb";
+}
+
+bool ModelLoader::loadJson(Model* model, std::string filePath)
+{
+	rapidjson::Document doc;
+	if(!parseJsonFile(filePath, doc)) return false;
+	auto relativeFilePath = Tfile::shared()->getReleativePath(filePath);
+	auto folder = Tfile::shared()->getFolder(filePath);
 
 	//get the material
 	auto matPool = MaterialPool::shared();
-	auto tmgr = TextureMgr::shared();
 	auto& materialList = doc["materialList"];
 	auto mangleedName = matPool->getModelMangleedName(relativeFilePath);
 	if(doc.HasMember("MaterialsFileName"))
 	{
-		
-		auto mData = Tfile::shared()->getData(Tfile::shared()->toAbsFilePath(doc["MaterialsFileName"].GetString(), folder),true);
 		rapidjson::Document matDoc;
-		matDoc.Parse<rapidjson::kParseDefaultFlags>(mData.getString().c_str());
-		if (matDoc.HasParseError())
+		if(!parseJsonFile(Tfile::shared()->toAbsFilePath(doc["MaterialsFileName"].GetString(), folder), matDoc))
 		{
-			tlog("[error] get json data err! %s %d offset %d",
-				filePath.c_str(),
-				matDoc.GetParseError(),
-				matDoc.GetErrorOffset());
 			abort();
 		}
 		auto& matList = matDoc["MaterialList"];
@@ -72,56 +457,10 @@ void ModelLoader::loadModel(Model *model, std::string filePath, bool useCache)
 	{
 		for (unsigned int i = 0;i<materialList.Size();i++)
 		{
-			auto & materialData = materialList[i];
-			// reuse material // there is a problem
-			Material* mat = nullptr;//matPool->getMaterialByName(mangleedName);
-			//if (!mat)
-			//{
-			//	mat = new Material();
-			//	matPool->addMaterial(mangleedName,mat);
-			//}
-
-			if(materialData.HasMember("effectType"))
-			{
-				mat = Material::createFromTemplate(materialData["effectType"].GetString());
-			}else
-			{
-				mat = Material::createFromTemplate("ModelPBR");
-			}
-			auto thestr = materialData["diffuseMap"].GetString();
-			if (strcmp(thestr, "") != 0)
-			{
-				mat->setTex("DiffuseMap",
-					tmgr->getByPath(Tfile::shared()->toAbsFilePath(materialData["diffuseMap"].GetString(), folder), true));
-			}
-			if (strcmp(materialData["normalMap"].GetString(), "") != 0)
-			{
-				mat->setTex("NormalMap",
-					tmgr->getByPath(Tfile::shared()->toAbsFilePath(materialData["normalMap"].GetString(), folder), true));
-			}
-			else
-			{
-				//default Normal Map
-				mat->setTex("NormalMap", tmgr->getByPath("Texture/BuiltInTexture/defaultNormalMap.png", true));
-			}
-
-			if (materialData.HasMember("roughnessMap") && strcmp(materialData["roughnessMap"].GetString(), "") != 0)
-			{
-				mat->setTex("RoughnessMap",
-					tmgr->getByPath(Tfile::shared()->toAbsFilePath(materialData["roughnessMap"].GetString(), folder), true));
-			}
-			else
-			{
-				//default Normal Map
-				mat->setTex("NormalMap", tmgr->getByPath("Texture/BuiltInTexture/defaultNormalMap.png", true));
-			}
-			//default Roughness Map
-			mat->setTex("RoughnessMap", tmgr->getByPath("Texture/BuiltInTexture/defaultRoughnessMap.png", true));
-			mat->setTex("MetallicMap", TextureMgr::shared()->getByPath("Texture/BuiltInTexture/defaultMetallic.png", true));
-			model->m_effectList.push_back(mat);
+			model->m_effectList.push_back(createLegacyMaterial(materialList[i], folder));
 		}
 	}
-	
+
 
 	//get the Mesh
 	auto& meshList = doc["MeshList"];
@@ -132,35 +471,115 @@ void ModelLoader::loadModel(Model *model, std::string filePath, bool useCache)
 		Mesh * theMesh = MaterialPool::shared()->getMeshByName(meshName);
 		if(!theMesh)//mesh use cache
 		{
-			theMesh = new Mesh();
-			auto & meshData = meshList[i];
-			//get vertices
-			auto &verticesData = meshData["vertices"];
-			for(unsigned int k = 0; k < verticesData.Size();k++)
-			{
-				auto& v = verticesData[k];
-				theMesh->addVertex(VertexData(vec3(v[0].GetDouble(),v[1].GetDouble(),v[2].GetDouble()),
-						vec3(v[3].GetDouble(),v[4].GetDouble(),v[5].GetDouble()),
-						vec2(v[6].GetDouble(),v[7].GetDouble())));
-			}
-			//get indices
-			auto &indicesData = meshData["indices"];
-			for(unsigned int k = 0; k < indicesData.Size();k++)
-			{
-				theMesh->addIndex(indicesData[k].GetInt());
-			}
-			//material
-			theMesh->setMatIndex(meshData["materialIndex"].GetInt());
-			//theMesh->caclNormals();
-			theMesh->finish(true);
+			theMesh = createJsonMesh(meshList[i]);
+			theMesh->submit();
 			MaterialPool::shared()->addMesh(meshName, theMesh);
 		}
 		model->m_meshList.push_back(theMesh);
 	}
-	if(useCache)
+	return true;
+}
+
+bool ModelLoader::loadBinary(Model* model, std::string filePath, std::string binaryPath)
+{
+	//one read for the whole model
+	auto data = Tfile::shared()->getData(binaryPath, false);
+	auto bytes = data.getBytes();
+	auto header = checkBinary(bytes, data.getSize(), binaryPath);
+	if(!header) return false;
+	if(isSourceChanged(filePath, header->m_source)
+		|| (header->m_materialPathSize && isSourceChanged(getMaterialPath(bytes, header), header->m_materialSource)))
 	{
-		m_modelCache[filePath] = model;
+		tlog("%s is older than its source, the json is loaded and the binary written again", binaryPath.c_str());
+		return false;
+	}
+	//same names as the json version, so the mesh cache is shared
+	auto relativeFilePath = Tfile::shared()->getReleativePath(filePath);
+	auto folder = Tfile::shared()->getFolder(filePath);
+	auto mangleedName = MaterialPool::shared()->getModelMangleedName(relativeFilePath);
+
+	auto materialTable = reinterpret_cast<const ModelBinaryMaterial *>(bytes + header->m_materialTableOffset);
+	for(uint32_t i = 0; i < header->m_materialCount; i++)
+	{
+		rapidjson::Document matDoc;
+		matDoc.Parse<rapidjson::kParseDefaultFlags>(reinterpret_cast<const char *>(bytes + materialTable[i].m_offset));
+		if(header->m_materialKind == 1)
+		{
+			model->m_effectList.push_back(Material::createFromJson(matDoc, folder));
+		}
+		else
+		{
+			model->m_effectList.push_back(createLegacyMaterial(matDoc, folder));
+		}
+	}
+
+	auto meshTable = reinterpret_cast<const ModelBinaryMesh *>(bytes + header->m_meshTableOffset);
+	for(uint32_t i = 0; i < header->m_meshCount; i++)
+	{
+		char meshName[512];
+		sprintf(meshName,"%s_%d",mangleedName.c_str(), i);
+		Mesh * theMesh = MaterialPool::shared()->getMeshByName(meshName);
+		if(!theMesh)
+		{
+			//tangents and bounding box are already in the file
+			theMesh = createBinaryMesh(bytes, meshTable[i]);
+			theMesh->submit();
+			MaterialPool::shared()->addMesh(meshName, theMesh);
+		}
+		model->m_meshList.push_back(theMesh);
+	}
+	return true;
+}
+
+Material* ModelLoader::createLegacyMaterial(rapidjson::Value& materialData, std::string folder)
+{
+	auto tmgr = TextureMgr::shared();
+	// reuse material // there is a problem
+	Material* mat = nullptr;//matPool->getMaterialByName(mangleedName);
+	//if (!mat)
+	//{
+	//	mat = new Material();
+	//	matPool->addMaterial(mangleedName,mat);
+	//}
+
+	if(materialData.HasMember("effectType"))
+	{
+		mat = Material::createFromTemplate(materialData["effectType"].GetString());
+	}else
+	{
+		mat = Material::createFromTemplate("ModelPBR");
+	}
+	auto thestr = materialData["diffuseMap"].GetString();
+	if (strcmp(thestr, "") != 0)
+	{
+		mat->setTex("DiffuseMap",
+			tmgr->getByPath(Tfile::shared()->toAbsFilePath(materialData["diffuseMap"].GetString(), folder), true));
+	}
+	if (strcmp(materialData["normalMap"].GetString(), "") != 0)
+	{
+		mat->setTex("NormalMap",
+			tmgr->getByPath(Tfile::shared()->toAbsFilePath(materialData["normalMap"].GetString(), folder), true));
+	}
+	else
+	{
+		//default Normal Map
+		mat->setTex("NormalMap", tmgr->getByPath("Texture/BuiltInTexture/defaultNormalMap.png", true));
+	}
+
+	if (materialData.HasMember("roughnessMap") && strcmp(materialData["roughnessMap"].GetString(), "") != 0)
+	{
+		mat->setTex("RoughnessMap",
+			tmgr->getByPath(Tfile::shared()->toAbsFilePath(materialData["roughnessMap"].GetString(), folder), true));
+	}
+	else
+	{
+		//default Normal Map
+		mat->setTex("NormalMap", tmgr->getByPath("Texture/BuiltInTexture/defaultNormalMap.png", true));
 	}
+	//default Roughness Map
+	mat->setTex("RoughnessMap", tmgr->getByPath("Texture/BuiltInTexture/defaultRoughnessMap.png", true));
+	mat->setTex("MetallicMap", TextureMgr::shared()->getByPath("Texture/BuiltInTexture/defaultMetallic.png", true));
+	return mat;
 }
 
 } // namespace tzw
@@ -4,16 +4,33 @@
 #include <rapidjson/rapidjson.h>
 #include <rapidjson/document.h>
 #include <unordered_map>
+#include <vector>
 
 namespace tzw {
 class Model;
+class Mesh;
+class Material;
+// Loads the json .tzw models, or the binary .tzwb next to them when there is one and it is up to date.
+// a .tzwb is written by convertToBinary, after a loose model was loaded from json or ahead of time with
+// CubeEngine -convert <model.tzw>... the vertices are stored after Mesh::finish so they only need to be uploaded.
+// it keeps the size and time of the .tzw and of its materials file, the json is loaded (and the .tzwb written
+// again) once either of them changed.
 class ModelLoader : public Singleton<ModelLoader>
 {
 public:
     ModelLoader();
     void loadModel(Model * model,std::string filePath, bool useCache = false);
+	//write <name>.tzwb beside the loose json file or to outPath, returns false if the model is packed or can't be read
+	bool convertToBinary(std::string filePath, std::string outPath = "");
+	//geometry only, the meshes are neither cached nor passed to the GPU, the caller owns them.
+	//a .tzwb is read from the plain file system path, a .tzw through the search paths
+	bool readMeshes(std::string filePath, std::vector<Mesh *> & meshList);
+	std::string getBinaryPath(std::string filePath);
 
   private:
+	bool loadJson(Model * model, std::string filePath);
+	bool loadBinary(Model * model, std::string filePath, std::string binaryPath);
+	Material * createLegacyMaterial(rapidjson::Value & materialData, std::string folder);
 	std::unordered_map<std::string, Model *> m_modelCache;
 };
 
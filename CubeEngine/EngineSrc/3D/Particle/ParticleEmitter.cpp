@@ -44,9 +44,6 @@ ParticleEmitter::ParticleEmitter(int maxSpawn)
 void
 ParticleEmitter::setUpTransFormation(TransformationInfo& info)
 {
-  auto currCam = g_GetCurrScene()->defaultCamera();
-  info.m_projectMatrix = currCam->projection();
-  info.m_viewMatrix = currCam->getViewMatrix();
   Matrix44 mat;
   mat.setToIdentity();
   info.m_worldMatrix = mat;
@@ -52,10 +52,6 @@ void LinePrimitive::initBuffer()
 
 void LinePrimitive::setUpTransFormation(TransformationInfo & info)
 {
-	auto currCam = g_GetCurrScene()->defaultCamera();
-	
-	info.m_projectMatrix = currCam->projection();
-    info.m_viewMatrix = currCam->getViewMatrix();
     info.m_worldMatrix = getTransform();
 	info.m_worldMatrix.stripScale();
 }
@@ -5,9 +5,15 @@
 #include "transvoxel_tables.h"
 #include "CubeGame/GameConfig.h"
 #include <algorithm>
+#include <vector>
 
 #include "MarchingCubes.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TV_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 
 
 struct Vector3i
@@ -127,26 +133,12 @@ enum Corner {
 static const float FIXED_FACTOR = 1.f / 256.f;
 namespace tzw {
 
-	tzw::VertexData genVertexData(VoxelVertex v)
-	{
-		tzw::VertexData a(v.vertex);
-		a.m_matIndex[0] = v.matInfo.matIndex1;
-		a.m_matIndex[1] = v.matInfo.matIndex2;
-		a.m_matIndex[2] = v.matInfo.matIndex3;
-		float factor1 = HIGH_FOUR_BIT( v.matInfo.matBlendFactor) / 15.f;
-		float factor2 = LOW_FOUR_BIT( v.matInfo.matBlendFactor) / 15.f;
-		float factor3 = 1 - factor1 - factor2;
-		a.m_matBlendFactor = vec3(factor1, factor2, factor3);
-		a.m_texCoord = v.vertex.xz();
-		return a;
-	}
-
-	VoxelVertex getVoxelVertex(vec3 v, vec3 basePoint, voxelInfo * vi0, voxelInfo * vi1)
+	// fixedPos is in 1/256 voxel, which is exact for every vertex TransVoxel generates.
+	// the mesh's packed transform maps it to world space, see generateWithoutNormal
+	static TerrainVertex genTerrainVertex(const Vector3i & fixedPos, vec3 normal, voxelInfo * vi)
 	{
-		VoxelVertex vertex;
-		vertex.vertex =  vec3(v.x * BLOCK_SIZE, v.y * BLOCK_SIZE, v.z * BLOCK_SIZE) + basePoint;
-		vertex.matInfo = vi0->matInfo;
-		return vertex;
+		unsigned short packedPos[3] = {(unsigned short)fixedPos.x, (unsigned short)fixedPos.y, (unsigned short)fixedPos.z};
+		return TerrainVertex(packedPos, normal, vi->matInfo);
 	}
 
 inline uint8_t get_border_mask(const Vector3i &pos, const Vector3i &block_size) {
@@ -209,6 +201,199 @@ struct voxelPosInfo
 	Vector3i v;
 	voxelInfo * info;
 };
+
+// The corners of the regular cells (and the transition cells, they are a subset) are in [MIN_PADDING, VOXEL_SIZE - MAX_PADDING],
+// they are copied into a plane with x contiguous, so a whole row of cells can be classified at once.
+// Each row is padded with its last value up to getCornerRowStride, so the unaligned loads at x + 1 never leave the row.
+static int getCornerRowStride(int VOXEL_SIZE)
+{
+	int cornerCount = VOXEL_SIZE - MIN_PADDING - MAX_PADDING + 1;
+	return ((cornerCount + 15) & ~15) + 16;
+}
+
+static int getCornerIndex(int VOXEL_SIZE, int rowStride, int x, int y, int z)
+{
+	return ((z - MIN_PADDING) * VOXEL_SIZE + (y - MIN_PADDING)) * rowStride + (x - MIN_PADDING);
+}
+
+static bool signCornerPlaneScalar(std::vector<uint8_t> & plane, int VOXEL_SIZE)
+{
+	const int cornerCount = VOXEL_SIZE - MIN_PADDING - MAX_PADDING + 1;
+	const int rowStride = getCornerRowStride(VOXEL_SIZE);
+	uint8_t minW = 0xff;
+	uint8_t maxW = 0;
+	for (int z = 0; z < cornerCount; z++)
+	{
+		for (int y = 0; y < cornerCount; y++)
+		{
+			const uint8_t * row = &plane[(z * VOXEL_SIZE + y) * rowStride];
+			for (int x = 0; x < cornerCount; x++)
+			{
+				minW = std::min(minW, row[x]);
+				maxW = std::max(maxW, row[x]);
+			}
+		}
+	}
+	if (maxW < 128 || minW >= 128)
+	{
+		return false;
+	}
+	for (int z = 0; z < cornerCount; z++)
+	{
+		for (int y = 0; y < cornerCount; y++)
+		{
+			uint8_t * row = &plane[(z * VOXEL_SIZE + y) * rowStride];
+			for (int x = 0; x < rowStride; x++)
+			{
+				row[x] = row[x] >= 128 ? 0xff : 0;
+			}
+		}
+	}
+	return true;
+}
+
+#ifdef TV_USE_SSE2
+static bool signCornerPlaneSSE2(std::vector<uint8_t> & plane, int VOXEL_SIZE)
+{
+	const int cornerCount = VOXEL_SIZE - MIN_PADDING - MAX_PADDING + 1;
+	const int rowStride = getCornerRowStride(VOXEL_SIZE);
+	__m128i minW = _mm_set1_epi8(char(0xff));
+	__m128i maxW = _mm_setzero_si128();
+	for (int z = 0; z < cornerCount; z++)
+	{
+		for (int y = 0; y < cornerCount; y++)
+		{
+			const uint8_t * row = &plane[(z * VOXEL_SIZE + y) * rowStride];
+			for (int x = 0; x < rowStride; x += 16)
+			{
+				__m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x));
+				minW = _mm_min_epu8(minW, w);
+				maxW = _mm_max_epu8(maxW, w);
+			}
+		}
+	}
+	// a lane is uniform when min and max share the sign bit, the block is uniform when every lane agrees on the same sign
+	int minSign = _mm_movemask_epi8(minW);
+	int maxSign = _mm_movemask_epi8(maxW);
+	if (maxSign == 0 || minSign == 0xffff)
+	{
+		return false;
+	}
+	const __m128i zero = _mm_setzero_si128();
+	for (int z = 0; z < cornerCount; z++)
+	{
+		for (int y = 0; y < cornerCount; y++)
+		{
+			uint8_t * row = &plane[(z * VOXEL_SIZE + y) * rowStride];
+			for (int x = 0; x < rowStride; x += 16)
+			{
+				__m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x));
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(row + x), _mm_cmplt_epi8(w, zero));
+			}
+		}
+	}
+	return true;
+}
+#endif
+
+// return false if all the corners are on the same side of the iso surface, nothing to mesh then.
+// otherwise the plane is turned into sign masks, 0xff for solid corner.
+static bool buildCornerPlane(voxelInfo * srcData, int VOXEL_SIZE, std::vector<uint8_t> & plane, bool isSimd)
+{
+	const int cornerCount = VOXEL_SIZE - MIN_PADDING - MAX_PADDING + 1;
+	const int rowStride = getCornerRowStride(VOXEL_SIZE);
+	plane.resize(size_t(VOXEL_SIZE) * VOXEL_SIZE * rowStride);
+	for (int x = MIN_PADDING; x < MIN_PADDING + cornerCount; x++)
+	{
+		for (int y = MIN_PADDING; y < MIN_PADDING + cornerCount; y++)
+		{
+			const voxelInfo * src = srcData + x * VOXEL_SIZE * VOXEL_SIZE + y * VOXEL_SIZE;
+			for (int z = MIN_PADDING; z < MIN_PADDING + cornerCount; z++)
+			{
+				plane[getCornerIndex(VOXEL_SIZE, rowStride, x, y, z)] = src[z].w;
+			}
+		}
+	}
+	for (int z = 0; z < cornerCount; z++)
+	{
+		for (int y = 0; y < cornerCount; y++)
+		{
+			uint8_t * row = &plane[(z * VOXEL_SIZE + y) * rowStride];
+			memset(row + cornerCount, row[cornerCount - 1], rowStride - cornerCount);
+		}
+	}
+
+	// the sign of a corner is w >= 128, see tos and sign
+#ifdef TV_USE_SSE2
+	if (isSimd)
+	{
+		return signCornerPlaneSSE2(plane, VOXEL_SIZE);
+	}
+#endif
+	return signCornerPlaneScalar(plane, VOXEL_SIZE);
+}
+
+static bool classifyCellRowScalar(const uint8_t * row00, const uint8_t * row10, const uint8_t * row01, const uint8_t * row11, int cellCount, uint8_t * caseCodes)
+{
+	bool isAnySurface = false;
+	for (int x = 0; x < cellCount; x++)
+	{
+		uint8_t code = (row00[x] & 1) | (row00[x + 1] & 2) | (row10[x] & 4) | (row10[x + 1] & 8)
+					| (row01[x] & 16) | (row01[x + 1] & 32) | (row11[x] & 64) | (row11[x + 1] & 128);
+		caseCodes[x] = code;
+		if (code != 0 && code != 255)
+		{
+			isAnySurface = true;
+		}
+	}
+	return isAnySurface;
+}
+
+#ifdef TV_USE_SSE2
+static bool classifyCellRowSSE2(const uint8_t * row00, const uint8_t * row10, const uint8_t * row01, const uint8_t * row11, int cellCount, uint8_t * caseCodes)
+{
+	bool isAnySurface = false;
+	const __m128i full = _mm_set1_epi8(char(0xff));
+	const __m128i zero = _mm_setzero_si128();
+	for (int x = 0; x < cellCount; x += 16)
+	{
+#define TV_CORNER_BITS(row, offset, bit) _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x + offset)), _mm_set1_epi8(char(bit)))
+		__m128i code = _mm_or_si128(
+			_mm_or_si128(_mm_or_si128(TV_CORNER_BITS(row00, 0, 1), TV_CORNER_BITS(row00, 1, 2)),
+						_mm_or_si128(TV_CORNER_BITS(row10, 0, 4), TV_CORNER_BITS(row10, 1, 8))),
+			_mm_or_si128(_mm_or_si128(TV_CORNER_BITS(row01, 0, 16), TV_CORNER_BITS(row01, 1, 32)),
+						_mm_or_si128(TV_CORNER_BITS(row11, 0, 64), TV_CORNER_BITS(row11, 1, 128))));
+#undef TV_CORNER_BITS
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(caseCodes + x), code);
+		int trivialMask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(code, zero), _mm_cmpeq_epi8(code, full)));
+		int validMask = cellCount - x >= 16 ? 0xffff : (1 << (cellCount - x)) - 1;
+		if ((trivialMask & validMask) != validMask)
+		{
+			isAnySurface = true;
+		}
+	}
+	return isAnySurface;
+}
+#endif
+
+// case code of the cells (x, y, z) for x in [MIN_PADDING, MIN_PADDING + rowStride - 16), same bit order as the corners in generateWithoutNormal.
+// return false if none of them need triangulation.
+static bool classifyCellRow(const std::vector<uint8_t> & plane, int VOXEL_SIZE, int y, int z, uint8_t * caseCodes, bool isSimd)
+{
+	const int rowStride = getCornerRowStride(VOXEL_SIZE);
+	const uint8_t * row00 = &plane[getCornerIndex(VOXEL_SIZE, rowStride, MIN_PADDING, y, z)];
+	const uint8_t * row10 = &plane[getCornerIndex(VOXEL_SIZE, rowStride, MIN_PADDING, y + 1, z)];
+	const uint8_t * row01 = &plane[getCornerIndex(VOXEL_SIZE, rowStride, MIN_PADDING, y, z + 1)];
+	const uint8_t * row11 = &plane[getCornerIndex(VOXEL_SIZE, rowStride, MIN_PADDING, y + 1, z + 1)];
+	const int cellCount = VOXEL_SIZE - MIN_PADDING - MAX_PADDING;
+#ifdef TV_USE_SSE2
+	if (isSimd)
+	{
+		return classifyCellRowSSE2(row00, row10, row01, row11, cellCount, caseCodes);
+	}
+#endif
+	return classifyCellRowScalar(row00, row10, row01, row11, cellCount, caseCodes);
+}
 void TransVoxel::generateWithoutNormal(vec3 basePoint, Mesh* mesh, Mesh * transitionMesh, int VOXEL_SIZE,
 	voxelInfo* srcData, float minValue, int lodLevel)
 {
@@ -219,13 +404,51 @@ void TransVoxel::generateWithoutNormal(vec3 basePoint, Mesh* mesh, Mesh * transi
 
 	const Vector3i min_pos = Vector3i(MIN_PADDING);
 	const Vector3i max_pos = block_size_with_padding - Vector3i(MAX_PADDING);
+	// pure air or pure solid, neither the regular cells nor the transition cells have a surface.
+	static thread_local std::vector<uint8_t> cornerPlane;
+	static thread_local std::vector<uint8_t> caseCodes;
+	const bool isSimd = m_isSimdEnabled.load(std::memory_order_relaxed);
+	if (!buildCornerPlane(srcData, VOXEL_SIZE, cornerPlane, isSimd))
+	{
+		return;
+	}
+	caseCodes.resize(getCornerRowStride(VOXEL_SIZE));
+
+	mesh->setPackedTransform(basePoint, BLOCK_SIZE * FIXED_FACTOR);
+	transitionMesh->setPackedTransform(basePoint, BLOCK_SIZE * FIXED_FACTOR);
+
+	// the vertices a cell owns on its maximal edges, for the following cells to reuse. two z slices are enough.
+	struct ReuseCell
+	{
+		int vertices[4];
+	};
+	static thread_local std::vector<ReuseCell> reuseDecks;
+	const int deckSize = VOXEL_SIZE * VOXEL_SIZE;
+	reuseDecks.assign(2 * deckSize, ReuseCell{{-1, -1, -1, -1}});
+	auto getReuseCell = [deckSize, VOXEL_SIZE](const Vector3i & p) -> ReuseCell & {
+		return reuseDecks[(p.z & 1) * deckSize + p.y * VOXEL_SIZE + p.x];
+	};
+
 	voxelPosInfo corner_positions[8];
 	vec3 corner_gradients[8];
 	voxelInfo * info[8];
 	Vector3i pos;
 	for (pos.z = min_pos.z; pos.z < max_pos.z; ++pos.z) {
 		for (pos.y = min_pos.y; pos.y < max_pos.y; ++pos.y) {
+			// the corner vertex slot is only valid if the cell really created it, mark the whole row as unusable for now
 			for (pos.x = min_pos.x; pos.x < max_pos.x; ++pos.x) {
+				getReuseCell(pos).vertices[0] = -1;
+			}
+			if (!classifyCellRow(cornerPlane, VOXEL_SIZE, pos.y, pos.z, caseCodes.data(), isSimd))
+			{
+				continue;
+			}
+			for (pos.x = min_pos.x; pos.x < max_pos.x; ++pos.x) {
+				uint8_t case_code = caseCodes[pos.x - min_pos.x];
+				if (case_code == 0 || case_code == 255) {
+					// If the case_code is 0 or 255, there is no triangulation to do
+					continue;
+				}
 
 				//    6-------7
 				//   /|      /|
@@ -250,31 +473,13 @@ void TransVoxel::generateWithoutNormal(vec3 basePoint, Mesh* mesh, Mesh * transi
 				// Get the value of cells.
 				// Negative values are "solid" and positive are "air".
 				// Due to raw cells being unsigned 8-bit, they get converted to signed.
+				// The case code is the concatenated signs of them, it comes from classifyCellRow.
 				for (unsigned int i = 0; i < 8; ++i) {
 					cell_samples[i] = tos(srcData, VOXEL_SIZE, corner_positions[i].v);
 					corner_positions[i].info = extractVoxel(srcData, VOXEL_SIZE, corner_positions[i].v);
 				}
 
-				// Concatenate the sign of cell values to obtain the case code.
-				// Index 0 is the less significant bit, and index 7 is the most significant bit.
-				uint8_t case_code = sign(cell_samples[0]);
-				case_code |= (sign(cell_samples[1]) << 1);
-				case_code |= (sign(cell_samples[2]) << 2);
-				case_code |= (sign(cell_samples[3]) << 3);
-				case_code |= (sign(cell_samples[4]) << 4);
-				case_code |= (sign(cell_samples[5]) << 5);
-				case_code |= (sign(cell_samples[6]) << 6);
-				case_code |= (sign(cell_samples[7]) << 7);
-
-
-				// ReuseCell &current_reuse_cell = get_reuse_cell(pos);
-				// Mark as unusable for now
-				// current_reuse_cell.vertices[0] = -1;
-
-				if (case_code == 0 || case_code == 255) {
-					// If the case_code is 0 or 255, there is no triangulation to do
-					continue;
-				}
+				ReuseCell &current_reuse_cell = getReuseCell(pos);
 
 				// TODO We might not always need all of them
 				// Compute normals
@@ -369,14 +574,14 @@ void TransVoxel::generateWithoutNormal(vec3 basePoint, Mesh* mesh, Mesh * transi
 						// You can check by "shaking" every vertex randomly in a shader based on its index,
 						// you will see vertices touching the -X, -Y or -Z sides of the block aren't connected
 
-						bool present = false;//(reuse_dir & direction_validity_mask) == reuse_dir;
-
-						// if (present) {
-						// 	Vector3i cache_pos = pos + L::dir_to_prev_vec(reuse_dir);
-						// 	ReuseCell &prev_cell = get_reuse_cell(cache_pos);
-						// 	// Will reuse a previous vertice
-						// 	cell_vertex_indices[i] = prev_cell.vertices[reuse_vertex_index];
-						// }
+						bool present = (reuse_dir & direction_validity_mask) == reuse_dir;
+						cell_vertex_indices[i] = -1;
+						if (present) {
+							Vector3i cache_pos = pos - Vector3i(reuse_dir & 1, (reuse_dir >> 1) & 1, (reuse_dir >> 2) & 1);
+							ReuseCell &prev_cell = getReuseCell(cache_pos);
+							// Will reuse a previous vertice
+							cell_vertex_indices[i] = prev_cell.vertices[reuse_vertex_index];
+						}
 
 
 						// Going to create a new vertice
@@ -390,26 +595,25 @@ void TransVoxel::generateWithoutNormal(vec3 basePoint, Mesh* mesh, Mesh * transi
 						// However, it might be possible on low-res blocks bordering high-res ones due to neighboring rules,
 						// or by falling back on the generator that was used to produce the volume.
 
-						Vector3i primary = p0.v * ti0 + p1.v * ti1;
-						vec3 primaryf = primary.to_vec3() * FIXED_FACTOR;
-						cell_vertex_indices[i] = mesh->getVerticesSize();
-						auto vdata = genVertexData(getVoxelVertex(primaryf, basePoint,p0.info, p0.info));
-						vdata.m_normal = (corner_gradients[v0] * t0 + corner_gradients[v1] * t1).normalized();
-						mesh->addVertex(vdata);
-						
-
+						if (cell_vertex_indices[i] == -1) {
+							Vector3i primary = p0.v * ti0 + p1.v * ti1;
+							cell_vertex_indices[i] = mesh->getVerticesSize();
+							mesh->addTerrainVertex(genTerrainVertex(primary, (corner_gradients[v0] * t0 + corner_gradients[v1] * t1).normalized(), p0.info));
+							if (reuse_dir & 8) {
+								// The vertex is on a maximal edge, the following cells can reuse it
+								current_reuse_cell.vertices[reuse_vertex_index] = cell_vertex_indices[i];
+							}
+						}
 
 					} else if (t == 0 && v1 == 7) {
 						// t == 0: the vertex is on p1
 						// v1 == 7: p1 on the max corner of the cell
 						// This cell owns the vertex, so it should be created.
 
-						Vector3i primary = p1.v;
-						vec3 primaryf = primary.to_vec3();
+						Vector3i primary = p1.v * 0x100;
 						cell_vertex_indices[i] = mesh->getVerticesSize();
-						auto vdata = genVertexData(getVoxelVertex(primaryf, basePoint,p1.info, p1.info));
-						vdata.m_normal = corner_gradients[v1];
-						mesh->addVertex(vdata);
+						mesh->addTerrainVertex(genTerrainVertex(primary, corner_gradients[v1], p1.info));
+						current_reuse_cell.vertices[0] = cell_vertex_indices[i];
 
 					} else {
 						// The vertex is either on p0 or p1
@@ -421,12 +625,18 @@ void TransVoxel::generateWithoutNormal(vec3 basePoint, Mesh* mesh, Mesh * transi
 						// numbered endpoint.
 
 
-						voxelPosInfo primaryP = t == 0 ? p1 : p0;
-						vec3 primaryf = primaryP.v.to_vec3();
-						cell_vertex_indices[i] = mesh->getVerticesSize();
-						auto vdata = genVertexData(getVoxelVertex(primaryf, basePoint,primaryP.info, primaryP.info));
-						vdata.m_normal = corner_gradients[t == 0 ? v1 : v0].normalized();
-						mesh->addVertex(vdata);
+						uint8_t reuse_dir = (t == 0 ? v1 ^ 7 : v0 ^ 7);
+						bool present = (reuse_dir & direction_validity_mask) == reuse_dir;
+						cell_vertex_indices[i] = -1;
+						if (present) {
+							Vector3i cache_pos = pos - Vector3i(reuse_dir & 1, (reuse_dir >> 1) & 1, (reuse_dir >> 2) & 1);
+							cell_vertex_indices[i] = getReuseCell(cache_pos).vertices[0];
+						}
+						if (cell_vertex_indices[i] == -1) {
+							voxelPosInfo primaryP = t == 0 ? p1 : p0;
+							cell_vertex_indices[i] = mesh->getVerticesSize();
+							mesh->addTerrainVertex(genTerrainVertex(primaryP.v * 0x100, corner_gradients[t == 0 ? v1 : v0].normalized(), primaryP.info));
+						}
 					}
 
 				} // for each cell vertex
@@ -768,11 +978,7 @@ void TransVoxel::build_transition(vec3 basePoint,Mesh * mesh, int VOXEL_SIZE, vo
 						}
 
 						cell_vertex_indices[i] = mesh->getVerticesSize();
-						auto vdata = genVertexData(getVoxelVertex(primaryf, basePoint,p0.info, p0.info));
-						//vdata.m_pos = vec3(primaryf.x * BLOCK_SIZE, primaryf.y * BLOCK_SIZE, -1 * primaryf.z * BLOCK_SIZE) + basePoint;
-						vdata.m_normal = (n0 * t0 + n1 * t1).normalized();
-
-						mesh->addVertex(vdata);
+						mesh->addTerrainVertex(genTerrainVertex(primary, normal, p0.info));
 						// if (reuse_direction & 0x8) {
 						// 	// The vertex can be re-used later
 						// 	ReuseTransitionCell &r = get_reuse_cell_2d(fx, fy);
@@ -822,11 +1028,7 @@ void TransVoxel::build_transition(vec3 basePoint,Mesh * mesh, int VOXEL_SIZE, vo
 						}
 
 						cell_vertex_indices[i] = mesh->getVerticesSize();
-						auto vdata = genVertexData(getVoxelVertex(primaryf, basePoint,primary.info, primary.info));
-						vdata.m_normal = cell_gradients[index_vertex];
-						//vdata.m_pos = vec3(primaryf.x * BLOCK_SIZE, primaryf.y * BLOCK_SIZE , -1 * primaryf.z * BLOCK_SIZE) + basePoint;
-
-						mesh->addVertex(vdata);
+						mesh->addTerrainVertex(genTerrainVertex(primary.v * 0x100, cell_gradients[index_vertex], primary.info));
 
 						// // We are on a corner so the vertex will be re-usable later
 						// ReuseTransitionCell &r = get_reuse_cell_2d(fx, fy);
@@ -856,7 +1058,17 @@ void TransVoxel::build_transition(vec3 basePoint,Mesh * mesh, int VOXEL_SIZE, vo
 	} // for y
 }
 
-TransVoxel::TransVoxel()
+void TransVoxel::setIsSimdEnabled(bool isEnabled)
+{
+	m_isSimdEnabled = isEnabled;
+}
+
+bool TransVoxel::isSimdEnabled() const
+{
+	return m_isSimdEnabled;
+}
+
+TransVoxel::TransVoxel():m_isSimdEnabled(true)
 {
 	
 }
@@ -4,6 +4,7 @@
 #include "../../Math/vec4.h"
 #include "../../Mesh/Mesh.h"
 #include "Mesh/VertexData.h"
+#include <atomic>
 
 namespace tzw {
 	struct voxelInfo;
@@ -14,7 +15,12 @@ class TransVoxel :public Singleton<TransVoxel>
 public:
     void generateWithoutNormal(vec3 basePoint,Mesh * mesh, Mesh * transitionMesh, int VOXEL_SIZE, voxelInfo * srcData, float minValue = -1, int lodLevel = 0);
 	void build_transition(vec3 basePoint,Mesh * mesh, int BlockSize, voxelInfo * srcData, int direction, int lodLevel = 0);
+	//false runs the scalar path of the cell classification, the output is the same, for the benchmark to compare
+	void setIsSimdEnabled(bool isEnabled);
+	bool isSimdEnabled() const;
     TransVoxel();
+private:
+	std::atomic<bool> m_isSimdEnabled;
 };
 
 } // namespace tzw
@@ -87,15 +87,15 @@ namespace tzw {
 
 	}
 
-	void ThumbNail::getSnapShotCommand(std::vector<RenderCommand>& commandList)
+	void ThumbNail::getSnapShotCommand(std::vector<RenderCommand>& commandList, PassTransformation & passTransformation)
 	{
-		auto m = Matrix44();
-		m.setToIdentity();
 		auto p = Matrix44();
 		p.perspective(45, 1, 0.1, 50);
 		auto node = Camera();
 		node.setPos(0.5, 0.5, 0.5);
 		node.lookAt(vec3(0, 0, 0), vec3(0, 1, 0));
+		passTransformation.m_projectMatrix = p;
+		passTransformation.m_viewMatrix = node.getViewMatrix();
 
 		if(m_node->getDrawableFlag() & static_cast<uint32_t>(DrawableFlag::Drawable))
 		{
@@ -105,9 +105,6 @@ namespace tzw {
 
     			m_node->setUpCommand(command);
 				m_node->setUpTransFormation(command.m_transInfo);
-
-				command.m_transInfo.m_projectMatrix = p;
-				command.m_transInfo.m_viewMatrix = node.getViewMatrix();
 				commandList.emplace_back(command);
 			}
 		}
@@ -129,8 +126,6 @@ namespace tzw {
 				mat->setIsEnableInstanced(command.getMat()->isEnableInstanced());
 				mat->reload();
 				command.setMat(mat);
-				command.m_transInfo.m_projectMatrix = p;
-				command.m_transInfo.m_viewMatrix = node.getViewMatrix();
 				commandList.emplace_back(command);
 			}
 		}
@@ -12,7 +12,7 @@ namespace tzw
 		ThumbNail(Drawable3D * node);
 		void initFrameBufferVK(DeviceRenderPassVK * renderPass);
 		void doSnapShot();
-		void getSnapShotCommand(std::vector<RenderCommand>&commandList);
+		void getSnapShotCommand(std::vector<RenderCommand>&commandList, PassTransformation & passTransformation);
 		Drawable3D* getNode() const;
 		void setNode(Drawable3D* const node);
 		bool isIsDone() const;
@@ -36,9 +36,6 @@ Grass::Grass(std::string filePath)
 
 void Grass::setUpTransFormation(TransformationInfo &info)
 {
-	auto currCam = g_GetCurrScene()->defaultCamera();
-	info.m_projectMatrix = currCam->projection();
-	info.m_viewMatrix = currCam->getViewMatrix();
 	Matrix44 mat;
 	mat.setToIdentity();
 	info.m_worldMatrix = mat;
@@ -5,6 +5,9 @@
 
 #include "3D/Model/Model.h"
 #include "Mesh/InstancedMesh.h"
+#include "Math/MathSimd.h"
+#include <algorithm>
+#include <atomic>
 
 namespace tzw {
 VegetationBatInfo::VegetationBatInfo()
@@ -20,6 +23,11 @@ VegetationBatInfo::VegetationBatInfo(VegetationType theType, std::string filePat
 
 VegetationBatch::VegetationBatch(const VegetationBatInfo * info)
 {
+	m_model = nullptr;
+	m_quadMesh = nullptr;
+	m_quadMat = nullptr;
+	m_totalCount = 0;
+	m_frameIndex = 0;
 	m_type = info->m_type;
 	auto filePath = info->file_path;
 	m_info = (*info);
@@ -125,66 +133,155 @@ VegetationBatch::VegetationBatch(const VegetationBatInfo * info)
 	}
 }
 
-void VegetationBatch::insertInstanceData(InstanceData inst)
+void VegetationBatch::beginFrame()
 {
-	switch (m_type)
+	m_frameGroupList.clear();
+}
+
+void VegetationBatch::addGroup(TreeGroup * group)
+{
+	m_frameGroupList.push_back(group);
+}
+
+void VegetationBatch::endFrame()
+{
+	m_frameIndex ++;
+	std::sort(m_frameGroupList.begin(), m_frameGroupList.end());
+	m_frameGroupList.erase(std::unique(m_frameGroupList.begin(), m_frameGroupList.end()), m_frameGroupList.end());
+	auto & instanceList = m_instancedMeshList[0]->m_instanceOffset;
+	//offset and count of the ranges written this frame
+	std::vector<std::pair<size_t, size_t>> changedList;
+	m_drawRangeList.clear();
+	for(auto group : m_frameGroupList)
 	{
-	case VegetationType::QUAD_TRI:
+		size_t count = group->m_instance.size();
+		auto iter = m_rangeMap.find(group->m_uid);
+		bool isChanged = iter == m_rangeMap.end() || iter->second.m_version != group->m_version;
+		if(iter == m_rangeMap.end())
 		{
-			m_instancedMeshList[0]->pushInstance(inst);
+			Range range;
+			range.m_offset = allocRange(count);
+			range.m_capacity = count;
+			iter = m_rangeMap.emplace(group->m_uid, range).first;
 		}
-		break;
-	case VegetationType::QUAD:
+		auto & range = iter->second;
+		if(isChanged)
 		{
-			m_instancedMeshList[0]->pushInstance(inst);
+			//a range only moves when the group outgrows it
+			if(count > range.m_capacity)
+			{
+				freeRange(range.m_offset, range.m_capacity);
+				range.m_offset = allocRange(count);
+				range.m_capacity = count;
+			}
+			range.m_version = group->m_version;
+			range.m_count = count;
+			std::copy(group->m_instance.begin(), group->m_instance.end(), instanceList.begin() + range.m_offset);
+			changedList.emplace_back(range.m_offset, count);
 		}
-		break;
-	case VegetationType::ModelType:
+		range.m_lastFrame = m_frameIndex;
+		if(range.m_count)
 		{
-			for(auto i = 0; i < m_model->getMeshCount(); i++)
+			m_drawRangeList.emplace_back(range.m_offset, range.m_count);
+		}
+	}
+	for(auto iter = m_rangeMap.begin(); iter != m_rangeMap.end();)
+	{
+		if(m_frameIndex - iter->second.m_lastFrame > VEGETATION_RANGE_KEEP_FRAMES)
+		{
+			freeRange(iter->second.m_offset, iter->second.m_capacity);
+			iter = m_rangeMap.erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+	std::sort(m_drawRangeList.begin(), m_drawRangeList.end());
+	size_t drawCount = 0;
+	m_totalCount = 0;
+	for(auto & drawRange : m_drawRangeList)
+	{
+		m_totalCount += drawRange.second;
+		if(drawCount && m_drawRangeList[drawCount - 1].first + m_drawRangeList[drawCount - 1].second == drawRange.first)
+		{
+			m_drawRangeList[drawCount - 1].second += drawRange.second;
+		}
+		else
+		{
+			m_drawRangeList[drawCount++] = drawRange;
+		}
+	}
+	m_drawRangeList.resize(drawCount);
+	//every mesh of a model shares the same instances, only the written ranges are uploaded
+	for(size_t i = 0; i < m_instancedMeshList.size(); i++)
+	{
+		auto & otherList = m_instancedMeshList[i]->m_instanceOffset;
+		if(i > 0)
+		{
+			otherList.resize(instanceList.size());
+		}
+		for(auto & changed : changedList)
+		{
+			if(i > 0)
 			{
-				m_instancedMeshList[i]->pushInstance(inst);
-				//m_model->getMesh(i)->pushInstance(inst);
+				std::copy(instanceList.begin() + changed.first, instanceList.begin() + changed.first + changed.second, otherList.begin() + changed.first);
 			}
+			m_instancedMeshList[i]->submitInstancedRange(int(changed.first), int(changed.first + changed.second));
 		}
-		break;
-	default: ;
 	}
-	m_totalCount += 1;
 }
 
-void VegetationBatch::clear()
+size_t VegetationBatch::allocRange(size_t count)
 {
-	switch (m_type)
+	if(!count) return 0;
+	auto & instanceList = m_instancedMeshList[0]->m_instanceOffset;
+	for(auto iter = m_freeMap.begin(); iter != m_freeMap.end(); ++iter)
 	{
-	case VegetationType::QUAD_TRI:
+		size_t offset = iter->first;
+		size_t size = iter->second;
+		//the free block at the end can grow with the buffer
+		bool isLast = offset + size == instanceList.size();
+		if(size < count && !isLast) continue;
+		m_freeMap.erase(iter);
+		if(size > count)
 		{
-			m_instancedMeshList[0]->clearInstances();
+			m_freeMap[offset + count] = size - count;
 		}
-		break;
-	case VegetationType::QUAD:
+		else if(size < count)
 		{
-			m_instancedMeshList[0]->clearInstances();
+			instanceList.resize(offset + count);
 		}
-		break;
-	case VegetationType::ModelType:
+		return offset;
+	}
+	size_t offset = instanceList.size();
+	instanceList.resize(offset + count);
+	return offset;
+}
+
+void VegetationBatch::freeRange(size_t offset, size_t count)
+{
+	if(!count) return;
+	auto next = m_freeMap.lower_bound(offset);
+	if(next != m_freeMap.end() && offset + count == next->first)
+	{
+		count += next->second;
+		next = m_freeMap.erase(next);
+	}
+	if(next != m_freeMap.begin())
+	{
+		auto prev = std::prev(next);
+		if(prev->first + prev->second == offset)
 		{
-			for(auto i = 0; i < m_model->getMeshCount(); i++)
-			{
-				m_instancedMeshList[i]->clearInstances();
-			}
+			prev->second += count;
+			return;
 		}
-		break;
-	default: ;
 	}
-	m_totalCount = 0;
+	m_freeMap[offset] = count;
 }
 
 void VegetationBatch::setUpTransFormation(TransformationInfo& info)
 {
-	auto currCam = g_GetCurrScene()->defaultCamera();
-	info.m_projectMatrix = currCam->projection();
-	info.m_viewMatrix = currCam->getViewMatrix();
 	Matrix44 mat;
 	mat.setToIdentity();
 	info.m_worldMatrix = mat;
@@ -198,12 +295,11 @@ void VegetationBatch::commitRenderCmd(RenderFlag::RenderStageType stageType, Ren
 		{
 			auto theMesh = m_quadMesh;
 			auto mat = m_quadMat;
-			m_instancedMeshList[0]->submitInstanced();
 			RenderCommand command(theMesh, mat, this, stageType, RenderCommand::PrimitiveType::TRIANGLES, RenderCommand::RenderBatchType::Instanced);
 			command.setInstancedMesh(m_instancedMeshList[0]);
 			command.setPrimitiveType(RenderCommand::PrimitiveType::TRIANGLES);
 			setUpTransFormation(command.m_transInfo);
-			queues->addRenderCommand(command, requirementArg);
+			addDrawRanges(command, queues, requirementArg);
 			setUpTransFormation(command.m_transInfo);
 		}
 		break;
@@ -212,12 +308,11 @@ void VegetationBatch::commitRenderCmd(RenderFlag::RenderStageType stageType, Ren
 		{
 			auto theMesh = m_quadMesh;
 			auto mat = m_quadMat;
-			m_instancedMeshList[0]->submitInstanced();
 			RenderCommand command(theMesh, mat, this, stageType, RenderCommand::PrimitiveType::TRIANGLES, RenderCommand::RenderBatchType::Instanced);
 			command.setInstancedMesh(m_instancedMeshList[0]);
 			command.setPrimitiveType(RenderCommand::PrimitiveType::TRIANGLES);
 			setUpTransFormation(command.m_transInfo);
-			queues->addRenderCommand(command, requirementArg);
+			addDrawRanges(command, queues, requirementArg);
 			setUpTransFormation(command.m_transInfo);
 		}
 		break;
@@ -229,12 +324,11 @@ void VegetationBatch::commitRenderCmd(RenderFlag::RenderStageType stageType, Ren
 				
 				auto theMesh = m_model->getMesh(i);
 				auto mat = m_model->getMat(theMesh->getMatIndex());
-				m_instancedMeshList[i]->submitInstanced();
 				RenderCommand command(theMesh, mat, this, stageType,RenderCommand::PrimitiveType::TRIANGLES, RenderCommand::RenderBatchType::Instanced);
 				command.setInstancedMesh(m_instancedMeshList[i]);
 				command.setPrimitiveType(RenderCommand::PrimitiveType::TRIANGLES);
 				setUpTransFormation(command.m_transInfo);
-				queues->addRenderCommand(command, requirementArg);
+				addDrawRanges(command, queues, requirementArg);
 				setUpTransFormation(command.m_transInfo);
 			}
 		}
@@ -258,12 +352,11 @@ void VegetationBatch::commitShadowRenderCmd(RenderQueues * queues, int level)
 				
 				auto theMesh = m_model->getMesh(i);
 				auto mat = m_model->getMat(theMesh->getMatIndex());
-				m_instancedMeshList[i]->submitInstanced();
 				RenderCommand command(theMesh, mat, this, RenderFlag::RenderStageType::SHADOW, RenderCommand::PrimitiveType::TRIANGLES, RenderCommand::RenderBatchType::Instanced);
 				command.setInstancedMesh(m_instancedMeshList[i]);
 				command.setPrimitiveType(RenderCommand::PrimitiveType::TRIANGLES);
 				setUpTransFormation(command.m_transInfo);
-				queues->addRenderCommand(command,level);
+				addDrawRanges(command, queues, level);
 				setUpTransFormation(command.m_transInfo);
 			}
 		}
@@ -272,6 +365,16 @@ void VegetationBatch::commitShadowRenderCmd(RenderQueues * queues, int level)
 	}
 }
 
+void VegetationBatch::addDrawRanges(RenderCommand & command, RenderQueues * queues, int level)
+{
+	//one command per run of visible groups which are next to each other in the instance buffer
+	for(auto & drawRange : m_drawRangeList)
+	{
+		command.setInstanceRange(int(drawRange.first), int(drawRange.second));
+		queues->addRenderCommand(command, level);
+	}
+}
+
 VegetationInfo::VegetationInfo()
 {
 }
@@ -297,64 +400,46 @@ void VegetationInfo::init(const VegetationBatInfo * lod0, const VegetationBatInf
 	
 }
 
-void VegetationInfo::clear()
+void VegetationInfo::beginFrame()
 {
 	for(int i = 0; i < 3; i++)
 	{
 		if(m_lodBatch[i])
 		{
-			m_lodBatch[i]->clear();
+			m_lodBatch[i]->beginFrame();
 		}
 	}
 }
 
-void VegetationInfo::commitRenderCmd(RenderFlag::RenderStageType stageType, RenderQueues * queues, int requirementArg)
+void VegetationInfo::endFrame()
 {
 	for(int i = 0; i < 3; i++)
 	{
-		if(m_lodBatch[i] && m_lodBatch[i]->m_totalCount)
+		if(m_lodBatch[i])
 		{
-			m_lodBatch[i]->commitRenderCmd(stageType, queues, requirementArg);
+			m_lodBatch[i]->endFrame();
 		}
 	}
 }
 
-void VegetationInfo::insert(InstanceData inst)
+void VegetationInfo::commitRenderCmd(RenderFlag::RenderStageType stageType, RenderQueues * queues, int requirementArg)
 {
-	auto cam = g_GetCurrScene()->defaultCamera();
-	auto dist = cam->getWorldPos().distance(inst.transform.getTranslation());
-	if(dist > 200.0f) return;//just ignore
-
-	if(dist < 35.f)
-	{
-		m_lodBatch[0]->insertInstanceData(inst);
-	}
-	else if(dist < 100.f)
+	for(int i = 0; i < 3; i++)
 	{
-		if(m_lodBatch[1])
-		{
-			m_lodBatch[1]->insertInstanceData(inst);
-		}else
+		if(m_lodBatch[i] && m_lodBatch[i]->m_totalCount)
 		{
-			m_lodBatch[0]->insertInstanceData(inst);
+			m_lodBatch[i]->commitRenderCmd(stageType, queues, requirementArg);
 		}
 	}
-	else
+}
+
+void VegetationInfo::addGroup(TreeGroup * group, int lod)
+{
+	while(lod > 0 && !m_lodBatch[lod])
 	{
-		if(m_lodBatch[2])
-		{
-			m_lodBatch[2]->insertInstanceData(inst);
-		} else
-		{
-			if(m_lodBatch[1])
-			{
-				m_lodBatch[1]->insertInstanceData(inst);
-			}else
-			{
-				m_lodBatch[0]->insertInstanceData(inst);
-			}	
-		}
+		lod --;
 	}
+	m_lodBatch[lod]->addGroup(group);
 }
 
 bool VegetationInfo::anyHas()
@@ -375,9 +460,22 @@ void VegetationInfo::submitShadowDraw(RenderQueues * queues, int level)
 	if(m_lodBatch[1] && m_lodBatch[1]->m_totalCount) m_lodBatch[1]->commitShadowRenderCmd(queues, level);
 }
 
+static std::atomic<unsigned int> g_treeGroupUid(0);
 TreeGroup::TreeGroup(int treeClass)
 {
 	m_treeClass = treeClass;
+	m_uid = g_treeGroupUid++;
+	m_version = 0;
+}
+
+void TreeGroup::commit()
+{
+	m_aabb.reset();
+	for(auto & inst : m_instance)
+	{
+		m_aabb.update(inst.transform.getTranslation());
+	}
+	m_version ++;
 }
 
 Tree::Tree()
@@ -415,27 +513,17 @@ int Tree::regVegetation(const VegetationBatInfo * lod0, const VegetationBatInfo
 
 void Tree::addTreeGroup(TreeGroup* treeGroup)
 {
-	m_tree[treeGroup->m_treeClass].insert(treeGroup);
+	if(treeGroup->m_instance.empty()) return;
+	m_visibleGroupList.push_back(treeGroup);
 }
 
 void Tree::clearTreeGroup()
 {
-	for(auto p : m_tree)
-	{
-		p.second.clear();
-	}
-	for(auto info :m_infoList)
-	{
-		info->clear();	
-	}
+	m_visibleGroupList.clear();
 }
 
-
 void Tree::setUpTransFormation(TransformationInfo &info)
 {
-	auto currCam = g_GetCurrScene()->defaultCamera();
-	info.m_projectMatrix = currCam->projection();
-	info.m_viewMatrix = currCam->getViewMatrix();
 	Matrix44 mat;
 	mat.setToIdentity();
 	info.m_worldMatrix = mat;
@@ -458,23 +546,86 @@ unsigned int Tree::getTypeId()
 	return 2333;
 }
 
+//squared distance from p to each box, four boxes per step
+static void squaredDistanceToBounds(const vec3 & p, const std::vector<float> * boundList, size_t count, float * out)
+{
+	const float * minX = boundList[0].data();
+	const float * minY = boundList[1].data();
+	const float * minZ = boundList[2].data();
+	const float * maxX = boundList[3].data();
+	const float * maxY = boundList[4].data();
+	const float * maxZ = boundList[5].data();
+	size_t i = 0;
+#if TZW_USE_SSE
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 px = _mm_set1_ps(p.x);
+	const __m128 py = _mm_set1_ps(p.y);
+	const __m128 pz = _mm_set1_ps(p.z);
+	for(; i + 4 <= count; i += 4)
+	{
+		__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(minX + i), px), _mm_sub_ps(px, _mm_loadu_ps(maxX + i))), zero);
+		__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(minY + i), py), _mm_sub_ps(py, _mm_loadu_ps(maxY + i))), zero);
+		__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(minZ + i), pz), _mm_sub_ps(pz, _mm_loadu_ps(maxZ + i))), zero);
+		__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		_mm_storeu_ps(out + i, dist);
+	}
+#endif
+	for(; i < count; i++)
+	{
+		float dx = std::max(std::max(minX[i] - p.x, p.x - maxX[i]), 0.0f);
+		float dy = std::max(std::max(minY[i] - p.y, p.y - maxY[i]), 0.0f);
+		float dz = std::max(std::max(minZ[i] - p.z, p.z - maxZ[i]), 0.0f);
+		out[i] = dx * dx + dy * dy + dz * dz;
+	}
+}
+
 void Tree::pushCommand(RenderFlag::RenderStageType requirementType, RenderQueues * queues, int requirementArg)
 {
-	//regroup
-	for(auto iter : m_tree)
+	//the lod is picked per group by the distance to its closest instance bound
+	size_t groupCount = m_visibleGroupList.size();
+	for(int i = 0; i < 6; i++)
+	{
+		m_boundList[i].resize(groupCount);
+	}
+	m_distList.resize(groupCount);
+	for(size_t i = 0; i < groupCount; i++)
 	{
-		// std::copy(iter->m_instance.begin(), iter->m_instance.end(), m_mesh->m_instanceOffset.begin());
-		auto info = m_infoList[iter.first];
-		auto &tg = iter;
-		auto theSet = tg.second;
-		for(auto group : theSet)
+		auto & aabb = m_visibleGroupList[i]->m_aabb;
+		vec3 minPos = aabb.min();
+		vec3 maxPos = aabb.max();
+		m_boundList[0][i] = minPos.x;
+		m_boundList[1][i] = minPos.y;
+		m_boundList[2][i] = minPos.z;
+		m_boundList[3][i] = maxPos.x;
+		m_boundList[4][i] = maxPos.y;
+		m_boundList[5][i] = maxPos.z;
+	}
+	auto cam = g_GetCurrScene()->defaultCamera();
+	squaredDistanceToBounds(cam->getWorldPos(), m_boundList, groupCount, m_distList.data());
+
+	for(auto info : m_infoList)
+	{
+		info->beginFrame();
+	}
+	for(size_t i = 0; i < groupCount; i++)
+	{
+		float dist = m_distList[i];
+		if(dist > 200.0f * 200.0f) continue;//just ignore
+		int lod = 2;
+		if(dist < 35.f * 35.f)
 		{
-			for(auto inst :group->m_instance)
-			{
-				info->insert(inst);
-			}
-			// info->m_totalCount += group->m_instance.size();
+			lod = 0;
+		}
+		else if(dist < 100.f * 100.f)
+		{
+			lod = 1;
 		}
+		auto group = m_visibleGroupList[i];
+		m_infoList[group->m_treeClass]->addGroup(group, lod);
+	}
+	for(auto info : m_infoList)
+	{
+		info->endFrame();
 	}
 	if (! m_isFinish)
 	{
@@ -489,38 +640,7 @@ void Tree::pushCommand(RenderFlag::RenderStageType requirementType, RenderQueues
 
 			}
 		}
-		// auto targetAmount = m_mesh->m_instanceOffset.size();
-		// if (targetAmount > 0)
-		// {
-		// 	// if(targetAmount > m_mesh->getInstanceBuf()->getAmount())
-		// 	// {
-		// 	// 	m_mesh->submitInstanced(targetAmount);
-		// 	// }else
-		// 	// {
-		// 	// 	m_mesh->reSubmitInstanced();
-		// 	// }
-		// 	m_mesh->submitInstanced();
-		// 	m_leafMesh->submitInstanced();
-		// 	// m_mesh->getInstanceBuf()->use();
-		// 	// m_mesh->getInstanceBuf()->allocate(&m_mesh->m_instanceOffset[0], m_mesh->m_instanceOffset.size() * sizeof(InstanceData), RenderFlag::BufferStorageType::DYNAMIC_DRAW);
-		// }
-		// // m_mesh->reSubmitInstanced();
 	}
-	// if(m_mesh->m_instanceOffset.size() > 0)
-	// {
-	// 	RenderCommand command(m_mesh, m_barkMat, RenderCommand::RenderType::Instanced);
-	// 	command.setPrimitiveType(RenderCommand::PrimitiveType::TRIANGLES);
-	// 	setUpTransFormation(command.m_transInfo);
-	// 	Renderer::shared()->addRenderCommand(command);
-	// 	setUpTransFormation(command.m_transInfo);
-	//
-	// 	RenderCommand commandLeaf(m_leafMesh,  m_leafMat, RenderCommand::RenderType::Instanced);
-	// 	commandLeaf.setPrimitiveType(RenderCommand::PrimitiveType::TRIANGLES);
-	// 	setUpTransFormation(commandLeaf.m_transInfo);
-	// 	Renderer::shared()->addRenderCommand(commandLeaf);
-	// 	setUpTransFormation(commandLeaf.m_transInfo);
-	// }
-
 }
 
 void Tree::finish()
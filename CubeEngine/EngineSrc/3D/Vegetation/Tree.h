@@ -1,12 +1,18 @@
 #pragma once
-#include <unordered_set>
+#include <vector>
+#include <map>
+#include <unordered_map>
 
 #include "../../Mesh/Mesh.h"
 #include "EngineSrc/Interface/Drawable3D.h"
 #include "EngineSrc/Texture/TextureMgr.h"
+
+//frames a group can be left out of a batch before its instance range is freed
+#define VEGETATION_RANGE_KEEP_FRAMES 120
 namespace tzw {
 	class Model;
 	class InstancedMesh;
+	class TreeGroup;
     enum class VegetationType
     {
 	    QUAD_TRI,
@@ -21,11 +27,15 @@ namespace tzw {
 		std::string file_path;
 		vec2 m_size;
 	};
+	// Every group added to a batch owns a range of its instance buffer, allocated from a free list the first time.
+	// a range is only written and uploaded again when the version of its group changed. the groups which are not added
+	// in a frame keep their range and are left out of the draw ranges, the range is freed after VEGETATION_RANGE_KEEP_FRAMES.
 	struct VegetationBatch
 	{
 		VegetationBatch(const VegetationBatInfo * info);
-		void insertInstanceData(InstanceData data);
-		void clear();
+		void beginFrame();
+		void addGroup(TreeGroup * group);
+		void endFrame();
 		void setUpTransFormation(TransformationInfo& info);
 		void commitRenderCmd(RenderFlag::RenderStageType stageType, RenderQueues * queues, int requirementArg);
 		void commitShadowRenderCmd(RenderQueues * queues, int level);
@@ -33,17 +43,40 @@ namespace tzw {
 		Mesh * m_quadMesh;
 		std::vector<InstancedMesh *> m_instancedMeshList;
 		Material * m_quadMat;
+		//instances drawn this frame
 		size_t m_totalCount;
 		VegetationType m_type;
 		VegetationBatInfo m_info;
+	private:
+		struct Range
+		{
+			unsigned int m_version;
+			size_t m_offset;
+			size_t m_capacity;
+			size_t m_count;
+			unsigned int m_lastFrame;
+		};
+		size_t allocRange(size_t count);
+		void addDrawRanges(RenderCommand & command, RenderQueues * queues, int level);
+		void freeRange(size_t offset, size_t count);
+		//group uid -> range
+		std::unordered_map<unsigned int, Range> m_rangeMap;
+		//offset -> size of the free instances, neighbours are merged
+		std::map<size_t, size_t> m_freeMap;
+		//offset and count of the instances drawn this frame, adjacent ranges are merged into one draw
+		std::vector<std::pair<size_t, size_t>> m_drawRangeList;
+		std::vector<TreeGroup *> m_frameGroupList;
+		unsigned int m_frameIndex;
 	};
 	struct VegetationInfo
 	{
 		VegetationInfo();
 		void init(const VegetationBatInfo * lod0, const VegetationBatInfo * lod1, const VegetationBatInfo * lod2);
-		void clear();
+		void beginFrame();
+		void endFrame();
 		void commitRenderCmd(RenderFlag::RenderStageType stageType, RenderQueues * queues, int requirementArg);
-		void insert(InstanceData inst);
+		//a missing lod falls back to the closer one
+		void addGroup(TreeGroup * group, int lod);
 		// VegetationType m_type;
 		VegetationBatch * m_lodBatch[3];
 		bool anyHas();
@@ -53,8 +86,14 @@ namespace tzw {
 	{
 	public:
 		TreeGroup(int treeClass);
+		//call after m_instance is refilled, the batches holding this group rebuild their ranges
+		void commit();
 	  std::vector<InstanceData> m_instance;
 		int m_treeClass;
+		//bound of the instance positions
+		AABB m_aabb;
+		unsigned int m_uid;
+		unsigned int m_version;
 	};
 	class Tree : public Singleton<Tree>, public Drawable3D
 	{
@@ -77,8 +116,11 @@ namespace tzw {
 	  bool m_isFinish;
 
 	private:
-		std::unordered_map<int, std::unordered_set<TreeGroup*>> m_tree;
+		std::vector<TreeGroup *> m_visibleGroupList;
 		std::vector<VegetationInfo *> m_infoList;
+		//min x, y, z and max x, y, z of the visible groups, laid out for the SIMD distance test
+		std::vector<float> m_boundList[6];
+		std::vector<float> m_distList;
 	};
 
 } // namespace tzw
\ No newline at end of file
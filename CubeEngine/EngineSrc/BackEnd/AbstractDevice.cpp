@@ -5,6 +5,8 @@
 #include "RenderBackEnd.h"
 #include "VkRenderBackEnd.h"
 #include "Rendering/GraphicsRenderer.h"
+#include "NullRenderBackEnd.h"
+#include "Rendering/HeadlessRenderer.h"
 namespace tzw {
 void AbstractDevice::keyPressEvent(int theCode)
 {
@@ -84,6 +86,13 @@ void AbstractDevice::createRenderBackEnd(GLFWwindow * window)
         RenderBackEnd::shared()->initDevice(window);
 
     }
+    else if(m_deviceType == RenderDeviceType::Null_Device)
+    {
+        Engine::shared()->setRenderBackEnd(NullRenderBackEnd::shared());
+        Engine::shared()->setRenderDeviceType(RenderDeviceType::Null_Device);
+        NullRenderBackEnd::shared()->initDevice(window);
+        HeadlessRenderer::shared()->init();
+    }
     else
     {
         Engine::shared()->setRenderBackEnd(VKRenderBackEnd::shared());
@@ -1,5 +1,6 @@
 #include "DeviceRenderPass.h"
 #include "VkRenderBackEnd.h"
+#include "Engine/Engine.h"
 #include "DeviceTexture.h"
 #include "DeviceFrameBuffer.h"
 #include "DeviceRenderStage.h"
@@ -51,7 +52,7 @@ namespace tzw
         vertexDataInput.addVertexAttributeDesc({VK_FORMAT_R32G32_SFLOAT, offsetof(VertexData, m_texCoord)});
 
         DeviceVertexInput emptyInstancingInput;
-		m_singlePipeline = VKRenderBackEnd::shared()->createPipeline_imp();
+		m_singlePipeline = Engine::shared()->getRenderBackEnd()->createPipeline_imp();
         m_singlePipeline->init(getFrameBuffer()->getSize(), material, getRenderPass(), vertexDataInput, false, emptyInstancingInput);
     }
 
@@ -60,6 +61,12 @@ namespace tzw
         return m_singlePipeline;
     }
 
+    void DeviceRenderStage::setPassTransformation(const Matrix44& viewMatrix, const Matrix44& projectMatrix)
+    {
+        m_passTransformation.m_viewMatrix = viewMatrix;
+        m_passTransformation.m_projectMatrix = projectMatrix;
+    }
+
     void DeviceRenderStage::initFullScreenQuad()
     {
         VertexData vertices[] = {
@@ -69,7 +76,7 @@ namespace tzw
             VertexData(vec3(-1.0f,  1.0f,  1.0f), vec2(0.0f, 1.f)),  // v2
             VertexData(vec3( 1.0f,  1.0f,  1.0f), vec2(1.f, 1.f)), // v3
         };
-        auto vbuffer = VKRenderBackEnd::shared()->createBuffer_imp();
+        auto vbuffer = Engine::shared()->getRenderBackEnd()->createBuffer_imp();
         vbuffer->init(DeviceBufferType::Vertex);
 
         vbuffer->allocate(vertices, sizeof(vertices[0]) * 4);
@@ -80,7 +87,7 @@ namespace tzw
          0,  1,  2,  1,  3,  2,
 
 		};
-        auto ibuffer = VKRenderBackEnd::shared()->createBuffer_imp();
+        auto ibuffer = Engine::shared()->getRenderBackEnd()->createBuffer_imp();
         ibuffer->init(DeviceBufferType::Index);
 
         ibuffer->allocate(indices, sizeof(indices));
@@ -22,7 +22,10 @@ public:
 	void setFrameBuffer(DeviceFrameBuffer * frameBuffer);
 	virtual void prepare();
 	virtual void finish() = 0;
-	virtual void draw(std::vector<RenderCommand> & cmdList) = 0;
+	//order is the draw order of the commands (see RenderQueues::sortCommandList), nullptr for the list order
+	virtual void draw(std::vector<RenderCommand> & cmdList, const uint32_t * order = nullptr) = 0;
+	//view and projection used by draw for every command
+	void setPassTransformation(const Matrix44 & viewMatrix, const Matrix44 & projectMatrix);
 	virtual void drawScreenQuad() = 0;
 	virtual void drawSphere() = 0;
 	void createSinglePipeline(Material * material);
@@ -44,6 +47,7 @@ protected:
 	DeviceRenderPass * m_renderPass;
 	DeviceFrameBuffer * m_frameBuffer;
 	DevicePipeline * m_singlePipeline;
+	PassTransformation m_passTransformation;
 	std::unordered_map<Material *, DevicePipeline *>m_matPipelinePool;
 	std::unordered_set<DevicePipeline *> m_fuckingObjList;
     static DeviceBuffer * m_quadVertexBuffer;
@@ -215,6 +215,11 @@ void GLFW_BackEnd::changeScreenSetting(int w, int h, bool isFullScreen)
 	glfwSetWindowCenter(m_window);
 }
 
+void GLFW_BackEnd::requestClose()
+{
+	glfwSetWindowShouldClose(m_window, GLFW_TRUE);
+}
+
 
 
 bool
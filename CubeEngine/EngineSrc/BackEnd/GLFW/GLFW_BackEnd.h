@@ -19,6 +19,7 @@ public:
 	void setWinSize(int width, int height) override;
 	void setIsFullScreen(bool isFullScreen) override;
 	void changeScreenSetting(int w, int h, bool isFullScreen) override;
+	void requestClose() override;
 private:
     GLFWwindow * m_window;
 	bool glfwSetWindowCenter( GLFWwindow * window );
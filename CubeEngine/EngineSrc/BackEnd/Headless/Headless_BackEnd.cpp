@@ -0,0 +1,43 @@
+#include "Headless_BackEnd.h"
+#include "EngineSrc/BackEnd/AbstractDevice.h"
+#include "EngineSrc/Engine/Engine.h"
+#include <cstdlib>
+
+namespace tzw {
+
+Headless_BackEnd::Headless_BackEnd()
+	: m_isCloseRequested(false)
+{
+}
+
+void
+Headless_BackEnd::prepare(int width, int height, bool isFullScreen)
+{
+	AbstractDevice::shared()->setRenderDevice(RenderDeviceType::Null_Device);
+	AbstractDevice::shared()->createRenderBackEnd(nullptr);
+	AbstractDevice::shared()->init(width, height);
+}
+
+void
+Headless_BackEnd::run()
+{
+	while (!m_isCloseRequested) {
+		Engine::shared()->update(EngineDef::headlessDeltaTime);
+	}
+	exit(EngineDef::headlessExitCode);
+}
+
+void
+Headless_BackEnd::getMousePos(double* posX, double* posY)
+{
+	*posX = 0.0;
+	*posY = 0.0;
+}
+
+void
+Headless_BackEnd::requestClose()
+{
+	m_isCloseRequested = true;
+}
+
+} // namespace tzw
@@ -0,0 +1,22 @@
+#ifndef TZW_HEADLESS_BACKEND_H
+#define TZW_HEADLESS_BACKEND_H
+
+#include "../WindowBackEnd.h"
+
+namespace tzw {
+// No window and no input, the frames run back to back with EngineDef::headlessDeltaTime on the null render device.
+class Headless_BackEnd : public WindowBackEnd
+{
+public:
+    Headless_BackEnd();
+    void prepare(int width, int height, bool isFullScreen) override;
+    void run() override;
+	void getMousePos(double* posX, double* posY) override;
+	void requestClose() override;
+private:
+	bool m_isCloseRequested;
+};
+
+} // namespace tzw
+
+#endif // TZW_HEADLESS_BACKEND_H
@@ -0,0 +1,129 @@
+#include "NullRenderBackEnd.h"
+#include "DeviceTexture.h"
+#include "null/DeviceBufferNull.h"
+#include "null/DeviceShaderNull.h"
+#include "null/DevicePipelineNull.h"
+#include "null/DeviceRenderPassNull.h"
+#include "null/DeviceRenderStageNull.h"
+#include "null/DeviceFrameBufferNull.h"
+#include "gli/gli.hpp"
+#include "SOIL2/stb_image.h"
+#include "Utility/log/Log.h"
+
+namespace tzw {
+
+NullDeviceStats::NullDeviceStats():
+m_drawCount(0),
+m_instanceCount(0),
+m_indexCount(0),
+m_uploadBytes(0),
+m_bufferCount(0),
+m_bufferBytes(0),
+m_textureCount(0),
+m_textureBytes(0),
+m_shaderCount(0),
+m_pipelineCount(0)
+{
+}
+
+void NullDeviceStats::resetFrame()
+{
+	m_drawCount = 0;
+	m_instanceCount = 0;
+	m_indexCount = 0;
+	m_uploadBytes = 0;
+}
+
+NullRenderBackEnd::NullRenderBackEnd()
+{
+}
+
+void NullRenderBackEnd::initDevice(GLFWwindow* window)
+{
+	tlog("null render device, nothing will be drawn");
+}
+
+DeviceTexture* NullRenderBackEnd::loadTexture_imp(const unsigned char* buf, size_t buffSize, unsigned int loadingFlag)
+{
+	DeviceTexture * texture = new DeviceTexture();
+	texture->m_uid = 0;
+	ImageMetaInfo & info = texture->m_metaInfo;
+	info.dds_mipMapLevel = 1;
+	info.m_imageFormat = ImageFormat::R8G8B8A8;
+	//only the header is parsed, the size is what the sprites and the GUI need
+	if(!stbi_info_from_memory(buf, static_cast<int>(buffSize), &info.width, &info.height, &info.channels))
+	{
+		gli::texture t = gli::load(reinterpret_cast<const char *>(buf), buffSize);
+		info.width = t.empty() ? 1 : t.extent().x;
+		info.height = t.empty() ? 1 : t.extent().y;
+		info.channels = 4;
+		info.dds_mipMapLevel = t.empty() ? 1 : static_cast<int>(t.levels());
+	}
+	m_stats.m_textureCount += 1;
+	m_stats.m_textureBytes += buffSize;
+	m_stats.m_uploadBytes += buffSize;
+	return texture;
+}
+
+DeviceTexture* NullRenderBackEnd::loadTextureRaw_imp(const unsigned char* buf, int width, int height, ImageFormat format, unsigned int loadingFlag)
+{
+	DeviceTexture * texture = new DeviceTexture();
+	texture->m_uid = 0;
+	ImageMetaInfo & info = texture->m_metaInfo;
+	info.width = width;
+	info.height = height;
+	info.channels = static_cast<int>(ImageFormatGetSize(format));
+	info.dds_mipMapLevel = 1;
+	info.m_imageFormat = format;
+	size_t size = size_t(width) * height * ImageFormatGetSize(format);
+	m_stats.m_textureCount += 1;
+	m_stats.m_textureBytes += size;
+	m_stats.m_uploadBytes += size;
+	return texture;
+}
+
+DeviceShader* NullRenderBackEnd::createShader_imp()
+{
+	return new DeviceShaderNull();
+}
+
+DeviceBuffer* NullRenderBackEnd::createBuffer_imp()
+{
+	return new DeviceBufferNull();
+}
+
+DeviceRenderPass* NullRenderBackEnd::createDeviceRenderpass_imp()
+{
+	return new DeviceRenderPassNull();
+}
+
+DevicePipeline* NullRenderBackEnd::createPipeline_imp()
+{
+	return new DevicePipelineNull();
+}
+
+DeviceRenderStage* NullRenderBackEnd::createRenderStage_imp()
+{
+	return new DeviceRenderStageNull();
+}
+
+DeviceFrameBuffer* NullRenderBackEnd::createFrameBuffer_imp()
+{
+	return new DeviceFrameBufferNull();
+}
+
+void NullRenderBackEnd::prepareFrame()
+{
+	m_stats.resetFrame();
+}
+
+void NullRenderBackEnd::endFrame(RenderPath* renderPath)
+{
+}
+
+NullDeviceStats& NullRenderBackEnd::getStats()
+{
+	return m_stats;
+}
+
+} // namespace tzw
@@ -0,0 +1,51 @@
+#pragma once
+#include "../Engine/EngineDef.h"
+#include "RenderBackEndBase.h"
+#include <cstddef>
+
+namespace tzw {
+
+//what the null device has been asked to do
+struct NullDeviceStats
+{
+	NullDeviceStats();
+	void resetFrame();
+	//per frame
+	int m_drawCount;
+	int m_instanceCount;
+	size_t m_indexCount;
+	//vertex, index and uniform data copied into buffers
+	size_t m_uploadBytes;
+	//alive resources
+	int m_bufferCount;
+	size_t m_bufferBytes;
+	int m_textureCount;
+	size_t m_textureBytes;
+	int m_shaderCount;
+	int m_pipelineCount;
+};
+
+// Render backend without any graphics api, the device objects only record the calls and the buffer sizes.
+// Used by the headless mode, so the CPU side of a frame can run on machines without a GPU.
+class NullRenderBackEnd:public Singleton<NullRenderBackEnd>, public RenderBackEndBase
+{
+public:
+	NullRenderBackEnd();
+	void initDevice(GLFWwindow * window) override;
+	DeviceTexture * loadTexture_imp(const unsigned char* buf, size_t buffSize, unsigned int loadingFlag) override;
+	DeviceTexture * loadTextureRaw_imp(const unsigned char* buf, int width, int height, ImageFormat format, unsigned int loadingFlag) override;
+	DeviceShader * createShader_imp() override;
+	DeviceBuffer * createBuffer_imp() override;
+	DeviceRenderPass * createDeviceRenderpass_imp() override;
+	DevicePipeline * createPipeline_imp() override;
+	DeviceRenderStage * createRenderStage_imp() override;
+	DeviceFrameBuffer * createFrameBuffer_imp() override;
+	void prepareFrame() override;
+	void endFrame(RenderPath * renderPath) override;
+	//the per frame counters are reset by prepareFrame
+	NullDeviceStats & getStats();
+private:
+	NullDeviceStats m_stats;
+};
+
+} // namespace tzw
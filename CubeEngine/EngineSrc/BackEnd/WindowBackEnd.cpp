@@ -42,4 +42,8 @@ void WindowBackEnd::setIsFullScreen(bool isFullScreen)
 void WindowBackEnd::changeScreenSetting(int w, int h, bool isFullScreen)
 {
 }
+
+void WindowBackEnd::requestClose()
+{
+}
 } // namespace tzw
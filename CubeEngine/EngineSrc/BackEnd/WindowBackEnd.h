@@ -16,6 +16,7 @@ public:
 	virtual void setWinSize(int width, int height);
 	virtual void setIsFullScreen(bool isFullScreen);
 	virtual void changeScreenSetting(int w, int h, bool isFullScreen);
+	virtual void requestClose();
 private:
 };
 
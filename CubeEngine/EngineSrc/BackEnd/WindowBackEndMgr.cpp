@@ -1,5 +1,6 @@
 #include "WindowBackEndMgr.h"
 #include "GLFW/GLFW_BackEnd.h"
+#include "Headless/Headless_BackEnd.h"
 namespace tzw {
 
 WindowBackEnd *WindowBackEndMgr::getWindowBackEnd(int type)
@@ -11,6 +12,10 @@ WindowBackEnd *WindowBackEndMgr::getWindowBackEnd(int type)
     {
         return backEnd = new GLFW_BackEnd();
     }
+    case TZW_WINDOW_HEADLESS:
+    {
+        return backEnd = new Headless_BackEnd();
+    }
     default:
         return nullptr;
     }
@@ -6,6 +6,7 @@ namespace tzw {
 #define TZW_WINDOW_GLFW 0
 #define TZW_WINDOW_SDL 1
 #define TZW_WINDOW_QT 2
+#define TZW_WINDOW_HEADLESS 3
 class WindowBackEndMgr:public Singleton<WindowBackEndMgr>
 {
 public:
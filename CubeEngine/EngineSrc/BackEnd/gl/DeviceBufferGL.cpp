@@ -6,22 +6,26 @@ namespace tzw
 	void DeviceBufferGL::allocate(void* data, size_t ammount)
 	{
 		bind();
-		RenderFlag::BufferTarget glBufferType = RenderFlag::BufferTarget::VertexBuffer;
-		switch(m_type)
-		{
-		case DeviceBufferType::Vertex:
-			glBufferType = RenderFlag::BufferTarget::VertexBuffer;
-			break;
-		case DeviceBufferType::Index:
-			glBufferType = RenderFlag::BufferTarget::IndexBuffer;
-			break;
-
-		
-		}
+		RenderFlag::BufferTarget glBufferType = getTarget();
 		RenderBackEnd::shared()->bindBuffer(glBufferType,m_uid);
 		RenderBackEnd::shared()->submit(glBufferType,ammount,data, RenderFlag::BufferStorageType::STATIC_DRAW);
 	}
 
+	void DeviceBufferGL::allocateEmpty(size_t ammount)
+	{
+		//the content is filled later by copyFrom
+		RenderFlag::BufferTarget glBufferType = getTarget();
+		RenderBackEnd::shared()->bindBuffer(glBufferType,m_uid);
+		RenderBackEnd::shared()->submit(glBufferType,ammount,nullptr, RenderFlag::BufferStorageType::DYNAMIC_DRAW);
+	}
+
+	void DeviceBufferGL::copyFrom(void* ptr, size_t size, size_t memOffset)
+	{
+		RenderFlag::BufferTarget glBufferType = getTarget();
+		RenderBackEnd::shared()->bindBuffer(glBufferType,m_uid);
+		RenderBackEnd::shared()->resubmit(glBufferType, memOffset, size, ptr);
+	}
+
 	bool DeviceBufferGL::init(DeviceBufferType type)
 	{
 		m_uid = RenderBackEnd::shared()->genBuffer();
@@ -47,4 +51,15 @@ namespace tzw
 		//no use, only for vulkan
 	}
 
+	RenderFlag::BufferTarget DeviceBufferGL::getTarget() const
+	{
+		switch(m_type)
+		{
+		case DeviceBufferType::Index:
+			return RenderFlag::BufferTarget::IndexBuffer;
+		default:
+			return RenderFlag::BufferTarget::VertexBuffer;
+		}
+	}
+
 }
\ No newline at end of file
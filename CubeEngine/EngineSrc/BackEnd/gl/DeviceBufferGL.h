@@ -1,5 +1,7 @@
 #pragma once
 #include "../DeviceBuffer.h"
+#include "Rendering/RenderFlag.h"
+#include <cstddef>
 
 namespace tzw
 {
@@ -8,9 +10,13 @@ class DeviceBufferGL : public DeviceBuffer
 {
 public:
 	virtual void allocate(void * data, size_t ammount);
+	void allocateEmpty(size_t ammount) override;
 	virtual bool init(DeviceBufferType type);
 	virtual void bind();//only for GL
 	void setUsePool(bool isUsed) override;
+	void copyFrom( void * ptr, size_t size, size_t memOffset = 0) override;
+private:
+	RenderFlag::BufferTarget getTarget() const;
 };
 };
 
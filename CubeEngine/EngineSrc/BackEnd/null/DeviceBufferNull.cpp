@@ -0,0 +1,66 @@
+#include "DeviceBufferNull.h"
+#include "../NullRenderBackEnd.h"
+namespace tzw
+{
+	DeviceBufferNull::DeviceBufferNull():
+	m_bufferSize(0)
+	{
+		m_alignment = 0;
+		NullRenderBackEnd::shared()->getStats().m_bufferCount += 1;
+	}
+
+	DeviceBufferNull::~DeviceBufferNull()
+	{
+		auto & stats = NullRenderBackEnd::shared()->getStats();
+		stats.m_bufferCount -= 1;
+		stats.m_bufferBytes -= m_bufferSize;
+	}
+
+	void DeviceBufferNull::allocate(void* data, size_t ammount)
+	{
+		resize(ammount);
+		NullRenderBackEnd::shared()->getStats().m_uploadBytes += ammount;
+	}
+
+	void DeviceBufferNull::allocateEmpty(size_t ammount)
+	{
+		resize(ammount);
+	}
+
+	bool DeviceBufferNull::init(DeviceBufferType type)
+	{
+		m_type = type;
+		return true;
+	}
+
+	void DeviceBufferNull::bind()
+	{
+	}
+
+	void DeviceBufferNull::setUsePool(bool isUsed)
+	{
+	}
+
+	size_t DeviceBufferNull::getSize()
+	{
+		return m_bufferSize;
+	}
+
+	bool DeviceBufferNull::hasEnoughRoom(size_t size)
+	{
+		return size <= m_bufferSize;
+	}
+
+	void DeviceBufferNull::copyFrom(void* ptr, size_t size, size_t memOffset)
+	{
+		NullRenderBackEnd::shared()->getStats().m_uploadBytes += size;
+	}
+
+	void DeviceBufferNull::resize(size_t ammount)
+	{
+		auto & stats = NullRenderBackEnd::shared()->getStats();
+		stats.m_bufferBytes += ammount;
+		stats.m_bufferBytes -= m_bufferSize;
+		m_bufferSize = ammount;
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "../DeviceBuffer.h"
+#include <cstddef>
+namespace tzw
+{
+
+class DeviceBufferNull : public DeviceBuffer
+{
+public:
+	DeviceBufferNull();
+	~DeviceBufferNull();
+	void allocate(void * data, size_t ammount) override;
+	void allocateEmpty(size_t ammount) override;
+	bool init(DeviceBufferType type) override;
+	void bind() override;
+	void setUsePool(bool isUsed) override;
+	size_t getSize() override;
+	bool hasEnoughRoom(size_t size) override;
+	void copyFrom( void * ptr, size_t size, size_t memOffset = 0) override;
+private:
+	void resize(size_t ammount);
+	size_t m_bufferSize;
+};
+};
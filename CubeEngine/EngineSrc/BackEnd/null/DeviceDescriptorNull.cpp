@@ -0,0 +1,19 @@
+#include "DeviceDescriptorNull.h"
+namespace tzw
+{
+	void DeviceDescriptorNull::updateDescriptorByBinding(int binding, DeviceTexture* texture)
+	{
+	}
+
+	void DeviceDescriptorNull::updateDescriptorByBinding(int binding, std::vector<DeviceTexture*>& textureList)
+	{
+	}
+
+	void DeviceDescriptorNull::updateDescriptorByBinding(int binding, DeviceBuffer* buffer, size_t offset, size_t range)
+	{
+	}
+
+	void DeviceDescriptorNull::updateDescriptorByBinding(int binding, DeviceItemBuffer* itemBuff)
+	{
+	}
+}
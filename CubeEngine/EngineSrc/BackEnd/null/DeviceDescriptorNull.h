@@ -0,0 +1,16 @@
+#pragma once
+#include "../DeviceDescriptor.h"
+#include <cstddef>
+namespace tzw
+{
+
+class DeviceDescriptorNull : public DeviceDescriptor
+{
+public:
+	DeviceDescriptorNull() = default;
+	void updateDescriptorByBinding(int binding, DeviceTexture * texture) override;
+	void updateDescriptorByBinding(int binding, std::vector<DeviceTexture *>& textureList) override;
+	void updateDescriptorByBinding(int binding, DeviceBuffer * buffer, size_t offset, size_t range) override;
+	void updateDescriptorByBinding(int binding, DeviceItemBuffer * itemBuff) override;
+};
+};
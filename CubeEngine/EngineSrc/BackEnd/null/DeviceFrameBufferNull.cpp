@@ -0,0 +1,63 @@
+#include "DeviceFrameBufferNull.h"
+#include "../DeviceTexture.h"
+#include "../NullRenderBackEnd.h"
+namespace tzw
+{
+	static DeviceTexture * createAttachment(int w, int h, ImageFormat format)
+	{
+		DeviceTexture * texture = new DeviceTexture();
+		texture->m_uid = 0;
+		texture->m_metaInfo.width = w;
+		texture->m_metaInfo.height = h;
+		texture->m_metaInfo.channels = 4;
+		texture->m_metaInfo.dds_mipMapLevel = 1;
+		texture->m_metaInfo.m_imageFormat = format;
+		auto & stats = NullRenderBackEnd::shared()->getStats();
+		stats.m_textureCount += 1;
+		stats.m_textureBytes += size_t(w) * h * ImageFormatGetSize(format);
+		return texture;
+	}
+
+	DeviceFrameBufferNull::DeviceFrameBufferNull()
+	{
+		m_depthTexture = nullptr;
+	}
+
+	void DeviceFrameBufferNull::init(int w, int h, DeviceRenderPass* renderPass)
+	{
+		m_size = vec2(w, h);
+		for(auto & attachInfo : renderPass->getAttachmentList())
+		{
+			if(attachInfo.isDepth)
+			{
+				m_depthTexture = createAttachment(w, h, attachInfo.format);
+			}
+			else
+			{
+				m_textureList.emplace_back(createAttachment(w, h, attachInfo.format));
+			}
+		}
+	}
+
+	void DeviceFrameBufferNull::init(DeviceTexture* tex, DeviceTexture* depth, DeviceRenderPass* renderPass)
+	{
+		m_size = vec2(tex->m_metaInfo.width, tex->m_metaInfo.height);
+		m_textureList.emplace_back(tex);
+		m_depthTexture = depth;
+	}
+
+	DeviceTexture* DeviceFrameBufferNull::getDepthMap()
+	{
+		return m_depthTexture;
+	}
+
+	std::vector<DeviceTexture*>& DeviceFrameBufferNull::getTextureList()
+	{
+		return m_textureList;
+	}
+
+	vec2 DeviceFrameBufferNull::getSize()
+	{
+		return m_size;
+	}
+}
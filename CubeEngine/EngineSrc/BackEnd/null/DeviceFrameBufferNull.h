@@ -0,0 +1,16 @@
+#pragma once
+#include "../DeviceFrameBuffer.h"
+namespace tzw
+{
+
+class DeviceFrameBufferNull : public DeviceFrameBuffer
+{
+public:
+	DeviceFrameBufferNull();
+	void init(int w, int h, DeviceRenderPass * renderPass) override;
+	void init(DeviceTexture * tex, DeviceTexture * depth, DeviceRenderPass * renderPass) override;
+	DeviceTexture * getDepthMap() override;
+	std::vector<DeviceTexture *> & getTextureList() override;
+	vec2 getSize() override;
+};
+};
@@ -0,0 +1,41 @@
+#include "DevicePipelineNull.h"
+#include "../NullRenderBackEnd.h"
+namespace tzw
+{
+	DevicePipelineNull::DevicePipelineNull():
+	m_mat(nullptr)
+	{
+	}
+
+	void DevicePipelineNull::init(vec2 viewPortSize, Material* mat, DeviceRenderPass* targetRenderPass,
+		DeviceVertexInput vertexInput, bool isSupportInstancing, DeviceVertexInput instanceVertexInput, int colorAttachmentCount)
+	{
+		m_mat = mat;
+		NullRenderBackEnd::shared()->getStats().m_pipelineCount += 1;
+	}
+
+	void DevicePipelineNull::updateUniformSingle(std::string name, void* buff, size_t size)
+	{
+		NullRenderBackEnd::shared()->getStats().m_uploadBytes += size;
+	}
+
+	DeviceDescriptor* DevicePipelineNull::getMaterialDescriptorSet()
+	{
+		return &m_materialDescriptor;
+	}
+
+	void DevicePipelineNull::collcetItemWiseDescritporSet()
+	{
+	}
+
+	DeviceDescriptor* DevicePipelineNull::giveItemWiseDescriptorSet()
+	{
+		//nothing is kept in the descriptor, so every draw can share the same one
+		return &m_itemDescriptor;
+	}
+
+	Material* DevicePipelineNull::getMaterial()
+	{
+		return m_mat;
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "../DevicePipeline.h"
+#include "DeviceDescriptorNull.h"
+namespace tzw
+{
+
+class DevicePipelineNull : public DevicePipeline
+{
+public:
+	DevicePipelineNull();
+	void init(vec2 viewPortSize, Material * mat, DeviceRenderPass* targetRenderPass
+		,DeviceVertexInput vertexInput, bool isSupportInstancing, DeviceVertexInput instanceVertexInput, int colorAttachmentCount = 1) override;
+	void updateUniformSingle(std::string name, void * buff, size_t size) override;
+	DeviceDescriptor * getMaterialDescriptorSet() override;
+	void collcetItemWiseDescritporSet() override;
+	DeviceDescriptor * giveItemWiseDescriptorSet() override;
+	Material * getMaterial();
+private:
+	Material * m_mat;
+	DeviceDescriptorNull m_materialDescriptor;
+	DeviceDescriptorNull m_itemDescriptor;
+};
+};
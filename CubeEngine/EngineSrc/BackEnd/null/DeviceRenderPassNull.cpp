@@ -0,0 +1,27 @@
+#include "DeviceRenderPassNull.h"
+namespace tzw
+{
+	DeviceRenderPassNull::DeviceRenderPassNull()
+	{
+	}
+
+	void DeviceRenderPassNull::init(int colorAttachNum, OpType opType, ImageFormat format, bool isNeedTransitionToRread, bool isOutputToScreen)
+	{
+		m_isNeedTransitionToRead = isNeedTransitionToRread;
+		m_isOutPutToScreen = isOutputToScreen;
+		m_opType = opType;
+		for(int i =0 ; i < colorAttachNum; i++)
+		{
+			DeviceRenderPassAttachmentInfo attachInfo;
+			attachInfo.attachmentIndex = i;
+			attachInfo.format = format;
+			attachInfo.isDepth = false;
+			m_attachmentList.emplace_back(attachInfo);
+		}
+		DeviceRenderPassAttachmentInfo depthInfo;
+		depthInfo.attachmentIndex = colorAttachNum;
+		depthInfo.format = ImageFormat::D24_S8;
+		depthInfo.isDepth = true;
+		m_attachmentList.emplace_back(depthInfo);
+	}
+}
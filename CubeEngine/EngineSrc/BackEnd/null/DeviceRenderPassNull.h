@@ -0,0 +1,12 @@
+#pragma once
+#include "../DeviceRenderPass.h"
+namespace tzw
+{
+
+class DeviceRenderPassNull : public DeviceRenderPass
+{
+public:
+	DeviceRenderPassNull();
+	void init(int colorAttachNum, OpType opType, ImageFormat format,bool isNeedTransitionToRread, bool isOutputToScreen = false) override;
+};
+};
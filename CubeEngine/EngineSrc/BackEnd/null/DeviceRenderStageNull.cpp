@@ -0,0 +1,167 @@
+#include "DeviceRenderStageNull.h"
+#include "DevicePipelineNull.h"
+#include "../NullRenderBackEnd.h"
+#include "Mesh/InstancedMesh.h"
+#include "Technique/Material.h"
+#include "Engine/Engine.h"
+namespace tzw
+{
+	DeviceRenderStageNull::DeviceRenderStageNull()
+	{
+		m_renderPass = nullptr;
+		m_frameBuffer = nullptr;
+		m_singlePipeline = nullptr;
+	}
+
+	void DeviceRenderStageNull::finish()
+	{
+	}
+
+	void DeviceRenderStageNull::draw(std::vector<RenderCommand>& cmdList, const uint32_t * order)
+	{
+		//same work as DeviceRenderStageVK::draw on the CPU side: pipeline lookup, per item uniform and the bind tracking
+		auto & stats = NullRenderBackEnd::shared()->getStats();
+		Material * lastMat = nullptr;
+		DevicePipeline * currPipeLine = nullptr;
+		DevicePipeline * lastPipeline = nullptr;
+		DeviceBuffer * lastVBO = nullptr;
+		DeviceBuffer * lastIBO = nullptr;
+		int bindIssued = 0;
+		int bindSkipped = 0;
+		const Matrix44 & viewMatrix = m_passTransformation.m_viewMatrix;
+		Matrix44 viewProjectMatrix = m_passTransformation.m_projectMatrix * viewMatrix;
+		size_t count = cmdList.size();
+		for(size_t n = 0; n < count; n++)
+		{
+			RenderCommand & a = cmdList[order ? order[n] : n];
+			Material * mat = a.getMat();
+			if(mat != lastMat)
+			{
+				auto iter = m_matPipelinePool.find(mat);
+				if(iter == m_matPipelinePool.end())
+				{
+					currPipeLine = NullRenderBackEnd::shared()->createPipeline_imp();
+					DeviceVertexInput vertexInput;
+					DeviceVertexInput instanceInput;
+					currPipeLine->init(vec2(), mat, m_renderPass, vertexInput, a.batchType() != RenderCommand::RenderBatchType::Single, instanceInput);
+					m_matPipelinePool[mat] = currPipeLine;
+				}
+				else
+				{
+					currPipeLine = iter->second;
+				}
+				lastMat = mat;
+			}
+			m_itemUniform[0] = viewProjectMatrix * a.m_transInfo.m_worldMatrix;
+			m_itemUniform[1] = viewMatrix * a.m_transInfo.m_worldMatrix;
+			currPipeLine->giveItemWiseDescriptorSet();
+			//wvp, wv, world, view and projection
+			stats.m_uploadBytes += sizeof(Matrix44) * 5;
+			Mesh * mesh = nullptr;
+			int instanceCount = 1;
+			if(a.batchType() != RenderCommand::RenderBatchType::Single)
+			{
+				mesh = a.getInstancedMesh()->getMesh();
+				instanceCount = a.getInstanceCount();
+			}
+			else
+			{
+				mesh = a.getMesh();
+			}
+			auto vbo = mesh->getArrayBuf()->bufferId();
+			auto ibo = mesh->getIndexBuf()->bufferId();
+			if(!vbo || !ibo) continue;
+			if(currPipeLine != lastPipeline)
+			{
+				lastPipeline = currPipeLine;
+				bindIssued += 2;
+			}
+			else
+			{
+				bindSkipped += 2;
+			}
+			if(vbo != lastVBO)
+			{
+				lastVBO = vbo;
+				bindIssued++;
+			}
+			else
+			{
+				bindSkipped++;
+			}
+			if(ibo != lastIBO)
+			{
+				lastIBO = ibo;
+				bindIssued++;
+			}
+			else
+			{
+				bindSkipped++;
+			}
+			drawElement(static_cast<uint32_t>(mesh->getIndicesSize()), instanceCount, 0, 0, 0);
+		}
+		Engine::shared()->increaseBindCount(bindIssued, bindSkipped);
+	}
+
+	void DeviceRenderStageNull::drawScreenQuad()
+	{
+		drawElement(6, 1, 0, 0, 0);
+	}
+
+	void DeviceRenderStageNull::drawSphere()
+	{
+		if(!m_sphere)
+		{
+			initSphere();
+		}
+		drawElement(static_cast<uint32_t>(m_sphere->getIndicesSize()), 1, 0, 0, 0);
+	}
+
+	void DeviceRenderStageNull::bindSinglePipelineDescriptor()
+	{
+	}
+
+	void DeviceRenderStageNull::bindSinglePipelineDescriptor(DeviceDescriptor* extraItemDescriptor)
+	{
+	}
+
+	void DeviceRenderStageNull::bindPipeline(DevicePipeline* pipeline)
+	{
+	}
+
+	void DeviceRenderStageNull::bindDescriptor(DevicePipeline* pipeline, std::vector<DeviceDescriptor*> descriptorList)
+	{
+	}
+
+	void DeviceRenderStageNull::beginRenderPass(vec4 clearColor, vec2 clearDepthStencil)
+	{
+	}
+
+	void DeviceRenderStageNull::endRenderPass()
+	{
+	}
+
+	void DeviceRenderStageNull::bindVBO(DeviceBuffer* buf)
+	{
+	}
+
+	void DeviceRenderStageNull::bindIBO(DeviceBuffer* buf)
+	{
+	}
+
+	void DeviceRenderStageNull::setScissor(vec4 scissorRect)
+	{
+	}
+
+	void DeviceRenderStageNull::drawElement(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+	{
+		auto & stats = NullRenderBackEnd::shared()->getStats();
+		stats.m_drawCount += 1;
+		stats.m_instanceCount += instanceCount;
+		stats.m_indexCount += size_t(indexCount) * instanceCount;
+	}
+
+	void DeviceRenderStageNull::fetchCommand()
+	{
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "../DeviceRenderStage.h"
+namespace tzw
+{
+
+class DeviceRenderStageNull : public DeviceRenderStage
+{
+public:
+	DeviceRenderStageNull();
+	void finish() override;
+	void draw(std::vector<RenderCommand> & cmdList, const uint32_t * order = nullptr) override;
+	void drawScreenQuad() override;
+	void drawSphere() override;
+	void bindSinglePipelineDescriptor() override;
+	void bindSinglePipelineDescriptor(DeviceDescriptor * extraItemDescriptor) override;
+	void bindPipeline(DevicePipeline * pipeline) override;
+	void bindDescriptor(DevicePipeline * pipeline, std::vector<DeviceDescriptor *> descriptorList) override;
+	void beginRenderPass(vec4 clearColor = vec4(0, 0, 0, 1), vec2 clearDepthStencil = vec2(1, 0)) override;
+	void endRenderPass() override;
+	void bindVBO(DeviceBuffer * buf) override;
+	void bindIBO(DeviceBuffer * buf) override;
+	void setScissor(vec4 scissorRect) override;
+	void drawElement(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) override;
+protected:
+	void fetchCommand() override;
+	//wvp and wv of the last item, written like the uniform buffer of the vulkan stage
+	Matrix44 m_itemUniform[2];
+};
+};
@@ -0,0 +1,31 @@
+#include "DeviceShaderNull.h"
+#include "../NullRenderBackEnd.h"
+namespace tzw
+{
+	DeviceShaderNull::DeviceShaderNull():
+	m_sourceSize(0)
+	{
+		m_uid = 0;
+	}
+
+	void DeviceShaderNull::addShader(const unsigned char* buff, size_t size, DeviceShaderType type, const unsigned char* fileInfoStr)
+	{
+		m_sourceSize += size;
+	}
+
+	bool DeviceShaderNull::create()
+	{
+		NullRenderBackEnd::shared()->getStats().m_shaderCount += 1;
+		return true;
+	}
+
+	bool DeviceShaderNull::finish()
+	{
+		return true;
+	}
+
+	size_t DeviceShaderNull::getSourceSize()
+	{
+		return m_sourceSize;
+	}
+}
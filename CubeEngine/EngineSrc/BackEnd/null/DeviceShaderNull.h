@@ -0,0 +1,18 @@
+#pragma once
+#include "../DeviceShader.h"
+#include <cstddef>
+namespace tzw
+{
+
+class DeviceShaderNull : public DeviceShader
+{
+public:
+	DeviceShaderNull();
+	void addShader(const unsigned char * buff, size_t size, DeviceShaderType type, const unsigned char * fileInfoStr) override;
+	bool create() override;
+	bool finish() override;
+	size_t getSourceSize();
+private:
+	size_t m_sourceSize;
+};
+};
@@ -7,6 +7,8 @@
 #include "Rendering/RenderCommand.h"
 #include "BackEnd/vk/DeviceBufferVK.h"
 #include "Mesh/InstancedMesh.h"
+#include "Technique/Material.h"
+#include "Engine/Engine.h"
 namespace tzw
 {
 	DeviceRenderStageVK::DeviceRenderStageVK()
@@ -20,30 +22,56 @@ namespace tzw
         CHECK_VULKAN_ERROR("vkEndCommandBuffer error %d\n", res);
 	}
 
-	void DeviceRenderStageVK::draw(std::vector<RenderCommand>& cmdList)
+	void DeviceRenderStageVK::draw(std::vector<RenderCommand>& cmdList, const uint32_t * order)
 	{
-        for(RenderCommand & a : cmdList)
+        //order comes from RenderQueues::sortCommandList which groups the commands by state, so only the binds which change are recorded
+        Material * lastMat = nullptr;
+        DevicePipelineVK * currPipeLine = nullptr;
+        DevicePipelineVK * lastPipeline = nullptr;
+        VkBuffer lastVBO = VK_NULL_HANDLE;
+        VkBuffer lastIBO = VK_NULL_HANDLE;
+        int bindIssued = 0;
+        int bindSkipped = 0;
+        const Matrix44 & viewMatrix = m_passTransformation.m_viewMatrix;
+        const Matrix44 & projectMatrix = m_passTransformation.m_projectMatrix;
+        Matrix44 viewProjectMatrix = projectMatrix * viewMatrix;
+        size_t count = cmdList.size();
+        for(size_t n = 0; n < count; n++)
         {
+            RenderCommand & a = cmdList[order ? order[n] : n];
 
             //if(a.batchType() != RenderCommand::RenderBatchType::Single) continue;
             Material * mat = a.getMat();
 
             //std::string & matStr = mat->getFullDescriptionStr();
-            DevicePipelineVK * currPipeLine;
-            auto iter = m_matPipelinePool.find(mat);
-            if(iter == m_matPipelinePool.end())
+            if(mat == lastMat)
+            {
+                //same pipeline as the previous command
+            }
+            else if(m_matPipelinePool.find(mat) == m_matPipelinePool.end())
             {
                 DeviceVertexInput vertexInput;
-                vertexInput.stride = sizeof(VertexData);
-                vertexInput.addVertexAttributeDesc({VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexData, m_pos)});
-                vertexInput.addVertexAttributeDesc({VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexData, m_color)});
-                vertexInput.addVertexAttributeDesc({VK_FORMAT_R32G32_SFLOAT, offsetof(VertexData, m_texCoord)});
-                vertexInput.addVertexAttributeDesc({VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexData, m_normal)});
-                vertexInput.addVertexAttributeDesc({VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexData, m_tangent)});
+                if(mat->getVertexFormat() == RenderFlag::VertexFormat::Terrain)
+                {
+                    //packed terrain vertex, decoded in the vertex shader
+                    vertexInput.stride = sizeof(TerrainVertex);
+                    vertexInput.addVertexAttributeDesc({VK_FORMAT_R16G16B16A16_UINT, offsetof(TerrainVertex, m_pos)});
+                    vertexInput.addVertexAttributeDesc({VK_FORMAT_R16G16_SNORM, offsetof(TerrainVertex, m_normal)});
+                    vertexInput.addVertexAttributeDesc({VK_FORMAT_R8G8B8A8_UINT, offsetof(TerrainVertex, m_mat)});
+                }
+                else
+                {
+                    vertexInput.stride = sizeof(VertexData);
+                    vertexInput.addVertexAttributeDesc({VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexData, m_pos)});
+                    vertexInput.addVertexAttributeDesc({VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexData, m_color)});
+                    vertexInput.addVertexAttributeDesc({VK_FORMAT_R32G32_SFLOAT, offsetof(VertexData, m_texCoord)});
+                    vertexInput.addVertexAttributeDesc({VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexData, m_normal)});
+                    vertexInput.addVertexAttributeDesc({VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexData, m_tangent)});
 
-                //use for terrain
-                vertexInput.addVertexAttributeDesc({VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexData, m_matBlendFactor)});
-                vertexInput.addVertexAttributeDesc({VK_FORMAT_R8G8B8_UINT, offsetof(VertexData, m_matIndex)});
+                    //use for terrain
+                    vertexInput.addVertexAttributeDesc({VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexData, m_matBlendFactor)});
+                    vertexInput.addVertexAttributeDesc({VK_FORMAT_R8G8B8_UINT, offsetof(VertexData, m_matIndex)});
+                }
                 //instancing optional
                 DeviceVertexInput instanceInput;
                 //instancing
@@ -70,15 +98,16 @@ namespace tzw
                 
             }
             else{
-                currPipeLine = static_cast<DevicePipelineVK*>(iter->second);
+                currPipeLine = static_cast<DevicePipelineVK*>(m_matPipelinePool[mat]);
             }
-            if(m_fuckingObjList.find(currPipeLine) == m_fuckingObjList.end())
+            if(mat != lastMat && m_fuckingObjList.find(currPipeLine) == m_fuckingObjList.end())
             {
                 m_fuckingObjList.insert(currPipeLine);
                 currPipeLine->collcetItemWiseDescritporSet();
                 //update material-wise parameter.
                 currPipeLine->updateUniform();
             }
+            lastMat = mat;
             
             //update uniform.
             DeviceDescriptor * itemDescriptorSet = currPipeLine->giveItemWiseDescriptorSet();
@@ -87,11 +116,11 @@ namespace tzw
             DeviceItemBuffer itemBuf = VKRenderBackEnd::shared()->getItemBufferPool()->giveMeItemBuffer(sizeof(ItemUniform));
             itemBuf.map();
                 ItemUniform uniformStruct;
-                uniformStruct.wvp = a.m_transInfo.m_projectMatrix * (a.m_transInfo.m_viewMatrix  * a.m_transInfo.m_worldMatrix );
-                uniformStruct.wv = a.m_transInfo.m_viewMatrix  * a.m_transInfo.m_worldMatrix;
+                uniformStruct.wvp = viewProjectMatrix * a.m_transInfo.m_worldMatrix;
+                uniformStruct.wv = viewMatrix  * a.m_transInfo.m_worldMatrix;
                 uniformStruct.world = a.m_transInfo.m_worldMatrix;
-                uniformStruct.view = a.m_transInfo.m_viewMatrix;
-                uniformStruct.projection = a.m_transInfo.m_projectMatrix;
+                uniformStruct.view = viewMatrix;
+                uniformStruct.projection = projectMatrix;
             itemBuf.copyFrom(&uniformStruct, sizeof(uniformStruct));
             itemBuf.unMap();
 		    Mesh * mesh = nullptr;
@@ -108,17 +137,43 @@ namespace tzw
             auto ibo = static_cast<DeviceBufferVK *>(mesh->getIndexBuf()->bufferId());
             if(vbo && ibo)
             {
-                vkCmdBindPipeline(m_command, VK_PIPELINE_BIND_POINT_GRAPHICS, currPipeLine->getPipeline());
-                VkBuffer vertexBuffers[] = {vbo->getBuffer()};
-                VkDeviceSize offsets[] = {0};
-                vkCmdBindVertexBuffers(m_command, 0, 1, vertexBuffers, offsets);
-            
-            
-                vkCmdBindIndexBuffer(m_command, ibo->getBuffer(), 0, VK_INDEX_TYPE_UINT16);
-
-                std::vector<VkDescriptorSet> descriptorSetList = {static_cast<DeviceDescriptorVK*>(currPipeLine->getMaterialDescriptorSet())->getDescSet(), 
-                    static_cast<DeviceDescriptorVK*>(itemDescriptorSet)->getDescSet(),};
-                vkCmdBindDescriptorSets(m_command, VK_PIPELINE_BIND_POINT_GRAPHICS, currPipeLine->getPipelineLayOut(), 0, descriptorSetList.size(), descriptorSetList.data(), 0, nullptr);
+                VkDescriptorSet itemSet = static_cast<DeviceDescriptorVK*>(itemDescriptorSet)->getDescSet();
+                if(currPipeLine != lastPipeline)
+                {
+                    vkCmdBindPipeline(m_command, VK_PIPELINE_BIND_POINT_GRAPHICS, currPipeLine->getPipeline());
+                    VkDescriptorSet descriptorSetList[] = {static_cast<DeviceDescriptorVK*>(currPipeLine->getMaterialDescriptorSet())->getDescSet(), itemSet};
+                    vkCmdBindDescriptorSets(m_command, VK_PIPELINE_BIND_POINT_GRAPHICS, currPipeLine->getPipelineLayOut(), 0, 2, descriptorSetList, 0, nullptr);
+                    lastPipeline = currPipeLine;
+                    bindIssued += 2;
+                }
+                else
+                {
+                    //the material set stays bound, only the item set changes
+                    vkCmdBindDescriptorSets(m_command, VK_PIPELINE_BIND_POINT_GRAPHICS, currPipeLine->getPipelineLayOut(), 1, 1, &itemSet, 0, nullptr);
+                    bindSkipped += 2;
+                }
+                if(vbo->getBuffer() != lastVBO)
+                {
+                    VkBuffer vertexBuffers[] = {vbo->getBuffer()};
+                    VkDeviceSize offsets[] = {0};
+                    vkCmdBindVertexBuffers(m_command, 0, 1, vertexBuffers, offsets);
+                    lastVBO = vbo->getBuffer();
+                    bindIssued++;
+                }
+                else
+                {
+                    bindSkipped++;
+                }
+                if(ibo->getBuffer() != lastIBO)
+                {
+                    vkCmdBindIndexBuffer(m_command, ibo->getBuffer(), 0, VK_INDEX_TYPE_UINT16);
+                    lastIBO = ibo->getBuffer();
+                    bindIssued++;
+                }
+                else
+                {
+                    bindSkipped++;
+                }
                 if(a.batchType() != RenderCommand::RenderBatchType::Single)
                 {
                     auto instancingMesh = a.getInstancedMesh();
@@ -126,13 +181,14 @@ namespace tzw
                     VkBuffer instanceVertexBuffers[] = {instVBO->getBuffer()};
                     VkDeviceSize instanceOffsets[] = {0};
                     vkCmdBindVertexBuffers(m_command, 1, 1, instanceVertexBuffers, instanceOffsets);
-                    vkCmdDrawIndexed(m_command, static_cast<uint32_t>(mesh->getIndicesSize()), instancingMesh->getInstanceSize(), 0, 0, 0);
+                    vkCmdDrawIndexed(m_command, static_cast<uint32_t>(mesh->getIndicesSize()), a.getInstanceCount(), 0, 0, a.getInstanceBegin());
                 }else
                 {
                     vkCmdDrawIndexed(m_command, static_cast<uint32_t>(mesh->getIndicesSize()), 1, 0, 0, 0);
                 }
             }
         }
+        Engine::shared()->increaseBindCount(bindIssued, bindSkipped);
 	}
 
     void DeviceRenderStageVK::drawScreenQuad()
@@ -18,7 +18,7 @@ class DeviceRenderStageVK : public DeviceRenderStage
 public:
 	DeviceRenderStageVK();
 	void finish();
-	void draw(std::vector<RenderCommand> & cmdList);
+	void draw(std::vector<RenderCommand> & cmdList, const uint32_t * order = nullptr);
 	void drawScreenQuad();
 	void drawSphere();
 	VkCommandBuffer getCommand();
@@ -44,6 +44,11 @@ bool Camera::isOutOfFrustum(AABB aabb)
     return m_frustum.isOutOfFrustum(aabb);
 }
 
+bool Camera::isInsideFrustum(AABB aabb)
+{
+    return m_frustum.isInsideFrustum(aabb);
+}
+
 
 Matrix44 Camera::projection() const
 {
@@ -200,16 +205,16 @@ void Camera::setUseCustomFrustumUpdate(bool useCustomFrustumUpdate)
 
 void Camera::reCache()
 {
-	cacheTransform();
-	updateFrustum();
-	for (auto child : m_children)
-	{
-		child->reCache();
-	}
+	Node::reCache();
 	//no need to update
 	setNeedToUpdate(false); 
 }
 
+void Camera::onTransformChanged()
+{
+	updateFrustum();
+}
+
 vec3 Camera::unproject(vec3 src)
 {
     auto viewport = Engine::shared()->winSize();
@@ -15,6 +15,7 @@ public:
     void setPerspective(float fov, float aspect, float near, float far);
     void setOrtho(float left, float right, float bottom, float top, float near, float far);
     bool isOutOfFrustum(AABB aabb);
+    bool isInsideFrustum(AABB aabb);
     Matrix44 projection() const;
     void setProjection(const Matrix44 &projection);
     Matrix44 getViewMatrix();
@@ -25,6 +26,7 @@ public:
     bool getUseCustomFrustumUpdate() const;
     void setUseCustomFrustumUpdate(bool useCustomFrustumUpdate);
 	void reCache() override;
+	void onTransformChanged() override;
     vec3 unproject(vec3 src);
 	vec3 worldToScreen(vec3 worldPos);
 	void getPerspectInfo(float * fov, float * aspect, float * near, float * far);
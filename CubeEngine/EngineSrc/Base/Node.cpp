@@ -19,6 +19,9 @@ Node::Node()
 	  m_rotateQ(Quaternion(0.0f, 0.0f, 0.0f, 1.0f)),
 	  m_pos(vec3()),
 	  m_needToUpdate(true),
+	  m_isTransformCached(false),
+	  m_isReCached(false),
+	  m_isCustomTransform(false),
 	  m_localPiority(0),
 	  m_globalPiority(0),
 	  m_isAccpectOCTtree(true),
@@ -44,9 +47,9 @@ Node *Node::create()
 }
 
 
-Matrix44 Node::getTransform()
+const Matrix44 & Node::getTransform()
 {
-    if(m_needToUpdate)
+    if(!m_isTransformCached)
     {
         cacheTransform();
     }
@@ -55,8 +58,10 @@ Matrix44 Node::getTransform()
 
 Matrix44 Node::getLocalTransform()
 {
-	
-    return getTranslationMatrix() * getRotationMatrix() * getScalingMatrix();
+    Matrix44 mat;
+    m_rotateQ.normalize();
+    mat.setTRS(m_pos, m_rotateQ, m_scale);
+    return mat;
 }
 
 vec3 Node::getPos() const
@@ -100,7 +105,7 @@ void Node::setRotateE(const vec3 &rotate)
     //theRotate.x = TbaseMath::clampf(rotate.x,-60.f,60.f);
     //theRotate.y = TbaseMath::clampf(rotate.y,0.f,360.f);
     m_rotateQ.fromEulerAngle(m_rotateE);
-    m_needToUpdate = true;
+    setNeedToUpdate(true);
 }
 
 void Node::setRotateE(float x, float y, float z)
@@ -116,7 +121,7 @@ vec3 Node::getScale() const
 void Node::setScale(const vec3 &scale)
 {
     m_scale = scale;
-    m_needToUpdate = true;
+    setNeedToUpdate(true);
 }
 
 void Node::setScale(float x, float y, float z)
@@ -157,7 +162,8 @@ void Node::visit(std::vector<Node*>&directDrawList)
 		updateAction(this,Engine::shared()->deltaTime());
 	std::vector <Node *> removeList;
 
-	if(getNeedToUpdate())
+	//the subtree may already be refreshed by the reCache of an ancestor
+	if(!m_isReCached && getNeedToUpdate())
 	{
 		this->reCache();
 		//setNeedToUpdate(false); //ԭֱFalseǺʵõжϣ̫ˣע
@@ -314,6 +320,11 @@ bool Node::getNeedToUpdate() const
 void Node::setNeedToUpdate(bool needToUpdate)
 {
     m_needToUpdate = needToUpdate;
+    if(needToUpdate)
+    {
+        m_isTransformCached = false;
+        m_isReCached = false;
+    }
 	for(auto child :m_children)
 	{
 		child->setNeedToUpdate(needToUpdate);
@@ -403,27 +414,113 @@ void Node::setIsAccpectOcTtree(bool isAccpectOCTtree)
 
 void Node::cacheTransform()
 {
-    if(getNeedToUpdate())
+    if(!m_isTransformCached)
     {
-        Matrix44 parentTransform;
-        parentTransform.setToIdentity();
         if(m_parent)
         {
-            parentTransform = m_parent->getTransform();
+            m_worldTransformCache = m_parent->getTransform() * getLocalTransform();
+        }else
+        {
+            m_worldTransformCache = getLocalTransform();
         }
-        Matrix44 localTransform = getLocalTransform();
-        m_worldTransformCache = parentTransform * localTransform;
+        m_isTransformCached = true;
     }
 }
 
+namespace
+{
+	//the flattened subtree of a reCache pass as structure of arrays, a parent always comes before its children.
+	//shared by the nested reCache calls (OrbitCamera::getTransform), each call only touches the entries it appended,
+	//so they are always accessed by index
+	struct ReCacheBatch
+	{
+		std::vector<Node *> m_nodeList;
+		//index of the parent entry, -1 for the first entry of a pass
+		std::vector<int> m_parentList;
+		std::vector<char> m_isNeedToUpdateList;
+		std::vector<Matrix44> m_localList;
+		std::vector<Matrix44> m_worldList;
+		void resize(size_t size)
+		{
+			m_nodeList.resize(size);
+			m_parentList.resize(size);
+			m_isNeedToUpdateList.resize(size);
+			m_localList.resize(size);
+			m_worldList.resize(size);
+		}
+	};
+	ReCacheBatch g_reCacheBatch;
+}
+
 void Node::reCache()
 {
-    cacheTransform();
-	for (auto child : m_children)
+	auto & batch = g_reCacheBatch;
+	size_t begin = batch.m_nodeList.size();
+	batch.m_nodeList.push_back(this);
+	batch.m_parentList.push_back(-1);
+	batch.m_isNeedToUpdateList.push_back(getNeedToUpdate());
+	for(size_t i = begin; i < batch.m_nodeList.size(); i++)
+	{
+		bool isNeedToUpdate = batch.m_isNeedToUpdateList[i] != 0;
+		for(auto child : batch.m_nodeList[i]->m_children)
+		{
+			batch.m_nodeList.push_back(child);
+			batch.m_parentList.push_back(int(i));
+			batch.m_isNeedToUpdateList.push_back(isNeedToUpdate || child->m_needToUpdate);
+		}
+	}
+	size_t end = batch.m_nodeList.size();
+	batch.resize(end);
+	//the local TRS of the dirty nodes first, then world = parent * local in one linear pass over the arrays
+	for(size_t i = begin; i < end; i++)
+	{
+		Node * node = batch.m_nodeList[i];
+		if(batch.m_isNeedToUpdateList[i] && !node->m_isTransformCached)
+		{
+			batch.m_localList[i] = node->getLocalTransform();
+		}
+	}
+	for(size_t i = begin; i < end; i++)
+	{
+		Node * node = batch.m_nodeList[i];
+		int parent = batch.m_parentList[i];
+		if(!batch.m_isNeedToUpdateList[i] || node->m_isTransformCached)
+		{
+			batch.m_worldList[i] = node->getTransform();
+		}
+		else if(parent >= 0)
+		{
+			batch.m_worldList[i] = batch.m_worldList[parent] * batch.m_localList[i];
+		}
+		else if(node->m_parent)
+		{
+			batch.m_worldList[i] = node->m_parent->getTransform() * batch.m_localList[i];
+		}
+		else
+		{
+			batch.m_worldList[i] = batch.m_localList[i];
+		}
+		if(node->m_isCustomTransform)
+		{
+			node->m_worldTransformCache = batch.m_worldList[i];
+			node->m_isTransformCached = true;
+			batch.m_worldList[i] = node->getTransform();
+		}
+	}
+	for(size_t i = begin; i < end; i++)
 	{
-		child->reCache();
+		if(!batch.m_isNeedToUpdateList[i]) continue;
+		Node * node = batch.m_nodeList[i];
+		node->m_worldTransformCache = batch.m_worldList[i];
+		node->m_isTransformCached = true;
+		node->onTransformChanged();
+		node->m_isReCached = true;
 	}
+	batch.resize(begin);
+}
 
+void Node::onTransformChanged()
+{
 }
 
 bool Node::getIsValid() const
@@ -545,7 +642,7 @@ void Node::setRotateQ(const Quaternion &rotateQ)
     float x,y,z;
     m_rotateQ.toEulserAngel(&x,&y,&z);
     m_rotateE = vec3(x, y, z);
-    m_needToUpdate = true;
+    setNeedToUpdate(true);
 }
 
 void Node::setRotateQ(const vec4& rotateQInV4)
@@ -29,7 +29,7 @@ public:
 	virtual ~Node();
 	//
 	static Node * create();
-	virtual Matrix44 getTransform();
+	virtual const Matrix44 & getTransform();
 	virtual Matrix44 getLocalTransform();
 	vec3 getPos() const;
 	virtual void setPos(const vec3 &pos);
@@ -68,7 +68,10 @@ public:
 	void setIsAccpectOcTtree(bool isAccpectOCTtree);
 	void cacheTransform();
 	virtual void visit(std::vector<Node*>&directDrawList);
+	//refresh the world transform of the whole subtree, parent before child in one linear pass
 	virtual void reCache();
+	//called by reCache for every node whose transform is changed, after its world transform is refreshed
+	virtual void onTransformChanged();
 	bool getIsValid() const;
 	void setIsValid(bool isValid);
 	void detachChild(Node * node);
@@ -102,6 +105,11 @@ protected:
 	vec3 m_rotateE;
 	vec3 m_pos;
 	bool m_needToUpdate;
+	//world cache is up to date, reCache has already visited this node since it's marked as need to update
+	bool m_isTransformCached;
+	bool m_isReCached;
+	//getTransform is overridden (OrbitCamera), the reCache pass reads it instead of using parent * local
+	bool m_isCustomTransform;
 	Matrix44 m_worldTransformCache;
 	int m_localPiority;
 	unsigned int m_globalPiority;
@@ -16,6 +16,21 @@ void PhysicsCompoundShape::addChildShape(Matrix44* mat, btCollisionShape* shape)
 	getRawShape()->addChildShape(transform, shape);
 }
 
+void PhysicsCompoundShape::removeChildShape(int index)
+{
+	getRawShape()->removeChildShapeByIndex(index);
+}
+
+void PhysicsCompoundShape::recalculateLocalAABB()
+{
+	getRawShape()->recalculateLocalAabb();
+}
+
+int PhysicsCompoundShape::getChildCount()
+{
+	return getRawShape()->getNumChildShapes();
+}
+
 void PhysicsCompoundShape::getChildShapeTransform(int index, float * data)
 {
 	getRawShape()->getChildTransform(index).getOpenGLMatrix(data);
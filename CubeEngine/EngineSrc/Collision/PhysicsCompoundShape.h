@@ -15,6 +15,10 @@ class PhysicsCompoundShape: public PhysicsShape
 	public:
 		PhysicsCompoundShape();
 		void addChildShape(Matrix44* mat, btCollisionShape * shape);
+		//the last child takes the place of the removed one, the local AABB is not shrunk until recalculateLocalAABB
+		void removeChildShape(int index);
+		void recalculateLocalAABB();
+		int getChildCount();
 		void getChildShapeTransform(int index, float * data);
 		Matrix44 adjustPrincipalAxis(std::function<float (int index)> getMassFunc);
 		btCompoundShape * getRawShape() override;
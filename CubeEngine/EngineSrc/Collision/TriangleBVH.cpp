@@ -0,0 +1,430 @@
+#include "TriangleBVH.h"
+#include "Mesh/Mesh.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <assert.h>
+
+namespace tzw
+{
+	#define BVH_BIN_COUNT 12
+	#define BVH_LEAF_SIZE 4
+	#define BVH_MAX_LEAF_SIZE 16
+	#define BVH_STACK_SIZE 64
+	// a query never needs more stack entries than the tree depth plus one, so the depth is bounded below the stack size.
+	// past BVH_MEDIAN_DEPTH the triangles are split at the median, then the leaves are forced at BVH_MAX_DEPTH
+	#define BVH_MEDIAN_DEPTH 48
+	#define BVH_MAX_DEPTH (BVH_STACK_SIZE - 4)
+
+	TriangleBVH::TriangleBVH()
+	{
+
+	}
+
+	void TriangleBVH::build(Mesh* mesh)
+	{
+		clear();
+		size_t indexCount = mesh->getIndicesSize();
+		uint32_t triCount = uint32_t(indexCount / 3);
+		if (!triCount)
+			return;
+		// same winding as the old brute force loops of the chunk
+		std::vector<vec3> srcVertices(triCount * 3);
+		std::vector<BuildTriangle> tris(triCount);
+		for (uint32_t i = 0; i < triCount; i++)
+		{
+			vec3 * v = &srcVertices[i * 3];
+			v[0] = mesh->getVertexPos(mesh->getIndex(i * 3 + 2));
+			v[1] = mesh->getVertexPos(mesh->getIndex(i * 3 + 1));
+			v[2] = mesh->getVertexPos(mesh->getIndex(i * 3));
+			BuildTriangle & tri = tris[i];
+			tri.m_min[0] = std::min(std::min(v[0].x, v[1].x), v[2].x);
+			tri.m_min[1] = std::min(std::min(v[0].y, v[1].y), v[2].y);
+			tri.m_min[2] = std::min(std::min(v[0].z, v[1].z), v[2].z);
+			tri.m_max[0] = std::max(std::max(v[0].x, v[1].x), v[2].x);
+			tri.m_max[1] = std::max(std::max(v[0].y, v[1].y), v[2].y);
+			tri.m_max[2] = std::max(std::max(v[0].z, v[1].z), v[2].z);
+			for (int axis = 0; axis < 3; axis++)
+			{
+				tri.m_centre[axis] = (tri.m_min[axis] + tri.m_max[axis]) * 0.5f;
+			}
+			tri.m_index = i;
+		}
+		m_nodes.reserve(triCount * 2 / BVH_LEAF_SIZE + 1);
+		buildRecursive(tris, 0, triCount, 0);
+		m_vertices.resize(triCount * 3);
+		for (uint32_t i = 0; i < triCount; i++)
+		{
+			const vec3 * v = &srcVertices[tris[i].m_index * 3];
+			m_vertices[i * 3] = v[0];
+			m_vertices[i * 3 + 1] = v[1];
+			m_vertices[i * 3 + 2] = v[2];
+		}
+	}
+
+	uint32_t TriangleBVH::buildRecursive(std::vector<BuildTriangle>& tris, uint32_t begin, uint32_t end, int depth)
+	{
+		uint32_t nodeIndex = uint32_t(m_nodes.size());
+		m_nodes.push_back(Node());
+		float boxMin[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+		float boxMax[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+		float centreMin[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+		float centreMax[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+		for (uint32_t i = begin; i < end; i++)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				boxMin[axis] = std::min(boxMin[axis], tris[i].m_min[axis]);
+				boxMax[axis] = std::max(boxMax[axis], tris[i].m_max[axis]);
+				centreMin[axis] = std::min(centreMin[axis], tris[i].m_centre[axis]);
+				centreMax[axis] = std::max(centreMax[axis], tris[i].m_centre[axis]);
+			}
+		}
+		for (int axis = 0; axis < 3; axis++)
+		{
+			m_nodes[nodeIndex].m_min[axis] = boxMin[axis];
+			m_nodes[nodeIndex].m_max[axis] = boxMax[axis];
+		}
+		uint32_t count = end - begin;
+		auto makeLeaf = [&]()
+		{
+			m_nodes[nodeIndex].m_offset = begin;
+			m_nodes[nodeIndex].m_count = count;
+			return nodeIndex;
+		};
+		if (count <= BVH_LEAF_SIZE || depth >= BVH_MAX_DEPTH)
+			return makeLeaf();
+		if (depth >= BVH_MEDIAN_DEPTH)
+		{
+			int axis = 0;
+			for (int k = 1; k < 3; k++)
+			{
+				if (centreMax[k] - centreMin[k] > centreMax[axis] - centreMin[axis])
+					axis = k;
+			}
+			uint32_t mid = begin + count / 2;
+			std::nth_element(tris.begin() + begin, tris.begin() + mid, tris.begin() + end, [axis](const BuildTriangle & a, const BuildTriangle & b)
+			{
+				return a.m_centre[axis] < b.m_centre[axis];
+			});
+			buildRecursive(tris, begin, mid, depth + 1);
+			m_nodes[nodeIndex].m_offset = buildRecursive(tris, mid, end, depth + 1);
+			m_nodes[nodeIndex].m_count = 0;
+			return nodeIndex;
+		}
+
+		// binned SAH, every axis is tried
+		auto halfArea = [](const float * bmin, const float * bmax)
+		{
+			float dx = bmax[0] - bmin[0], dy = bmax[1] - bmin[1], dz = bmax[2] - bmin[2];
+			return dx * dy + dy * dz + dz * dx;
+		};
+		struct Bin
+		{
+			float m_min[3];
+			float m_max[3];
+			uint32_t m_count;
+		};
+		float bestCost = FLT_MAX;
+		int bestAxis = -1;
+		int bestSplit = 0;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float extent = centreMax[axis] - centreMin[axis];
+			if (extent <= 0.0f)
+				continue;
+			Bin bins[BVH_BIN_COUNT];
+			for (auto & bin : bins)
+			{
+				bin.m_min[0] = bin.m_min[1] = bin.m_min[2] = FLT_MAX;
+				bin.m_max[0] = bin.m_max[1] = bin.m_max[2] = -FLT_MAX;
+				bin.m_count = 0;
+			}
+			float scale = BVH_BIN_COUNT / extent;
+			for (uint32_t i = begin; i < end; i++)
+			{
+				int b = std::min(int((tris[i].m_centre[axis] - centreMin[axis]) * scale), BVH_BIN_COUNT - 1);
+				Bin & bin = bins[b];
+				bin.m_count++;
+				for (int k = 0; k < 3; k++)
+				{
+					bin.m_min[k] = std::min(bin.m_min[k], tris[i].m_min[k]);
+					bin.m_max[k] = std::max(bin.m_max[k], tris[i].m_max[k]);
+				}
+			}
+			// sweep from the right to get the cost of every right side, then from the left
+			float rightCost[BVH_BIN_COUNT];
+			float accMin[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+			float accMax[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+			uint32_t accCount = 0;
+			for (int b = BVH_BIN_COUNT - 1; b > 0; b--)
+			{
+				accCount += bins[b].m_count;
+				for (int k = 0; k < 3; k++)
+				{
+					accMin[k] = std::min(accMin[k], bins[b].m_min[k]);
+					accMax[k] = std::max(accMax[k], bins[b].m_max[k]);
+				}
+				rightCost[b] = accCount ? halfArea(accMin, accMax) * accCount : 0.0f;
+			}
+			accMin[0] = accMin[1] = accMin[2] = FLT_MAX;
+			accMax[0] = accMax[1] = accMax[2] = -FLT_MAX;
+			accCount = 0;
+			for (int b = 0; b < BVH_BIN_COUNT - 1; b++)
+			{
+				accCount += bins[b].m_count;
+				for (int k = 0; k < 3; k++)
+				{
+					accMin[k] = std::min(accMin[k], bins[b].m_min[k]);
+					accMax[k] = std::max(accMax[k], bins[b].m_max[k]);
+				}
+				if (!accCount || accCount == count)
+					continue;
+				float cost = halfArea(accMin, accMax) * accCount + rightCost[b + 1];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = b + 1;
+				}
+			}
+		}
+
+		uint32_t mid;
+		if (bestAxis < 0)
+		{
+			// all centres are at the same point
+			if (count <= BVH_MAX_LEAF_SIZE)
+				return makeLeaf();
+			mid = begin + count / 2;
+		}
+		else
+		{
+			float leafCost = halfArea(boxMin, boxMax) * count;
+			if (bestCost >= leafCost && count <= BVH_MAX_LEAF_SIZE)
+				return makeLeaf();
+			float scale = BVH_BIN_COUNT / (centreMax[bestAxis] - centreMin[bestAxis]);
+			float minC = centreMin[bestAxis];
+			auto iter = std::partition(tris.begin() + begin, tris.begin() + end, [bestAxis, bestSplit, scale, minC](const BuildTriangle & tri)
+			{
+				return std::min(int((tri.m_centre[bestAxis] - minC) * scale), BVH_BIN_COUNT - 1) < bestSplit;
+			});
+			mid = uint32_t(iter - tris.begin());
+			if (mid == begin || mid == end)
+			{
+				mid = begin + count / 2;
+			}
+		}
+		buildRecursive(tris, begin, mid, depth + 1);
+		uint32_t right = buildRecursive(tris, mid, end, depth + 1);
+		m_nodes[nodeIndex].m_offset = right;
+		m_nodes[nodeIndex].m_count = 0;
+		return nodeIndex;
+	}
+
+	void TriangleBVH::clear()
+	{
+		m_nodes.clear();
+		m_vertices.clear();
+	}
+
+	bool TriangleBVH::isEmpty() const
+	{
+		return m_nodes.empty();
+	}
+
+	size_t TriangleBVH::getTriangleCount() const
+	{
+		return m_vertices.size() / 3;
+	}
+
+	// slab test, return the entry distance or FLT_MAX if the box is missed or farther than maxT
+	static inline float rayBoxEntry(const float * bmin, const float * bmax, const float * origin, const float * invDir, float maxT)
+	{
+		float tNear = 0.0f;
+		float tFar = maxT;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float t0 = (bmin[axis] - origin[axis]) * invDir[axis];
+			float t1 = (bmax[axis] - origin[axis]) * invDir[axis];
+			if (t0 > t1)
+				std::swap(t0, t1);
+			tNear = t0 > tNear ? t0 : tNear;
+			tFar = t1 < tFar ? t1 : tFar;
+		}
+		return tNear <= tFar ? tNear : FLT_MAX;
+	}
+
+	template<bool isAny>
+	bool TriangleBVH::rayCast(const Ray& ray, float& t) const
+	{
+		if (m_nodes.empty())
+			return false;
+		vec3 o = ray.origin();
+		vec3 d = ray.direction();
+		float origin[3] = {o.x, o.y, o.z};
+		float dir[3] = {d.x, d.y, d.z};
+		float invDir[3];
+		for (int axis = 0; axis < 3; axis++)
+		{
+			// keep the sign so that the slab test still works on the zero components
+			float dv = dir[axis];
+			invDir[axis] = dv != 0.0f ? 1.0f / dv : (std::signbit(dv) ? -FLT_MAX : FLT_MAX);
+		}
+		float closest = FLT_MAX;
+		bool isHit = false;
+		uint32_t stack[BVH_STACK_SIZE];
+		int top = 0;
+		uint32_t nodeIndex = 0;
+		if (rayBoxEntry(m_nodes[0].m_min, m_nodes[0].m_max, origin, invDir, closest) == FLT_MAX)
+			return false;
+		for (;;)
+		{
+			const Node & node = m_nodes[nodeIndex];
+			if (node.m_count)
+			{
+				for (uint32_t i = node.m_offset; i < node.m_offset + node.m_count; i++)
+				{
+					float triT;
+					if (ray.intersectTriangle(m_vertices[i * 3], m_vertices[i * 3 + 1], m_vertices[i * 3 + 2], &triT) && triT < closest)
+					{
+						closest = triT;
+						isHit = true;
+						if (isAny)
+						{
+							t = closest;
+							return true;
+						}
+					}
+				}
+			}
+			else
+			{
+				// visit the nearer child first, the other one waits on the stack
+				uint32_t left = nodeIndex + 1;
+				uint32_t right = node.m_offset;
+				float tLeft = rayBoxEntry(m_nodes[left].m_min, m_nodes[left].m_max, origin, invDir, closest);
+				float tRight = rayBoxEntry(m_nodes[right].m_min, m_nodes[right].m_max, origin, invDir, closest);
+				if (tLeft > tRight)
+				{
+					std::swap(tLeft, tRight);
+					std::swap(left, right);
+				}
+				if (tLeft != FLT_MAX)
+				{
+					if (tRight != FLT_MAX)
+					{
+						assert(top < BVH_STACK_SIZE);
+						stack[top++] = right;
+					}
+					nodeIndex = left;
+					continue;
+				}
+			}
+			// pop, the nodes which start behind the closest hit are skipped
+			bool isFound = false;
+			while (top > 0)
+			{
+				uint32_t candidate = stack[--top];
+				if (rayBoxEntry(m_nodes[candidate].m_min, m_nodes[candidate].m_max, origin, invDir, closest) != FLT_MAX)
+				{
+					nodeIndex = candidate;
+					isFound = true;
+					break;
+				}
+			}
+			if (!isFound)
+				break;
+		}
+		if (isHit)
+		{
+			t = closest;
+		}
+		return isHit;
+	}
+
+	bool TriangleBVH::rayCastFirst(const Ray& ray, float& t) const
+	{
+		return rayCast<false>(ray, t);
+	}
+
+	bool TriangleBVH::rayCastAny(const Ray& ray, float& t) const
+	{
+		return rayCast<true>(ray, t);
+	}
+
+	void TriangleBVH::sphereQuery(const t_Sphere& sphere, std::vector<vec3>& hitPoints) const
+	{
+		if (m_nodes.empty())
+			return;
+		vec3 c = sphere.centre();
+		float centre[3] = {c.x, c.y, c.z};
+		float radius2 = sphere.radius() * sphere.radius();
+		uint32_t stack[BVH_STACK_SIZE];
+		int top = 0;
+		stack[top++] = 0;
+		while (top > 0)
+		{
+			const Node & node = m_nodes[stack[--top]];
+			float dist2 = 0.0f;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float v = std::max(std::max(node.m_min[axis] - centre[axis], centre[axis] - node.m_max[axis]), 0.0f);
+				dist2 += v * v;
+			}
+			if (dist2 > radius2)
+				continue;
+			if (node.m_count)
+			{
+				for (uint32_t i = node.m_offset; i < node.m_offset + node.m_count; i++)
+				{
+					vec3 hitPoint;
+					if (sphere.intersectWithTriangle(m_vertices[i * 3], m_vertices[i * 3 + 1], m_vertices[i * 3 + 2], hitPoint))
+					{
+						hitPoints.push_back(hitPoint);
+					}
+				}
+			}
+			else
+			{
+				assert(top + 2 <= BVH_STACK_SIZE);
+				stack[top++] = node.m_offset;
+				stack[top++] = uint32_t(&node - m_nodes.data()) + 1;
+			}
+		}
+	}
+
+	bool TriangleBVH::isAnyVertexInside(const AABB& box) const
+	{
+		if (m_nodes.empty())
+			return false;
+		vec3 bmin = box.min();
+		vec3 bmax = box.max();
+		uint32_t stack[BVH_STACK_SIZE];
+		int top = 0;
+		stack[top++] = 0;
+		while (top > 0)
+		{
+			const Node & node = m_nodes[stack[--top]];
+			if (node.m_min[0] > bmax.x || node.m_max[0] < bmin.x
+				|| node.m_min[1] > bmax.y || node.m_max[1] < bmin.y
+				|| node.m_min[2] > bmax.z || node.m_max[2] < bmin.z)
+				continue;
+			if (node.m_count)
+			{
+				for (uint32_t i = node.m_offset * 3; i < (node.m_offset + node.m_count) * 3; i++)
+				{
+					if (box.isInside(m_vertices[i]))
+						return true;
+				}
+			}
+			else
+			{
+				assert(top + 2 <= BVH_STACK_SIZE);
+				stack[top++] = node.m_offset;
+				stack[top++] = uint32_t(&node - m_nodes.data()) + 1;
+			}
+		}
+		return false;
+	}
+}
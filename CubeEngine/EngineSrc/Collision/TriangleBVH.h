@@ -0,0 +1,53 @@
+#pragma once
+#include "Math/vec3.h"
+#include "Math/AABB.h"
+#include "Math/Ray.h"
+#include "Math/t_Sphere.h"
+#include <vector>
+#include <cstdint>
+
+namespace tzw
+{
+	class Mesh;
+	// Static triangle BVH for the picking queries of a mesh, binned SAH build into a flattened node array.
+	// Triangles are copied in world space, so the tree stays valid while the mesh itself is rebuilt.
+	class TriangleBVH
+	{
+	public:
+		TriangleBVH();
+		//safe to call from a worker thread, the mesh is only read
+		void build(Mesh * mesh);
+		void clear();
+		bool isEmpty() const;
+		size_t getTriangleCount() const;
+		//closest hit, t is in the unit of the ray direction
+		bool rayCastFirst(const Ray & ray, float & t) const;
+		bool rayCastAny(const Ray & ray, float & t) const;
+		//same rule as t_Sphere::intersectWithTriangle
+		void sphereQuery(const t_Sphere & sphere, std::vector<vec3> & hitPoints) const;
+		//true if any triangle vertex is inside the box
+		bool isAnyVertexInside(const AABB & box) const;
+	private:
+		struct Node
+		{
+			float m_min[3];
+			float m_max[3];
+			//first triangle for leaf, right child for interior node, the left child always follows its parent
+			uint32_t m_offset;
+			//zero for interior node
+			uint32_t m_count;
+		};
+		struct BuildTriangle
+		{
+			float m_min[3];
+			float m_max[3];
+			float m_centre[3];
+			uint32_t m_index;
+		};
+		uint32_t buildRecursive(std::vector<BuildTriangle> & tris, uint32_t begin, uint32_t end, int depth);
+		template<bool isAny> bool rayCast(const Ray & ray, float & t) const;
+		std::vector<Node> m_nodes;
+		//three vertices per triangle, in leaf order
+		std::vector<vec3> m_vertices;
+	};
+}
@@ -29,6 +29,8 @@
 #include "DebugSystem.h"
 #include "BackEnd/VkRenderBackEnd.h"
 #include "Rendering/GraphicsRenderer.h"
+#include "Rendering/HeadlessRenderer.h"
+#include "FrameProfiler.h"
 
 namespace tzw {
 
@@ -89,6 +91,11 @@ void Engine::setUnlimitedCursor(bool enable)
 	m_winBackEnd->setUnlimitedCursor(enable);
 }
 
+void Engine::requestClose()
+{
+	m_winBackEnd->requestClose();
+}
+
 std::string Engine::getWorkingDirectory()
 {
 	int length = 32;
@@ -134,6 +141,10 @@ void Engine::loadConfig()
 	RenderBackEnd::shared()->setIsCheckGL(doc["IsGraphicsDebugCheck"].GetBool());
 
 	m_isFullScreen = doc["IsFullScreen"].GetBool();
+	if(doc.HasMember("WorkerThreadCount"))
+	{
+		WorkerThreadSystem::shared()->setWorkerCount(doc["WorkerThreadCount"].GetInt());
+	}
 
 	TranslationMgr::shared()->load(doc["Language"].GetString()); 
 }
@@ -228,6 +239,28 @@ void Engine::resetVerticesIndicesCount()
     m_indicesCount = 0;
 }
 
+void Engine::increaseBindCount(int issued, int skipped)
+{
+    m_bindIssuedCount += issued;
+    m_bindSkippedCount += skipped;
+}
+
+void Engine::resetBindCount()
+{
+    m_bindIssuedCount = 0;
+    m_bindSkippedCount = 0;
+}
+
+int Engine::getBindIssuedCount() const
+{
+    return m_bindIssuedCount;
+}
+
+int Engine::getBindSkippedCount() const
+{
+    return m_bindSkippedCount;
+}
+
 std::string Engine::getFilePath(std::string path)
 {
     return "./Res/" + path;
@@ -264,22 +297,31 @@ void Engine::update(float delta)
 {
     m_deltaTime = delta;
     int logicBefore = clock();
+	auto profiler = FrameProfiler::shared();
+	profiler->beginStage(FrameStage::Logic);
 	DebugSystem::shared()->handleDraw(delta);
 	PhysicsMgr::shared()->stepSimulation(delta);
 	TimerMgr::shared()->handle(delta);
 	WorkerThreadSystem::shared()->mainThreadUpdate();
 	EventMgr::shared()->apply(delta);
     shared()->delegate()->onUpdate(delta);
+	profiler->endStage(FrameStage::Logic);
+	profiler->beginStage(FrameStage::Visit);
     SceneMgr::shared()->doVisit();
+	profiler->endStage(FrameStage::Visit);
 	resetDrawCallCount();
     m_logicUpdateTime = CLOCKS_TO_MS(clock() - logicBefore);
     int applyRenderBefore = clock();
 	resetVerticesIndicesCount();
+	resetBindCount();
 	if(m_type == RenderDeviceType::OpenGl_Device)
 	{
 		DebugSystem::shared()->doRender(delta);
 		Renderer::shared()->renderAll();
 	
+	}else if(m_type == RenderDeviceType::Null_Device)
+	{
+		HeadlessRenderer::shared()->render();
 	}else
 	{
 		GraphicsRenderer::shared()->render();
@@ -287,13 +329,17 @@ void Engine::update(float delta)
 	}
 	AudioSystem::shared()->update();
     m_applyRenderTime = CLOCKS_TO_MS(clock() - applyRenderBefore);
+	profiler->endFrame();
 }
 
 void Engine::onStart()
 {
 	initLogSystem();
 	tlog("Cube-Engine By tzw%s", EngineDef::versionStr);
-	RenderBackEnd::shared()->printFullDeviceInfo();
+	if(m_type != RenderDeviceType::Null_Device)
+	{
+		RenderBackEnd::shared()->printFullDeviceInfo();
+	}
     Engine::shared()->initSingletons();
     Engine::shared()->delegate()->onStart();
 	ScriptPyMgr::shared()->doScriptInit();
@@ -368,7 +414,7 @@ int Engine::run(int argc, char *argv[], AppEntry * delegate)
 	Tfile::shared()->addSearchPath("./");
 	Tfile::shared()->addSearchZip("Asset.pkg");
 	shared()->loadConfig();
-	shared()->m_winBackEnd = WindowBackEndMgr::shared()->getWindowBackEnd(TZW_WINDOW_GLFW);
+	shared()->m_winBackEnd = WindowBackEndMgr::shared()->getWindowBackEnd(EngineDef::isHeadless ? TZW_WINDOW_HEADLESS : TZW_WINDOW_GLFW);
 	shared()->m_winBackEnd->prepare(shared()->windowWidth(), shared()->windowHeight(), shared()->m_isFullScreen);
 	shared()->m_winBackEnd->run();
     return 0;
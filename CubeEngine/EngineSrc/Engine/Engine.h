@@ -30,6 +30,11 @@ public:
     void resetDrawCallCount();
     void increaseVerticesIndicesCount(int v,int i);
     void resetVerticesIndicesCount();
+    //pipeline, descriptor and buffer binds recorded and skipped by the render stages
+    void increaseBindCount(int issued, int skipped);
+    void resetBindCount();
+    int getBindIssuedCount() const;
+    int getBindSkippedCount() const;
     std::string getFilePath(std::string path);
     int getApplyRenderTime() const;
     int getLogicUpdateTime() const;
@@ -39,6 +44,8 @@ public:
     void setIsEnableOutLine(bool isEnableOutLine);
 	void setClearColor(float r, float g, float b);
 	void setUnlimitedCursor(bool enable);
+	//leave the main loop after the current frame
+	void requestClose();
 	std::string getWorkingDirectory();
 	int getMouseButton(int mouseButton);
 	void loadConfig();
@@ -57,6 +64,8 @@ private:
     int m_drawCallCount{};
     int m_verticesCount{};
     int m_indicesCount{};
+    int m_bindIssuedCount{};
+    int m_bindSkippedCount{};
     int m_logicUpdateTime{};
     int m_applyRenderTime{};
     Engine();
@@ -8,4 +8,7 @@ const char * EngineDef::versionStr = "Tiny Builder";
 int EngineDef::focusPiority = 997;
 
 bool EngineDef::isUseVulkan = true;
+bool EngineDef::isHeadless = false;
+float EngineDef::headlessDeltaTime = 1.0f / 60.0f;
+int EngineDef::headlessExitCode = 0;
 } // namespace tzw
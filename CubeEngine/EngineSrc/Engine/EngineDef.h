@@ -18,6 +18,8 @@ typedef unsigned short short_u;
 enum class RenderDeviceType{
     Vulkan_Device,
     OpenGl_Device,
+    //records the device calls only, used by the headless benchmark
+    Null_Device,
 };
 class EngineDef
 {
@@ -32,6 +34,11 @@ public:
     static const char * versionStr;
     static int focusPiority;
     static bool isUseVulkan;
+    static bool isHeadless;
+    //fixed frame delta of the headless window backend
+    static float headlessDeltaTime;
+    //exit code of the headless run, set by the app entry before it requests the close
+    static int headlessExitCode;
 };
 } // namespace tzw
 
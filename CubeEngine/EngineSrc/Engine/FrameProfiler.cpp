@@ -0,0 +1,151 @@
+#include "FrameProfiler.h"
+#include <algorithm>
+#include <cstdio>
+namespace tzw
+{
+static const char * g_stageName[] = {"logic", "visit", "culling", "sort", "submit", "gui"};
+static const char * g_counterName[] = {"drawCall", "index", "bindIssued", "bindSkipped", "uploadBytes"};
+
+FrameProfiler::FrameProfiler():
+m_isEnable(false),
+m_isFrameValid(false)
+{
+	clear();
+}
+
+void FrameProfiler::setIsEnable(bool isEnable)
+{
+	if(isEnable == m_isEnable) return;
+	m_isEnable = isEnable;
+	m_isFrameValid = false;
+}
+
+bool FrameProfiler::isEnable() const
+{
+	return m_isEnable;
+}
+
+void FrameProfiler::beginStage(FrameStage stage)
+{
+	if(!m_isEnable) return;
+	int i = static_cast<int>(stage);
+	m_stageBegin[i] = std::chrono::high_resolution_clock::now();
+	m_isStageOpen[i] = true;
+}
+
+void FrameProfiler::endStage(FrameStage stage)
+{
+	int i = static_cast<int>(stage);
+	if(!m_isEnable || !m_isStageOpen[i]) return;
+	auto now = std::chrono::high_resolution_clock::now();
+	//a stage may run several times in one frame
+	m_currFrame.m_stageTime[i] += std::chrono::duration<double, std::milli>(now - m_stageBegin[i]).count();
+	m_isStageOpen[i] = false;
+}
+
+void FrameProfiler::setCounter(FrameCounter counter, double value)
+{
+	if(!m_isEnable) return;
+	m_currFrame.m_counter[static_cast<int>(counter)] = value;
+}
+
+void FrameProfiler::endFrame()
+{
+	if(m_isEnable && m_isFrameValid)
+	{
+		m_frameList.push_back(m_currFrame);
+	}
+	resetCurrFrame();
+	m_isFrameValid = m_isEnable;
+}
+
+void FrameProfiler::clear()
+{
+	m_frameList.clear();
+	resetCurrFrame();
+	m_isFrameValid = false;
+}
+
+void FrameProfiler::resetCurrFrame()
+{
+	std::fill(std::begin(m_currFrame.m_stageTime), std::end(m_currFrame.m_stageTime), 0.0);
+	std::fill(std::begin(m_currFrame.m_counter), std::end(m_currFrame.m_counter), 0.0);
+	std::fill(std::begin(m_isStageOpen), std::end(m_isStageOpen), false);
+}
+
+size_t FrameProfiler::getFrameCount() const
+{
+	return m_frameList.size();
+}
+
+std::string FrameProfiler::getReport()
+{
+	std::string report;
+	char buff[256];
+	size_t frameCount = m_frameList.size();
+	snprintf(buff, sizeof(buff), "frames: %zu\n", frameCount);
+	report += buff;
+	if(!frameCount) return report;
+	std::vector<double> timeList(frameCount);
+	double frameTotal = 0.0;
+	for(int stage = 0; stage < static_cast<int>(FrameStage::Count); stage++)
+	{
+		double sum = 0.0;
+		for(size_t i = 0; i < frameCount; i++)
+		{
+			timeList[i] = m_frameList[i].m_stageTime[stage];
+			sum += timeList[i];
+		}
+		std::sort(timeList.begin(), timeList.end());
+		double avg = sum / frameCount;
+		frameTotal += avg;
+		snprintf(buff, sizeof(buff), "%-10s avg %8.3f ms  min %8.3f ms  max %8.3f ms  p95 %8.3f ms\n", g_stageName[stage],
+			avg, timeList.front(), timeList.back(), timeList[(frameCount - 1) * 95 / 100]);
+		report += buff;
+	}
+	snprintf(buff, sizeof(buff), "%-10s avg %8.3f ms\n", "total", frameTotal);
+	report += buff;
+	for(int counter = 0; counter < static_cast<int>(FrameCounter::Count); counter++)
+	{
+		double sum = 0.0;
+		for(auto & frame : m_frameList)
+		{
+			sum += frame.m_counter[counter];
+		}
+		snprintf(buff, sizeof(buff), "%-10s avg %.1f\n", g_counterName[counter], sum / frameCount);
+		report += buff;
+	}
+	return report;
+}
+
+bool FrameProfiler::saveCSV(std::string filePath)
+{
+	FILE * file = fopen(filePath.c_str(), "w");
+	if(!file) return false;
+	fprintf(file, "frame");
+	for(auto name : g_stageName)
+	{
+		fprintf(file, ",%s", name);
+	}
+	for(auto name : g_counterName)
+	{
+		fprintf(file, ",%s", name);
+	}
+	fprintf(file, "\n");
+	for(size_t i = 0; i < m_frameList.size(); i++)
+	{
+		fprintf(file, "%zu", i);
+		for(double t : m_frameList[i].m_stageTime)
+		{
+			fprintf(file, ",%.4f", t);
+		}
+		for(double c : m_frameList[i].m_counter)
+		{
+			fprintf(file, ",%.0f", c);
+		}
+		fprintf(file, "\n");
+	}
+	fclose(file);
+	return true;
+}
+}
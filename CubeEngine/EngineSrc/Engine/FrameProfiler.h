@@ -0,0 +1,60 @@
+#pragma once
+#include "Engine/EngineDef.h"
+#include <chrono>
+#include <string>
+#include <vector>
+namespace tzw
+{
+enum class FrameStage
+{
+	Logic,
+	Visit,
+	Culling,
+	Sort,
+	Submit,
+	GUI,
+	Count
+};
+enum class FrameCounter
+{
+	DrawCall,
+	Index,
+	BindIssued,
+	BindSkipped,
+	UploadBytes,
+	Count
+};
+// Per frame CPU time of each stage, recorded only while enabled.
+// Recording starts with the frame after setIsEnable(true), so a frame is never half measured.
+class FrameProfiler : public Singleton<FrameProfiler>
+{
+public:
+	FrameProfiler();
+	void setIsEnable(bool isEnable);
+	bool isEnable() const;
+	void beginStage(FrameStage stage);
+	void endStage(FrameStage stage);
+	void setCounter(FrameCounter counter, double value);
+	//called once at the end of Engine::update
+	void endFrame();
+	void clear();
+	size_t getFrameCount() const;
+	//average, min, max and 95th percentile of every stage in ms, average of every counter
+	std::string getReport();
+	//one line per frame
+	bool saveCSV(std::string filePath);
+private:
+	struct FrameRecord
+	{
+		double m_stageTime[static_cast<int>(FrameStage::Count)];
+		double m_counter[static_cast<int>(FrameCounter::Count)];
+	};
+	void resetCurrFrame();
+	bool m_isEnable;
+	bool m_isFrameValid;
+	std::chrono::high_resolution_clock::time_point m_stageBegin[static_cast<int>(FrameStage::Count)];
+	bool m_isStageOpen[static_cast<int>(FrameStage::Count)];
+	FrameRecord m_currFrame;
+	std::vector<FrameRecord> m_frameList;
+};
+}
@@ -1,43 +1,67 @@
 #include "WorkerThreadSystem.h"
 #include <thread>
 #include <mutex>
+#include <chrono>
+#include <algorithm>
 #include "CubeGame/LoadingUI.h"
+#include "Utility/log/Log.h"
 
 namespace tzw
 {
-	WorkerJob::WorkerJob(VoidJob work, VoidJob finish):m_work(work),m_onFinished(finish)
+	static bool jobPriorityCompare(const WorkerJob & left, const WorkerJob & right)
 	{
-		
+		return left.m_priority > right.m_priority;
 	}
 
-	WorkerJob::WorkerJob(VoidJob work):m_work(work),m_onFinished(nullptr)
+	WorkerJob::WorkerJob(VoidJob work, VoidJob finish):m_work(work),m_onFinished(finish),m_priority(0.0f),m_owner(nullptr)
 	{
 
 	}
 
-	WorkerJob::WorkerJob():m_onFinished(nullptr),m_work(nullptr)
+	WorkerJob::WorkerJob(VoidJob work):m_work(work),m_onFinished(nullptr),m_priority(0.0f),m_owner(nullptr)
 	{
-	
+
+	}
+
+	WorkerJob::WorkerJob(VoidJob work, VoidJob finish, float priority, const void* owner):m_work(work),m_onFinished(finish),m_priority(priority),m_owner(owner)
+	{
+
+	}
+
+	WorkerJob::WorkerJob():m_onFinished(nullptr),m_work(nullptr),m_priority(0.0f),m_owner(nullptr)
+	{
+
 	}
 
 
 	WorkerThreadSystem::WorkerThreadSystem()
 	{
-		m_thread = nullptr;
-		m_readyToDeathCount = 0;
+		m_pendingCount = 0;
+		m_runningCount = 0;
+		m_nextQueue = 0;
+		m_workerCount = 0;
+		m_mainThreadBudget = 4.0f;
+		m_isInit = false;
 	}
 
 
 
 	void WorkerThreadSystem::pushOrder(WorkerJob order)
 	{
-		m_rwMutex.lock();
-		m_JobRecieverList.push_back(order);
-		m_rwMutex.unlock();
-		if(!m_thread)
+		if(!m_isInit)
 		{
 			init();
 		}
+		auto queue = m_queueList[m_nextQueue++ % m_queueList.size()];
+		queue->m_mutex.lock();
+		queue->m_jobs.push_back(order);
+		std::push_heap(queue->m_jobs.begin(), queue->m_jobs.end(), jobPriorityCompare);
+		queue->m_mutex.unlock();
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_pendingCount++;
+		}
+		m_sleepCondition.notify_one();
 	}
 
 	void WorkerThreadSystem::pushMainThreadOrder(WorkerJob order)
@@ -52,61 +76,199 @@ namespace tzw
 		pushMainThreadOrder(order);
 	}
 
+	bool WorkerThreadSystem::cancelOrder(const void* owner)
+	{
+		if(!owner) return false;
+		int removeCount = 0;
+		for(auto queue : m_queueList)
+		{
+			queue->m_mutex.lock();
+			auto & jobs = queue->m_jobs;
+			auto iter = std::remove_if(jobs.begin(), jobs.end(), [owner](const WorkerJob & job){return job.m_owner == owner;});
+			if(iter != jobs.end())
+			{
+				removeCount += int(jobs.end() - iter);
+				jobs.erase(iter, jobs.end());
+				std::make_heap(jobs.begin(), jobs.end(), jobPriorityCompare);
+			}
+			queue->m_mutex.unlock();
+		}
+		m_pendingCount -= removeCount;
+
+		//the finished callback of the job which already done is useless too.
+		auto isOwnBy = [owner](const WorkerJob & job){return job.m_owner == owner;};
+		m_rwMutex.lock();
+		size_t callbackCount = m_mainThreadCB1.size();
+		m_mainThreadCB1.remove_if(isOwnBy);
+		callbackCount -= m_mainThreadCB1.size();
+		m_rwMutex.unlock();
+		callbackCount += m_mainThreadCB2.size();
+		m_mainThreadCB2.remove_if(isOwnBy);
+		callbackCount -= m_mainThreadCB2.size();
+		//a dropped callback cancels the job as well, its work has no effect then
+		return removeCount > 0 || callbackCount > 0;
+	}
+
+	void WorkerThreadSystem::waitOrder(const void* owner)
+	{
+		if(!owner) return;
+		cancelOrder(owner);
+		//a job popped before the cancel has marked its worker under the queue lock already
+		for(auto queue : m_queueList)
+		{
+			while(queue->m_runningOwner.load() == owner)
+			{
+				std::this_thread::yield();
+			}
+		}
+		//the callback of the job which just finished
+		cancelOrder(owner);
+	}
+
+	bool WorkerThreadSystem::isIdle()
+	{
+		//running is raised before pending drops, so a job moving between them is never missed
+		if(m_runningCount > 0 || m_pendingCount > 0) return false;
+		if(!m_mainThreadCB2.empty() || !m_mainThreadFunctionList.empty()) return false;
+		std::lock_guard<std::mutex> lock(m_rwMutex);
+		return m_mainThreadCB1.empty();
+	}
+
+	void WorkerThreadSystem::parallelFor(int count, std::function<void(int)> func)
+	{
+		if(count <= 0) return;
+		if(!m_isInit)
+		{
+			init();
+		}
+		struct ParallelContext
+		{
+			std::function<void (int)> m_func;
+			int m_count;
+			std::atomic<int> m_next;
+			std::atomic<int> m_done;
+		};
+		// a helper job may start after we have returned, it finds no item left then and never touches func.
+		auto context = std::make_shared<ParallelContext>();
+		context->m_func = std::move(func);
+		context->m_count = count;
+		context->m_next = 0;
+		context->m_done = 0;
+		auto runItems = [](ParallelContext * ctx)
+		{
+			for(;;)
+			{
+				int index = ctx->m_next++;
+				if(index >= ctx->m_count) break;
+				ctx->m_func(index);
+				ctx->m_done++;
+			}
+		};
+		int helperCount = std::min(count - 1, m_workerCount);
+		for(int i = 0; i < helperCount; i++)
+		{
+			pushOrder(WorkerJob([context, runItems]() {runItems(context.get());}, nullptr, -1.0f, nullptr));
+		}
+		runItems(context.get());
+		while(context->m_done < count)
+		{
+			std::this_thread::yield();
+		}
+	}
+
 	void WorkerThreadSystem::init()
 	{
-		m_thread = new std::thread([&]() {workderUpdate();});
-		m_thread->detach();
+		if(m_isInit) return;
+		m_isInit = true;
+		int count = m_workerCount;
+		if(count <= 0)
+		{
+			count = std::max(int(std::thread::hardware_concurrency()) - 1, 1);
+		}
+		for(int i = 0; i < count; i++)
+		{
+			m_queueList.push_back(new WorkerQueue());
+		}
+		for(int i = 0; i < count; i++)
+		{
+			auto thread = new std::thread([this, i]() {workderUpdate(i);});
+			thread->detach();
+			m_threadList.push_back(thread);
+		}
+		m_workerCount = count;
+		tlog("worker thread system start with %d workers", count);
+	}
+
+	bool WorkerThreadSystem::popOrder(int queueIndex, int workerIndex, WorkerJob& job)
+	{
+		auto queue = m_queueList[queueIndex];
+		std::lock_guard<std::mutex> lock(queue->m_mutex);
+		if(queue->m_jobs.empty())
+		{
+			return false;
+		}
+		std::pop_heap(queue->m_jobs.begin(), queue->m_jobs.end(), jobPriorityCompare);
+		job = std::move(queue->m_jobs.back());
+		queue->m_jobs.pop_back();
+		m_queueList[workerIndex]->m_runningOwner = job.m_owner;
+		m_runningCount++;
+		m_pendingCount--;
+		return true;
 	}
 
-	void WorkerThreadSystem::workderUpdate()
+	void WorkerThreadSystem::workderUpdate(int workerIndex)
 	{
-		bool isReciverEmpty = false;
+		int queueCount = int(m_queueList.size());
 		for(;;)
 		{
-			m_rwMutex.lock();
-			isReciverEmpty = m_JobRecieverList.empty();
-			if(!isReciverEmpty)
+			WorkerJob job;
+			bool isFound = popOrder(workerIndex, workerIndex, job);
+			//steal from the others
+			for(int i = 1; i < queueCount && !isFound; i++)
 			{
-				std::swap(m_JobRecieverList, m_jobProcessList);
+				isFound = popOrder((workerIndex + i) % queueCount, workerIndex, job);
 			}
-			m_rwMutex.unlock();
-			if(isReciverEmpty)
+			if(!isFound)
 			{
-				std::this_thread::sleep_for(std::chrono::milliseconds(500));
+				std::unique_lock<std::mutex> lock(m_sleepMutex);
+				m_sleepCondition.wait(lock, [this]{return m_pendingCount > 0;});
+				continue;
 			}
-			while(!m_jobProcessList.empty())
+			if(job.m_work)
 			{
-				auto job = m_jobProcessList.front();
-				m_jobProcessList.pop_front();
-				if(job.m_work)
+				job.m_work();
+				if(job.m_onFinished)
 				{
-					job.m_work();
-					if(job.m_onFinished)
-					{
-						m_rwMutex.lock();
-						m_mainThreadCB1.push_back(job);
-						m_rwMutex.unlock();
-					}
+					m_rwMutex.lock();
+					m_mainThreadCB1.push_back(job);
+					m_rwMutex.unlock();
 				}
 			}
+			m_queueList[workerIndex]->m_runningOwner = nullptr;
+			m_runningCount--;
 		}
 	}
 
 	void WorkerThreadSystem::mainThreadUpdate()
 	{
 		m_rwMutex.lock();
-		std::swap(m_mainThreadCB1, m_mainThreadCB2);
+		m_mainThreadCB2.splice(m_mainThreadCB2.end(), m_mainThreadCB1);
 		m_rwMutex.unlock();
-		if(!m_mainThreadCB2.empty())
+		// the rest callbacks will be handled in the next frame once the budget is exhausted, at least one per frame.
+		auto beginTime = std::chrono::steady_clock::now();
+		while(!m_mainThreadCB2.empty())
 		{
-			for(auto cb : m_mainThreadCB2)
+			auto cb = m_mainThreadCB2.front();
+			m_mainThreadCB2.pop_front();
+			if(cb.m_onFinished)
 			{
-				if(cb.m_onFinished)
-				{
-					cb.m_onFinished();
-				}
+				cb.m_onFinished();
+			}
+			std::chrono::duration<float, std::milli> cost = std::chrono::steady_clock::now() - beginTime;
+			if(cost.count() >= m_mainThreadBudget)
+			{
+				break;
 			}
-			m_mainThreadCB2.clear();
 		}
 		if(!m_mainThreadFunctionList.empty())
 		{
@@ -115,4 +277,29 @@ namespace tzw
 			job.m_work();
 		}
 	}
+
+	void WorkerThreadSystem::setWorkerCount(int count)
+	{
+		if(m_isInit)
+		{
+			tlogError("worker thread system is already running with %d workers", m_workerCount);
+			return;
+		}
+		m_workerCount = count;
+	}
+
+	int WorkerThreadSystem::getWorkerCount() const
+	{
+		return m_workerCount;
+	}
+
+	void WorkerThreadSystem::setMainThreadBudget(float ms)
+	{
+		m_mainThreadBudget = ms;
+	}
+
+	float WorkerThreadSystem::getMainThreadBudget() const
+	{
+		return m_mainThreadBudget;
+	}
 }
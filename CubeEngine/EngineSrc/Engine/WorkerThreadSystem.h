@@ -6,6 +6,8 @@
 #include <list>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 namespace tzw{
 	typedef std::function<void ()> VoidJob;
 	class WorkerJob
@@ -13,9 +15,14 @@ namespace tzw{
 	public:
 		WorkerJob(VoidJob work, VoidJob finish);
 		WorkerJob(VoidJob work);
+		WorkerJob(VoidJob work, VoidJob finish, float priority, const void * owner);
 		WorkerJob();
 		VoidJob m_work;
 		VoidJob m_onFinished;
+		//smaller value runs first, chunk use the distance to the player
+		float m_priority;
+		//the jobs which share the same owner can be canceled together, see WorkerThreadSystem::cancelOrder
+		const void * m_owner;
 	};
 	//typedef std::function<void ()> WorkerJob;
 	class WorkerThreadSystem: public Singleton<WorkerThreadSystem>
@@ -25,18 +32,47 @@ namespace tzw{
 		void pushOrder(WorkerJob order);
 		void pushMainThreadOrder(WorkerJob order);
 		void pushMainThreadOrderWithLoading(std::string tipsInfo, WorkerJob order);
+		//true if a queued job or the pending callback of a finished one was dropped
+		bool cancelOrder(const void * owner);
+		//cancel the jobs of owner and block until the one running on a worker is done, main thread only.
+		//nothing of owner runs or gets called back afterward, so it can be deleted.
+		void waitOrder(const void * owner);
+		//nothing queued, running or waiting for its main thread callback
+		bool isIdle();
+		//run func(0) ... func(count - 1) on the workers and the calling thread, return when all of them are done.
+		//the calling thread takes the items which are not picked up yet, so busy workers never stall it.
+		void parallelFor(int count, std::function<void (int)> func);
 		void init();
-		void workderUpdate();
+		void workderUpdate(int workerIndex);
 		void mainThreadUpdate();
+		//0 means hardware_concurrency - 1, must be called before the first order has been pushed
+		void setWorkerCount(int count);
+		int getWorkerCount() const;
+		void setMainThreadBudget(float ms);
+		float getMainThreadBudget() const;
 	private:
-		std::list<WorkerJob> m_JobRecieverList;
-		std::list<WorkerJob> m_jobProcessList;
+		struct WorkerQueue
+		{
+			std::vector<WorkerJob> m_jobs;//min heap by m_priority
+			std::mutex m_mutex;
+			//owner of the job the worker with the same index is running
+			std::atomic<const void *> m_runningOwner{nullptr};
+		};
+		bool popOrder(int queueIndex, int workerIndex, WorkerJob & job);
+		std::vector<WorkerQueue *> m_queueList;
+		std::vector<std::thread *> m_threadList;
+		std::mutex m_sleepMutex;
+		std::condition_variable m_sleepCondition;
+		std::atomic<int> m_pendingCount;
+		std::atomic<int> m_runningCount;
+		std::atomic<unsigned int> m_nextQueue;
 		std::list<WorkerJob> m_mainThreadFunctionList;
 		std::list<WorkerJob> m_mainThreadCB1;
 		std::list<WorkerJob> m_mainThreadCB2;
-		std::thread * m_thread;
 		std::mutex m_rwMutex;
-		int m_readyToDeathCount;
+		int m_workerCount;
+		float m_mainThreadBudget;
+		bool m_isInit;
 	};
 }
 
@@ -176,6 +176,7 @@ void EventMgr::apply(float delta)
        }
        m_eventDeque.pop_front();
    }
+   ScriptPyMgr::shared()->flushInputEvents();
     for(size_t i =0;i<m_list.size();i++)
     {
         EventListener * event = m_list[i];
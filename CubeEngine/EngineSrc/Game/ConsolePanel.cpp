@@ -8,6 +8,7 @@
 #include <iostream>
 #include "../ScriptPy/ScriptPyMgr.h"
 #include "2D/GUISystem.h"
+#include "Utility/log/Log.h"
 
 namespace tzw {
 	ConsolePanel::ConsolePanel()
@@ -76,6 +77,12 @@ namespace tzw {
 
 	void ConsolePanel::Draw(const char* title, bool* p_open)
 	{
+		std::vector<std::string> lineList;
+		fetchConsoleLog(lineList);
+		for(auto & line : lineList)
+		{
+			AddLog("%s", line.c_str());
+		}
 		ImGui::SetNextWindowSize(ImVec2(520, 600), ImGuiCond_FirstUseEver);
 		if (!ImGui::Begin(title, p_open))
 		{
@@ -180,6 +187,8 @@ namespace tzw {
 		if (command_line[0] == '!')
 		{
 			ScriptPyMgr::shared()->callFunPyVoid("tzw", "tzw_on_gm_command", command_line + 1);
+			//gm commands may reload the script modules
+			ScriptPyMgr::shared()->invalidateFunctions();
 		}
 		else
 		{
@@ -41,6 +41,8 @@ DebugInfoPanel::DebugInfoPanel()
 	logicUpdateTime = 0;
 	renderUpdateTime = 0;
 	verticesCount = 0;
+	bindIssuedCount = 0;
+	bindSkippedCount = 0;
 	sceneCurrNodes = 0;
 	//GUISystem::shared()->addObject(this);
 
@@ -56,6 +58,7 @@ void DebugInfoPanel::drawIMGUI(bool * isOpen)
 	ImGui::Text("logicUpdate: %d ms", logicUpdateTime);
 	ImGui::Text("applyRender: %d ms", renderUpdateTime);
 	ImGui::Text("indices: %d", verticesCount);
+	ImGui::Text("binds: %d (skipped %d)", bindIssuedCount, bindSkippedCount);
 	ImGui::Text("GL Ver: %s", RenderBackEnd::shared()->getCurrVersion().c_str());
 	ImGui::Text("GLSL Ver: %s", RenderBackEnd::shared()->getShaderSupportVersion().c_str());
 	static int values_offset = 0;
@@ -81,6 +84,8 @@ void DebugInfoPanel::updateInfo()
 		logicUpdateTime = Engine::shared()->getLogicUpdateTime();
 		renderUpdateTime = Engine::shared()->getApplyRenderTime();
 		verticesCount = Engine::shared()->getIndicesCount();
+		bindIssuedCount = Engine::shared()->getBindIssuedCount();
+		bindSkippedCount = Engine::shared()->getBindSkippedCount();
 		for (int i = 0; i < IM_ARRAYSIZE(values) - 1; i++)
 		{
 			values[i] = values[i + 1];
@@ -15,6 +15,8 @@ private:
 	int logicUpdateTime;
 	int renderUpdateTime;
 	int verticesCount;
+	int bindIssuedCount;
+	int bindSkippedCount;
 	int sceneCurrNodes;
 };
 
@@ -21,6 +21,7 @@ OrbitCamera::OrbitCamera()
     offsetToCentre = 0.6;
     m_distToFront = 0.2;
 	m_dist = m_defaultDist;
+	m_isCustomTransform = true;
     m_enableFPSFeature = true;
     collisionPackage = new ColliderEllipsoid();
     collisionPackage->eRadius = vec3(m_distToside, distToGround, m_distToFront);
@@ -479,8 +480,9 @@ static Matrix44 targetTo(vec3 eye, vec3 target, vec3 up)
 	out[15] = 1;
 	return mat;
 }
-Matrix44 OrbitCamera::getTransform()
+const Matrix44 & OrbitCamera::getTransform()
 {
+	//the orbit is computed on every call, the world cache just holds the result
 	if(m_focusNode) 
 	{
 		m_focusNode->reCache();
@@ -490,15 +492,12 @@ Matrix44 OrbitCamera::getTransform()
 		dir.z = m_dist * -1.0f * sinf(m_longitude) * sinf(m_latitude);
 		dir.y = m_dist * cosf(m_latitude);
 		auto camPos = centrePos + dir;
-		auto resultMat = targetTo(camPos, centrePos, vec3(0, 1, 0));
-		
-		return resultMat;
+		m_worldTransformCache = targetTo(camPos, centrePos, vec3(0, 1, 0));
 	}else
 	{
-		Matrix44 mat;
-		mat.setToIdentity();
-		return mat;
+		m_worldTransformCache.setToIdentity();
 	}
+	return m_worldTransformCache;
 }
 
 void OrbitCamera::resetDirection()
@@ -48,7 +48,7 @@ public:
     void setIsMoving(bool isMoving);
 
 	void setFocusNode(Node * focusNode);
-	virtual Matrix44 getTransform();
+	const Matrix44 & getTransform() override;
 	void resetDirection();
 	void zoom(float dist);
 	float getDefaultDist() const;
@@ -30,11 +30,6 @@ Node::NodeType Drawable::getNodeType()
     return NodeType::Drawable;
 }
 
-void Drawable::reCache()
-{
-    Node::reCache();
-}
-
 Material *Drawable::getMaterial() const
 {
     return m_material;
@@ -47,9 +42,6 @@ void Drawable::setMaterial(Material *technique)
 
 void Drawable::setUpTransFormation(TransformationInfo &info)
 {
-	auto currCam = g_GetCurrScene()->defaultCamera();
-    info.m_projectMatrix = currCam->projection();
-    info.m_viewMatrix = currCam->getViewMatrix();
     info.m_worldMatrix = getTransform();
 }
 
@@ -14,7 +14,6 @@ public:
     Camera *camera() const;
     void setCamera(Camera *camera);
     virtual Node::NodeType getNodeType();
-    virtual void reCache();
 	virtual Material *getMaterial() const;
 	virtual void setMaterial(Material *technique);
     virtual void setUpTransFormation(TransformationInfo & info);
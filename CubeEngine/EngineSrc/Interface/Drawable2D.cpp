@@ -22,7 +22,7 @@ void Drawable2D::setContentSize(const vec2 &contentSize)
 {
     m_contentSize = contentSize;
     m_anchorPointInPoints = vec2(m_contentSize.x * m_anchorPoint.x,m_contentSize.y * m_anchorPoint.y);
-    m_needToUpdate = true;
+    setNeedToUpdate(true);
 }
 
 vec2 Drawable2D::anchorPoint() const
@@ -33,16 +33,13 @@ vec2 Drawable2D::anchorPoint() const
 
 void Drawable2D::setUpTransFormation(TransformationInfo &info)
 {
-	auto currCam = g_GetCurrScene()->defaultGUICamera();
-    info.m_projectMatrix = currCam->projection();
-    info.m_viewMatrix = currCam->getViewMatrix();
     info.m_worldMatrix = getTransform();
 }
 void Drawable2D::setAnchorPoint(const vec2 &anchorPoint)
 {
     m_anchorPoint = anchorPoint;
     m_anchorPointInPoints = vec2(m_contentSize.x * m_anchorPoint.x,m_contentSize.y * m_anchorPoint.y);
-    m_needToUpdate = true;
+    setNeedToUpdate(true);
 }
 
 Matrix44 Drawable2D::getLocalTransform()
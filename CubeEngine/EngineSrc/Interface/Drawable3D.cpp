@@ -9,6 +9,7 @@ Drawable3D::Drawable3D()
 {
 	setLocalPiority(-999);
 	m_octNodeIndex = -1;
+	m_octSlot = -1;
 	m_drawableFlag = static_cast<uint32_t>(DrawableFlag::Drawable);
 }
 
@@ -61,9 +62,8 @@ bool Drawable3D::intersectBySphere(const t_Sphere &sphere, std::vector<vec3> &hi
     return false;
 }
 
-void Drawable3D::reCache()
+void Drawable3D::onTransformChanged()
 {
-    Drawable::reCache();
     reCacheAABB();
 }
 
@@ -102,6 +102,16 @@ int Drawable3D::getOctNodeIndex()
 	return m_octNodeIndex;
 }
 
+void Drawable3D::setOctSlot(int slot)
+{
+	m_octSlot = slot;
+}
+
+int Drawable3D::getOctSlot()
+{
+	return m_octSlot;
+}
+
 Mesh* Drawable3D::getMesh(int index)
 {
 	return nullptr;
@@ -136,6 +146,10 @@ void Drawable3D::getCommandForInstanced(std::vector<InstanceRendereData> & comma
     return;
 }
 
+void Drawable3D::onRemovedFromOctree()
+{
+}
+
 Drawable3DGroup::Drawable3DGroup(Drawable3D **obj, int count)
 {
 	init(obj, count);
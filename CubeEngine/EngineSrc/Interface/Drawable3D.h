@@ -28,13 +28,15 @@ public:
     virtual bool intersectByAABB(const AABB & other, vec3 &overLap);
     virtual Drawable3D * intersectByRay(const Ray & ray,vec3 &hitPoint);
     virtual bool intersectBySphere(const t_Sphere & sphere, std::vector<vec3> &hitPoint);
-    virtual void reCache();
+    void onTransformChanged() override;
     void reCacheAABB();
 	bool getIsHitable() const;
 	void setIsHitable(bool val);
 	virtual void setUpCommand(RenderCommand & command);
 	int setOctNodeIndex(int index);
 	int getOctNodeIndex();
+	void setOctSlot(int slot);
+	int getOctSlot();
 	virtual Mesh * getMesh(int index);
 	virtual Mesh * getMesh();
 	virtual int getMeshCount();
@@ -42,11 +44,15 @@ public:
 	uint32_t getDrawableFlag() const;
 	void setDrawableFlag(const uint32_t drawableFlag);
 	virtual void getCommandForInstanced(std::vector<InstanceRendereData> & commandList);
+	//called when OctreeScene::removeObj takes it out of the scene, not when it only moves between the octree nodes
+	virtual void onRemovedFromOctree();
 protected:
     AABB m_localAABB;
     AABB m_worldAABBCache;
 	bool m_isHitable;
 	int m_octNodeIndex;
+	//index in the draw list of the octree node, lets the octree remove it in O(1)
+	int m_octSlot;
 	uint32_t m_drawableFlag;
 };
 
@@ -1,6 +1,7 @@
 #include "AABB.h"
 #include "math.h"
 #include <algorithm>
+#include "MathSimd.h"
 
 namespace tzw {
 
@@ -73,9 +74,39 @@ void AABB::update(vec3 vec)
         m_max.setZ (vec.z );
 }
 
-void AABB::transForm(Matrix44 mat)
+void AABB::transForm(const Matrix44 & mat)
 {
+#if TZW_USE_SSE
+    //each corner is a sum of one term per axis, so the extreme corners come from the per axis min/max terms (Arvo)
+    const float * m = mat.data();
+    __m128 c0 = _mm_loadu_ps(m);
+    __m128 c1 = _mm_loadu_ps(m + 4);
+    __m128 c2 = _mm_loadu_ps(m + 8);
+    __m128 c3 = _mm_loadu_ps(m + 12);
+    __m128 a = _mm_mul_ps(c0, _mm_set1_ps(m_min.x));
+    __m128 b = _mm_mul_ps(c0, _mm_set1_ps(m_max.x));
+    __m128 lo = _mm_min_ps(a, b);
+    __m128 hi = _mm_max_ps(a, b);
+    a = _mm_mul_ps(c1, _mm_set1_ps(m_min.y));
+    b = _mm_mul_ps(c1, _mm_set1_ps(m_max.y));
+    lo = _mm_add_ps(lo, _mm_min_ps(a, b));
+    hi = _mm_add_ps(hi, _mm_max_ps(a, b));
+    a = _mm_mul_ps(c2, _mm_set1_ps(m_min.z));
+    b = _mm_mul_ps(c2, _mm_set1_ps(m_max.z));
+    lo = _mm_add_ps(_mm_add_ps(lo, _mm_min_ps(a, b)), c3);
+    hi = _mm_add_ps(_mm_add_ps(hi, _mm_max_ps(a, b)), c3);
+    float outMin[4], outMax[4];
+    _mm_storeu_ps(outMin, lo);
+    _mm_storeu_ps(outMax, hi);
+    m_min = vec3(outMin[0], outMin[1], outMin[2]);
+    m_max = vec3(outMax[0], outMax[1], outMax[2]);
+#else
+    transFormScalar(mat);
+#endif
+}
 
+void AABB::transFormScalar(const Matrix44 & mat)
+{
     vec3 corners[8];
      // Near face, specified counter-clockwise
     // Left-top-front.
@@ -111,17 +142,17 @@ void AABB::reset()
     m_max = vec3(-999999,-999999,-999999);
 }
 
-void AABB::merge(AABB box)
+void AABB::merge(const AABB & box)
 {
         // Calculate the new minimum point.
-        m_min.setX (std::min(m_min.x, box.min ().x));
-        m_min.setY (std::min(m_min.y, box.min ().y));
-        m_min.setZ (std::min(m_min.z, box.min ().z));
+        m_min.x = std::min(m_min.x, box.m_min.x);
+        m_min.y = std::min(m_min.y, box.m_min.y);
+        m_min.z = std::min(m_min.z, box.m_min.z);
 
         // Calculate the new maximum point.
-        m_max.setX (std::max(m_max.x, box.max().x));
-        m_max.setY(std::max(m_max.y, box.max().y));
-        m_max.setZ(std::max(m_max.z, box.max().z));
+        m_max.x = std::max(m_max.x, box.m_max.x);
+        m_max.y = std::max(m_max.y, box.m_max.y);
+        m_max.z = std::max(m_max.z, box.m_max.z);
 }
 
 vec3 AABB::min() const
@@ -13,9 +13,11 @@ public:
     ~AABB();
     void update(vec3 *vec, int num);
     void update(vec3 vec);
-    void transForm(Matrix44 mat);
+    void transForm(const Matrix44 & mat);
+    //the eight corner scalar path, always compiled so the SIMD result can be checked against it
+    void transFormScalar(const Matrix44 & mat);
     void reset();
-    void merge(AABB box);
+    void merge(const AABB & box);
     vec3 min() const;
     void setMin(const vec3 &min);
 
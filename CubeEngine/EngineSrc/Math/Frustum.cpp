@@ -2,6 +2,7 @@
 #include "frustum.h"
 #include "../Math/Matrix44.h"
 #include "../Base/Camera.h"
+#include "MathSimd.h"
 namespace tzw {
 
 bool Frustum::initFrustumFromCamera(Camera* camera)
@@ -18,7 +19,55 @@ bool Frustum::initFrustumFromProjectMatrix(Matrix44 matrix)
     return true;
 }
 
+#if TZW_USE_SSE
+// distance of the p-vertex (isOut) or the n-vertex (!isOut) of the box to 4 planes, same order as Plane::dist2Plane
+template<bool isOut>
+static inline __m128 boxDist4(__m128 nx, __m128 ny, __m128 nz, __m128 dist, const vec3 & boxMin, const vec3 & boxMax)
+{
+    __m128 zero = _mm_setzero_ps();
+    __m128 lo, hi, mask;
+    mask = _mm_cmplt_ps(nx, zero);
+    lo = _mm_set1_ps(isOut ? boxMin.x : boxMax.x);
+    hi = _mm_set1_ps(isOut ? boxMax.x : boxMin.x);
+    __m128 px = _mm_or_ps(_mm_and_ps(mask, hi), _mm_andnot_ps(mask, lo));
+    mask = _mm_cmplt_ps(ny, zero);
+    lo = _mm_set1_ps(isOut ? boxMin.y : boxMax.y);
+    hi = _mm_set1_ps(isOut ? boxMax.y : boxMin.y);
+    __m128 py = _mm_or_ps(_mm_and_ps(mask, hi), _mm_andnot_ps(mask, lo));
+    mask = _mm_cmplt_ps(nz, zero);
+    lo = _mm_set1_ps(isOut ? boxMin.z : boxMax.z);
+    hi = _mm_set1_ps(isOut ? boxMax.z : boxMin.z);
+    __m128 pz = _mm_or_ps(_mm_and_ps(mask, hi), _mm_andnot_ps(mask, lo));
+    __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, px), _mm_mul_ps(ny, py)), _mm_mul_ps(nz, pz));
+    return _mm_sub_ps(d, dist);
+}
+
+// bit i is set if the box is in front of plane i
+template<bool isOut>
+static inline int boxFrontMask(const float * planeX, const float * planeY, const float * planeZ, const float * planeDist, const AABB & aabb)
+{
+    vec3 boxMin = aabb.min();
+    vec3 boxMax = aabb.max();
+    __m128 zero = _mm_setzero_ps();
+    __m128 d0 = boxDist4<isOut>(_mm_loadu_ps(planeX), _mm_loadu_ps(planeY), _mm_loadu_ps(planeZ), _mm_loadu_ps(planeDist), boxMin, boxMax);
+    __m128 d1 = boxDist4<isOut>(_mm_loadu_ps(planeX + 4), _mm_loadu_ps(planeY + 4), _mm_loadu_ps(planeZ + 4), _mm_loadu_ps(planeDist + 4), boxMin, boxMax);
+    return _mm_movemask_ps(_mm_cmpgt_ps(d0, zero)) | (_mm_movemask_ps(_mm_cmpgt_ps(d1, zero)) << 4);
+}
+#endif
+
 bool Frustum::isOutOfFrustum(const AABB& aabb) const
+{
+#if TZW_USE_SSE
+    if (!_initialized)
+        return false;
+    int planeMask = _clipZ ? 0x3f : 0x0f;
+    return (boxFrontMask<true>(_planeX, _planeY, _planeZ, _planeDist, aabb) & planeMask) != 0;
+#else
+    return isOutOfFrustumScalar(aabb);
+#endif
+}
+
+bool Frustum::isOutOfFrustumScalar(const AABB& aabb) const
 {
     if (_initialized)
     {
@@ -39,6 +88,56 @@ bool Frustum::isOutOfFrustum(const AABB& aabb) const
     return false;
 }
 
+void Frustum::isOutOfFrustum(const AABB* aabbList, size_t count, bool* resultList) const
+{
+    if (!_initialized)
+    {
+        for (size_t i = 0; i < count; i++)
+            resultList[i] = false;
+        return;
+    }
+#if TZW_USE_SSE
+    int planeMask = _clipZ ? 0x3f : 0x0f;
+    for (size_t i = 0; i < count; i++)
+        resultList[i] = (boxFrontMask<true>(_planeX, _planeY, _planeZ, _planeDist, aabbList[i]) & planeMask) != 0;
+#else
+    for (size_t i = 0; i < count; i++)
+        resultList[i] = isOutOfFrustum(aabbList[i]);
+#endif
+}
+
+bool Frustum::isInsideFrustum(const AABB& aabb) const
+{
+    if (!_initialized)
+        return true;
+#if TZW_USE_SSE
+    int planeMask = _clipZ ? 0x3f : 0x0f;
+    return (boxFrontMask<false>(_planeX, _planeY, _planeZ, _planeDist, aabb) & planeMask) == 0;
+#else
+    return isInsideFrustumScalar(aabb);
+#endif
+}
+
+bool Frustum::isInsideFrustumScalar(const AABB& aabb) const
+{
+    if (!_initialized)
+        return true;
+    vec3 point;
+    int plane = _clipZ ? 6 : 4;
+    for (int i = 0; i < plane; i++)
+    {
+        // the corner farthest along the normal must be behind every plane
+        const vec3& normal = _plane[i].getNormal();
+        point.setX (normal.x < 0 ? aabb.min().x: aabb.max ().x);
+        point.setY( normal.y < 0 ? aabb.min().y: aabb.max ().y);
+        point.setZ (normal.z < 0 ? aabb.min().z: aabb.max ().z);
+
+        if (_plane[i].getSide(point) == PointSide::FRONT_PLANE )
+            return false;
+    }
+    return true;
+}
+
 void Frustum::createPlane( Camera* camera)
 {
      Matrix44 mat = camera->getViewProjectionMatrix();
@@ -51,6 +150,7 @@ void Frustum::createPlane( Camera* camera)
     _plane[3].initPlane(-vec3(m[3] - m[1], m[7] - m[5], m[11] - m[9]), (m[15] - m[13]));//top
     _plane[4].initPlane(-vec3(m[3] + m[2], m[7] + m[6], m[11] + m[10]), (m[15] + m[14]));//near
     _plane[5].initPlane(-vec3(m[3] - m[2], m[7] - m[6], m[11] - m[10]), (m[15] - m[14]));//far
+    updatePlaneSoA();
 }
 
 void Frustum::createPlane(Matrix44 matrix)
@@ -62,6 +162,29 @@ void Frustum::createPlane(Matrix44 matrix)
    _plane[3].initPlane(-vec3(m[3] - m[1], m[7] - m[5], m[11] - m[9]), (m[15] - m[13]));//top
    _plane[4].initPlane(-vec3(m[3] + m[2], m[7] + m[6], m[11] + m[10]), (m[15] + m[14]));//near
    _plane[5].initPlane(-vec3(m[3] - m[2], m[7] - m[6], m[11] - m[10]), (m[15] - m[14]));//far
+   updatePlaneSoA();
+}
+
+void Frustum::updatePlaneSoA()
+{
+    for (int i = 0; i < 8; i++)
+    {
+        if (i < 6)
+        {
+            const vec3& normal = _plane[i].getNormal();
+            _planeX[i] = normal.x;
+            _planeY[i] = normal.y;
+            _planeZ[i] = normal.z;
+            _planeDist[i] = _plane[i].getDist();
+        }
+        else
+        {
+            _planeX[i] = 0.0f;
+            _planeY[i] = 0.0f;
+            _planeZ[i] = 0.0f;
+            _planeDist[i] = 1.0f;
+        }
+    }
 }
 
 } // namespace tzw
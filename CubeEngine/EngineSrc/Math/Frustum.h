@@ -29,6 +29,22 @@ public:
      */
     bool isOutOfFrustum(const AABB& aabb) const;
 
+    /**
+     * is aabb completely inside frustum.
+     */
+    bool isInsideFrustum(const AABB& aabb) const;
+
+    /**
+     * batch variant of isOutOfFrustum, resultList[i] is the result of aabbList[i].
+     */
+    void isOutOfFrustum(const AABB* aabbList, size_t count, bool* resultList) const;
+
+    /**
+     * the scalar paths, always compiled so the SIMD results can be checked against them.
+     */
+    bool isOutOfFrustumScalar(const AABB& aabb) const;
+    bool isInsideFrustumScalar(const AABB& aabb) const;
+
     /**
      * get & set z clip. if bclipZ == true use near and far plane
      */
@@ -46,7 +62,17 @@ protected:
      */
     void createPlane(Matrix44 matrix);
 
+    /**
+     * copy the planes to the SoA layout used by the SIMD tests
+     */
+    void updatePlaneSoA();
+
     Plane _plane[6];             // clip plane, left, right, top, bottom, near, far
+    // _plane as structure of arrays, padded to 8 with planes nothing is in front of
+    float _planeX[8];
+    float _planeY[8];
+    float _planeZ[8];
+    float _planeDist[8];
     bool _clipZ;                // use near and far clip plane
     bool _initialized;
 };
@@ -0,0 +1,20 @@
+#ifndef TZW_MATHSIMD_H
+#define TZW_MATHSIMD_H
+
+// SSE2 is the baseline of every x86-64 target, other architectures use the scalar path.
+// define TZW_NO_SIMD to force the scalar path.
+#if !defined(TZW_NO_SIMD) && (defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__))
+#define TZW_USE_SSE 1
+#include <emmintrin.h>
+#else
+#define TZW_USE_SSE 0
+#endif
+
+#if TZW_USE_SSE
+#define TZW_SHUFFLE_MASK(x, y, z, w) ((x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+#define TZW_SWIZZLE(v, x, y, z, w) _mm_castsi128_ps(_mm_shuffle_epi32(_mm_castps_si128(v), TZW_SHUFFLE_MASK(x, y, z, w)))
+#define TZW_SPLAT(v, i) TZW_SWIZZLE(v, i, i, i, i)
+#define TZW_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, TZW_SHUFFLE_MASK(x, y, z, w))
+#endif
+
+#endif // TZW_MATHSIMD_H
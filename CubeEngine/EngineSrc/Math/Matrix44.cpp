@@ -5,6 +5,7 @@
 #define MATH_TOLERANCE              2e-37f
 #define MATH_EPSILON                0.000001f
 #include "Engine/EngineDef.h"
+#include "MathSimd.h"
 namespace tzw {
 
 Matrix44::Matrix44()
@@ -72,7 +73,79 @@ void Matrix44::setRotation(const Quaternion &q)
     m_data[15] = 1.0f;
 }
 
+void Matrix44::setTRS(const vec3 &offset, const Quaternion &q, const vec3 &scaleFactor)
+{
+    float x2 = q.x + q.x;
+    float y2 = q.y + q.y;
+    float z2 = q.z + q.z;
+
+    float xx2 = q.x * x2;
+    float yy2 = q.y * y2;
+    float zz2 = q.z * z2;
+    float xy2 = q.x * y2;
+    float xz2 = q.x * z2;
+    float yz2 = q.y * z2;
+    float wx2 = q.w * x2;
+    float wy2 = q.w * y2;
+    float wz2 = q.w * z2;
+
+    m_data[0] = (1.0f - yy2 - zz2) * scaleFactor.x;
+    m_data[1] = (xy2 + wz2) * scaleFactor.x;
+    m_data[2] = (xz2 - wy2) * scaleFactor.x;
+    m_data[3] = 0.0f;
+
+    m_data[4] = (xy2 - wz2) * scaleFactor.y;
+    m_data[5] = (1.0f - xx2 - zz2) * scaleFactor.y;
+    m_data[6] = (yz2 + wx2) * scaleFactor.y;
+    m_data[7] = 0.0f;
+
+    m_data[8] = (xz2 + wy2) * scaleFactor.z;
+    m_data[9] = (yz2 - wx2) * scaleFactor.z;
+    m_data[10] = (1.0f - xx2 - yy2) * scaleFactor.z;
+    m_data[11] = 0.0f;
+
+    m_data[12] = offset.x;
+    m_data[13] = offset.y;
+    m_data[14] = offset.z;
+    m_data[15] = 1.0f;
+}
+
+#if TZW_USE_SSE
+//column j of the result is lhs * (column j of rhs), same summation order as the scalar path
+static inline void multiplySSE(__m128 a0, __m128 a1, __m128 a2, __m128 a3, const float * rhs, float * dest)
+{
+    for(int j = 0; j < 4; j++)
+    {
+        __m128 b = _mm_loadu_ps(rhs + j * 4);
+        __m128 r = _mm_mul_ps(a0, TZW_SPLAT(b, 0));
+        r = _mm_add_ps(r, _mm_mul_ps(a1, TZW_SPLAT(b, 1)));
+        r = _mm_add_ps(r, _mm_mul_ps(a2, TZW_SPLAT(b, 2)));
+        r = _mm_add_ps(r, _mm_mul_ps(a3, TZW_SPLAT(b, 3)));
+        _mm_storeu_ps(dest + j * 4, r);
+    }
+}
+
+static inline __m128 transformSSE(__m128 c0, __m128 c1, __m128 c2, __m128 c3, __m128 v)
+{
+    __m128 r = _mm_mul_ps(c0, TZW_SPLAT(v, 0));
+    r = _mm_add_ps(r, _mm_mul_ps(c1, TZW_SPLAT(v, 1)));
+    r = _mm_add_ps(r, _mm_mul_ps(c2, TZW_SPLAT(v, 2)));
+    return _mm_add_ps(r, _mm_mul_ps(c3, TZW_SPLAT(v, 3)));
+}
+#endif
+
 Matrix44 Matrix44::operator *(const Matrix44 &other) const
+{
+    Matrix44 dest;
+#if TZW_USE_SSE
+    multiplySSE(_mm_loadu_ps(m_data), _mm_loadu_ps(m_data + 4), _mm_loadu_ps(m_data + 8), _mm_loadu_ps(m_data + 12), other.m_data, dest.m_data);
+    return dest;
+#else
+    return multiplyScalar(other);
+#endif
+}
+
+Matrix44 Matrix44::multiplyScalar(const Matrix44 &other) const
 {
     Matrix44 dest;
     auto mat2 = other.m_data;
@@ -106,8 +179,31 @@ Matrix44 Matrix44::operator *(const Matrix44 &other) const
     return dest;
 }
 
+void Matrix44::multiplyList(const Matrix44 &lhs, const Matrix44 *rhsList, Matrix44 *dstList, size_t count)
+{
+#if TZW_USE_SSE
+    __m128 a0 = _mm_loadu_ps(lhs.m_data);
+    __m128 a1 = _mm_loadu_ps(lhs.m_data + 4);
+    __m128 a2 = _mm_loadu_ps(lhs.m_data + 8);
+    __m128 a3 = _mm_loadu_ps(lhs.m_data + 12);
+    for(size_t i = 0; i < count; i++)
+    {
+        //rhs is fully read before dest is written, so dst may alias rhs
+        float result[16];
+        multiplySSE(a0, a1, a2, a3, rhsList[i].m_data, result);
+        memcpy(dstList[i].m_data, result, sizeof(result));
+    }
+#else
+    for(size_t i = 0; i < count; i++)
+    {
+        dstList[i] = lhs * rhsList[i];
+    }
+#endif
+}
+
 vec4 Matrix44::operator *(const vec4 &other) const
 {
+    //a single vector gains nothing from SSE once the loads and stores are paid, see transformVec3List
     vec4 result;
     float x = other.x, y = other.y, z = other.z,w = other.w;
     auto mat = m_data;
@@ -222,7 +318,83 @@ void Matrix44::perspective(float fovy, float aspect, float near, float far)
     }
 }
 
-Matrix44 Matrix44::inverted(bool *invertible)
+#if TZW_USE_SSE
+//2x2 blocks are stored as (m00, m01, m10, m11), A * B
+static inline __m128 mat2Mul(__m128 a, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, TZW_SWIZZLE(b, 0, 3, 0, 3)), _mm_mul_ps(TZW_SWIZZLE(a, 1, 0, 3, 2), TZW_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+//adj(A) * B
+static inline __m128 mat2AdjMul(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(TZW_SWIZZLE(a, 3, 3, 0, 0), b), _mm_mul_ps(TZW_SWIZZLE(a, 1, 1, 2, 2), TZW_SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+//A * adj(B)
+static inline __m128 mat2MulAdj(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, TZW_SWIZZLE(b, 3, 0, 3, 0)), _mm_mul_ps(TZW_SWIZZLE(a, 1, 0, 3, 2), TZW_SWIZZLE(b, 2, 1, 2, 1)));
+}
+#endif
+
+Matrix44 Matrix44::inverted(bool *invertible) const
+{
+#if TZW_USE_SSE
+    //block inverse on the 2x2 sub matrices, inverse(transpose(M)) == transpose(inverse(M)) so the storage order doesn't matter
+    Matrix44 result;
+    __m128 r0 = _mm_loadu_ps(m_data);
+    __m128 r1 = _mm_loadu_ps(m_data + 4);
+    __m128 r2 = _mm_loadu_ps(m_data + 8);
+    __m128 r3 = _mm_loadu_ps(m_data + 12);
+    __m128 A = _mm_movelh_ps(r0, r1);
+    __m128 B = _mm_movehl_ps(r1, r0);
+    __m128 C = _mm_movelh_ps(r2, r3);
+    __m128 D = _mm_movehl_ps(r3, r2);
+
+    //(|A|, |B|, |C|, |D|)
+    __m128 detSub = _mm_sub_ps(_mm_mul_ps(TZW_SHUFFLE(r0, r2, 0, 2, 0, 2), TZW_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+                               _mm_mul_ps(TZW_SHUFFLE(r0, r2, 1, 3, 1, 3), TZW_SHUFFLE(r1, r3, 0, 2, 0, 2)));
+    __m128 detA = TZW_SPLAT(detSub, 0);
+    __m128 detB = TZW_SPLAT(detSub, 1);
+    __m128 detC = TZW_SPLAT(detSub, 2);
+    __m128 detD = TZW_SPLAT(detSub, 3);
+
+    __m128 D_C = mat2AdjMul(D, C);
+    __m128 A_B = mat2AdjMul(A, B);
+    __m128 X_ = _mm_sub_ps(_mm_mul_ps(detD, A), mat2Mul(B, D_C));
+    __m128 W_ = _mm_sub_ps(_mm_mul_ps(detA, D), mat2Mul(C, A_B));
+    __m128 Y_ = _mm_sub_ps(_mm_mul_ps(detB, C), mat2MulAdj(D, A_B));
+    __m128 Z_ = _mm_sub_ps(_mm_mul_ps(detC, B), mat2MulAdj(A, D_C));
+
+    //|M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+    __m128 tr = _mm_mul_ps(A_B, TZW_SWIZZLE(D_C, 0, 2, 1, 3));
+    tr = _mm_add_ps(tr, _mm_movehl_ps(tr, tr));
+    tr = _mm_add_ps(tr, TZW_SPLAT(tr, 1));
+    __m128 detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), TZW_SPLAT(tr, 0));
+    if (_mm_cvtss_f32(detM) == 0.0f)
+    {
+        if (invertible) {(*invertible) = false;}
+        return result;
+    }
+    if (invertible) {(*invertible) = true;}
+    __m128 rDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+    X_ = _mm_mul_ps(X_, rDetM);
+    Y_ = _mm_mul_ps(Y_, rDetM);
+    Z_ = _mm_mul_ps(Z_, rDetM);
+    W_ = _mm_mul_ps(W_, rDetM);
+
+    _mm_storeu_ps(result.m_data, TZW_SHUFFLE(X_, Y_, 3, 1, 3, 1));
+    _mm_storeu_ps(result.m_data + 4, TZW_SHUFFLE(X_, Y_, 2, 0, 2, 0));
+    _mm_storeu_ps(result.m_data + 8, TZW_SHUFFLE(Z_, W_, 3, 1, 3, 1));
+    _mm_storeu_ps(result.m_data + 12, TZW_SHUFFLE(Z_, W_, 2, 0, 2, 0));
+    return result;
+#else
+    return invertedScalar(invertible);
+#endif
+}
+
+Matrix44 Matrix44::invertedScalar(bool *invertible) const
 {
     auto mat = m_data;
     Matrix44 result;
@@ -278,7 +450,7 @@ Matrix44 Matrix44::inverted(bool *invertible)
     return result;
 }
 
-Matrix44 Matrix44::transpose()
+Matrix44 Matrix44::transpose() const
 {
     Matrix44 result;
     auto dest = result.m_data;
@@ -304,22 +476,37 @@ Matrix44 Matrix44::transpose()
 
 vec4 Matrix44::operator *(const vec4 &v)
 {
-    vec4 dst;
-    auto m = m_data;
-    dst.x = v.x * m[0] + v.y * m[4] + v.z * m[8] + v.w * m[12];
-    dst.y = v.x * m[1] + v.y * m[5] + v.z * m[9] + v.w * m[13];
-    dst.z = v.x * m[2] + v.y * m[6] + v.z * m[10] + v.w * m[14];
-    dst.w = v.x * m[3] + v.y * m[7] + v.z * m[11] + v.w * m[15];
-    return dst;
+    return static_cast<const Matrix44 &>(*this) * v;
 }
 
-vec3 Matrix44::transformVec3(vec3 v)
+vec3 Matrix44::transformVec3(vec3 v) const
 {
     auto result = *this * vec4(v, 1.0f);
     return vec3(result.x, result.y, result.z);
 }
 
-vec4 Matrix44::transofrmVec4(vec4 v)
+void Matrix44::transformVec3List(const vec3 *src, vec3 *dst, size_t count) const
+{
+#if TZW_USE_SSE
+    __m128 c0 = _mm_loadu_ps(m_data);
+    __m128 c1 = _mm_loadu_ps(m_data + 4);
+    __m128 c2 = _mm_loadu_ps(m_data + 8);
+    __m128 c3 = _mm_loadu_ps(m_data + 12);
+    for(size_t i = 0; i < count; i++)
+    {
+        float out[4];
+        _mm_storeu_ps(out, transformSSE(c0, c1, c2, c3, _mm_setr_ps(src[i].x, src[i].y, src[i].z, 1.0f)));
+        dst[i] = vec3(out[0], out[1], out[2]);
+    }
+#else
+    for(size_t i = 0; i < count; i++)
+    {
+        dst[i] = transformVec3(src[i]);
+    }
+#endif
+}
+
+vec4 Matrix44::transofrmVec4(vec4 v) const
 {
 	return *this * v;
 }
@@ -352,6 +539,11 @@ float *Matrix44::data()
     return m_data;
 }
 
+const float *Matrix44::data() const
+{
+    return m_data;
+}
+
 void Matrix44::getRowData(float* data)
 {
     data[0] = m_data[0];
@@ -380,17 +572,17 @@ void Matrix44::copyFromArray(float* data)
 	}
 }
 
-vec3 Matrix44::up()
+vec3 Matrix44::up() const
 {
     return vec3(m_data[4], m_data[5], m_data[6]);
 }
 
-vec3 Matrix44::forward()
+vec3 Matrix44::forward() const
 {
     return -vec3(m_data[8], m_data[9], m_data[10]);
 }
 
-vec3 Matrix44::right()
+vec3 Matrix44::right() const
 {
 	return vec3(m_data[0], m_data[1], m_data[2]);
 }
@@ -417,7 +609,7 @@ void Matrix44::stripScale()
 	m_data[10] = z.z;
 }
 
-vec3 Matrix44::getTranslation()
+vec3 Matrix44::getTranslation() const
 {
 	return vec3(m_data[12], m_data[13], m_data[14]);
 }
@@ -3,6 +3,7 @@
 #include "vec3.h"
 #include "vec4.h"
 #include "Quaternion.h"
+#include <cstddef>
 namespace tzw {
 
 class Matrix44
@@ -13,24 +14,33 @@ public:
     void setTranslate(vec3 offset);
     void setScale(vec3 scaleFactor);
     void setRotation(const Quaternion &quaternion);
+    //same as translate * rotation * scale, without the two full multiplies
+    void setTRS(const vec3 &offset, const Quaternion &quaternion, const vec3 &scaleFactor);
     Matrix44 operator *(const Matrix44 &  other) const;
     vec4 operator *(const vec4 &  other) const;
     void ortho(float left, float right, float bottom, float top, float near, float far);
     void perspective(float fovy, float aspect, float near, float far);
-    Matrix44 inverted(bool *invertible = 0);
-    Matrix44 transpose();
+    Matrix44 inverted(bool *invertible = 0) const;
+    Matrix44 transpose() const;
     vec4 operator * (const vec4 & v );
-    vec3 transformVec3(vec3 v);
-	vec4 transofrmVec4(vec4 v);
+    vec3 transformVec3(vec3 v) const;
+	vec4 transofrmVec4(vec4 v) const;
+	//the scalar paths, always compiled so the SIMD results can be checked against them
+	Matrix44 multiplyScalar(const Matrix44 & other) const;
+	Matrix44 invertedScalar(bool *invertible = 0) const;
+	//batch variants, dst may alias src
+	void transformVec3List(const vec3 * src, vec3 * dst, size_t count) const;
+	static void multiplyList(const Matrix44 & lhs, const Matrix44 * rhsList, Matrix44 * dstList, size_t count);
     void frustum(float left, float right, float bottom, float top, float near, float far);
     float * data();
+    const float * data() const;
 	void getRowData(float * data);
 	void copyFromArray(float * data);
-    vec3 up();
-    vec3 forward();
-    vec3 right();
+    vec3 up() const;
+    vec3 forward() const;
+    vec3 right() const;
 	void stripScale();
-	vec3 getTranslation();
+	vec3 getTranslation() const;
 	float determinant() const;
 	bool decompose(vec3* scale, Quaternion* rotation, vec3* translation) const;
 	bool getRotation(Quaternion * q);
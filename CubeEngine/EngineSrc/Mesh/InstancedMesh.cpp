@@ -1,17 +1,18 @@
 #include "InstancedMesh.h"
 #include <iostream>
 #include <assert.h>
+#include <algorithm>
 #include "Utility/log/Log.h"
 
 namespace tzw {
 
-	InstancedMesh::InstancedMesh()
+	InstancedMesh::InstancedMesh():m_mesh(nullptr), m_dirtyBegin(0), m_dirtyEnd(0), m_capacity(0), m_isAABBDirty(true)
 	{
 		m_instanceBuf = new RenderBuffer(RenderBuffer::Type::VERTEX);
 		m_instanceBuf->create();
 	}
 
-	InstancedMesh::InstancedMesh(Mesh* mesh):m_mesh(mesh)
+	InstancedMesh::InstancedMesh(Mesh* mesh):m_mesh(mesh), m_dirtyBegin(0), m_dirtyEnd(0), m_capacity(0), m_isAABBDirty(true)
 	{
 		m_instanceBuf = new RenderBuffer(RenderBuffer::Type::VERTEX);
 		m_instanceBuf->create();
@@ -27,7 +28,7 @@ namespace tzw {
 		m_instanceOffset.push_back(instanceData);
 	}
 
-	void InstancedMesh::pushInstances(std::vector<InstanceData> instancePos)
+	void InstancedMesh::pushInstances(const std::vector<InstanceData> & instancePos)
 	{
 		m_instanceOffset = instancePos;
 	}
@@ -42,9 +43,14 @@ namespace tzw {
 		if (m_instanceOffset.size() > 0 || preserveNumber > 0)
 		{
 			m_instanceBuf->use();
-			int size = (preserveNumber > 0) ?preserveNumber:m_instanceOffset.size();
-			void * data = (preserveNumber > 0)?NULL:&m_instanceOffset[0];
-			m_instanceBuf->allocate(data, size * sizeof(InstanceData));
+			if(preserveNumber > 0)
+			{
+				m_instanceBuf->allocateEmpty(preserveNumber * sizeof(InstanceData));
+			}
+			else
+			{
+				m_instanceBuf->allocate(&m_instanceOffset[0], m_instanceOffset.size() * sizeof(InstanceData));
+			}
 		}
 	}
 
@@ -64,6 +70,11 @@ namespace tzw {
 
 	InstancedMesh::~InstancedMesh()
 	{
+		for(auto slot : m_slotList)
+		{
+			slot->m_instancedMesh = nullptr;
+			slot->m_index = -1;
+		}
 		delete m_instanceBuf;
 	}
 
@@ -77,5 +88,105 @@ namespace tzw {
 		m_mesh = mesh;
 	}
 
+	InstanceSlot* InstancedMesh::addSlot(const InstanceData& instanceData)
+	{
+		auto slot = new InstanceSlot();
+		slot->m_instancedMesh = this;
+		slot->m_index = int(m_instanceOffset.size());
+		m_instanceOffset.push_back(instanceData);
+		m_slotList.push_back(slot);
+		markDirty(slot->m_index);
+		return slot;
+	}
+
+	void InstancedMesh::updateSlot(InstanceSlot* slot, const InstanceData& instanceData)
+	{
+		assert(slot->m_instancedMesh == this && m_slotList[slot->m_index] == slot);
+		m_instanceOffset[slot->m_index] = instanceData;
+		markDirty(slot->m_index);
+	}
+
+	void InstancedMesh::removeSlot(InstanceSlot* slot)
+	{
+		assert(slot->m_instancedMesh == this && m_slotList[slot->m_index] == slot);
+		// swap with the last one to keep the instances packed, only the filled hole has to be uploaded
+		int index = slot->m_index;
+		int last = int(m_instanceOffset.size()) - 1;
+		if(index != last)
+		{
+			m_instanceOffset[index] = m_instanceOffset[last];
+			m_slotList[index] = m_slotList[last];
+			m_slotList[index]->m_index = index;
+			markDirty(index);
+		}
+		m_instanceOffset.pop_back();
+		m_slotList.pop_back();
+		m_isAABBDirty = true;
+		delete slot;
+	}
+
+	void InstancedMesh::commitSlots()
+	{
+		int count = int(m_instanceOffset.size());
+		if(count > m_capacity)
+		{
+			// grow geometrically, the whole content is uploaded again
+			m_capacity = std::max(count, std::max(m_capacity * 2, 64));
+			m_instanceBuf->use();
+			m_instanceBuf->allocateEmpty(m_capacity * sizeof(InstanceData));
+			m_dirtyBegin = 0;
+			m_dirtyEnd = count;
+		}
+		int dirtyEnd = std::min(m_dirtyEnd, count);
+		if(m_dirtyBegin < dirtyEnd)
+		{
+			m_instanceBuf->resubmit(&m_instanceOffset[m_dirtyBegin], m_dirtyBegin * sizeof(InstanceData), (dirtyEnd - m_dirtyBegin) * sizeof(InstanceData));
+		}
+		m_dirtyBegin = 0;
+		m_dirtyEnd = 0;
+	}
+
+	void InstancedMesh::submitInstancedRange(int begin, int end)
+	{
+		if(begin < end)
+		{
+			markDirty(begin);
+			markDirty(end - 1);
+		}
+		commitSlots();
+	}
+
+	const AABB& InstancedMesh::getInstanceAABB()
+	{
+		if(m_isAABBDirty)
+		{
+			m_instanceAABB.reset();
+			AABB localAABB = m_mesh->getAabb();
+			for(auto & instance : m_instanceOffset)
+			{
+				AABB aabb = localAABB;
+				aabb.transForm(instance.transform);
+				m_instanceAABB.merge(aabb);
+			}
+			m_isAABBDirty = false;
+		}
+		return m_instanceAABB;
+	}
+
+	void InstancedMesh::markDirty(int index)
+	{
+		m_isAABBDirty = true;
+		if(m_dirtyBegin >= m_dirtyEnd)
+		{
+			m_dirtyBegin = index;
+			m_dirtyEnd = index + 1;
+		}
+		else
+		{
+			m_dirtyBegin = std::min(m_dirtyBegin, index);
+			m_dirtyEnd = std::max(m_dirtyEnd, index + 1);
+		}
+	}
+
 } // namespace tzw
 
@@ -9,6 +9,13 @@
 #include "../Engine/EngineDef.h"
 #include "../Math/Ray.h"
 namespace tzw {
+class InstancedMesh;
+//handle of a persistent instance, m_index follows the instance when the slots are compacted
+struct InstanceSlot
+{
+	InstancedMesh * m_instancedMesh;
+	int m_index;
+};
 class InstancedMesh
 {
 public:
@@ -17,7 +24,7 @@ public:
 	RenderBuffer *getInstanceBuf() const;
 	std::vector<InstanceData> m_instanceOffset;
 	void pushInstance(InstanceData instanceData);
-	void pushInstances(std::vector<InstanceData> instancePos);
+	void pushInstances(const std::vector<InstanceData> & instancePos);
 	void clearInstances();
 	void submitInstanced(int preserveNumber = 0);
 	int getInstanceSize();
@@ -25,9 +32,28 @@ public:
 	~InstancedMesh();
 	Mesh * getMesh();
 	void setMesh(Mesh * mesh);
+	//persistent instances, they stay in m_instanceOffset across frames and only the changed range is uploaded by commitSlots.
+	//don't mix with pushInstance / clearInstances on the same mesh
+	InstanceSlot * addSlot(const InstanceData & instanceData);
+	void updateSlot(InstanceSlot * slot, const InstanceData & instanceData);
+	void removeSlot(InstanceSlot * slot);
+	void commitSlots();
+	//upload [begin, end) of m_instanceOffset, the device buffer is only reallocated when it has to grow
+	void submitInstancedRange(int begin, int end);
+	//bounds of all the instances in world space, recomputed lazily after the slots changed
+	const AABB & getInstanceAABB();
 private:
+	void markDirty(int index);
 	RenderBuffer* m_instanceBuf;
 	Mesh * m_mesh;
+	std::vector<InstanceSlot *> m_slotList;
+	//dirty range of m_instanceOffset, [m_dirtyBegin, m_dirtyEnd)
+	int m_dirtyBegin;
+	int m_dirtyEnd;
+	//instances the device buffer can hold
+	int m_capacity;
+	AABB m_instanceAABB;
+	bool m_isAABBDirty;
 };
 
 } // namespace tzw
@@ -6,7 +6,7 @@
 namespace tzw {
 
 Mesh::Mesh()
-	: m_matIndex(0), m_vbo(0), m_ibo(0)
+	: m_matIndex(0), m_vbo(0), m_ibo(0), m_vertexFormat(RenderFlag::VertexFormat::Standard), m_packedScale(1.0f)
 {
 	m_arrayBuf = new RenderBuffer(RenderBuffer::Type::VERTEX);
 	m_indexBuf = new RenderBuffer(RenderBuffer::Type::INDEX);
@@ -39,6 +39,43 @@ void Mesh::addVertices(VertexData *vertices, int size)
     }
 }
 
+void Mesh::addTerrainVertex(const TerrainVertex& vertex)
+{
+	m_vertexFormat = RenderFlag::VertexFormat::Terrain;
+	m_terrainVertices.push_back(vertex);
+}
+
+void Mesh::setPackedTransform(vec3 offset, float scale)
+{
+	m_packedOffset = offset;
+	m_packedScale = scale;
+}
+
+Matrix44 Mesh::getPackedTransform() const
+{
+	Matrix44 mat;
+	mat.setToIdentity();
+	mat.setScale(vec3(m_packedScale, m_packedScale, m_packedScale));
+	mat.setTranslate(m_packedOffset);
+	return mat;
+}
+
+RenderFlag::VertexFormat Mesh::getVertexFormat() const
+{
+	return m_vertexFormat;
+}
+
+const void * Mesh::getVertexBuffer(size_t& byteSize) const
+{
+	if (m_vertexFormat == RenderFlag::VertexFormat::Terrain)
+	{
+		byteSize = m_terrainVertices.size() * sizeof(TerrainVertex);
+		return m_terrainVertices.empty() ? nullptr : &m_terrainVertices[0];
+	}
+	byteSize = m_vertices.size() * sizeof(VertexData);
+	return m_vertices.empty() ? nullptr : &m_vertices[0];
+}
+
 void Mesh::finish(bool isPassToGPU)
 {
 	calcTangents();
@@ -51,7 +88,9 @@ void Mesh::finish(bool isPassToGPU)
 
 void Mesh::submit(RenderFlag::BufferStorageType storageType)
 {
-	if (m_vertices.empty()) return;
+	size_t vertexBytes = 0;
+	auto vertexBuffer = getVertexBuffer(vertexBytes);
+	if (!vertexBuffer) return;
     //if(Engine::shared()->getRenderDeviceType() != RenderDeviceType::OpenGl_Device)return;
     if(m_ibo == 0)
     {
@@ -59,7 +98,7 @@ void Mesh::submit(RenderFlag::BufferStorageType storageType)
     }
     //pass data to the VBO
     m_arrayBuf->use();
-    m_arrayBuf->allocate(&m_vertices[0], m_vertices.size() * sizeof(VertexData), storageType);
+    m_arrayBuf->allocate(const_cast<void *>(vertexBuffer), vertexBytes, storageType);
 
     //pass data to the IBO
     m_indexBuf->use();
@@ -116,6 +155,8 @@ void Mesh::clearInstances()
 
 void Mesh::calcTangents()
 {
+    //the packed terrain vertex has no tangent
+    if (m_vertexFormat != RenderFlag::VertexFormat::Standard) return;
     size_t indexCount = m_indices.size();
     // Accumulate each triangle normal into each of the triangle vertices
     for (unsigned int i = 0 ; i < indexCount ; i += 3) {
@@ -165,9 +206,14 @@ void Mesh::submitInstanced(int preserveNumber)
 	if (m_instanceOffset.size() > 0 || preserveNumber > 0)
 	{
 		m_instanceBuf->use();
-		int size = (preserveNumber > 0) ?preserveNumber:m_instanceOffset.size();
-		void * data = (preserveNumber > 0)?NULL:&m_instanceOffset[0];
-		m_instanceBuf->allocate(data, size * sizeof(InstanceData));
+		if(preserveNumber > 0)
+		{
+			m_instanceBuf->allocateEmpty(preserveNumber * sizeof(InstanceData));
+		}
+		else
+		{
+			m_instanceBuf->allocate(&m_instanceOffset[0], m_instanceOffset.size() * sizeof(InstanceData));
+		}
 	}
 }
 
@@ -279,9 +325,22 @@ void Mesh::calBaryCentric()
 
 VertexData Mesh::getVertex(unsigned int index)
 {
+	if (m_vertexFormat == RenderFlag::VertexFormat::Terrain)
+	{
+		return VertexData(getVertexPos(index), m_terrainVertices[index].getNormal());
+	}
     return m_vertices[index];
 }
 
+vec3 Mesh::getVertexPos(unsigned int index)
+{
+	if (m_vertexFormat == RenderFlag::VertexFormat::Terrain)
+	{
+		return m_packedOffset + m_terrainVertices[index].getPackedPos() * m_packedScale;
+	}
+	return m_vertices[index].m_pos;
+}
+
 void Mesh::setVertex(unsigned int index, VertexData vertex)
 {
     m_vertices[index] = vertex;
@@ -580,6 +639,10 @@ size_t Mesh::getIndicesSize()
 
 size_t Mesh::getVerticesSize()
 {
+	if (m_vertexFormat == RenderFlag::VertexFormat::Terrain)
+	{
+		return m_terrainVertices.size();
+	}
     return m_vertices.size();
 }
 
@@ -601,6 +664,8 @@ void Mesh::clearVertices()
 {
     m_vertices.clear();
 	m_vertices.shrink_to_fit();
+	m_terrainVertices.clear();
+	m_terrainVertices.shrink_to_fit();
 }
 
 void Mesh::clearIndices()
@@ -620,9 +685,10 @@ void Mesh::setAabb(const AABB &aabb)
 
 void Mesh::calculateAABB()
 {
-    for(size_t i=0;i<m_vertices.size();i++)
+    size_t vertexCount = getVerticesSize();
+    for(size_t i=0;i<vertexCount;i++)
     {
-        m_aabb.update(m_vertices[i].m_pos);
+        m_aabb.update(getVertexPos(i));
     }
 }
 
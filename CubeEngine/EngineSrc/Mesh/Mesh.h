@@ -43,6 +43,11 @@ public:
     void addIndices(unsigned short * index,int size);
     void addVertex(VertexData vertexData);
     void addVertices(VertexData * vertices,int size);
+    //switch the mesh to RenderFlag::VertexFormat::Terrain, the positions are decoded with the packed transform
+    void addTerrainVertex(const TerrainVertex & vertex);
+    void setPackedTransform(vec3 offset, float scale);
+    Matrix44 getPackedTransform() const;
+    RenderFlag::VertexFormat getVertexFormat() const;
     void finish(bool isPassToGPU = true);
 
     integer_u vbo() const;
@@ -67,9 +72,11 @@ public:
     void caclNormals();
     void calBaryCentric();
     VertexData getVertex(unsigned int index);
+    vec3 getVertexPos(unsigned int index);
     void setVertex(unsigned int index, VertexData vertex);
     std::vector<short_u> m_indices;
     std::vector<VertexData> m_vertices;
+    std::vector<TerrainVertex> m_terrainVertices;
 	std::vector<InstanceData> m_instanceOffset;
     void subDivide(int level = 1);
     void cloneFrom(Mesh * other);
@@ -104,6 +111,7 @@ private:
 	
 
     void subDivideIter();
+    const void * getVertexBuffer(size_t & byteSize) const;
     
     AABB m_aabb;
     RenderBuffer* m_arrayBuf;
@@ -112,6 +120,9 @@ private:
 
     unsigned int m_matIndex;
     integer_u m_vbo,m_ibo;
+    RenderFlag::VertexFormat m_vertexFormat;
+    vec3 m_packedOffset;
+    float m_packedScale;
 };
 
 } // namespace tzw
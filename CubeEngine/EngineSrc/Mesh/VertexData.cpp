@@ -1,4 +1,6 @@
 #include "VertexData.h"
+#include <cmath>
+#include <algorithm>
 
 namespace tzw {
 
@@ -44,6 +46,69 @@ VertexData::VertexData(vec3 pos, vec2 texCoord, vec4 color)
 
 }
 
+static float signNotZero(float v)
+{
+	return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+TerrainVertex::TerrainVertex()
+{
+	m_pos[0] = m_pos[1] = m_pos[2] = m_pos[3] = 0;
+	m_normal[0] = m_normal[1] = 0;
+	m_mat[0] = m_mat[1] = m_mat[2] = m_mat[3] = 0;
+}
+
+TerrainVertex::TerrainVertex(const unsigned short * packedPos, vec3 normal, const MatBlendInfo & matInfo)
+{
+	m_pos[0] = packedPos[0];
+	m_pos[1] = packedPos[1];
+	m_pos[2] = packedPos[2];
+	m_pos[3] = 0;
+
+	//project on the octahedron, then fold the lower half over the upper one
+	float l1 = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+	float px = 0.0f, py = 0.0f;
+	if (l1 > 0.0f)
+	{
+		px = normal.x / l1;
+		py = normal.y / l1;
+		if (normal.z < 0.0f)
+		{
+			float fx = (1.0f - fabsf(py)) * signNotZero(px);
+			float fy = (1.0f - fabsf(px)) * signNotZero(py);
+			px = fx;
+			py = fy;
+		}
+	}
+	m_normal[0] = short(lroundf(std::clamp(px, -1.0f, 1.0f) * 32767.0f));
+	m_normal[1] = short(lroundf(std::clamp(py, -1.0f, 1.0f) * 32767.0f));
+
+	m_mat[0] = (unsigned char)matInfo.matIndex1;
+	m_mat[1] = (unsigned char)matInfo.matIndex2;
+	m_mat[2] = (unsigned char)matInfo.matIndex3;
+	m_mat[3] = matInfo.matBlendFactor;
+}
+
+vec3 TerrainVertex::getPackedPos() const
+{
+	return vec3(m_pos[0], m_pos[1], m_pos[2]);
+}
+
+vec3 TerrainVertex::getNormal() const
+{
+	float x = m_normal[0] / 32767.0f;
+	float y = m_normal[1] / 32767.0f;
+	float z = 1.0f - fabsf(x) - fabsf(y);
+	if (z < 0.0f)
+	{
+		float fx = (1.0f - fabsf(y)) * signNotZero(x);
+		float fy = (1.0f - fabsf(x)) * signNotZero(y);
+		x = fx;
+		y = fy;
+	}
+	return vec3(x, y, z).normalized();
+}
+
 VertexDataLite::VertexDataLite()
 {
 }
@@ -33,6 +33,22 @@ public:
 	vec3 m_tangent;
 };
 
+// packed vertex of the voxel terrain, 16 bytes instead of sizeof(VertexData).
+// the position is quantized in the mesh's packed space, see Mesh::setPackedTransform
+class TerrainVertex
+{
+public:
+	TerrainVertex();
+	TerrainVertex(const unsigned short * packedPos, vec3 normal, const MatBlendInfo & matInfo);
+	vec3 getPackedPos() const;
+	vec3 getNormal() const;
+	unsigned short m_pos[4];
+	//octahedral encoded, snorm
+	short m_normal[2];
+	//matIndex1 ~ 3, matBlendFactor
+	unsigned char m_mat[4];
+};
+
 class VertexDataLite
 {
 public:
@@ -244,6 +244,8 @@ namespace tzw
         SceneCuller::shared()->collectPrimitives();
         RenderQueues * renderQueues = SceneCuller::shared()->getRenderQueues();
         auto & commonList = renderQueues->getCommonList();
+        Camera * camera = g_GetCurrScene()->defaultCamera();
+        renderQueues->sortCommandList(commonList, renderQueues->getCommonOrder(), camera->getWorldPos(), true);
         for (int i = 0 ; i < 3 ; i++)
         {
             auto & shadowList = renderQueues->getShadowList(i);
@@ -258,12 +260,12 @@ namespace tzw
                 {
                     command.setMat(m_shadowMat);
                 }
-                command.m_transInfo.m_viewMatrix = ShadowMap::shared()->getLightViewMatrix();
-                command.m_transInfo.m_projectMatrix = ShadowMap::shared()->getLightProjectionMatrix(i);
-
             }
+            //every command shares the shadow material now, so sort by mesh only
+            renderQueues->sortCommandList(shadowList, renderQueues->getShadowOrder(i), vec3(), false);
+            m_ShadowStage[i]->setPassTransformation(ShadowMap::shared()->getLightViewMatrix(), ShadowMap::shared()->getLightProjectionMatrix(i));
             //drawObjs_Common(m_matPipelinePool, shadowCommand[i], m_ShadowStage[i], shadowList);
-            m_ShadowStage[i]->draw(shadowList);
+            m_ShadowStage[i]->draw(shadowList, renderQueues->getShadowOrder(i).data());
             m_ShadowStage[i]->endRenderPass();
             m_ShadowStage[i]->finish();
             m_renderPath->addRenderStage(m_ShadowStage[i]);
@@ -272,7 +274,8 @@ namespace tzw
         //------------deferred g - pass begin-------------
         m_gPassStage->prepare();
         m_gPassStage->beginRenderPass();
-        m_gPassStage->draw(commonList);
+        m_gPassStage->setPassTransformation(camera->getViewMatrix(), camera->projection());
+        m_gPassStage->draw(commonList, renderQueues->getCommonOrder().data());
         m_gPassStage->endRenderPass();
         m_gPassStage->finish();
         m_renderPath->addRenderStage(m_gPassStage);
@@ -377,6 +380,7 @@ namespace tzw
         m_transparentStage->prepare();
         m_transparentStage->beginRenderPass();
         auto transList = renderQueues->getTransparentList();
+        m_transparentStage->setPassTransformation(camera->getViewMatrix(), camera->projection());
         m_transparentStage->draw(transList);
         m_transparentStage->endRenderPass();
         m_transparentStage->finish();
@@ -445,6 +449,8 @@ namespace tzw
         auto drawSize = renderQueues->getGUICommandList().size();
         m_guiStage[imageIdx]->prepare();
         m_guiStage[imageIdx]->beginRenderPass();
+        Camera * guiCamera = g_GetCurrScene()->defaultGUICamera();
+        m_guiStage[imageIdx]->setPassTransformation(guiCamera->getViewMatrix(), guiCamera->projection());
         m_guiStage[imageIdx]->draw(renderQueues->getGUICommandList());
         if(!m_imguiPipeline)
         {
@@ -588,7 +594,9 @@ namespace tzw
                 }
                 
                 std::vector<RenderCommand> thumbnailCommandList;
-                thumbnail->getSnapShotCommand(thumbnailCommandList);
+                PassTransformation thumbnailTransformation;
+                thumbnail->getSnapShotCommand(thumbnailCommandList, thumbnailTransformation);
+                m_thumbNailRenderStage->setPassTransformation(thumbnailTransformation.m_viewMatrix, thumbnailTransformation.m_projectMatrix);
                 m_thumbNailRenderStage->setFrameBuffer(thumbnail->getFrameBufferVK());
                 m_thumbNailRenderStage->prepare();
                 m_thumbNailRenderStage->beginRenderPass(vec4(0.5, 0.5, 0.5, 1.0));
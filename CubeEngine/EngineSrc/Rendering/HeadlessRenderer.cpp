@@ -0,0 +1,164 @@
+#include "HeadlessRenderer.h"
+#include "Engine/Engine.h"
+#include "Engine/FrameProfiler.h"
+#include "BackEnd/NullRenderBackEnd.h"
+#include "Scene/SceneCuller.h"
+#include "Scene/SceneMgr.h"
+#include "3D/ShadowMap/ShadowMap.h"
+#include "3D/Thumbnail.h"
+#include "2D/GUISystem.h"
+#include "Rendering/Renderer.h"
+#include "Technique/Material.h"
+namespace tzw
+{
+	HeadlessRenderer::HeadlessRenderer()
+	{
+	}
+
+	void HeadlessRenderer::init()
+	{
+		auto backEnd = Engine::shared()->getRenderBackEnd();
+		auto size = Engine::shared()->winSize();
+		auto thumbnailPass = backEnd->createDeviceRenderpass_imp();
+		thumbnailPass->init(1, DeviceRenderPass::OpType::LOADCLEAR_AND_STORE, ImageFormat::R8G8B8A8_S, true);
+		auto thumbnailBuffer = backEnd->createFrameBuffer_imp();
+		thumbnailBuffer->init(1024, 1024, thumbnailPass);
+		m_thumbNailStage = backEnd->createRenderStage_imp();
+		m_thumbNailStage->init(thumbnailPass, thumbnailBuffer);
+
+		auto gBufferRenderPass = backEnd->createDeviceRenderpass_imp();
+		gBufferRenderPass->init(4, DeviceRenderPass::OpType::LOADCLEAR_AND_STORE, ImageFormat::R8G8B8A8_S, true);
+		auto gBuffer = backEnd->createFrameBuffer_imp();
+		gBuffer->init(size.x, size.y, gBufferRenderPass);
+		m_gPassStage = backEnd->createRenderStage_imp();
+		m_gPassStage->init(gBufferRenderPass, gBuffer);
+
+		m_shadowMat = new Material();
+		m_shadowMat->loadFromTemplate("Shadow");
+		m_shadowInstancedMat = new Material();
+		m_shadowInstancedMat->loadFromTemplate("ShadowInstance");
+		for(int i = 0; i < 3; i ++)
+		{
+			auto shadowRenderPass = backEnd->createDeviceRenderpass_imp();
+			shadowRenderPass->init(0, DeviceRenderPass::OpType::LOADCLEAR_AND_STORE, ImageFormat::R8G8B8A8_S, true);
+			auto shadowBuffer = backEnd->createFrameBuffer_imp();
+			shadowBuffer->init(1024, 1024, shadowRenderPass);
+			m_ShadowStage[i] = backEnd->createRenderStage_imp();
+			m_ShadowStage[i]->init(shadowRenderPass, shadowBuffer);
+		}
+
+		auto transparentPass = backEnd->createDeviceRenderpass_imp();
+		transparentPass->init(1, DeviceRenderPass::OpType::LOAD_AND_STORE, ImageFormat::R16G16B16A16_SFLOAT, false);
+		m_transparentStage = backEnd->createRenderStage_imp();
+		m_transparentStage->init(transparentPass, gBuffer);
+
+		auto guiPass = backEnd->createDeviceRenderpass_imp();
+		guiPass->init(1, DeviceRenderPass::OpType::LOAD_AND_STORE, ImageFormat::Surface_Format, false, true);
+		auto screenBuffer = backEnd->createFrameBuffer_imp();
+		screenBuffer->init(size.x, size.y, guiPass);
+		m_guiStage = backEnd->createRenderStage_imp();
+		m_guiStage->init(guiPass, screenBuffer);
+	}
+
+	void HeadlessRenderer::render()
+	{
+		auto backEnd = NullRenderBackEnd::shared();
+		auto profiler = FrameProfiler::shared();
+		backEnd->prepareFrame();
+
+		profiler->beginStage(FrameStage::Culling);
+		SceneCuller::shared()->collectPrimitives();
+		profiler->endStage(FrameStage::Culling);
+
+		RenderQueues * renderQueues = SceneCuller::shared()->getRenderQueues();
+		auto & commonList = renderQueues->getCommonList();
+		Camera * camera = g_GetCurrScene()->defaultCamera();
+		profiler->beginStage(FrameStage::Sort);
+		renderQueues->sortCommandList(commonList, renderQueues->getCommonOrder(), camera->getWorldPos(), true);
+		for(int i = 0; i < 3; i++)
+		{
+			auto & shadowList = renderQueues->getShadowList(i);
+			for(auto & command : shadowList)
+			{
+				command.setMat(command.batchType() != RenderCommand::RenderBatchType::Single ? m_shadowInstancedMat : m_shadowMat);
+			}
+			renderQueues->sortCommandList(shadowList, renderQueues->getShadowOrder(i), vec3(), false);
+		}
+		profiler->endStage(FrameStage::Sort);
+
+		profiler->beginStage(FrameStage::Submit);
+		for(int i = 0; i < 3; i++)
+		{
+			m_ShadowStage[i]->prepare();
+			m_ShadowStage[i]->beginRenderPass();
+			m_ShadowStage[i]->setPassTransformation(ShadowMap::shared()->getLightViewMatrix(), ShadowMap::shared()->getLightProjectionMatrix(i));
+			m_ShadowStage[i]->draw(renderQueues->getShadowList(i), renderQueues->getShadowOrder(i).data());
+			m_ShadowStage[i]->endRenderPass();
+			m_ShadowStage[i]->finish();
+		}
+		m_gPassStage->prepare();
+		m_gPassStage->beginRenderPass();
+		m_gPassStage->setPassTransformation(camera->getViewMatrix(), camera->projection());
+		m_gPassStage->draw(commonList, renderQueues->getCommonOrder().data());
+		m_gPassStage->endRenderPass();
+		m_gPassStage->finish();
+		m_transparentStage->prepare();
+		m_transparentStage->beginRenderPass();
+		m_transparentStage->setPassTransformation(camera->getViewMatrix(), camera->projection());
+		m_transparentStage->draw(renderQueues->getTransparentList());
+		m_transparentStage->endRenderPass();
+		m_transparentStage->finish();
+		Camera * guiCamera = g_GetCurrScene()->defaultGUICamera();
+		m_guiStage->prepare();
+		m_guiStage->beginRenderPass();
+		m_guiStage->setPassTransformation(guiCamera->getViewMatrix(), guiCamera->projection());
+		m_guiStage->draw(renderQueues->getGUICommandList());
+		profiler->endStage(FrameStage::Submit);
+
+		profiler->beginStage(FrameStage::GUI);
+		GUISystem::shared()->renderIMGUI();
+		auto drawData = GUISystem::shared()->getDrawData();
+		if(drawData && drawData->TotalVtxCount > 0)
+		{
+			backEnd->getStats().m_uploadBytes += drawData->TotalVtxCount * sizeof(ImDrawVert) + drawData->TotalIdxCount * sizeof(ImDrawIdx);
+			for (int n = 0; n < drawData->CmdListsCount; n++)
+			{
+				const ImDrawList* cmdList = drawData->CmdLists[n];
+				for (int i = 0; i < cmdList->CmdBuffer.Size; i++)
+				{
+					m_guiStage->drawElement(cmdList->CmdBuffer[i].ElemCount, 1, 0, 0, 0);
+				}
+			}
+		}
+		m_guiStage->endRenderPass();
+		m_guiStage->finish();
+		profiler->endStage(FrameStage::GUI);
+
+		renderQueues->clearCommands();
+		//one snapshot per frame like the vulkan path, the result is never readable so the texture stays empty
+		for(auto thumbnail : Renderer::shared()->getThumbNailList())
+		{
+			if(!thumbnail->isIsDone())
+			{
+				std::vector<RenderCommand> thumbnailCommandList;
+				PassTransformation thumbnailTransformation;
+				thumbnail->getSnapShotCommand(thumbnailCommandList, thumbnailTransformation);
+				m_thumbNailStage->setPassTransformation(thumbnailTransformation.m_viewMatrix, thumbnailTransformation.m_projectMatrix);
+				m_thumbNailStage->prepare();
+				m_thumbNailStage->beginRenderPass(vec4(0.5, 0.5, 0.5, 1.0));
+				m_thumbNailStage->draw(thumbnailCommandList);
+				m_thumbNailStage->finish();
+				thumbnail->setIsDone(true);
+				break;
+			}
+		}
+		backEnd->endFrame(nullptr);
+
+		auto & stats = backEnd->getStats();
+		profiler->setCounter(FrameCounter::DrawCall, stats.m_drawCount);
+		profiler->setCounter(FrameCounter::Index, double(stats.m_indexCount));
+		profiler->setCounter(FrameCounter::BindIssued, Engine::shared()->getBindIssuedCount());
+		profiler->setCounter(FrameCounter::BindSkipped, Engine::shared()->getBindSkippedCount());
+		profiler->setCounter(FrameCounter::UploadBytes, double(stats.m_uploadBytes));
+	}
+}
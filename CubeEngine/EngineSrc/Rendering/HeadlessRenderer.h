@@ -0,0 +1,24 @@
+#pragma once
+#include "../Engine/EngineDef.h"
+#include "BackEnd/DeviceRenderStage.h"
+namespace tzw
+{
+	class Material;
+	// Frame of the null device, the same CPU work as GraphicsRenderer::render up to the command recording,
+	// each stage is timed by FrameProfiler.
+	class HeadlessRenderer:public Singleton<HeadlessRenderer>
+	{
+	public:
+		HeadlessRenderer();
+		void init();
+		void render();
+	private:
+		DeviceRenderStage * m_ShadowStage[3];
+		DeviceRenderStage * m_gPassStage;
+		DeviceRenderStage * m_transparentStage;
+		DeviceRenderStage * m_guiStage;
+		DeviceRenderStage * m_thumbNailStage;
+		Material * m_shadowMat;
+		Material * m_shadowInstancedMat;
+	};
+}
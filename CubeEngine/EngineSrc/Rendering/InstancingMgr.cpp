@@ -3,137 +3,94 @@
 #include "Renderer.h"
 #include "Scene/SceneMgr.h"
 #include "Mesh/InstancedMesh.h"
+#include "Scene/OctreeScene.h"
+#include "Base/Camera.h"
 #include <unordered_set>
 namespace tzw
 {
-	void InstancingMgr::prepare(RenderFlag::RenderStage renderType)
+	static bool isGroupVisible(const AABB & aabb, const OctreeCullingView & view)
 	{
-		for(auto & innerMap : m_map)
+		if(view.m_camera)
 		{
-			for(auto & t: innerMap.second)
-			{
-				int clearID = 0;
-				switch(renderType)
-				{
-				case RenderFlag::RenderStage::GUI: break;
-				case RenderFlag::RenderStage::COMMON:
-					clearID = COMMON_PASS_INSTANCE;
-					break;
-				case RenderFlag::RenderStage::SHADOW:
-					clearID = SHADOW_PASS_INSTANCE;
-					break;
-				default: ;
-				}
-				if(t.second[clearID])
-				{
-					t.second[clearID]->clearInstances();
-				}
-			}
+			return !view.m_camera->isOutOfFrustum(aabb);
 		}
+		vec3 aMin = aabb.min(), aMax = aabb.max();
+		vec3 bMin = view.m_range.min(), bMax = view.m_range.max();
+		return aMin.x <= bMax.x && bMin.x <= aMax.x
+			&& aMin.y <= bMax.y && bMin.y <= aMax.y
+			&& aMin.z <= bMax.z && bMin.z <= aMax.z;
 	}
 
-	void InstancingMgr::pushInstanceRenderData(RenderFlag::RenderStage stage, InstanceRendereData data)
+	InstanceSlot* InstancingMgr::addSlot(const void * group, Material* material, Mesh* mesh, const InstanceData& data)
 	{
-		int clearID = getInstancedIndexFromRenderType(stage);
-		auto mesh_to_instance = m_map.find(data.material);
-		InstancedMesh * instacing = nullptr;
-		if(mesh_to_instance != m_map.end())
+		auto & instancing = m_groupMap[group].m_map[material][mesh];
+		if(!instancing)
 		{
-			auto instancedMesh = mesh_to_instance->second.find(data.m_mesh);
-			if(instancedMesh != mesh_to_instance->second.end())
-			{
-				if(instancedMesh->second[clearID])
-				{
-					instacing = instancedMesh->second[clearID];
-				}
-				else
-				{
-					instacing = new InstancedMesh(data.m_mesh);
-					instancedMesh->second[clearID] = instacing;
-					instancedMesh->second[clearID]->pushInstance(data.data);
-				}
-				
-			}else
-			{
-				instacing = new InstancedMesh(data.m_mesh);
-				for(int i =0 ; i< MAX_INSTANCE_INDEX; i++)
-				{
-					mesh_to_instance->second[data.m_mesh][i] = nullptr;
-				}
-				mesh_to_instance->second[data.m_mesh][clearID] = instacing;
-			}
-		}else
-		{
-			innerMeshMap newMap;
-			m_map.insert(std::make_pair(data.material, newMap));// = newMap;
-			instacing = new InstancedMesh(data.m_mesh);
-			for(int i =0 ; i< MAX_INSTANCE_INDEX; i++)
-			{
-				m_map[data.material][data.m_mesh][i] = nullptr;
-			}
-			m_map[data.material][data.m_mesh][clearID] = instacing;
+			instancing = new InstancedMesh(mesh);
 		}
-		instacing->pushInstance(data.data);
-		
+		return instancing->addSlot(data);
 	}
 
-	void InstancingMgr::generateDrawCall(RenderFlag::RenderStageType requirementType, RenderQueues * queues, int requirementArg)
+	void InstancingMgr::updateSlot(InstanceSlot* slot, const InstanceData& data)
 	{
-		RenderFlag::RenderStage renderType;
-		switch(requirementType){
-		case RenderFlag::RenderStageType::SHADOW:
-			renderType = RenderFlag::RenderStage::SHADOW;
-			break;
-		case RenderFlag::RenderStageType::COMMON:
-			renderType = RenderFlag::RenderStage::COMMON;
-			break;
-		}
-		int clearID = getInstancedIndexFromRenderType(renderType);
-		for(auto & innerMap : m_map)
+		slot->m_instancedMesh->updateSlot(slot, data);
+	}
+
+	void InstancingMgr::removeSlot(InstanceSlot* slot)
+	{
+		slot->m_instancedMesh->removeSlot(slot);
+	}
+
+	void InstancingMgr::commitSlots()
+	{
+		for(auto groupIter = m_groupMap.begin(); groupIter != m_groupMap.end();)
 		{
-			for(auto & t: innerMap.second)
+			auto & group = groupIter->second;
+			group.m_aabb.reset();
+			for(auto matIter = group.m_map.begin(); matIter != group.m_map.end();)
 			{
-				t.second[clearID]->submitInstanced();
-				RenderCommand command(t.first, innerMap.first, nullptr, requirementType, RenderCommand::PrimitiveType::TRIANGLES, RenderCommand::RenderBatchType::Instanced);
-				command.setInstancedMesh(t.second[clearID]);
-				command.setPrimitiveType(RenderCommand::PrimitiveType::TRIANGLES);
-				setUpTransFormation(command.m_transInfo);
-				queues->addRenderCommand(command, requirementArg);
+				auto & innerMap = matIter->second;
+				for(auto iter = innerMap.begin(); iter != innerMap.end();)
+				{
+					//the pools of a destroyed island are empty now, drop them with their buffers
+					if(!iter->second->getInstanceSize())
+					{
+						delete iter->second;
+						iter = innerMap.erase(iter);
+						continue;
+					}
+					iter->second->commitSlots();
+					group.m_aabb.merge(iter->second->getInstanceAABB());
+					++iter;
+				}
+				matIter = innerMap.empty() ? group.m_map.erase(matIter) : std::next(matIter);
 			}
+			groupIter = group.m_map.empty() ? m_groupMap.erase(groupIter) : std::next(groupIter);
 		}
-
 	}
-	void InstancingMgr::generateDrawCall(RenderFlag::RenderStageType requirementType, int requirementArg, std::vector<RenderCommand>& cmmdList)
+
+	void InstancingMgr::generateDrawCall(RenderFlag::RenderStageType requirementType, RenderQueues * queues, int requirementArg, const OctreeCullingView & view)
 	{
-		RenderFlag::RenderStage renderType;
-		switch(requirementType){
-		case RenderFlag::RenderStageType::SHADOW:
-			renderType = RenderFlag::RenderStage::SHADOW;
-			break;
-		case RenderFlag::RenderStageType::COMMON:
-			renderType = RenderFlag::RenderStage::COMMON;
-			break;
-		}
-		int clearID = getInstancedIndexFromRenderType(renderType);
-		for(auto & innerMap : m_map)
+		for(auto & groupIter : m_groupMap)
 		{
-			for(auto & t: innerMap.second)
+			if(!isGroupVisible(groupIter.second.m_aabb, view)) continue;
+			for(auto & innerMap : groupIter.second.m_map)
 			{
-				t.second[clearID]->submitInstanced();
-				RenderCommand command(t.first, innerMap.first, nullptr, requirementType, RenderCommand::PrimitiveType::TRIANGLES, RenderCommand::RenderBatchType::Instanced);
-				command.setInstancedMesh(t.second[clearID]);
-				command.setPrimitiveType(RenderCommand::PrimitiveType::TRIANGLES);
-				setUpTransFormation(command.m_transInfo);
-				cmmdList.emplace_back(command);
+				for(auto & t: innerMap.second)
+				{
+					if(!t.second->getInstanceSize()) continue;
+					RenderCommand command(t.first, innerMap.first, nullptr, requirementType, RenderCommand::PrimitiveType::TRIANGLES, RenderCommand::RenderBatchType::Instanced);
+					command.setInstancedMesh(t.second);
+					command.setPrimitiveType(RenderCommand::PrimitiveType::TRIANGLES);
+					setUpTransFormation(command.m_transInfo);
+					queues->addRenderCommand(command, requirementArg);
+				}
 			}
 		}
 	}
 
 	void InstancingMgr::setUpTransFormation(TransformationInfo& info)
 	{
-		auto currCam = g_GetCurrScene()->defaultCamera();
-		info.m_projectMatrix = currCam->projection();
-		info.m_viewMatrix = currCam->getViewMatrix();
 		Matrix44 mat;
 		mat.setToIdentity();
 		info.m_worldMatrix = mat;
@@ -166,20 +123,4 @@ namespace tzw
 		}
 		return;
 	}
-	int InstancingMgr::getInstancedIndexFromRenderType(RenderFlag::RenderStage renderType)
-	{
-		int clearID = 0;
-		switch(renderType)
-		{
-		case RenderFlag::RenderStage::GUI: break;
-		case RenderFlag::RenderStage::COMMON:
-			clearID = COMMON_PASS_INSTANCE;
-			break;
-		case RenderFlag::RenderStage::SHADOW:
-			clearID = SHADOW_PASS_INSTANCE;
-			break;
-		default: ;
-		}
-		return clearID;
-	}
 }
@@ -3,28 +3,37 @@
 #include <unordered_map>
 #include "RenderCommand.h"
 #include "Rendering/RenderQueues.h"
+#include "Math/AABB.h"
 namespace tzw
 {
 class Mesh;
 class InstancedMesh;
 class Material;
-#define MAX_INSTANCE_INDEX 2
-
-#define SHADOW_PASS_INSTANCE 0
-#define COMMON_PASS_INSTANCE 1
-typedef std::unordered_map<Mesh *, InstancedMesh*[MAX_INSTANCE_INDEX]> innerMeshMap;
+struct InstanceSlot;
+struct OctreeCullingView;
+typedef std::unordered_map<Mesh *, InstancedMesh*> innerMeshMap;
+//the pools of one group, the bounds of all of them are tested once per view
+struct InstancingGroup
+{
+	std::unordered_map<Material *, innerMeshMap> m_map;
+	AABB m_aabb;
+};
+// Persistent instance pools, one InstancedMesh per group, material and mesh.
+// The owners keep their slots across frames and only touch them when something changed,
+// commitSlots uploads the changed ranges once per frame and every pass draws the same buffers.
+// a group is whatever moves together (an island for the game parts), the groups out of a view are not drawn in it
 class InstancingMgr :public Singleton<InstancingMgr>
 	{
 	public:
-		void prepare(RenderFlag::RenderStage renderType);
-		void pushInstanceRenderData(RenderFlag::RenderStage renderType, InstanceRendereData data);
-		void generateDrawCall(RenderFlag::RenderStageType requirementType, RenderQueues * queues, int requirementArg);
-		void generateDrawCall(RenderFlag::RenderStageType requirementType, int requirementArg, std::vector<RenderCommand>& cmmdList);
+		InstanceSlot * addSlot(const void * group, Material * material, Mesh * mesh, const InstanceData & data);
+		void updateSlot(InstanceSlot * slot, const InstanceData & data);
+		void removeSlot(InstanceSlot * slot);
+		void commitSlots();
+		void generateDrawCall(RenderFlag::RenderStageType requirementType, RenderQueues * queues, int requirementArg, const OctreeCullingView & view);
 		void setUpTransFormation(TransformationInfo& info);
 		void generateSingleCommand(RenderFlag::RenderStageType requirementType, std::vector<InstanceRendereData> data, std::vector<RenderCommand> & cmdList);
-		int getInstancedIndexFromRenderType(RenderFlag::RenderStage renderType);
 	private:
-		std::unordered_map<Material *, innerMeshMap> m_map;
+		std::unordered_map<const void *, InstancingGroup> m_groupMap;
 	};
 
 
@@ -2,6 +2,7 @@
 //#include "../BackEnd/RenderBackEnd.h"
 #include "BackEnd/RenderBackEndBase.h"
 #include "Engine/Engine.h"
+#include "Utility/log/Log.h"
 namespace tzw {
 
 RenderBuffer::RenderBuffer(Type bufferType)
@@ -34,21 +35,22 @@ void RenderBuffer::allocate(void *data, unsigned int amount, RenderFlag::BufferS
 	m_amount = amount;
 }
 
+void RenderBuffer::allocateEmpty(unsigned int amount)
+{
+    m_bufferId->allocateEmpty(amount);
+	m_amount = amount;
+}
+
 void RenderBuffer::resubmit(void* data, unsigned offset, unsigned amount)
 {
-    printf("resubmit");
-    return;
-    /*
-    switch(m_type)
+    if(offset + amount > m_amount)
     {
-    case Type::INDEX:
-        RenderBackEnd::shared()->resubmit(RenderFlag::BufferTarget::IndexBuffer, offset ,amount,data);
-        break;
-    case Type::VERTEX:
-        RenderBackEnd::shared()->resubmit(RenderFlag::BufferTarget::VertexBuffer, offset ,amount,data);
-        break;
+        tlogError("resubmit out of range, %u + %u > %u", offset, amount, m_amount);
+        return;
     }
-    */
+    m_bufferId->map();
+    m_bufferId->copyFrom(data, amount, offset);
+    m_bufferId->unmap();
 }
 
 void RenderBuffer::use()
@@ -17,6 +17,8 @@ public:
     RenderBuffer(Type bufferType);
     void create();
     void allocate(void * data, unsigned int amount, RenderFlag::BufferStorageType storageType = RenderFlag::BufferStorageType::STATIC_DRAW);
+    //reserve the storage without uploading, the content is written by resubmit
+    void allocateEmpty(unsigned int amount);
 	void resubmit(void * data, unsigned int offset, unsigned int amount);
     void use();
     DeviceBuffer * bufferId() const;
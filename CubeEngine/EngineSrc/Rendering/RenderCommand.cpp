@@ -6,7 +6,7 @@
 namespace tzw {
 
 RenderCommand::RenderCommand(Mesh *mesh, Material *material, void * obj,RenderFlag::RenderStageType renderStageType, PrimitiveType primitiveType, RenderBatchType batchType)
-    :m_mesh(mesh),m_material(material),
+    :m_mesh(mesh),m_instancedMesh(nullptr),m_instanceBegin(0),m_instanceCount(-1),m_material(material),
 	m_primitiveType(primitiveType),m_Zorder(0),
     m_batchType(batchType)
 {
@@ -87,6 +87,22 @@ void RenderCommand::setInstancedMesh(InstancedMesh* const instancedMesh)
 {
 	m_instancedMesh = instancedMesh;
 }
+
+void RenderCommand::setInstanceRange(int begin, int count)
+{
+	m_instanceBegin = begin;
+	m_instanceCount = count;
+}
+
+int RenderCommand::getInstanceBegin() const
+{
+	return m_instanceBegin;
+}
+
+int RenderCommand::getInstanceCount() const
+{
+	return m_instanceCount < 0 ? m_instancedMesh->getInstanceSize() : m_instanceCount;
+}
 Material* RenderCommand::getMat()
 {
     return m_material;
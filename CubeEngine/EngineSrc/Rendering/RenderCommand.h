@@ -17,9 +17,11 @@ struct InstanceRendereData
 };
 struct TransformationInfo{
     Matrix44 m_worldMatrix;
+};
+//view and projection are shared by every command of a pass, instead of being copied into each command
+struct PassTransformation{
     Matrix44 m_viewMatrix;
     Matrix44 m_projectMatrix;
-	std::vector<vec3> m_instancedOffset;
 };
 
 class RenderCommand
@@ -57,6 +59,10 @@ public:
 	RenderBatchType m_batchType;
 	InstancedMesh* getInstancedMesh() const;
 	void setInstancedMesh(InstancedMesh* const instancedMesh);
+	//draw the instances [begin, begin + count) of the instanced mesh, by default all of them
+	void setInstanceRange(int begin, int count);
+	int getInstanceBegin() const;
+	int getInstanceCount() const;
     Material * getMat();
     void setMat(Material * newMat);
     Mesh * getMesh();
@@ -66,6 +72,9 @@ private:
 	RenderFlag::RenderStage m_renderState;
     Mesh * m_mesh;
 	InstancedMesh * m_instancedMesh;
+	int m_instanceBegin;
+	//-1 for every instance of m_instancedMesh
+	int m_instanceCount;
     Material *m_material;
     PrimitiveType m_primitiveType;
     unsigned int m_Zorder;
@@ -75,6 +75,12 @@ enum class BufferStorageType
 	DYNAMIC_DRAW,
 };
 
+enum class VertexFormat
+{
+	Standard,//VertexData
+	Terrain,//TerrainVertex
+};
+
 enum class CullMode{
     Back,
     Front,
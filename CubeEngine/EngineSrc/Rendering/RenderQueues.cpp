@@ -2,8 +2,37 @@
 #include "3D/Vegetation/Tree.h"
 #include "Rendering/InstancingMgr.h"
 #include "../3D/ShadowMap/ShadowMap.h"
+#include "Technique/Material.h"
+#include "Mesh/InstancedMesh.h"
+#include <cstring>
 namespace tzw
 {
+	//pointers are hashed to the id fields of the sort key, a collision only costs a redundant bind
+	static uint64_t hashPtr(const void * ptr, int bits)
+	{
+		uint64_t v = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr));
+		return ((v >> 4) * 0x9E3779B97F4A7C15ull) >> (64 - bits);
+	}
+
+	//stage:4 | program:14 | material:14 | mesh:16 | depth:16
+	static uint64_t genSortKey(RenderCommand & cmd, const vec3 & viewPos, bool isSortByDepth)
+	{
+		Material * mat = cmd.getMat();
+		Mesh * mesh = cmd.batchType() != RenderCommand::RenderBatchType::Single ? cmd.getInstancedMesh()->getMesh() : cmd.getMesh();
+		uint64_t key = static_cast<uint64_t>(cmd.getRenderState()) << 60;
+		key |= hashPtr(mat ? mat->getProgram() : nullptr, 14) << 46;
+		key |= hashPtr(mat, 14) << 32;
+		key |= hashPtr(mesh, 16) << 16;
+		if(isSortByDepth)
+		{
+			//the bits of a positive float keep its order, the top 16 bits are sign, exponent and 7 bits of mantissa
+			float dist = (cmd.m_transInfo.m_worldMatrix.getTranslation() - viewPos).length();
+			uint32_t distBits;
+			memcpy(&distBits, &dist, sizeof(distBits));
+			key |= distBits >> 16;
+		}
+		return key;
+	}
 
 	void RenderQueues::addRenderCommand(RenderCommand& command, int level)
 	{
@@ -48,16 +77,74 @@ namespace tzw
 		return m_afterDepthList;
 	}
 
+	std::vector<uint32_t>& RenderQueues::getShadowOrder(int index)
+	{
+		return m_shadowOrder[index];
+	}
+
+	std::vector<uint32_t>& RenderQueues::getCommonOrder()
+	{
+		return m_commonOrder;
+	}
+
 	void RenderQueues::clearCommands()
 	{
 		for(int i = 0; i < 3; i++ )
 		{
 			m_shadowList[i].clear();
+			m_shadowOrder[i].clear();
 		}
 		m_commonList.clear();
+		m_commonOrder.clear();
 		m_guiCommandList.clear();
 		m_transparentList.clear();
 		m_afterDepthList.clear();
 	}
 
+	void RenderQueues::sortCommandList(std::vector<RenderCommand>& cmdList, std::vector<uint32_t>& order, const vec3& viewPos, bool isSortByDepth)
+	{
+		size_t count = cmdList.size();
+		order.resize(count);
+		if(count < 2)
+		{
+			if(count) order[0] = 0;
+			return;
+		}
+		m_sortList.resize(count);
+		m_sortTmpList.resize(count);
+		uint64_t diffBits = 0;
+		for(size_t i = 0; i < count; i++)
+		{
+			m_sortList[i].m_key = genSortKey(cmdList[i], viewPos, isSortByDepth);
+			m_sortList[i].m_index = static_cast<uint32_t>(i);
+			diffBits |= m_sortList[i].m_key ^ m_sortList[0].m_key;
+		}
+		//LSD radix sort by byte, the bytes which are the same for every key are skipped
+		for(int shift = 0; shift < 64; shift += 8)
+		{
+			if(((diffBits >> shift) & 0xff) == 0) continue;
+			uint32_t offset[256] = {};
+			for(size_t i = 0; i < count; i++)
+			{
+				offset[(m_sortList[i].m_key >> shift) & 0xff]++;
+			}
+			uint32_t sum = 0;
+			for(int b = 0; b < 256; b++)
+			{
+				uint32_t c = offset[b];
+				offset[b] = sum;
+				sum += c;
+			}
+			for(size_t i = 0; i < count; i++)
+			{
+				m_sortTmpList[offset[(m_sortList[i].m_key >> shift) & 0xff]++] = m_sortList[i];
+			}
+			m_sortList.swap(m_sortTmpList);
+		}
+		for(size_t i = 0; i < count; i++)
+		{
+			order[i] = m_sortList[i].m_index;
+		}
+	}
+
 }
\ No newline at end of file
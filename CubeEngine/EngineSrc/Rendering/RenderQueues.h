@@ -15,10 +15,25 @@ namespace tzw {
 		std::vector<RenderCommand> & getGUICommandList();
 		std::vector<RenderCommand> & getTransparentList();
 		std::vector<RenderCommand> & getAfterDepthList();
+		std::vector<uint32_t> & getShadowOrder(int index);
+		std::vector<uint32_t> & getCommonOrder();
 		void clearCommands();
+		//stable radix sort by (stage, program, material, mesh, depth), so consecutive commands share as much state as possible.
+		//the commands are not moved, order receives the indices into cmdList in draw order.
+		//depth is the distance to viewPos, front to back, only used if isSortByDepth is true
+		void sortCommandList(std::vector<RenderCommand> & cmdList, std::vector<uint32_t> & order, const vec3 & viewPos, bool isSortByDepth);
 	private:
+		struct SortItem
+		{
+			uint64_t m_key;
+			uint32_t m_index;
+		};
+		std::vector<SortItem> m_sortList;
+		std::vector<SortItem> m_sortTmpList;
 		std::vector<RenderCommand> m_shadowList[3];
 		std::vector<RenderCommand> m_commonList;
+		std::vector<uint32_t> m_shadowOrder[3];
+		std::vector<uint32_t> m_commonOrder;
 		std::vector<RenderCommand> m_guiCommandList;
 		std::vector<RenderCommand> m_transparentList;
 		std::vector<RenderCommand> m_afterDepthList;
@@ -174,9 +174,14 @@ void Renderer::renderAll()
 void Renderer::renderAllCommon()
 {
 	RenderQueues * queues = SceneCuller::shared()->getRenderQueues();
-	for(auto& command : queues->getCommonList())
+	auto camera = g_GetCurrScene()->defaultCamera();
+	setPassCamera(camera);
+	auto & commonList = queues->getCommonList();
+	auto & order = queues->getCommonOrder();
+	queues->sortCommandList(commonList, order, camera->getWorldPos(), true);
+	for(uint32_t index : order)
 	{
-		renderCommon(command);
+		renderCommon(commonList[index]);
 	}
 
 }
@@ -194,6 +199,7 @@ void Renderer::renderAllShadow(int index)
 void Renderer::renderAllTransparent()
 {
 	RenderQueues * queues = SceneCuller::shared()->getRenderQueues();
+	setPassCamera(g_GetCurrScene()->defaultCamera());
 	for(RenderCommand & command : queues->getTransparentList())
 	{
 		renderCommon(command);
@@ -204,6 +210,7 @@ void Renderer::renderAllTransparent()
 void Renderer::renderAllClearDepthTransparent()
 {
 	RenderQueues * queues = SceneCuller::shared()->getRenderQueues();
+	setPassCamera(g_GetCurrScene()->defaultCamera());
 	for(RenderCommand & command : queues->getAfterDepthList())
 	{
 		renderCommon(command);
@@ -216,7 +223,7 @@ void Renderer::renderAllGUI()
 	RenderBackEnd::shared()->setBlendFactor(RenderFlag::BlendingFactor::SrcAlpha,
 											RenderFlag::BlendingFactor::OneMinusSrcAlpha);
 	RenderQueues * queues = SceneCuller::shared()->getRenderQueues();
-	
+	setPassCamera(g_GetCurrScene()->defaultGUICamera());
 	RenderBackEnd::shared()->enableFunction(RenderFlag::RenderFunction::DepthTest);
 	for(RenderCommand & command : queues->getGUICommandList())
 	{
@@ -247,19 +254,17 @@ void Renderer::renderShadow(RenderCommand &command,int index, const Matrix44 & l
 		  
 		applyRenderSetting(command.m_material);
 		  
-		auto cpyTransInfo = command.m_transInfo;
+		PassTransformation lightPass;
+		lightPass.m_viewMatrix = lightViewMatrix;
+		lightPass.m_projectMatrix = ShadowMap::shared()->getLightProjectionMatrix(index);
 		  
-		// one more little hack for light view & project matrix
-		cpyTransInfo.m_viewMatrix = lightViewMatrix;
-		cpyTransInfo.m_projectMatrix = ShadowMap::shared()->getLightProjectionMatrix(index);
-		  
-		applyTransform(program, cpyTransInfo);
+		applyTransform(program, command.m_transInfo, lightPass);
 		
-		auto lightWVP = ShadowMap::shared()->getLightProjectionMatrix(index) * (lightViewMatrix * cpyTransInfo.m_worldMatrix);
+		auto lightWVP = lightPass.m_projectMatrix * (lightViewMatrix * command.m_transInfo.m_worldMatrix);
 		program->setUniformMat4v("TU_lightWVP", lightWVP.data());
 		RenderBackEnd::shared()->setDepthMaskWriteEnable(true);
 		RenderBackEnd::shared()->setDepthTestEnable(true);
-		renderPrimitveInstanced(command.m_instancedMesh, command.m_material, command.m_primitiveType, program);
+		renderPrimitveInstanced(command.m_instancedMesh, command.getInstanceBegin(), command.getInstanceCount(), command.m_material, command.m_primitiveType, program);
 	}
 	else
 	{
@@ -269,16 +274,8 @@ void Renderer::renderShadow(RenderCommand &command,int index, const Matrix44 & l
 		// ShadowMap::shared()->getProgram()->use();
 		applyRenderSetting(command.m_material);
 		  
-		auto cpyTransInfo = command.m_transInfo;
-		  
-		// one more little hack for light view & project matrix
-		cpyTransInfo.m_viewMatrix = lightViewMatrix;
-		cpyTransInfo.m_projectMatrix = ShadowMap::shared()->getLightProjectionMatrix(index);
-
 		//no need to apply other matrix just use TU_lightWVP
-		// applyTransform(ShadowMap::shared()->getProgram(), cpyTransInfo);
-
-		auto lightWVP = ShadowMap::shared()->getLightProjectionMatrix(index) * (lightViewMatrix * cpyTransInfo.m_worldMatrix);
+		auto lightWVP = ShadowMap::shared()->getLightProjectionMatrix(index) * (lightViewMatrix * command.m_transInfo.m_worldMatrix);
 		ShadowMap::shared()->getProgram()->setUniformMat4v("TU_lightWVP", lightWVP.data());
 		RenderBackEnd::shared()->setDepthMaskWriteEnable(true);
 		RenderBackEnd::shared()->setDepthTestEnable(true);
@@ -316,10 +313,10 @@ void Renderer::render(const RenderCommand &command)
 {
 	command.m_material->use();
 	applyRenderSetting(command.m_material);
-	applyTransform(command.m_material->getProgram(), command.m_transInfo, true);
+	applyTransform(command.m_material->getProgram(), command.m_transInfo, m_passTransformation, true);
 	if (command.batchType() == RenderCommand::RenderBatchType::Instanced)
 	{
-		renderPrimitveInstanced(command.m_instancedMesh, command.m_material, command.m_primitiveType);
+		renderPrimitveInstanced(command.m_instancedMesh, command.getInstanceBegin(), command.getInstanceCount(), command.m_material, command.m_primitiveType);
 	}
 	else
 	{
@@ -347,7 +344,7 @@ void Renderer::renderPrimitive(Mesh * mesh, Material * effect,RenderCommand::Pri
 	  
 	// Tell OpenGL programmable pipeline how to locate vertex position data
 
-	setVertexAttribute(program);
+	setVertexAttribute(program, mesh->getVertexFormat());
 	switch(primitiveType)
 	{
 		case RenderCommand::PrimitiveType::Lines:
@@ -365,7 +362,7 @@ void Renderer::renderPrimitive(Mesh * mesh, Material * effect,RenderCommand::Pri
 	}
 }
 #define RAISE error = glGetError();tlogError("raise error %d\n",error);
-void Renderer::renderPrimitveInstanced(InstancedMesh * instancedMesh, Material * effect, RenderCommand::PrimitiveType primitiveType, ShaderProgram * extraProgram)
+void Renderer::renderPrimitveInstanced(InstancedMesh * instancedMesh, int instanceBegin, int instanceCount, Material * effect, RenderCommand::PrimitiveType primitiveType, ShaderProgram * extraProgram)
 {
 	auto program = effect->getProgram();
 	if (extraProgram)
@@ -386,6 +383,8 @@ void Renderer::renderPrimitveInstanced(InstancedMesh * instancedMesh, Material *
 	//instanced part
 	instancedMesh->getInstanceBuf()->use();
 	RenderBackEnd::shared()->selfCheck();
+	//the instance attributes start at the first instance of the range, so no base instance is needed
+	int instanceOffset = instanceBegin * sizeof(InstanceData);
 	int grassOffsetLocation = program->attributeLocation("a_instance_offset");
 	if(grassOffsetLocation >0)
 	{
@@ -393,10 +392,10 @@ void Renderer::renderPrimitveInstanced(InstancedMesh * instancedMesh, Material *
 		program->enableAttributeArray(grassOffsetLocation + 1);
 		program->enableAttributeArray(grassOffsetLocation + 2);
 		program->enableAttributeArray(grassOffsetLocation + 3);
-		program->setAttributeBuffer(grassOffsetLocation, GL_FLOAT, 0, 4, sizeof(InstanceData));
-		program->setAttributeBuffer(grassOffsetLocation + 1, GL_FLOAT, 4 * sizeof( GLfloat), 4, sizeof(InstanceData));
-		program->setAttributeBuffer(grassOffsetLocation + 2, GL_FLOAT, 8 * sizeof(GLfloat), 4, sizeof(InstanceData));
-		program->setAttributeBuffer(grassOffsetLocation + 3, GL_FLOAT, 12 * sizeof(GLfloat), 4, sizeof(InstanceData));
+		program->setAttributeBuffer(grassOffsetLocation, GL_FLOAT, instanceOffset, 4, sizeof(InstanceData));
+		program->setAttributeBuffer(grassOffsetLocation + 1, GL_FLOAT, instanceOffset + 4 * sizeof( GLfloat), 4, sizeof(InstanceData));
+		program->setAttributeBuffer(grassOffsetLocation + 2, GL_FLOAT, instanceOffset + 8 * sizeof(GLfloat), 4, sizeof(InstanceData));
+		program->setAttributeBuffer(grassOffsetLocation + 3, GL_FLOAT, instanceOffset + 12 * sizeof(GLfloat), 4, sizeof(InstanceData));
 		glVertexAttribDivisor(grassOffsetLocation, 1);
 		glVertexAttribDivisor(grassOffsetLocation + 1, 1);
 		glVertexAttribDivisor(grassOffsetLocation + 2, 1);
@@ -411,14 +410,14 @@ void Renderer::renderPrimitveInstanced(InstancedMesh * instancedMesh, Material *
 	if(extraInstanceOffsetLocation > 0)
 	{
 		program->enableAttributeArray(extraInstanceOffsetLocation);
-		program->setAttributeBuffer(extraInstanceOffsetLocation, GL_FLOAT, offsetof(InstanceData, extraInfo.x), 4, sizeof(InstanceData));
+		program->setAttributeBuffer(extraInstanceOffsetLocation, GL_FLOAT, instanceOffset + offsetof(InstanceData, extraInfo.x), 4, sizeof(InstanceData));
 		glVertexAttribDivisor(extraInstanceOffsetLocation, 1);
 	}
 	
 	switch (primitiveType)
 	{
 	case RenderCommand::PrimitiveType::TRIANGLES:
-		RenderBackEnd::shared()->drawElementInstanced(RenderFlag::IndicesType::Triangles, mesh->getIndicesSize(), 0, instancedMesh->getInstanceSize());
+		RenderBackEnd::shared()->drawElementInstanced(RenderFlag::IndicesType::Triangles, mesh->getIndicesSize(), 0, instanceCount);
 		break;
 	case RenderCommand::PrimitiveType::Lines: break;
 	case RenderCommand::PrimitiveType::TRIANGLE_STRIP: break;
@@ -651,8 +650,13 @@ void Renderer::updateThumbNail(ThumbNail* thumb)
 	m_thumbNailList.push_back(thumb);
 }
 
-void Renderer::setVertexAttribute(ShaderProgram* program)
+void Renderer::setVertexAttribute(ShaderProgram* program, RenderFlag::VertexFormat format)
 {
+	if (format == RenderFlag::VertexFormat::Terrain)
+	{
+		setTerrainVertexAttribute(program);
+		return;
+	}
 	int vertexLocation = program->attributeLocation("a_position");
 	  
 	program->enableAttributeArray(vertexLocation);
@@ -710,6 +714,36 @@ void Renderer::setVertexAttribute(ShaderProgram* program)
 	}
 }
 
+void Renderer::setTerrainVertexAttribute(ShaderProgram* program)
+{
+	// the quantized position is converted to float as is, the model matrix carries Mesh::getPackedTransform,
+	// so the depth and shadow programs which only read a_position work unchanged
+	int vertexLocation = program->attributeLocation("a_position");
+	program->enableAttributeArray(vertexLocation);
+	program->setAttributeBuffer(vertexLocation, GL_UNSIGNED_SHORT, offsetof(TerrainVertex, m_pos), 3, sizeof(TerrainVertex));
+	int normalLocation = program->attributeLocation("a_packedNormal");
+	if (normalLocation > 0)
+	{
+		program->enableAttributeArray(normalLocation);
+		program->setAttributeBuffer(normalLocation, GL_SHORT, offsetof(TerrainVertex, m_normal), 2, sizeof(TerrainVertex), true);
+	}
+	int matLocation = program->attributeLocation("a_mat");
+	if (matLocation > 0)
+	{
+		program->enableAttributeArray(matLocation);
+		program->setAttributeBufferInt(matLocation, GL_UNSIGNED_BYTE, offsetof(TerrainVertex, m_mat), 4, sizeof(TerrainVertex));
+	}
+	// the standard attributes a program may still declare would read past the packed vertex
+	for (auto name : {"a_normal", "a_texcoord", "a_color", "a_bc", "a_matBlend", "a_tangent"})
+	{
+		int location = program->attributeLocation(name);
+		if (location > 0)
+		{
+			program->disableAttributeArray(location);
+		}
+	}
+}
+
 std::vector<ThumbNail*>& Renderer::getThumbNailList()
 {
 	return m_thumbNailList;
@@ -800,7 +834,8 @@ void Renderer::skyBoxPass()
 
 			TransformationInfo info;
 			Sky::shared()->setUpTransFormation(info);
-			applyTransform(mat->getProgram(), info);
+			setPassCamera(g_GetCurrScene()->defaultCamera());
+			applyTransform(mat->getProgram(), info, m_passTransformation);
 			Sky::shared()->prepare();
 			renderPrimitive(Sky::shared()->getMesh(), mat, RenderCommand::PrimitiveType::TRIANGLES);
 			RenderBackEnd::shared()->setIsCullFace(true);
@@ -817,7 +852,8 @@ void Renderer::skyBoxPass()
 			mat->setVar("TU_winSize", Engine::shared()->winSize());
 			TransformationInfo info;
 			skyBox->setUpTransFormation(info);
-			applyTransform(mat->getProgram(), info);
+			setPassCamera(g_GetCurrScene()->defaultCamera());
+			applyTransform(mat->getProgram(), info, m_passTransformation);
 			renderPrimitive(skyBox->skyBoxMesh(), mat, RenderCommand::PrimitiveType::TRIANGLES);
 		}
 	}
@@ -1236,11 +1272,11 @@ void Renderer::applyRenderSetting(Material * mat)
 	RenderBackEnd::shared()->setDepthTestEnable(mat->isIsDepthTestEnable());
 }
 
-void Renderer::applyTransform(ShaderProgram *program, const TransformationInfo &info, bool isHackingWV)
+void Renderer::applyTransform(ShaderProgram *program, const TransformationInfo &info, const PassTransformation &pass, bool isHackingWV)
 {
 	program->use();
-	auto p = info.m_projectMatrix;
-	auto v = info.m_viewMatrix;
+	auto p = pass.m_projectMatrix;
+	auto v = pass.m_viewMatrix;
 	auto m = info.m_worldMatrix;
 	auto vp = p * v;
 	auto mv = v *m;
@@ -1255,6 +1291,12 @@ void Renderer::applyTransform(ShaderProgram *program, const TransformationInfo &
 	program->setUniformMat4v("TU_normalMatrix", (m).inverted().transpose().data());
 }
 
+void Renderer::setPassCamera(Camera* camera)
+{
+	m_passTransformation.m_viewMatrix = camera->getViewMatrix();
+	m_passTransformation.m_projectMatrix = camera->projection();
+}
+
 void Renderer::toneMappingPass()
 {
 	if(m_aaEnable)
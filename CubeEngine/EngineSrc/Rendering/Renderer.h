@@ -8,6 +8,7 @@
 namespace tzw {
 class Mesh;
 class ThumbNail;
+class Camera;
 class Renderer
 {
 public:
@@ -25,7 +26,8 @@ public:
     void clearCommands();
     void render(const RenderCommand &command);
     void renderPrimitive(Mesh * mesh, Material *effect, RenderCommand::PrimitiveType primitiveType, ShaderProgram * extraProgram = nullptr);
-	void renderPrimitveInstanced(InstancedMesh * instancedMesh, Material *effect, RenderCommand::PrimitiveType primitiveType, ShaderProgram * extraProgram = nullptr);
+	//draws the instances [instanceBegin, instanceBegin + instanceCount) of instancedMesh
+	void renderPrimitveInstanced(InstancedMesh * instancedMesh, int instanceBegin, int instanceCount, Material *effect, RenderCommand::PrimitiveType primitiveType, ShaderProgram * extraProgram = nullptr);
     bool enable3DRender() const;
     void setEnable3DRender(bool enable3DRender);
 
@@ -49,7 +51,8 @@ public:
 	void initBuffer();
 	void onChangeScreenSize(int newW, int newH);
 	void updateThumbNail(ThumbNail * thumb);
-	void setVertexAttribute(ShaderProgram * program);
+	void setVertexAttribute(ShaderProgram * program, RenderFlag::VertexFormat format = RenderFlag::VertexFormat::Standard);
+	void setTerrainVertexAttribute(ShaderProgram * program);
 
 	std::vector<ThumbNail *> & getThumbNailList();
 private:
@@ -76,7 +79,8 @@ private:
 	void autoExposurePass();
 	void AAPass();
 	void applyRenderSetting(Material * effect);
-    void applyTransform(ShaderProgram * shader, const TransformationInfo & info, bool isHackingWV = false);
+    void applyTransform(ShaderProgram * shader, const TransformationInfo & info, const PassTransformation & pass, bool isHackingWV = false);
+	void setPassCamera(Camera * camera);
 	void toneMappingPass();
 	void bindScreenForWriting();
 	void copyToFrame(FrameBuffer * bufferSrc, FrameBuffer *bufferDst, Material * mat);
@@ -127,6 +131,8 @@ private:
 	bool m_aaEnable;
 	bool m_shadowEnable;
 	std::vector<ThumbNail *> m_thumbNailList;
+	//view and projection of the list being rendered
+	PassTransformation m_passTransformation;
 	
 public:
 	bool isShadowEnable() const;
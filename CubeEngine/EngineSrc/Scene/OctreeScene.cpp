@@ -4,194 +4,293 @@
 #include "../base/Camera.h"
 #include <cassert>
 #include "3D/Primitive/CubePrimitive.h"
-#define MAX_DEEP 5
+#include "Engine/WorkerThreadSystem.h"
+#define MAX_DEEP 6
+//how far the loose bounding grows out of the cell on each side, relative to the cell size
+#define OCTREE_LOOSENESS 0.125f
+//every level pushes at most 7 siblings
+#define OCTREE_STACK_SIZE (MAX_DEEP * 7 + 1)
+//the nodes of this level are the subtrees cullingViews hands out to the workers
+#define OCTREE_TASK_DEPTH 2
 namespace tzw {
-static int g_nodeIndex = 0;
-void OctreeNode::genId()
-{
-	m_index = g_nodeIndex;
-	g_nodeIndex += 1;
-}
 OctreeNode::OctreeNode()
 {
     for(int i =0;i<8;i++)
     {
-        m_child[i] = nullptr;
+        m_child[i] = -1;
     }
-	genId();
+	m_parent = -1;
+	m_childCount = 0;
+	m_depth = 0;
+	m_index = -1;
 }
 
-OctreeScene::OctreeScene(): m_root(nullptr)
+static bool isContain(const AABB & outer, const AABB & inner)
 {
+	vec3 outerMin = outer.min(), outerMax = outer.max();
+	vec3 innerMin = inner.min(), innerMax = inner.max();
+	return outerMin.x <= innerMin.x && outerMin.y <= innerMin.y && outerMin.z <= innerMin.z
+		&& outerMax.x >= innerMax.x && outerMax.y >= innerMax.y && outerMax.z >= innerMax.z;
 }
 
-void OctreeScene::init(AABB range)
+static bool isOverlap(const AABB & a, const AABB & b)
 {
-    m_root = new OctreeNode();
-    m_root->aabb = range;
-	m_nodeList.push_back(m_root);
-    subDivide(m_root,1);
+	vec3 aMin = a.min(), aMax = a.max();
+	vec3 bMin = b.min(), bMax = b.max();
+	return aMin.x <= bMax.x && bMin.x <= aMax.x
+		&& aMin.y <= bMax.y && bMin.y <= aMax.y
+		&& aMin.z <= bMax.z && bMin.z <= aMax.z;
 }
 
-void OctreeScene::subDivide(OctreeNode *node, int level)
+OctreeScene::OctreeScene(): m_root(-1), m_nodeCount(0), m_objCount(0)
 {
-    if(level> MAX_DEEP) {return;}
-    auto subAABBList = node->aabb.split8();
-    for(int i =0;i<8;i++)
-    {
-		auto child = new OctreeNode();
-		m_nodeList.push_back(child);
-        child->aabb = subAABBList[i];
-		node->m_child[i] = child;
-        subDivide(child,level + 1 );
-    }
 }
 
-std::vector<Drawable3D *> &OctreeScene::getVisibleList()
+void OctreeScene::init(AABB range)
 {
-    return m_visibleList;
+    m_rangeMin = range.min();
+    m_rangeSize = range.max() - range.min();
+    m_root = allocNode(-1, 0, m_rangeMin);
 }
 
-bool OctreeScene::isInOctree(Drawable3D * obj)
+vec3 OctreeScene::getCellSize(int depth) const
 {
-	return m_objSet.find(obj) != m_objSet.end();
+	return m_rangeSize * (1.0f / float(1 << depth));
 }
 
-OctreeNode* OctreeScene::getNodeByIndex(int index)
+int OctreeScene::allocNode(int parent, int depth, const vec3& cellMin)
 {
-	return m_nodeList[index];
+	int index;
+	if(!m_freeList.empty())
+	{
+		index = m_freeList.back();
+		m_freeList.pop_back();
+	}
+	else
+	{
+		index = int(m_nodeList.size());
+		m_nodeList.emplace_back();
+	}
+	OctreeNode & node = m_nodeList[index];
+	for(int i = 0; i < 8; i++)
+	{
+		node.m_child[i] = -1;
+	}
+	node.m_parent = parent;
+	node.m_childCount = 0;
+	node.m_depth = depth;
+	node.m_index = index;
+	vec3 cellSize = getCellSize(depth);
+	node.aabb.reset();
+	node.aabb.update(cellMin - cellSize * OCTREE_LOOSENESS);
+	node.aabb.update(cellMin + cellSize * (1.0f + OCTREE_LOOSENESS));
+	m_nodeCount++;
+	return index;
 }
 
-void OctreeScene::addObj(Drawable3D *obj)
+void OctreeScene::releaseEmptyNode(int index)
 {
-    auto result = addObj_R(m_root,obj);
-    if(result)
-    {
-		m_objSet.insert(obj);
-	}else
+	// walk up as long as the nodes are left empty, the root always stays
+	while(index != m_root)
 	{
-		//printf("can't add Object\n");
-		//assert(0);
+		OctreeNode & node = m_nodeList[index];
+		if(!node.m_drawlist.empty() || node.m_childCount > 0)
+		{
+			return;
+		}
+		int parent = node.m_parent;
+		OctreeNode & parentNode = m_nodeList[parent];
+		for(int i = 0; i < 8; i++)
+		{
+			if(parentNode.m_child[i] == index)
+			{
+				parentNode.m_child[i] = -1;
+				break;
+			}
+		}
+		parentNode.m_childCount--;
+		node.m_index = -1;
+		m_freeList.push_back(index);
+		m_nodeCount--;
+		index = parent;
 	}
 }
 
-bool OctreeScene::addObj_R(OctreeNode *node, Drawable3D *obj)
+bool OctreeScene::findCell(AABB& objAABB, int& depth, int cell[3])
 {
-    if(node->aabb.isCanCotain(obj->getAABB()))
-    {
-        if(!node->m_child[0])//terminal node
-        {
-            node->m_drawlist.push_back(obj);
-			obj->setOctNodeIndex(node->m_index);
-            return true;
-        }else {
-            for(int i =0;i<8;i++)
-            {
-                if(addObj_R(node->m_child[i],obj))
-                {
-                    return true;
-                }
-            }
-			// the children can containt that ,so we only can put it in parent.
-			node->m_drawlist.push_back(obj);
-			return true;
-        }
-    }
-    return false;
+	vec3 objMin = objAABB.min();
+	vec3 objSize = objAABB.max() - objMin;
+	vec3 centre = objAABB.centre();
+	vec3 local = centre - m_rangeMin;
+	depth = 0;
+	cell[0] = cell[1] = cell[2] = 0;
+	if(local.x < 0.0f || local.y < 0.0f || local.z < 0.0f
+		|| local.x >= m_rangeSize.x || local.y >= m_rangeSize.y || local.z >= m_rangeSize.z)
+	{
+		// out of range, only the loose bounding of the root could hold it
+		return isContain(m_nodeList[m_root].aabb, objAABB);
+	}
+	while(depth < MAX_DEEP)
+	{
+		vec3 childSize = getCellSize(depth + 1) * (2.0f * OCTREE_LOOSENESS);
+		if(objSize.x > childSize.x || objSize.y > childSize.y || objSize.z > childSize.z)
+		{
+			break;
+		}
+		depth++;
+	}
+	if(depth == 0)
+	{
+		return isContain(m_nodeList[m_root].aabb, objAABB);
+	}
+	vec3 cellSize = getCellSize(depth);
+	int maxCell = (1 << depth) - 1;
+	cell[0] = std::min(int(local.x / cellSize.x), maxCell);
+	cell[1] = std::min(int(local.y / cellSize.y), maxCell);
+	cell[2] = std::min(int(local.z / cellSize.z), maxCell);
+	return true;
 }
 
-void OctreeScene::removeObj(Drawable3D *obj)
+std::vector<Drawable3D *> &OctreeScene::getVisibleList()
+{
+    return m_visibleList;
+}
+
+bool OctreeScene::isInOctree(Drawable3D * obj)
 {
-    removeObj_R(m_root,obj);
+	return obj->getOctNodeIndex() >= 0;
+}
 
-	{	
-		auto iter = m_objMap.find(obj);
-		if (iter != m_objMap.end())
-		{
-			m_objMap.erase(iter);
-		}
-	}
+OctreeNode* OctreeScene::getNodeByIndex(int index)
+{
+	return &m_nodeList[index];
+}
 
-	{	
-		auto iter = m_objSet.find(obj);
-		if (iter != m_objSet.end())
+int OctreeScene::getNodeCount() const
+{
+	return m_nodeCount;
+}
+
+void OctreeScene::addObj(Drawable3D *obj)
+{
+	if(obj->getOctNodeIndex() >= 0)
+	{
+		unlinkObj(obj);
+	}
+	AABB objAABB = obj->getAABB();
+	int depth;
+	int cell[3];
+	if(!findCell(objAABB, depth, cell))
+	{
+		//printf("can't add Object\n");
+		return;
+	}
+	// descend from the root and create the missing nodes on the way
+	int index = m_root;
+	for(int d = 1; d <= depth; d++)
+	{
+		int shift = depth - d;
+		int childCell[3] = {cell[0] >> shift, cell[1] >> shift, cell[2] >> shift};
+		int childId = (childCell[0] & 1) | ((childCell[1] & 1) << 1) | ((childCell[2] & 1) << 2);
+		int child = m_nodeList[index].m_child[childId];
+		if(child < 0)
 		{
-			m_objSet.erase(iter);
+			vec3 cellSize = getCellSize(d);
+			vec3 cellMin = m_rangeMin + vec3(childCell[0] * cellSize.x, childCell[1] * cellSize.y, childCell[2] * cellSize.z);
+			child = allocNode(index, d, cellMin);
+			m_nodeList[index].m_child[childId] = child;
+			m_nodeList[index].m_childCount++;
 		}
+		index = child;
 	}
-
+	OctreeNode & node = m_nodeList[index];
+	obj->setOctNodeIndex(index);
+	obj->setOctSlot(int(node.m_drawlist.size()));
+	node.m_drawlist.push_back(obj);
+	m_objCount++;
 }
 
-bool OctreeScene::removeObj_R(OctreeNode *node, Drawable3D *obj)
+void OctreeScene::removeObj(Drawable3D *obj)
 {
-    auto result = std::find(node->m_drawlist.begin(),node->m_drawlist.end(),obj);
-    if(result != node->m_drawlist.end())
-    {
-        node->m_drawlist.erase(result);
-        return true;
-    }else
-    {
-        if(!node->m_child[0]) return false;//terminal node.
-
-        for(int i =0;i<8;i++)
-        {
-            if(removeObj_R(node->m_child[i],obj))
-            {
-                return true;
-            }
-        }
-        return false;
-    }
+	if(obj->getOctNodeIndex() < 0)
+	{
+		return;
+	}
+	unlinkObj(obj);
+	obj->onRemovedFromOctree();
 }
 
-bool OctreeScene::hitByRay_R(OctreeNode *node, const Ray &ray, vec3 &hitPoint)
+void OctreeScene::unlinkObj(Drawable3D *obj)
 {
-    vec3 result;
-    if(ray.intersectAABB(node->aabb,nullptr,result))
-    {
-        //check self
-        for(int i =0;i<node->m_drawlist.size();i++)
-        {
-            Drawable3D * obj = node->m_drawlist[i];
-            if(ray.intersectAABB(obj->getAABB(),nullptr,hitPoint))
-            {
-                return true;
-            }
-        }
-        //check sub
-        if(!node->m_child[0]) return false; // is terminal
-        for(int i = 0;i<8;i++)
-        {
-            if(hitByRay_R(node->m_child[i],ray,hitPoint))
-            {
-                return true;
-            }
-        }
-        return false;
-    }else
-    {
-        return false;
-    }
+	int index = obj->getOctNodeIndex();
+	// swap with the last one, the slot of that object is patched
+	auto & drawList = m_nodeList[index].m_drawlist;
+	int slot = obj->getOctSlot();
+	assert(slot < int(drawList.size()) && drawList[slot] == obj);
+	Drawable3D * last = drawList.back();
+	drawList[slot] = last;
+	last->setOctSlot(slot);
+	drawList.pop_back();
+	obj->setOctNodeIndex(-1);
+	obj->setOctSlot(-1);
+	m_objCount--;
+	releaseEmptyNode(index);
 }
 
 void OctreeScene::updateObj(Drawable3D *obj)
 {
-	if(obj->getOctNodeIndex() >= 0)
+	int index = obj->getOctNodeIndex();
+	if(index >= 0)
 	{
-		auto node = getNodeByIndex(obj->getOctNodeIndex());
-		if(node->aabb.isCanCotain(obj->getAABB()))// no need to update;
+		const OctreeNode & node = m_nodeList[index];
+		AABB objAABB = obj->getAABB();
+		if(isContain(node.aabb, objAABB))
 		{
-			return;
+			// still in the loose bounding, only move it when it became small enough for a deeper level
+			if(node.m_depth == MAX_DEEP)
+			{
+				return;
+			}
+			vec3 objSize = objAABB.max() - objAABB.min();
+			vec3 childSize = getCellSize(node.m_depth + 1) * (2.0f * OCTREE_LOOSENESS);
+			if(objSize.x > childSize.x || objSize.y > childSize.y || objSize.z > childSize.z)
+			{
+				return;
+			}
 		}
 	}
-	
-    removeObj(obj);
     addObj(obj);
 }
 
 bool OctreeScene::hitByRay(const Ray &ray, vec3 &hitPoint)
 {
-    return hitByRay_R(m_root,ray,hitPoint);
+	int stack[OCTREE_STACK_SIZE];
+	int top = 0;
+	stack[top++] = m_root;
+	while(top > 0)
+	{
+		const OctreeNode & node = m_nodeList[stack[--top]];
+		vec3 result;
+		if(!ray.intersectAABB(node.aabb, nullptr, result))
+		{
+			continue;
+		}
+		for(auto obj : node.m_drawlist)
+		{
+			if(ray.intersectAABB(obj->getAABB(), nullptr, hitPoint))
+			{
+				return true;
+			}
+		}
+		for(int i = 7; i >= 0; i--)
+		{
+			if(node.m_child[i] >= 0)
+			{
+				stack[top++] = node.m_child[i];
+			}
+		}
+	}
+	return false;
 }
 
 void OctreeScene::cullingByCamera(Camera *camera)
@@ -203,103 +302,228 @@ void OctreeScene::cullingByCamera(Camera *camera)
 
 void OctreeScene::cullingByCameraExtraFlag(Camera* camera, uint32_t flags, std::vector<Drawable3D*>& resultList)
 {
-	cullingByCameraFlag_R(m_root,camera, flags, resultList);
-    //auto test = [camera](const AABB& targetAABB){return !camera->isOutOfFrustum(targetAABB);};
-	//cullingImp_R(m_root,flags, &resultList,test);
+	// the lowest bit marks a node which is completely inside, its subtree skips the frustum tests
+	int stack[OCTREE_STACK_SIZE];
+	int top = 0;
+	stack[top++] = m_root << 1;
+	while(top > 0)
+	{
+		int item = stack[--top];
+		const OctreeNode & node = m_nodeList[item >> 1];
+		bool isInside = (item & 1) != 0;
+		if(!isInside)
+		{
+			if(camera->isOutOfFrustum(node.aabb))
+			{
+				continue;
+			}
+			isInside = camera->isInsideFrustum(node.aabb);
+		}
+		for(auto obj : node.m_drawlist)
+		{
+			if((obj->getDrawableFlag() & flags) && (isInside || !camera->isOutOfFrustum(obj->getAABB())))
+			{
+				resultList.push_back(obj);
+			}
+		}
+		for(int i = 0; i < 8; i++)
+		{
+			if(node.m_child[i] >= 0)
+			{
+				stack[top++] = (node.m_child[i] << 1) | int(isInside);
+			}
+		}
+	}
 }
 
 void OctreeScene::getRange(std::vector<Drawable3D *> *list, uint32_t flags, AABB aabb)
 {
-    auto test = [&aabb](const AABB& targetAABB){vec3 noNeedVar; return aabb.isIntersect(targetAABB, noNeedVar);};
-    cullingImp_R(m_root,flags, list,test);
+    auto test = [&aabb](const AABB& targetAABB){return isOverlap(aabb, targetAABB);};
+    cullingImp(flags, list, test);
 }
 
 int OctreeScene::getAmount()
 {
-    return getAmount_R(m_root);
+    return m_objCount;
 }
 
-int OctreeScene::getAmount_R(OctreeNode *node)
+void OctreeScene::cullingImp(uint32_t flags,  std::vector<Drawable3D *> *list, const std::function<bool(const AABB&)>& testFunc)
 {
-    int the_size = node->m_drawlist.size();
-    if(!node->m_child[0]) return the_size;
-    for(int i =0;i<8;i++)
-    {
-        the_size += getAmount_R(node->m_child[i]);
-    }
-    return the_size;
+	int stack[OCTREE_STACK_SIZE];
+	int top = 0;
+	stack[top++] = m_root;
+	while(top > 0)
+	{
+		const OctreeNode & node = m_nodeList[stack[--top]];
+		if(!testFunc(node.aabb))
+		{
+			continue;
+		}
+		for(auto drawObj : node.m_drawlist)
+		{
+			if((drawObj->getDrawableFlag() & flags) && testFunc(drawObj->getAABB()))
+			{
+				list->push_back(drawObj);
+			}
+		}
+		for(int i = 0; i < 8; i++)
+		{
+			if(node.m_child[i] >= 0)
+			{
+				stack[top++] = node.m_child[i];
+			}
+		}
+	}
 }
-static Camera * currentCamera = nullptr;
-static int compare(const void * a, const void * b)
+
+void OctreeScene::cullingViews(const std::vector<OctreeCullingView>& views, std::vector<OctreeCullingResult>& resultList)
 {
-	auto nodeA = (OctreeNode *)a;
-	auto nodeB = (OctreeNode *)b;
-    auto vA = nodeA->aabb.centre() - currentCamera->getPos();
-    auto vB = nodeB->aabb.centre() - currentCamera->getPos();
-    auto distA  = fabs(vA.x) + fabs(vA.y) + fabs(vA.z);
-    auto distB  = fabs(vB.x) + fabs(vB.y) + fabs(vB.z);
-    if(distA > distB)
-    {
-        return 1;
-    }
-    else if(fabs(distA  - distB) < 0.00001)
-    {
-        return 0;
-    }else
-    {
-        return -1;
-    }
+	resultList.clear();
+	m_cullingTaskList.clear();
+	if(views.empty() || views.size() > 32)
+	{
+		return;
+	}
+	// the top levels are walked here, every node at OCTREE_TASK_DEPTH becomes a task of its own
+	uint32_t allMask = views.size() == 32 ? 0xffffffffu : (1u << views.size()) - 1;
+	CullingTask stack[OCTREE_STACK_SIZE];
+	int top = 0;
+	stack[top++] = {m_root, allMask, 0};
+	while(top > 0)
+	{
+		CullingTask task = stack[--top];
+		const OctreeNode & node = m_nodeList[task.m_node];
+		if(node.m_depth == OCTREE_TASK_DEPTH)
+		{
+			m_cullingTaskList.push_back(task);
+			continue;
+		}
+		if(!cullingNode(views, node, task, resultList))
+		{
+			continue;
+		}
+		for(int i = 0; i < 8; i++)
+		{
+			if(node.m_child[i] >= 0)
+			{
+				stack[top++] = {node.m_child[i], task.m_testMask, task.m_insideMask};
+			}
+		}
+	}
+	// every task writes its own list, they are merged in order so the result doesn't depend on the scheduling
+	if(m_cullingTaskResult.size() < m_cullingTaskList.size())
+	{
+		m_cullingTaskResult.resize(m_cullingTaskList.size());
+	}
+	WorkerThreadSystem::shared()->parallelFor(int(m_cullingTaskList.size()), [this, &views](int index)
+	{
+		auto & taskResult = m_cullingTaskResult[index];
+		taskResult.clear();
+		cullingSubtree(views, m_cullingTaskList[index], taskResult);
+	});
+	for(size_t i = 0; i < m_cullingTaskList.size(); i++)
+	{
+		resultList.insert(resultList.end(), m_cullingTaskResult[i].begin(), m_cullingTaskResult[i].end());
+	}
 }
 
-void OctreeScene::cullingByCameraFlag_R(OctreeNode* node, Camera* camera, uint32_t flags, std::vector<Drawable3D*>& resultList)
+bool OctreeScene::cullingNode(const std::vector<OctreeCullingView>& views, const OctreeNode& node, CullingTask& task, std::vector<OctreeCullingResult>& resultList)
 {
-	if(!camera->isOutOfFrustum(node->aabb))
-    {
-        for(int i=0;i<node->m_drawlist.size();i++)
-        {
-            Drawable3D * obj = node->m_drawlist[i];
-            if(!camera->isOutOfFrustum(obj->getAABB()))
-            {
-            	if(obj->getDrawableFlag() & flags)
-            	{
-            		resultList.push_back (obj);
-            	}
-            }
-        }
-        if(!node->m_child[0]) return;//terminal node return directly
-        for(int i=0;i<8;i++)
-        {
-            cullingByCameraFlag_R(node->m_child[i],camera, flags, resultList);
-        }
-    }
+	int viewCount = int(views.size());
+	for(int i = 0; i < viewCount; i++)
+	{
+		uint32_t bit = 1u << i;
+		if(!(task.m_testMask & bit))
+		{
+			continue;
+		}
+		const OctreeCullingView & view = views[i];
+		bool isOut, isInside;
+		if(view.m_camera)
+		{
+			isOut = view.m_camera->isOutOfFrustum(node.aabb);
+			isInside = !isOut && view.m_camera->isInsideFrustum(node.aabb);
+		}
+		else
+		{
+			isOut = !isOverlap(view.m_range, node.aabb);
+			isInside = !isOut && isContain(view.m_range, node.aabb);
+		}
+		if(isOut || isInside)
+		{
+			task.m_testMask &= ~bit;
+		}
+		if(isInside)
+		{
+			task.m_insideMask |= bit;
+		}
+	}
+	if(!(task.m_testMask | task.m_insideMask))
+	{
+		return false;
+	}
+	for(auto obj : node.m_drawlist)
+	{
+		uint32_t objFlags = obj->getDrawableFlag();
+		uint32_t viewMask = 0;
+		AABB objAABB;
+		bool isAABBCached = false;
+		for(int i = 0; i < viewCount; i++)
+		{
+			uint32_t bit = 1u << i;
+			const OctreeCullingView & view = views[i];
+			if(!(view.m_flags & objFlags))
+			{
+				continue;
+			}
+			if(task.m_insideMask & bit)
+			{
+				viewMask |= bit;
+			}
+			else if(task.m_testMask & bit)
+			{
+				if(!isAABBCached)
+				{
+					objAABB = obj->getAABB();
+					isAABBCached = true;
+				}
+				bool isVisible = view.m_camera ? !view.m_camera->isOutOfFrustum(objAABB) : isOverlap(view.m_range, objAABB);
+				if(isVisible)
+				{
+					viewMask |= bit;
+				}
+			}
+		}
+		if(viewMask)
+		{
+			resultList.push_back({obj, viewMask});
+		}
+	}
+	return true;
 }
 
-void OctreeScene::cullingImp_R(OctreeNode *node, uint32_t flags,  std::vector<Drawable3D *> *list, const std::function<bool(const AABB&)>& testFunc)
+void OctreeScene::cullingSubtree(const std::vector<OctreeCullingView>& views, const CullingTask& rootTask, std::vector<OctreeCullingResult>& resultList)
 {
-	if(testFunc(node->aabb))
-    {
-        //put self
-        for(auto drawObj : node->m_drawlist)
-        {
-            if(drawObj->getDrawableFlag() & flags)
-            {
-        		if(testFunc(drawObj->getAABB()))
-	            {
-	                list->push_back(drawObj);
-	            }
-            }
-        }
-        //check sub
-        if(!node->m_child[0]) return;
-        for(int i =0;i<8;i++)
-        {
-            cullingImp_R(node->m_child[i], flags, list, testFunc);
-        }
-    }
+	CullingTask stack[OCTREE_STACK_SIZE];
+	int top = 0;
+	stack[top++] = rootTask;
+	while(top > 0)
+	{
+		CullingTask task = stack[--top];
+		const OctreeNode & node = m_nodeList[task.m_node];
+		if(!cullingNode(views, node, task, resultList))
+		{
+			continue;
+		}
+		for(int i = 0; i < 8; i++)
+		{
+			if(node.m_child[i] >= 0)
+			{
+				stack[top++] = {node.m_child[i], task.m_testMask, task.m_insideMask};
+			}
+		}
+	}
 }
 
-
-
-
 } // namespace tzw
 
@@ -5,21 +5,42 @@
 
 #include "../Math/AABB.h"
 #include "../Math/Ray.h"
-#include <unordered_set>
-#include <unordered_map>
+#include <vector>
 namespace tzw {
 class Drawable3D;
 class Camera;
 struct OctreeNode
 {
     OctreeNode();
+    //loose bounding, the cell grown by OCTREE_LOOSENESS on each side
     AABB aabb;
     std::vector<Drawable3D *> m_drawlist;
-    OctreeNode * m_child[8];
+    //index in the node pool, -1 means no child
+    int m_child[8];
+    int m_parent;
+    int m_childCount;
+    int m_depth;
 	int m_index;
-	void genId();
 };
 
+//a view of OctreeScene::cullingViews, culled by the frustum of m_camera, or by m_range if m_camera is nullptr
+struct OctreeCullingView
+{
+    Camera * m_camera;
+    AABB m_range;
+    uint32_t m_flags;
+};
+
+struct OctreeCullingResult
+{
+    Drawable3D * m_obj;
+    //bit i is set if the object is visible in view i
+    uint32_t m_viewMask;
+};
+
+// Loose octree, the nodes are created on demand when an object lands in them and freed again once they are empty.
+// An object is stored in the cell which contains its centre, at the deepest level where it still fits the slack of the
+// loose bounding, so small moves keep it inside the same node.
 class OctreeScene
 {
 public:
@@ -31,24 +52,42 @@ public:
     bool hitByRay(const Ray &ray, vec3 &hitPoint);
     void cullingByCamera(Camera * camera);
 	void cullingByCameraExtraFlag(Camera * camera, uint32_t flags, std::vector<Drawable3D *> & resultList);
+	//cull up to 32 views in one traversal, the subtrees are spread over the worker threads. main thread only.
+	void cullingViews(const std::vector<OctreeCullingView> & views, std::vector<OctreeCullingResult> & resultList);
     void getRange(std::vector<Drawable3D *> * list, uint32_t flags, AABB aabb);
     int getAmount();
     std::vector<Drawable3D *>& getVisibleList();
 	bool isInOctree(Drawable3D * obj);
 	OctreeNode * getNodeByIndex(int index);
+	int getNodeCount() const;
 private:
-    int getAmount_R(OctreeNode * node);
-	void cullingByCameraFlag_R(OctreeNode * node,Camera * camera, uint32_t flags, std::vector<Drawable3D *> & resultList);
-    void cullingImp_R(OctreeNode * node, uint32_t flags, std::vector<Drawable3D *> * list, const std::function<bool(const AABB&)>& testFunc);
-    OctreeNode * m_root;
-    bool addObj_R(OctreeNode * node,Drawable3D * obj);
-    bool removeObj_R(OctreeNode * node,Drawable3D * obj);
-    bool hitByRay_R(OctreeNode * node,const Ray &ray, vec3 & hitPoint);
-    void subDivide(OctreeNode * node,int level);
+    void cullingImp(uint32_t flags, std::vector<Drawable3D *> * list, const std::function<bool(const AABB&)>& testFunc);
+    struct CullingTask
+    {
+        int m_node;
+        //views which still need the test, views which contain the whole node
+        uint32_t m_testMask;
+        uint32_t m_insideMask;
+    };
+    bool cullingNode(const std::vector<OctreeCullingView> & views, const OctreeNode & node, CullingTask & task, std::vector<OctreeCullingResult> & resultList);
+    void cullingSubtree(const std::vector<OctreeCullingView> & views, const CullingTask & rootTask, std::vector<OctreeCullingResult> & resultList);
+    //take it out of its node without notifying the object, used when it only moves
+    void unlinkObj(Drawable3D * obj);
+    bool findCell(AABB & objAABB, int & depth, int cell[3]);
+    vec3 getCellSize(int depth) const;
+    int allocNode(int parent, int depth, const vec3 & cellMin);
+    void releaseEmptyNode(int index);
+    int m_root;
+    //node pool, a released node keeps its slot and the capacity of its draw list for the next allocation
+    std::vector<OctreeNode> m_nodeList;
+    std::vector<int> m_freeList;
+    vec3 m_rangeMin;
+    vec3 m_rangeSize;
+    int m_nodeCount;
+    int m_objCount;
     std::vector<Drawable3D *> m_visibleList;
-	std::unordered_set<Drawable3D *> m_objSet;
-	std::unordered_map<Drawable3D *, int> m_objMap;
-	std::vector<OctreeNode *> m_nodeList;
+    std::vector<CullingTask> m_cullingTaskList;
+    std::vector<std::vector<OctreeCullingResult>> m_cullingTaskResult;
 };
 
 } // namespace tzw
@@ -26,35 +26,26 @@ namespace tzw
 		directDrawList.clear();
 		auto cam = SceneMgr::shared()->getCurrScene()->defaultCamera();
 		OctreeScene * octreeScene =  SceneMgr::shared()->getCurrScene()->getOctreeScene();
-		SceneMgr::shared()->getCurrScene()->getOctreeScene()->cullingByCamera(cam);
+		cullingViews(cam, octreeScene);
 		//vegetation
 		Tree::shared()->clearTreeGroup();
-		auto &visibleList = octreeScene->getVisibleList();
-		for(auto obj : visibleList)
+		const uint32_t drawableFlag = static_cast<uint32_t>(DrawableFlag::Drawable);
+		for(auto & result : m_cullingResult)
 		{
-			obj->submitDrawCmd(RenderFlag::RenderStageType::COMMON, m_renderQueues, 0);
-			if(obj->onSubmitDrawCommand)
+			auto obj = result.m_obj;
+			if((result.m_viewMask & 1) && (obj->getDrawableFlag() & drawableFlag))
 			{
-				obj->onSubmitDrawCommand(RenderFlag::RenderStage::COMMON);
+				obj->submitDrawCmd(RenderFlag::RenderStageType::COMMON, m_renderQueues, 0);
+				if(obj->onSubmitDrawCommand)
+				{
+					obj->onSubmitDrawCommand(RenderFlag::RenderStage::COMMON);
+				}
 			}
 		}
 		Tree::shared()->pushCommand(RenderFlag::RenderStageType::COMMON, m_renderQueues, 0);
-		std::vector<Drawable3D *> nodeList;
-		octreeScene->cullingByCameraExtraFlag(cam, static_cast<uint32_t>(DrawableFlag::Instancing), nodeList);
-		InstancingMgr::shared()->prepare(RenderFlag::RenderStage::COMMON);
-		std::vector<InstanceRendereData> istanceCommandList;
-		for(auto node:nodeList)
-		{
-			if(node->getIsVisible())
-			{
-				node->getCommandForInstanced(istanceCommandList);   
-			}
-		}
-		for(auto& instanceData : istanceCommandList)
-		{
-			InstancingMgr::shared()->pushInstanceRenderData(RenderFlag::RenderStage::COMMON, instanceData);
-		}
-		InstancingMgr::shared()->generateDrawCall(RenderFlag::RenderStageType::COMMON, m_renderQueues, 0);
+		//the instancing nodes keep their own slots up to date, only the changed ranges are uploaded here
+		InstancingMgr::shared()->commitSlots();
+		InstancingMgr::shared()->generateDrawCall(RenderFlag::RenderStageType::COMMON, m_renderQueues, 0, m_cullingViewList[0]);
 
 
 		collectShadowCmd();
@@ -70,35 +61,45 @@ namespace tzw
 		return m_renderQueues;
 	}
 
-	void SceneCuller::collectShadowCmd()
+	void SceneCuller::cullingViews(Camera* camera, OctreeScene* octreeScene)
 	{
+		// view 0 is the camera, view 1 ~ 3 are the shadow cascades, all of them are culled in one traversal
+		// the instancing nodes are drawn from the persistent pools of InstancingMgr, so they are skipped here,
+		// the pools test their group bounds against the same views
 		ShadowMap::shared()->calculateProjectionMatrix();
+		m_cullingViewList.clear();
+		OctreeCullingView mainView;
+		mainView.m_camera = camera;
+		mainView.m_flags = static_cast<uint32_t>(DrawableFlag::Drawable);
+		m_cullingViewList.push_back(mainView);
+		for(int i = 0; i < 3; i ++)
+		{
+			OctreeCullingView shadowView;
+			shadowView.m_camera = nullptr;
+			shadowView.m_range = ShadowMap::shared()->getPotentialRange(i);
+			shadowView.m_flags = static_cast<uint32_t>(DrawableFlag::Drawable);
+			m_cullingViewList.push_back(shadowView);
+		}
+		octreeScene->cullingViews(m_cullingViewList, m_cullingResult);
+	}
+
+	void SceneCuller::collectShadowCmd()
+	{
 		for(int i = 0; i < 3; i ++)
 		{
-		
-			auto aabb = ShadowMap::shared()->getPotentialRange(i);
-			std::vector<Drawable3D *> shadowNeedDrawList;
-		    g_GetCurrScene()->getRange(&shadowNeedDrawList, static_cast<uint32_t>(DrawableFlag::Drawable) | static_cast<uint32_t>(DrawableFlag::Instancing), aabb);
-            InstancingMgr::shared()->prepare(RenderFlag::RenderStage::SHADOW);
-		    std::vector<InstanceRendereData> istanceCommandList;
-		    for(auto obj:shadowNeedDrawList)
+			uint32_t viewBit = 1u << (i + 1);
+		    for(auto & result : m_cullingResult)
 		    {
+			    if(!(result.m_viewMask & viewBit)) continue;
+			    auto obj = result.m_obj;
 			    if(!obj->getIsVisible()) continue;
 			    if(obj->getDrawableFlag() &static_cast<uint32_t>(DrawableFlag::Drawable))
 			    {
 				    obj->submitDrawCmd(RenderFlag::RenderStageType::COMMON, m_renderQueues, i);
 			    }
-			    else//instancing
-			    {
-				    obj->getCommandForInstanced(istanceCommandList);   
-			    }
 		    }
-		    for(auto& instanceData : istanceCommandList)
-	        {
-		        InstancingMgr::shared()->pushInstanceRenderData(RenderFlag::RenderStage::SHADOW, instanceData);
-	        }
             Tree::shared()->submitShadowDraw(m_renderQueues, i);
-            InstancingMgr::shared()->generateDrawCall(RenderFlag::RenderStageType::SHADOW, m_renderQueues, i);
+            InstancingMgr::shared()->generateDrawCall(RenderFlag::RenderStageType::SHADOW, m_renderQueues, i, m_cullingViewList[i + 1]);
 		}
 	}
 
@@ -5,6 +5,7 @@
 #include <unordered_map>
 #include "Rendering/RenderCommand.h"
 #include "Rendering/RenderQueues.h"
+#include "OctreeScene.h"
 namespace tzw {
 	class SceneCuller:public Singleton<SceneCuller>
 	{
@@ -15,7 +16,10 @@ namespace tzw {
 		RenderQueues * getRenderQueues();
 	private:
 		RenderQueues * m_renderQueues;
+		void cullingViews(Camera * camera, OctreeScene * octreeScene);
 		void collectShadowCmd();
+		std::vector<OctreeCullingView> m_cullingViewList;
+		std::vector<OctreeCullingResult> m_cullingResult;
 	
 	};
 
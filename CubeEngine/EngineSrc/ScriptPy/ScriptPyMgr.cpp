@@ -18,10 +18,81 @@
 namespace py = pybind11;
 namespace tzw
 {
-	ScriptPyMgr::ScriptPyMgr()
+	ScriptPyFunction::ScriptPyFunction(std::string moduleName, std::string functionName):
+		m_moduleName(moduleName),
+		m_functionName(functionName),
+		m_func(nullptr),
+		m_args(nullptr),
+		m_generation(0)
 	{
 	}
 
+	ScriptPyFunction::~ScriptPyFunction()
+	{
+		Py_XDECREF(m_func);
+		Py_XDECREF(m_args);
+	}
+
+	bool
+	ScriptPyFunction::isValid()
+	{
+		return resolve();
+	}
+
+	bool
+	ScriptPyFunction::resolve()
+	{
+		unsigned int generation = ScriptPyMgr::shared()->getFunctionGeneration();
+		//a failed lookup is not retried until the next reload
+		if (m_generation == generation) return m_func != nullptr;
+		m_generation = generation;
+		Py_XDECREF(m_func);
+		m_func = nullptr;
+		PyObject * pModule = PyImport_ImportModule(m_moduleName.c_str());
+		if (pModule == nullptr)
+		{
+			PyErr_Print();
+			tlogError("python module %s not found", m_moduleName.c_str());
+			return false;
+		}
+		PyObject * pFunc = PyObject_GetAttrString(pModule, m_functionName.c_str());
+		Py_DECREF(pModule);
+		if (pFunc == nullptr || !PyCallable_Check(pFunc))
+		{
+			PyErr_Clear();
+			Py_XDECREF(pFunc);
+			tlogError("python function %s.%s not found", m_moduleName.c_str(), m_functionName.c_str());
+			return false;
+		}
+		m_func = pFunc;
+		return true;
+	}
+
+	PyObject *
+	ScriptPyFunction::getArgTuple(size_t size)
+	{
+		//PyTuple_SetItem only works on a tuple nobody else holds, the callee may have stored it
+		if (m_args && (size_t(PyTuple_GET_SIZE(m_args)) != size || (size > 0 && Py_REFCNT(m_args) != 1)))
+		{
+			Py_DECREF(m_args);
+			m_args = nullptr;
+		}
+		if (m_args == nullptr)
+		{
+			m_args = PyTuple_New(size);
+		}
+		return m_args;
+	}
+
+	ScriptPyMgr::ScriptPyMgr():
+		g_lua_state(nullptr),
+		m_functionGeneration(1)
+	{
+		m_inputEventFunc = getFunction("tzw", "tzw_engine_input_event");
+		m_inputEventListFunc = getFunction("tzw", "tzw_engine_input_event_list");
+		m_uiUpdateFunc = getFunction("tzw", "tzw_engine_ui_update");
+	}
+
 
 	void
 	ScriptPyMgr::init()
@@ -110,15 +181,56 @@ namespace tzw
 		// }
 		//
 
+		m_inputEventList.push_back(eventInfo);
+	}
+
+	void
+	ScriptPyMgr::flushInputEvents()
+	{
+		if (m_inputEventList.empty()) return;
 		try
 		{
-			auto module = py::module::import("tzw");
-			module.attr("tzw_engine_input_event")(eventInfo);
+			if (m_inputEventListFunc->isValid())
+			{
+				py::list eventList;
+				for (auto & eventInfo : m_inputEventList)
+				{
+					eventList.append(py::cast(eventInfo));
+				}
+				m_inputEventListFunc->callVoid(eventList.ptr());
+			}
+			else
+			{
+				//scripts without the batched entry still get the events one by one
+				for (auto & eventInfo : m_inputEventList)
+				{
+					py::object pyEvent = py::cast(eventInfo);
+					m_inputEventFunc->callVoid(pyEvent.ptr());
+				}
+			}
 		}
 		catch(py::error_already_set &ex)
 		{
 			py::print(ex.what());
 		}
+		m_inputEventList.clear();
+	}
+
+	ScriptPyFunction*
+	ScriptPyMgr::getFunction(const char* moduleStr, const char* functionName)
+	{
+		std::string key = std::string(moduleStr) + "." + functionName;
+		auto iter = m_functionMap.find(key);
+		if (iter != m_functionMap.end()) return iter->second;
+		auto func = new ScriptPyFunction(moduleStr, functionName);
+		m_functionMap[key] = func;
+		return func;
+	}
+
+	unsigned int
+	ScriptPyMgr::getFunctionGeneration() const
+	{
+		return m_functionGeneration;
 	}
 
 	void
@@ -142,7 +254,7 @@ namespace tzw
 		// 	tlogError("error : %s\n", lua_tostring(g_lua_state, -1));
 		// }
 
-		callFunPyVoid("tzw", "tzw_engine_ui_update", Engine::shared()->deltaTime());
+		m_uiUpdateFunc->callVoid(Engine::shared()->deltaTime());
 	}
 
 	std::string
@@ -160,6 +272,13 @@ namespace tzw
 		// 	tlogError("error on Reload:\n %s\n", lua_tostring(g_lua_state, -1));
 		// }
 		callFunPyVoid("tzw", "tzw_engine_reload");
+		invalidateFunctions();
+	}
+
+	void
+	ScriptPyMgr::invalidateFunctions()
+	{
+		m_functionGeneration += 1;
 	}
 
 	void*
@@ -7,9 +7,36 @@
 #include "Utility/log/Log.h"
 #include "Python.h"
 #include "Base/TypeTraits.h"
+#include "Event/EventMgr.h"
+#include <unordered_map>
+#include <vector>
 namespace tzw
 {
-class EventInfo;
+// module.function resolved on the first call and kept until ScriptPyMgr::reload.
+// the argument tuple is reused as long as python did not keep a reference to it.
+class ScriptPyFunction
+{
+public:
+  ScriptPyFunction(std::string moduleName, std::string functionName);
+  ~ScriptPyFunction();
+  template<class... Types>
+  void callVoid(Types... args);
+  template<class... Types>
+  bool callBool(Types... args);
+  bool isValid();
+private:
+  //new reference, nullptr on failure
+  template<class... Types>
+  PyObject * call(Types... args);
+  bool resolve();
+  PyObject * getArgTuple(size_t size);
+  std::string m_moduleName;
+  std::string m_functionName;
+  PyObject * m_func;
+  PyObject * m_args;
+  unsigned int m_generation;
+};
+
 class ScriptPyMgr : public Singleton<ScriptPyMgr>
 {
 public:
@@ -18,7 +45,14 @@ public:
   void doScriptInit();
   void doScriptUIUpdate();
   void finalize();
+  //queued, all the events of a frame are sent to python by flushInputEvents
   void raiseInputEvent(EventInfo eventInfo);
+  void flushInputEvents();
+  //the handle is owned by the manager and stays valid, it re-resolves itself after a reload
+  ScriptPyFunction * getFunction(const char * moduleStr, const char * functionName);
+  unsigned int getFunctionGeneration() const;
+  //call after the script reloaded its modules, so the handles do not keep the old functions
+  void invalidateFunctions();
 
   void pushArg() {}
   template<typename T, class... Types>
@@ -44,6 +78,11 @@ public:
 	{
 	pValue = PyFloat_FromDouble(t);
 	}
+	else if constexpr(std::is_same<T, PyObject *>::value)
+	{
+	Py_INCREF(t);
+	pValue = t;
+	}
 	else if constexpr(isString<T>::value)
 	{
 	if constexpr (isCstring<T>::value)//is It a C String?
@@ -95,6 +134,12 @@ public:
 
 private:
   lua_State* g_lua_state;
+  std::unordered_map<std::string, ScriptPyFunction *> m_functionMap;
+  unsigned int m_functionGeneration;
+  std::vector<EventInfo> m_inputEventList;
+  ScriptPyFunction * m_inputEventFunc;
+  ScriptPyFunction * m_inputEventListFunc;
+  ScriptPyFunction * m_uiUpdateFunc;
 };
 
 template<class... Types>
@@ -143,66 +188,48 @@ template<class... Types>
 void
 ScriptPyMgr::callFunPyVoid(const char * moduleStr, const char* functionName, Types... args)
 {
-	PyObject *pName, *pModule, *pDict, *pFunc;
-	PyObject *pArgs, *pValue;
-	pName = PyUnicode_DecodeFSDefault(moduleStr);
-	pModule = PyImport_Import(pName);
-	Py_DECREF(pName);
-	pFunc = PyObject_GetAttrString(pModule, functionName);
-	size_t size = sizeof...(args);
-
-    if (pFunc && PyCallable_Check(pFunc)) 
-	{
-        pArgs = PyTuple_New(size);
-
-    	pushArgPy(pArgs, 0,  args...);
-        pValue = PyObject_CallObject(pFunc, pArgs);
-        Py_DECREF(pArgs);
-        if (pValue != NULL) {
-            // printf("Result of call: %ld\n", PyLong_AsLong(pValue));
-            Py_DECREF(pValue);
-        }
-        else {
-            Py_DECREF(pFunc);
-            Py_DECREF(pModule);
-            PyErr_Print();
-            fprintf(stderr,"Call failed\n");
-        }
-	}
+	getFunction(moduleStr, functionName)->callVoid(args...);
 }
 
 template<class... Types>
 bool
 ScriptPyMgr::callFunPyBool(const char * moduleStr, const char* functionName, Types... args)
 {
-	PyObject *pName, *pModule, *pDict, *pFunc;
-	PyObject *pArgs, *pValue;
-	pName = PyUnicode_DecodeFSDefault(moduleStr);
-	pModule = PyImport_Import(pName);
-	Py_DECREF(pName);
-	pFunc = PyObject_GetAttrString(pModule, functionName);
-	size_t size = sizeof...(args);
-	float returnVal = false;
-    if (pFunc && PyCallable_Check(pFunc)) 
+	return getFunction(moduleStr, functionName)->callBool(args...);
+}
+
+template<class... Types>
+PyObject *
+ScriptPyFunction::call(Types... args)
+{
+	if(!resolve()) return nullptr;
+	PyObject * pArgs = getArgTuple(sizeof...(args));
+	ScriptPyMgr::shared()->pushArgPy(pArgs, 0, args...);
+	PyObject * pValue = PyObject_CallObject(m_func, pArgs);
+	if (pValue == NULL)
 	{
-        pArgs = PyTuple_New(size);
-
-    	pushArgPy(pArgs, 0,  args...);
-        pValue = PyObject_CallObject(pFunc, pArgs);
-    	
-        Py_DECREF(pArgs);
-        if (pValue != NULL) {
-            // printf("Result of call: %ld\n", PyLong_AsLong(pValue));
-        	returnVal = (bool)PyLong_AsLong(pValue);
-            Py_DECREF(pValue);
-        }
-        else {
-            Py_DECREF(pFunc);
-            Py_DECREF(pModule);
-            PyErr_Print();
-            fprintf(stderr,"Call failed\n");
-        }
+		PyErr_Print();
+		tlogError("call %s.%s failed", m_moduleName.c_str(), m_functionName.c_str());
 	}
+	return pValue;
+}
+
+template<class... Types>
+void
+ScriptPyFunction::callVoid(Types... args)
+{
+	PyObject * pValue = call(args...);
+	Py_XDECREF(pValue);
+}
+
+template<class... Types>
+bool
+ScriptPyFunction::callBool(Types... args)
+{
+	PyObject * pValue = call(args...);
+	if (pValue == NULL) return false;
+	bool returnVal = PyObject_IsTrue(pValue) == 1;
+	Py_DECREF(pValue);
 	return returnVal;
 }
 	
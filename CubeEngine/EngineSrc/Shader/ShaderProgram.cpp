@@ -184,9 +184,15 @@ void ShaderProgram::enableAttributeArray(unsigned int attributeId)
 	RenderBackEnd::shared()->selfCheck();
 }
 
-void ShaderProgram::setAttributeBuffer(int ID, int dataType, int offset, int size, int stride)
+void ShaderProgram::disableAttributeArray(unsigned int attributeId)
 {
-    glVertexAttribPointer(ID,size,dataType,GL_FALSE,stride,reinterpret_cast<void *>(offset));
+    glDisableVertexAttribArray(attributeId);
+	RenderBackEnd::shared()->selfCheck();
+}
+
+void ShaderProgram::setAttributeBuffer(int ID, int dataType, int offset, int size, int stride, bool isNormalized)
+{
+    glVertexAttribPointer(ID,size,dataType,isNormalized ? GL_TRUE : GL_FALSE,stride,reinterpret_cast<void *>(offset));
 	RenderBackEnd::shared()->selfCheck();
 }
 
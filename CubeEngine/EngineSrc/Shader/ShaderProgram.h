@@ -33,7 +33,8 @@ public:
     void setUniform4Float(const char * str,vec4 v);
     unsigned int attributeLocation(std::string name);
     void enableAttributeArray(unsigned int attributeId);
-    void setAttributeBuffer(int ID, int dataType, int offset, int size, int stride = 0);
+	void disableAttributeArray(unsigned int attributeId);
+    void setAttributeBuffer(int ID, int dataType, int offset, int size, int stride = 0, bool isNormalized = false);
 	void setAttributeBufferInt(int ID, int dataType, int offset, int size, int stride = 0);
 	int uniformLocation(std::string name);
 	void reload();
@@ -22,7 +22,7 @@ namespace tzw {
 Material::Material(): m_isCullFace(false), m_program(nullptr),
 	m_factorSrc(RenderFlag::BlendingFactor::SrcAlpha),m_factorDst(RenderFlag::BlendingFactor::OneMinusSrcAlpha),
 	m_isDepthTestEnable(true), m_isDepthWriteEnable(true), m_isEnableBlend(false),
-	m_renderStage(RenderFlag::RenderStage::COMMON),m_isEnableInstanced(false),m_cullMode(RenderFlag::CullMode::Back)
+	m_renderStage(RenderFlag::RenderStage::COMMON),m_isEnableInstanced(false),m_cullMode(RenderFlag::CullMode::Back),m_vertexFormat(RenderFlag::VertexFormat::Standard)
 {
 }
 
@@ -112,6 +112,22 @@ void Material::loadFromJson(rapidjson::Value& doc, std::string envFolder)
 	{
 		m_isEnableInstanced = false;
 	}
+	if (doc.HasMember("VertexFormat"))
+	{
+		std::string theStr = doc["VertexFormat"].GetString();
+		if(theStr == "Terrain")
+		{
+			m_vertexFormat = RenderFlag::VertexFormat::Terrain;
+		}
+		else
+		{
+			m_vertexFormat = RenderFlag::VertexFormat::Standard;
+		}
+	}
+	else
+	{
+		m_vertexFormat = RenderFlag::VertexFormat::Standard;
+	}
 	if (doc.HasMember("SrcBlendFactor"))
 	{
 		std::string theStr = doc["SrcBlendFactor"].GetString();
@@ -191,7 +207,7 @@ void Material::loadFromJson(rapidjson::Value& doc, std::string envFolder)
 		auto& shaders = doc["shaders"];
 		m_vsPath = shaders["vs"].GetString();
 		m_fsPath = shaders["fs"].GetString();
-		if(Engine::shared()->getRenderDeviceType() == RenderDeviceType::Vulkan_Device)
+		if(Engine::shared()->getRenderDeviceType() != RenderDeviceType::OpenGl_Device)
 		{
 			m_vsPath = "Vulkan" + m_vsPath;
 			m_fsPath = "Vulkan" + m_fsPath;
@@ -663,6 +679,7 @@ Material *Material::clone()
 	mat->m_factorSrc = m_factorSrc;
 	mat->m_factorDst = m_factorDst;
 	mat->m_cullMode = m_cullMode;
+	mat->m_vertexFormat = m_vertexFormat;
 	return mat;
 }
 
@@ -880,6 +897,11 @@ void Material::setRenderStage(const RenderFlag::RenderStage renderStage)
 	updateFullDescriptionStr();
 }
 
+RenderFlag::VertexFormat Material::getVertexFormat() const
+{
+	return m_vertexFormat;
+}
+
 bool Material::isIsDepthTestEnable() const
 {
 	return m_isDepthTestEnable;
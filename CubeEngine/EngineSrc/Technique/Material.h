@@ -96,9 +96,12 @@ private:
 	RenderFlag::RenderStage m_renderStage;
 	std::string m_fullDescString;
 	RenderFlag::CullMode m_cullMode;
+	//the vertex layout of the meshes drawn with this material, "VertexFormat" in the template
+	RenderFlag::VertexFormat m_vertexFormat;
 public:
 	RenderFlag::RenderStage getRenderStage() const;
 	void setRenderStage(const RenderFlag::RenderStage renderStage);
+	RenderFlag::VertexFormat getVertexFormat() const;
 };
 
 } // namespace tzw
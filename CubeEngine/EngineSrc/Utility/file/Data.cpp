@@ -8,21 +8,24 @@ const Data Data::Null;
 
 Data::Data() :
 _bytes(nullptr),
-_size(0),mangledForDDS(false)
+_size(0),mangledForDDS(false),
+_isView(false)
 {
 }
 
 Data::Data(Data&& other) :
 _bytes(nullptr),
 _size(0),
-	mangledForDDS(false)
+	mangledForDDS(false),
+_isView(false)
 {
     move(other);
 }
 
 Data::Data(const Data& other) :
 _bytes(nullptr),
-_size(0)
+_size(0),
+_isView(false)
 {
     tlog("In the copy constructor of Data.");
     copy(other._bytes, other._size);
@@ -44,6 +47,7 @@ Data& Data::operator= (const Data& other)
 Data& Data::operator= (Data&& other)
 {
     tlog("In the move assignment of Data.");
+    clear();
     move(other);
     return *this;
 }
@@ -53,8 +57,10 @@ void Data::move(Data& other)
     _bytes = other._bytes;
     _size = other._size;
 	mangledForDDS = other.mangledForDDS;
+    _isView = other._isView;
     other._bytes = nullptr;
     other._size = 0;
+    other._isView = false;
 }
 
 bool Data::isNull() const
@@ -95,13 +101,31 @@ void Data::fastSet(unsigned char* bytes, const size_t size)
 {
     _bytes = bytes;
     _size = size;
+    _isView = false;
+}
+
+void Data::setView(unsigned char* bytes, const size_t size)
+{
+    clear();
+    _bytes = bytes;
+    _size = size;
+    _isView = true;
+}
+
+bool Data::isView() const
+{
+    return _isView;
 }
 
 void Data::clear()
 {
-    free(_bytes);
+    if (!_isView)
+    {
+        free(_bytes);
+    }
     _bytes = nullptr;
     _size = 0;
+    _isView = false;
 }
 }
 
@@ -74,6 +74,13 @@ public:
      */
     void fastSet(unsigned char* bytes, const size_t size);
 
+    /** Points the Data at memory it does not own, e.g. an entry of a mapped archive.
+     *  @note The memory has to outlive the Data and must not be written through getBytes.
+     */
+    void setView(unsigned char* bytes, const size_t size);
+
+    bool isView() const;
+
     /**
      * Clears data, free buffer and reset data size.
      */
@@ -94,6 +101,7 @@ private:
 private:
     unsigned char* _bytes;
     size_t _size;
+    bool _isView;
 };
 
 }
@@ -0,0 +1,122 @@
+#include "MappedFile.h"
+#include "Utility/log/Log.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace tzw
+{
+MappedFile::MappedFile():
+m_bytes(nullptr),
+m_size(0)
+#ifdef _WIN32
+,m_fileHandle(nullptr),
+m_mappingHandle(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(std::string filePath)
+{
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if(!mapping)
+    {
+        CloseHandle(file);
+        tlogError("can not map %s", filePath.c_str());
+        return false;
+    }
+    void * view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    if(!view)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        tlogError("can not map %s", filePath.c_str());
+        return false;
+    }
+    m_fileHandle = file;
+    m_mappingHandle = mapping;
+    m_bytes = static_cast<unsigned char *>(view);
+    m_size = size_t(fileSize.QuadPart);
+#else
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        return false;
+    }
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    void * view = mmap(nullptr, size_t(fileStat.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    //the mapping keeps the file alive
+    ::close(fd);
+    if(view == MAP_FAILED)
+    {
+        tlogError("can not map %s", filePath.c_str());
+        return false;
+    }
+    m_bytes = static_cast<unsigned char *>(view);
+    m_size = size_t(fileStat.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(!m_bytes)
+    {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(m_bytes);
+    CloseHandle(m_mappingHandle);
+    CloseHandle(m_fileHandle);
+    m_mappingHandle = nullptr;
+    m_fileHandle = nullptr;
+#else
+    munmap(m_bytes, m_size);
+#endif
+    m_bytes = nullptr;
+    m_size = 0;
+}
+
+unsigned char* MappedFile::getBytes() const
+{
+    return m_bytes;
+}
+
+size_t MappedFile::getSize() const
+{
+    return m_size;
+}
+
+bool MappedFile::isOpen() const
+{
+    return m_bytes != nullptr;
+}
+}
@@ -0,0 +1,29 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+#include <string>
+namespace tzw {
+// A read-only file mapped into memory as copy-on-write,
+// writes to the mapping get private pages and never reach the file.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator= (const MappedFile&) = delete;
+    bool open(std::string filePath);
+    void close();
+    unsigned char* getBytes() const;
+    size_t getSize() const;
+    bool isOpen() const;
+private:
+    unsigned char* m_bytes;
+    size_t m_size;
+#ifdef _WIN32
+    void * m_fileHandle;
+    void * m_mappingHandle;
+#endif
+};
+}
+
+#endif // MAPPED_FILE_H
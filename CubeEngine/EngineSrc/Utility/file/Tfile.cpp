@@ -6,7 +6,10 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "Utility/log/Log.h"
-#include "zip/zip.h"
+#include "MappedFile.h"
+#define MINIZ_HEADER_FILE_ONLY
+#include "zip/miniz.h"
+#include <chrono>
 #include <filesystem>
 namespace tzw
 {
@@ -17,125 +20,209 @@ Tfile *Tfile::shared()
     return m_instance;
 }
 
+// lower case, '/' separated, without "." and ".." segments, so "./Res\\A.png" and "res/a.png" hit the same entry
+static std::string normalizePath(const std::string & path)
+{
+	std::string result;
+	result.reserve(path.size());
+	size_t begin = 0;
+	while(begin <= path.size())
+	{
+		size_t end = path.find_first_of("/\\", begin);
+		if(end == std::string::npos) end = path.size();
+		size_t len = end - begin;
+		if(len == 2 && path[begin] == '.' && path[begin + 1] == '.')
+		{
+			auto slash = result.rfind('/');
+			result.erase(slash == std::string::npos ? 0 : slash);
+		}
+		else if(len > 0 && !(len == 1 && path[begin] == '.'))
+		{
+			if(!result.empty()) result.push_back('/');
+			for(size_t k = begin; k < end; k++)
+			{
+				result.push_back(char(tolower((unsigned char)path[k])));
+			}
+		}
+		begin = end + 1;
+	}
+	return result;
+}
+
+static uint16_t readU16(const unsigned char * bytes)
+{
+	return uint16_t(bytes[0] | (bytes[1] << 8));
+}
+
+static uint32_t readU32(const unsigned char * bytes)
+{
+	return uint32_t(bytes[0]) | (uint32_t(bytes[1]) << 8) | (uint32_t(bytes[2]) << 16) | (uint32_t(bytes[3]) << 24);
+}
+
 Data Tfile::getData(std::string filename, bool forString)
 {
     if (filename.empty())
       {
           return Data::Null;
       }
-      Data ret;
-      unsigned char* buffer = nullptr;
-      size_t size = 0;
-      size_t readsize = 0;
-      const char* mode = nullptr;
-      if (forString)
-          mode = "rt";
-      else
-          mode = "rb";
-
-	//search the file
-	for(auto searchPath :m_searchPath)
+	Data ret;
+	std::string realPath;
+	if(findLooseFile(normalizePath(filename), realPath) && readLooseFile(realPath, forString, ret))
 	{
-		std::string realFileName = searchPath + filename;
-          // Read the file from hardware
-		FILE *fp = fopen(realFileName.c_str (), mode);	
-		if(!fp)
-		{
-			continue;
-		}
-		fseek(fp,0,SEEK_END);
-		size = ftell(fp);
-		fseek(fp,0,SEEK_SET);
-		if (forString)
-		{
-		  buffer = (unsigned char*)malloc(sizeof(unsigned char) * (size + 1));
-		  buffer[size] = '\0';
-		}
-		else
+		return ret;
+	}
+	auto archiveName = getArchiveName(filename);
+	ArchiveEntry entry;
+	MappedFile * archive = nullptr;
+	if(findArchiveEntry(normalizePath(archiveName), entry, archive) && readArchiveEntry(entry, archive, forString, ret))
+	{
+		if(archiveName != filename)
 		{
-		  buffer = (unsigned char*)malloc(sizeof(unsigned char) * size);
+			ret.mangledForDDS = true;
 		}
-		readsize = fread(buffer, sizeof(unsigned char), size, fp);
-		fclose(fp);
-		if (forString && readsize < size)
+		return ret;
+	}
+	//not indexed, it may have been written after the search path was mounted
+	std::vector<std::string> searchPathList;
+	{
+		std::shared_lock<std::shared_mutex> lock(m_indexMutex);
+		searchPathList = m_searchPath;
+	}
+	for(auto & searchPath : searchPathList)
+	{
+		if(readLooseFile(searchPath + filename, forString, ret))
 		{
-		  buffer[readsize] = '\0';
+			return ret;
 		}
+	}
+	tlogError("Bad file :Get data from file %s failed", filename.c_str());
+	abort();
+	return ret;
+}
+
+bool Tfile::findLooseFile(const std::string& key, std::string& realPath)
+{
+	std::shared_lock<std::shared_mutex> lock(m_indexMutex);
+	auto iter = m_looseIndex.find(key);
+	if(iter == m_looseIndex.end()) return false;
+	realPath = iter->second;
+	return true;
+}
+
+bool Tfile::findArchiveEntry(const std::string& key, ArchiveEntry& entry, MappedFile*& archive)
+{
+	std::shared_lock<std::shared_mutex> lock(m_indexMutex);
+	auto iter = m_archiveIndex.find(key);
+	if(iter == m_archiveIndex.end()) return false;
+	entry = iter->second;
+	archive = m_archiveList[entry.m_archive];
+	return true;
+}
 
-		if(buffer && readsize)
+bool Tfile::readLooseFile(const std::string& realPath, bool forString, Data& ret)
+{
+	FILE *fp = fopen(realPath.c_str(), forString ? "rt" : "rb");
+	if(!fp)
+	{
+		return false;
+	}
+	fseek(fp,0,SEEK_END);
+	size_t size = ftell(fp);
+	fseek(fp,0,SEEK_SET);
+	unsigned char* buffer = nullptr;
+	if (forString)
+	{
+	  buffer = (unsigned char*)malloc(sizeof(unsigned char) * (size + 1));
+	  buffer[size] = '\0';
+	}
+	else
+	{
+	  buffer = (unsigned char*)malloc(sizeof(unsigned char) * size);
+	}
+	size_t readsize = fread(buffer, sizeof(unsigned char), size, fp);
+	fclose(fp);
+	if (forString && readsize < size)
+	{
+	  buffer[readsize] = '\0';
+	}
+	if(!readsize)
+	{
+		free(buffer);
+		return false;
+	}
+	ret.fastSet(buffer, readsize);
+	return true;
+}
+
+bool Tfile::readArchiveEntry(const ArchiveEntry& entry, MappedFile* archive, bool forString, Data& ret)
+{
+	auto bytes = archive->getBytes();
+	auto archiveSize = archive->getSize();
+	//the local header has its own name and extra field lengths, the data follows them
+	auto headerOffset = entry.m_localHeaderOffset;
+	if(headerOffset + 30 > archiveSize || readU32(bytes + headerOffset) != 0x04034b50)
+	{
+		tlogError("bad archive entry at %llu", (unsigned long long)headerOffset);
+		return false;
+	}
+	auto dataOffset = headerOffset + 30 + readU16(bytes + headerOffset + 26) + readU16(bytes + headerOffset + 28);
+	if(dataOffset + entry.m_compressedSize > archiveSize)
+	{
+		tlogError("bad archive entry at %llu", (unsigned long long)headerOffset);
+		return false;
+	}
+	auto src = bytes + dataOffset;
+	size_t size = size_t(entry.m_size);
+	if(entry.m_method == 0 && !forString)
+	{
+		ret.setView(src, size);
+		return true;
+	}
+	auto buffer = (unsigned char*)malloc(size + 1);
+	if(entry.m_method == 0)
+	{
+		memcpy(buffer, src, size);
+	}
+	else if(entry.m_method == MZ_DEFLATED)
+	{
+		//raw deflate, tinfl keeps all its state on the stack so concurrent reads are fine
+		if(tinfl_decompress_mem_to_mem(buffer, size, src, size_t(entry.m_compressedSize), 0) != size)
 		{
-		  ret.fastSet(buffer, readsize);
-			return ret;
+			free(buffer);
+			tlogError("can not inflate archive entry at %llu", (unsigned long long)headerOffset);
+			return false;
 		}
 	}
+	else
+	{
+		free(buffer);
+		tlogError("unsupported compression %d of archive entry at %llu", entry.m_method, (unsigned long long)headerOffset);
+		return false;
+	}
+	if(forString)
+	{
+		buffer[size] = '\0';
+	}
+	ret.fastSet(buffer, size);
+	return true;
+}
 
-
+std::string Tfile::getArchiveName(std::string filename)
+{
 	char tmp[256];
 	auto theList = {"png", "jpg", "tga"};
 	findPreFix(filename.c_str(), tmp);
 	std::string preFix = tmp;
 	auto found = preFix.find("UITexture");
-	bool hasChangeForDDS = false;
 	if(found == std::string::npos)
 	{	
 		//cook汾ļ
 		if(std::find(theList.begin(), theList.end(), getExtension(filename))!= theList.end())
 		{
-			filename = getFileNameWithOutExtension(filename) +".dds";
-			hasChangeForDDS = true;
-		}
-	}
-	//search the zip
-	for(auto zipData : m_searchZip)
-    {
-		struct zip_t *zip = zipData.second;
-		if(zip)
-		{
-    		std::string zipFilename = filename;
-			if(zip_entry_open(zip, zipFilename.c_str()) == 0)
-			{
-				void * buf = nullptr;
-
-		       readsize = zip_entry_size(zip);
-				if(forString)
-				{
-					buf = malloc(sizeof(char) *(readsize + 1));
-				}else
-				{
-					buf = malloc(sizeof(char) * readsize);	
-				}
-		        auto size_loaded = zip_entry_noallocread(zip, buf, readsize);
-				
-				if (size_loaded == -1)
-				{
-					abort();
-				}
-				buffer = static_cast<unsigned char*>(buf);
-				if(forString)
-				{
-					//use the real size
-					buffer[size_loaded] = '\0';
-				}
-				zip_entry_close(zip);
-				ret.fastSet(buffer, readsize);
-			}
-    		if(buffer)
-    		{
-   				if(hasChangeForDDS)
-				{
-					ret.mangledForDDS = true;
-				}
-    			return ret;
-    		}
+			return getFileNameWithOutExtension(filename) +".dds";
 		}
-
-    }
-	if (nullptr == buffer || 0 == readsize)
-	{
-		tlogError("Bad file :Get data from file %s failed", filename.c_str());
-		abort();
 	}
-	return ret;
+	return filename;
 }
 
 std::string Tfile::fullPathFromRelativeFile(const std::string &filename, const std::string &relativeFile)
@@ -178,7 +265,36 @@ std::string Tfile::guessFileType(std::string filePath)
 
 void Tfile::addSearchPath(std::string searchPath)
 {
+	std::unique_lock<std::shared_mutex> lock(m_indexMutex);
     m_searchPath.push_back (searchPath);
+	indexSearchPath(searchPath);
+}
+
+void Tfile::indexSearchPath(std::string searchPath)
+{
+	auto begin = std::chrono::high_resolution_clock::now();
+	size_t count = 0;
+	std::error_code ec;
+	std::filesystem::path root(searchPath.empty() ? "." : searchPath);
+	std::filesystem::recursive_directory_iterator iter(root, std::filesystem::directory_options::skip_permission_denied, ec);
+	for(; !ec && iter != std::filesystem::recursive_directory_iterator(); iter.increment(ec))
+	{
+		auto name = iter->path().filename().string();
+		if(iter->is_directory(ec))
+		{
+			//.git, .vs and the like
+			if(!name.empty() && name[0] == '.') iter.disable_recursion_pending();
+			continue;
+		}
+		if(!iter->is_regular_file(ec)) continue;
+		auto relativePath = iter->path().lexically_relative(root).generic_string();
+		//the first search path wins, same as the probing order
+		if(m_looseIndex.emplace(normalizePath(relativePath), searchPath + relativePath).second)
+		{
+			count++;
+		}
+	}
+	tlog("mount %s: %zu files, %.2f ms", searchPath.c_str(), count, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count());
 }
 
 std::string Tfile::getReleativePath(std::string filePath)
@@ -227,9 +343,46 @@ std::string Tfile::toAbsFilePath(std::string filePath, std::string workingCpy)
 
 void Tfile::addSearchZip(std::string zipPath)
 {
-	struct zip_t *zip = zip_open(zipPath.c_str(), 0, 'r');
-	m_searchZip[zipPath] = zip;
-	
+	auto begin = std::chrono::high_resolution_clock::now();
+	auto archive = new MappedFile();
+	if(!archive->open(zipPath))
+	{
+		delete archive;
+		tlogError("can not open archive %s", zipPath.c_str());
+		return;
+	}
+	mz_zip_archive zip;
+	memset(&zip, 0, sizeof(zip));
+	if(!mz_zip_reader_init_mem(&zip, archive->getBytes(), archive->getSize(), 0))
+	{
+		delete archive;
+		tlogError("bad archive %s", zipPath.c_str());
+		return;
+	}
+	std::unique_lock<std::shared_mutex> lock(m_indexMutex);
+	int archiveIndex = int(m_archiveList.size());
+	m_archiveList.push_back(archive);
+	size_t count = 0;
+	mz_uint fileCount = mz_zip_reader_get_num_files(&zip);
+	for(mz_uint i = 0; i < fileCount; i++)
+	{
+		mz_zip_archive_file_stat stat;
+		if(!mz_zip_reader_file_stat(&zip, i, &stat) || mz_zip_reader_is_file_a_directory(&zip, i)) continue;
+		//encrypted entries can not be read
+		if(stat.m_bit_flag & 1) continue;
+		ArchiveEntry entry;
+		entry.m_archive = archiveIndex;
+		entry.m_localHeaderOffset = stat.m_local_header_ofs;
+		entry.m_compressedSize = stat.m_comp_size;
+		entry.m_size = stat.m_uncomp_size;
+		entry.m_method = stat.m_method;
+		if(m_archiveIndex.emplace(normalizePath(stat.m_filename), entry).second)
+		{
+			count++;
+		}
+	}
+	mz_zip_reader_end(&zip);
+	tlog("mount %s: %zu files, %.2f ms", zipPath.c_str(), count, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count());
 }
 
 std::string Tfile::getExtension(std::string path)
@@ -265,44 +418,24 @@ std::string Tfile::getFileNameWithOutExtension(std::string path)
 
 bool Tfile::isExist(std::string path)
 {
+	std::string realPath;
+	if(findLooseFile(normalizePath(path), realPath) && std::filesystem::exists(realPath))
+	{
+		return true;
+	}
+	ArchiveEntry entry;
+	MappedFile * archive = nullptr;
+	if(findArchiveEntry(normalizePath(getArchiveName(path)), entry, archive))
+	{
+		return true;
+	}
+	std::shared_lock<std::shared_mutex> lock(m_indexMutex);
 	for(auto searchPath :m_searchPath)
 	{
 		 if(std::filesystem::exists(searchPath + path))
 			 return true;
 	}
-	bool isZipFind = false;
-	char tmp[256];
-	auto theList = {"png", "jpg", "tga"};
-	findPreFix(path.c_str(), tmp);
-	std::string preFix = tmp;
-	auto found = preFix.find("UITexture");
-	bool hasChangeForDDS = false;
-	if(found == std::string::npos)
-	{	
-		//cook汾ļ
-		if(std::find(theList.begin(), theList.end(), getExtension(path))!= theList.end())
-		{
-			path = getFileNameWithOutExtension(path) +".dds";
-			hasChangeForDDS = true;
-		}
-	}
-	//search the zip
-	for(auto zipData : m_searchZip)
-    {
-		struct zip_t *zip = zipData.second;
-		if(zip)
-		{
-    		std::string zipFilename = path;
-			if(zip_entry_open(zip, zipFilename.c_str()) == 0)
-			{
-				isZipFind = true;
-				zip_entry_close(zip);
-				break;
-			}
-		}
-
-    }
-	return isZipFind;
+	return false;
 }
 
 rapidjson::Document Tfile::getJsonObject(std::string filePath)
@@ -328,14 +461,13 @@ Tfile::Tfile()
 
 Tfile::~Tfile()
 {
-	for(auto zip :m_searchZip)
+	for(auto archive : m_archiveList)
 	{
-		zip_close(zip.second);
+		delete archive;
 	}
-	m_searchZip.clear();
+	m_archiveList.clear();
+	m_archiveIndex.clear();
 }
 
 
 }
-
-
@@ -2,12 +2,19 @@
 #define TFILE_H
 #include <string>
 #include <vector>
+#include <cstdint>
 #include "Data.h"
 #include <map>
+#include <unordered_map>
+#include <shared_mutex>
 #include "rapidjson/document.h"
-struct zip_t;
 namespace tzw
 {
+class MappedFile;
+// Every loose file under the search paths and every entry of the search archives is indexed when it is mounted,
+// so a lookup is one hash probe. The archives are memory mapped and only read, getData is safe from any thread.
+// a stored archive entry is returned as a view of the mapping, a deflated one is inflated into its own buffer.
+// loose files created after the mount are still found by probing the search paths once the index misses.
 class Tfile
 {
 public:
@@ -29,9 +36,27 @@ public:
 	~Tfile();
 private:
     Tfile();
-    
+	struct ArchiveEntry
+	{
+		int m_archive;
+		uint64_t m_localHeaderOffset;
+		uint64_t m_compressedSize;
+		uint64_t m_size;
+		int m_method;
+	};
+	void indexSearchPath(std::string searchPath);
+	bool findLooseFile(const std::string & key, std::string & realPath);
+	bool findArchiveEntry(const std::string & key, ArchiveEntry & entry, MappedFile *& archive);
+	bool readLooseFile(const std::string & realPath, bool forString, Data & ret);
+	bool readArchiveEntry(const ArchiveEntry & entry, MappedFile * archive, bool forString, Data & ret);
+	std::string getArchiveName(std::string filename);
+
     std::vector<std::string> m_searchPath;
-	std::map<std::string, zip_t *> m_searchZip;
+	std::vector<MappedFile *> m_archiveList;
+	//keys are lower case with '/' separators, see normalizePath
+	std::unordered_map<std::string, std::string> m_looseIndex;
+	std::unordered_map<std::string, ArchiveEntry> m_archiveIndex;
+	std::shared_mutex m_indexMutex;
     static Tfile * m_instance;
 };
 }
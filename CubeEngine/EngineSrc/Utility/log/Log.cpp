@@ -2,64 +2,488 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
-#include "Game/ConsolePanel.h"
 #include <ctime>
+#include <csignal>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 namespace tzw
 {
-	static FILE * fileHandle;
+	std::atomic<int> g_logLevel(int(LogLevel::Info));
+	std::atomic<uint32_t> g_logCategoryMask(LOG_CATEGORY_ALL);
+
+	//must be a power of two
+	static const size_t LOG_RING_SIZE = 4096;
+	static const size_t LOG_TEXT_SIZE = 496;
+	static const int LOG_RATE_LIMIT = 32;
+	static const size_t LOG_RATE_SLOT_COUNT = 256;
+	static const size_t LOG_CONSOLE_MAX = 4096;
+	static const size_t LOG_SAMPLE_SIZE = 64;
+
+	struct LogRecord
+	{
+		//the ring slot is free for the producer at position p when it is p, filled when it is p + 1
+		std::atomic<size_t> m_sequence;
+		LogLevel m_level;
+		time_t m_time;
+		uint32_t m_length;
+		char m_text[LOG_TEXT_SIZE];
+	};
+
+	struct LogRateSlot
+	{
+		//hash of the formatted text, the format string alone can't tell apart what tlog_lua and the like pass in
+		std::atomic<uint64_t> m_hash{0};
+		std::atomic<int64_t> m_second{0};
+		std::atomic<int> m_count{0};
+		std::atomic<int> m_suppressed{0};
+		//the first muted record, for the report in drain
+		std::mutex m_sampleMutex;
+		char m_sample[LOG_SAMPLE_SIZE];
+		LogLevel m_sampleLevel;
+	};
+
+	struct LogSystem
+	{
+		LogSystem();
+		bool checkRate(LogLevel level, const char * text, size_t length);
+		bool push(LogLevel level, const char * text, size_t length);
+		//caller holds m_drainMutex. the suppressed counts are reported once their second is over, or all of them if isFinal
+		void drain(bool isFinal = false);
+		bool reportSuppressed(bool isFinal);
+		void write(LogLevel level, time_t t, const char * text, size_t length);
+		LogRecord m_ring[LOG_RING_SIZE];
+		std::atomic<size_t> m_enqueuePos;
+		size_t m_dequeuePos;
+		std::atomic<int> m_dropped;
+		LogRateSlot m_rateList[LOG_RATE_SLOT_COUNT];
+		//there is one consumer at a time, the writer thread or whoever flushes
+		std::mutex m_drainMutex;
+		FILE * m_file;
+		time_t m_headerTime;
+		char m_header[32];
+		std::mutex m_consoleMutex;
+		std::deque<std::string> m_consoleList;
+		std::thread m_writer;
+		std::mutex m_writerMutex;
+		std::condition_variable m_writerCondition;
+		bool m_isStop;
+		std::atomic<bool> m_isRunning;
+	};
+
+	LogSystem::LogSystem():
+		m_enqueuePos(0),
+		m_dequeuePos(0),
+		m_dropped(0),
+		m_file(nullptr),
+		m_headerTime(0),
+		m_isStop(false),
+		m_isRunning(false)
+	{
+		for(size_t i = 0; i < LOG_RING_SIZE; i++)
+		{
+			m_ring[i].m_sequence.store(i, std::memory_order_relaxed);
+		}
+		m_header[0] = '\0';
+	}
+
+	//never destroyed, so logging from static destructors and other threads during exit stays valid
+	static LogSystem & getLogSystem()
+	{
+		static LogSystem * system = new LogSystem();
+		return *system;
+	}
+
+	static int64_t getRateSecond()
+	{
+		return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	bool LogSystem::checkRate(LogLevel level, const char * text, size_t length)
+	{
+		//FNV-1a
+		uint64_t hash = 14695981039346656037ull;
+		for(size_t i = 0; i < length; i++)
+		{
+			hash = (hash ^ (unsigned char)text[i]) * 1099511628211ull;
+		}
+		int64_t second = getRateSecond();
+		auto & slot = m_rateList[hash % LOG_RATE_SLOT_COUNT];
+		//another message took the slot, start over. racing threads only let a few extra records through
+		if(slot.m_hash.load(std::memory_order_relaxed) != hash)
+		{
+			slot.m_hash.store(hash, std::memory_order_relaxed);
+			slot.m_second.store(second, std::memory_order_relaxed);
+			slot.m_count.store(0, std::memory_order_relaxed);
+		}
+		int64_t lastSecond = slot.m_second.load(std::memory_order_relaxed);
+		if(lastSecond != second && slot.m_second.compare_exchange_strong(lastSecond, second, std::memory_order_relaxed))
+		{
+			slot.m_count.store(0, std::memory_order_relaxed);
+		}
+		if(slot.m_count.fetch_add(1, std::memory_order_relaxed) < LOG_RATE_LIMIT)
+		{
+			return true;
+		}
+		if(slot.m_suppressed.fetch_add(1, std::memory_order_relaxed) == 0)
+		{
+			std::lock_guard<std::mutex> lock(slot.m_sampleMutex);
+			size_t sampleLength = std::min(length, LOG_SAMPLE_SIZE - 1);
+			memcpy(slot.m_sample, text, sampleLength);
+			slot.m_sample[sampleLength] = '\0';
+			slot.m_sampleLevel = level;
+		}
+		return false;
+	}
+
+	bool LogSystem::reportSuppressed(bool isFinal)
+	{
+		bool isWritten = false;
+		int64_t second = getRateSecond();
+		for(auto & slot : m_rateList)
+		{
+			if(!slot.m_suppressed.load(std::memory_order_relaxed))
+			{
+				continue;
+			}
+			if(!isFinal && slot.m_second.load(std::memory_order_relaxed) == second)
+			{
+				continue;
+			}
+			int suppressed = slot.m_suppressed.exchange(0, std::memory_order_relaxed);
+			if(!suppressed)
+			{
+				continue;
+			}
+			char text[LOG_SAMPLE_SIZE + 64];
+			int length;
+			LogLevel level;
+			{
+				std::lock_guard<std::mutex> lock(slot.m_sampleMutex);
+				length = snprintf(text, sizeof(text), "%d more records like \"%s\" suppressed", suppressed, slot.m_sample);
+				level = slot.m_sampleLevel;
+			}
+			write(level, time(nullptr), text, std::min(size_t(length), sizeof(text) - 1));
+			isWritten = true;
+		}
+		return isWritten;
+	}
+
+	bool LogSystem::push(LogLevel level, const char * text, size_t length)
+	{
+		size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+		LogRecord * record = nullptr;
+		for(;;)
+		{
+			record = &m_ring[pos & (LOG_RING_SIZE - 1)];
+			size_t sequence = record->m_sequence.load(std::memory_order_acquire);
+			intptr_t diff = intptr_t(sequence) - intptr_t(pos);
+			if(diff == 0)
+			{
+				if(m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if(diff < 0)
+			{
+				//full
+				return false;
+			}
+			else
+			{
+				pos = m_enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+		record->m_level = level;
+		record->m_time = time(nullptr);
+		record->m_length = uint32_t(length);
+		memcpy(record->m_text, text, length);
+		record->m_sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	void LogSystem::drain(bool isFinal)
+	{
+		bool isWritten = false;
+		for(;;)
+		{
+			auto & record = m_ring[m_dequeuePos & (LOG_RING_SIZE - 1)];
+			if(record.m_sequence.load(std::memory_order_acquire) != m_dequeuePos + 1)
+			{
+				break;
+			}
+			write(record.m_level, record.m_time, record.m_text, record.m_length);
+			record.m_sequence.store(m_dequeuePos + LOG_RING_SIZE, std::memory_order_release);
+			m_dequeuePos++;
+			isWritten = true;
+		}
+		int dropped = m_dropped.exchange(0);
+		if(dropped)
+		{
+			char text[64];
+			int length = snprintf(text, sizeof(text), "%d log records dropped, the ring was full", dropped);
+			write(LogLevel::Warning, time(nullptr), text, length);
+			isWritten = true;
+		}
+		if(reportSuppressed(isFinal))
+		{
+			isWritten = true;
+		}
+		if(isWritten)
+		{
+			fflush(stdout);
+			if(m_file)
+			{
+				fflush(m_file);
+			}
+		}
+	}
+
+	void LogSystem::write(LogLevel level, time_t t, const char * text, size_t length)
+	{
+		//localtime is not thread safe, it is only called here under the drain lock
+		if(t != m_headerTime || !m_header[0])
+		{
+			struct tm *lt = localtime(&t);
+			snprintf(m_header, sizeof(m_header), "[%02d/%02d/%02d %02d:%02d:%02d]", lt->tm_mon+1, lt->tm_mday, lt->tm_year%100, lt->tm_hour, lt->tm_min, lt->tm_sec);
+			m_headerTime = t;
+		}
+		static const char * tagList[] = {"[verbose]", " ", "[warning]", "[error]"};
+		const char * tag = tagList[int(level)];
+		fprintf(stdout, "%s%s%.*s\n", m_header, tag, int(length), text);
+		if(m_file)
+		{
+			fprintf(m_file, "%s%s%.*s\n", m_header, tag, int(length), text);
+		}
+		std::lock_guard<std::mutex> lock(m_consoleMutex);
+		//nobody fetches while the console is hidden, keep the latest lines only
+		if(m_consoleList.size() >= LOG_CONSOLE_MAX)
+		{
+			m_consoleList.pop_front();
+		}
+		if(level == LogLevel::Info)
+		{
+			m_consoleList.emplace_back(text, length);
+		}
+		else
+		{
+			m_consoleList.emplace_back(std::string(tag) + std::string(text, length));
+		}
+	}
+
+	static void writeRecord(LogSystem & system, LogLevel level, const char * text, size_t length)
+	{
+		bool isPushed = system.push(level, text, length);
+		if(!isPushed && level == LogLevel::Error)
+		{
+			flushLog();
+			isPushed = system.push(level, text, length);
+		}
+		if(!isPushed)
+		{
+			system.m_dropped.fetch_add(1);
+		}
+		//errors often precede an abort, and nobody drains before init or after shutdown
+		if(level == LogLevel::Error || !system.m_isRunning.load())
+		{
+			flushLog();
+		}
+	}
+
+	static void logV(LogLevel level, const char * pattern, va_list args)
+	{
+		auto & system = getLogSystem();
+		va_list argsCopy;
+		va_copy(argsCopy, args);
+		char buffer[LOG_TEXT_SIZE];
+		int length = vsnprintf(buffer, sizeof(buffer), pattern, args);
+		if(length < 0)
+		{
+			va_end(argsCopy);
+			return;
+		}
+		const char * text = buffer;
+		//too long for a ring slot
+		std::string longText;
+		if(size_t(length) >= sizeof(buffer))
+		{
+			longText.resize(length + 1);
+			vsnprintf(&longText[0], longText.size(), pattern, argsCopy);
+			text = longText.c_str();
+		}
+		va_end(argsCopy);
+		//errors are never muted
+		if(level != LogLevel::Error && !system.checkRate(level, text, length))
+		{
+			return;
+		}
+		if(text == buffer)
+		{
+			writeRecord(system, level, text, length);
+			return;
+		}
+		//write it in place after everything queued before it
+		std::lock_guard<std::mutex> lock(system.m_drainMutex);
+		system.drain();
+		system.write(level, time(nullptr), text, length);
+		fflush(stdout);
+		if(system.m_file)
+		{
+			fflush(system.m_file);
+		}
+	}
+
+	static void writerLoop()
+	{
+		auto & system = getLogSystem();
+		for(;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(system.m_writerMutex);
+				if(system.m_writerCondition.wait_for(lock, std::chrono::milliseconds(5), [&system]{return system.m_isStop;}))
+				{
+					break;
+				}
+			}
+			flushLog();
+		}
+	}
+
+	void flushLogOnCrash()
+	{
+		auto & system = getLogSystem();
+		//don't wait for a drain which may never finish
+		if(system.m_drainMutex.try_lock())
+		{
+			system.drain(true);
+			system.m_drainMutex.unlock();
+		}
+	}
+
+#ifndef _WIN32
+	static void onCrash(int sig)
+	{
+		flushLogOnCrash();
+		signal(sig, SIG_DFL);
+		raise(sig);
+	}
+#endif
+
 	void initLogSystem()
 	{
-		fileHandle = fopen("./log.txt","w+");
+		auto & system = getLogSystem();
+		{
+			std::lock_guard<std::mutex> lock(system.m_drainMutex);
+			if(!system.m_file)
+			{
+				system.m_file = fopen("./log.txt","w+");
+			}
+		}
+		if(system.m_isRunning.exchange(true))
+		{
+			return;
+		}
+		static bool isHookInstalled = false;
+		if(!isHookInstalled)
+		{
+			isHookInstalled = true;
+			atexit(shutdownLogSystem);
+			//the CRT of msvc routes the access violations to these signals and the default action exits the process,
+			//the unhandled exception filter of the app (and its minidump) would never run, it calls flushLogOnCrash itself
+#ifndef _WIN32
+			signal(SIGSEGV, onCrash);
+			signal(SIGABRT, onCrash);
+			signal(SIGFPE, onCrash);
+			signal(SIGILL, onCrash);
+#endif
+		}
+		system.m_isStop = false;
+		system.m_writer = std::thread(writerLoop);
+	}
+
+	void flushLog()
+	{
+		auto & system = getLogSystem();
+		std::lock_guard<std::mutex> lock(system.m_drainMutex);
+		system.drain();
+	}
+
+	void shutdownLogSystem()
+	{
+		auto & system = getLogSystem();
+		if(system.m_isRunning.exchange(false))
+		{
+			{
+				std::lock_guard<std::mutex> lock(system.m_writerMutex);
+				system.m_isStop = true;
+			}
+			system.m_writerCondition.notify_one();
+			if(system.m_writer.joinable())
+			{
+				system.m_writer.join();
+			}
+		}
+		std::lock_guard<std::mutex> lock(system.m_drainMutex);
+		system.drain(true);
+		if(system.m_file)
+		{
+			fclose(system.m_file);
+			system.m_file = nullptr;
+		}
+	}
+
+	void setLogLevel(LogLevel level)
+	{
+		g_logLevel.store(int(level), std::memory_order_relaxed);
+	}
+
+	void setLogCategoryMask(uint32_t mask)
+	{
+		g_logCategoryMask.store(mask, std::memory_order_relaxed);
+	}
+
+	void fetchConsoleLog(std::vector<std::string> & lineList)
+	{
+		auto & system = getLogSystem();
+		std::lock_guard<std::mutex> lock(system.m_consoleMutex);
+		for(auto & line : system.m_consoleList)
+		{
+			lineList.emplace_back(std::move(line));
+		}
+		system.m_consoleList.clear();
 	}
 
 	void tlog(const char * pattern, ...)
 	{
-		const int MAX_BUFFER_SIZE = 128;
-		static char header[MAX_BUFFER_SIZE];
-
-		time_t t = time(NULL);
-		struct tm *lt = localtime(&t);
-		static char thePattern[512] = {};
-		snprintf(header, MAX_BUFFER_SIZE, "[%02d/%02d/%02d %02d:%02d:%02d] ", lt->tm_mon+1, lt->tm_mday, lt->tm_year%100, lt->tm_hour, lt->tm_min, lt->tm_sec);
-		memset(thePattern,0,512);
-		
-		memcpy(thePattern,header,strlen(header));
-		strcat(thePattern,pattern);
-		strcat(thePattern, "\n");
+		if(!isLogEnabled(LogLevel::Info, LOG_CATEGORY_DEFAULT)) return;
 		va_list vaArg;
 		va_start(vaArg,pattern);
-		vfprintf(stdout,thePattern, vaArg);
-		vfprintf(fileHandle, thePattern, vaArg);
-		auto consolePanel = ConsolePanel::shared();
-		if(consolePanel)
-		{
-			consolePanel->AddLog(pattern, vaArg);
-		}
+		logV(LogLevel::Info, pattern, vaArg);
 		va_end(vaArg);
 	}
 
 	void tlogError(const char * pattern, ...)
 	{
-		const int MAX_BUFFER_SIZE = 128;
-		static char header[MAX_BUFFER_SIZE];
-
-		time_t t = time(NULL);
-		struct tm *lt = localtime(&t);
-		static char thePattern[2048] = {};
-		snprintf(header, MAX_BUFFER_SIZE, "[%02d/%02d/%02d %02d:%02d:%02d][error]", lt->tm_mon+1, lt->tm_mday, lt->tm_year%100, lt->tm_hour, lt->tm_min, lt->tm_sec);
-		memset(thePattern,0,2048);
-		
-		memcpy(thePattern,header,strlen(header));
-		strcat(thePattern,pattern);
-		strcat(thePattern, "\n");
+		if(!isLogEnabled(LogLevel::Error, LOG_CATEGORY_DEFAULT)) return;
 		va_list vaArg;
 		va_start(vaArg,pattern);
-		vfprintf(stdout,thePattern, vaArg);
-		vfprintf(fileHandle, thePattern, vaArg);
-		ConsolePanel::shared()->AddLog(thePattern, vaArg);
+		logV(LogLevel::Error, pattern, vaArg);
 		va_end(vaArg);
 	}
 
-}
+	void tlogWrite(LogLevel level, uint32_t category, const char * pattern, ...)
+	{
+		if(!isLogEnabled(level, category)) return;
+		va_list vaArg;
+		va_start(vaArg,pattern);
+		logV(level, pattern, vaArg);
+		va_end(vaArg);
+	}
 
+}
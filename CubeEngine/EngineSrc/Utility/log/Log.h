@@ -1,9 +1,55 @@
 #ifndef TZW_LOG_H
 #define TZW_LOG_H
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
 namespace tzw
 {
+	enum class LogLevel
+	{
+		Verbose,
+		Info,
+		Warning,
+		Error,
+	};
+	//bit mask, tlog and tlogError use LOG_CATEGORY_DEFAULT
+	enum LogCategory : uint32_t
+	{
+		LOG_CATEGORY_DEFAULT = 1u << 0,
+		LOG_CATEGORY_RENDER = 1u << 1,
+		LOG_CATEGORY_PHYSICS = 1u << 2,
+		LOG_CATEGORY_SCRIPT = 1u << 3,
+		LOG_CATEGORY_FILE = 1u << 4,
+		LOG_CATEGORY_GAME = 1u << 5,
+		LOG_CATEGORY_ALL = 0xffffffffu,
+	};
+	// The records are formatted on the calling thread and pushed into a lock free ring, a writer thread started by
+	// initLogSystem prints them to stdout and log.txt. errors are flushed before tlogError returns, and the ring is
+	// flushed on exit and when the process crashes, by a signal hook or on windows by flushLogOnCrash in the crash
+	// handler of the app. a message repeated more than LOG_RATE_LIMIT times per second is muted for the rest of that
+	// second, the writer reports how many were suppressed. errors are never muted.
 	void tlog(const char * pattern, ...);
 	void tlogError(const char * pattern, ...);
+	void tlogWrite(LogLevel level, uint32_t category, const char * pattern, ...);
 	void initLogSystem();
+	//write everything queued so far on the calling thread
+	void flushLog();
+	//best effort for a crash handler, what can be written without waiting for another thread is written
+	void flushLogOnCrash();
+	void shutdownLogSystem();
+	void setLogLevel(LogLevel level);
+	void setLogCategoryMask(uint32_t mask);
+	//the lines for the console panel, main thread only
+	void fetchConsoleLog(std::vector<std::string> & lineList);
+
+	extern std::atomic<int> g_logLevel;
+	extern std::atomic<uint32_t> g_logCategoryMask;
+	inline bool isLogEnabled(LogLevel level, uint32_t category)
+	{
+		return int(level) >= g_logLevel.load(std::memory_order_relaxed) && (category & g_logCategoryMask.load(std::memory_order_relaxed));
+	}
 }
+//the arguments are not evaluated when the level or the category is filtered out
+#define TLOG_CAT(level, category, ...) do { if(tzw::isLogEnabled(level, category)) tzw::tlogWrite(level, category, __VA_ARGS__); } while(0)
 #endif // !TZW_LOG_H
@@ -17,6 +17,8 @@ public:
 	static clock_t DurationEnd();
 	static float clamp(float val, float min, float max);
 	static std::string getUserPath(std::string filePath);
+	//soft and hard page faults of this process so far
+	static size_t getPageFaultCount();
 };
 
 } // namespace tzw
@@ -1,5 +1,6 @@
 #include "Tmisc.h"
 #include <windows.h>
+#include <psapi.h>
 #include <stdarg.h>
 namespace tzw {
 
@@ -59,4 +60,14 @@ std::string Tmisc::getUserPath(std::string filePath)
 	return filePath;
 }
 
+size_t Tmisc::getPageFaultCount()
+{
+	PROCESS_MEMORY_COUNTERS counters;
+	if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return 0;
+	}
+	return counters.PageFaultCount;
+}
+
 } // namespace tzw
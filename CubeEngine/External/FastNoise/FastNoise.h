@@ -207,6 +207,21 @@ public:
 	void GradientPerturb(FN_DECIMAL& x, FN_DECIMAL& y, FN_DECIMAL& z) const;
 	void GradientPerturbFractal(FN_DECIMAL& x, FN_DECIMAL& y, FN_DECIMAL& z) const;
 
+	//3D batch (FastNoiseBatch.cpp)
+	enum SIMDLevel { SIMD_Scalar, SIMD_SSE2, SIMD_AVX2 };
+
+	// Fills out[i] = GetNoise(x[i], y[i], z[i]) for count points
+	// Perlin and PerlinFractal (FBM, Billow) with Quintic interp run on the best SIMD level of the cpu,
+	// every other noise type falls back to GetNoise per point
+	void GetNoiseSet(const FN_DECIMAL* x, const FN_DECIMAL* y, const FN_DECIMAL* z, FN_DECIMAL* out, int count) const;
+
+	// Returns the SIMD level GetNoiseSet(...) runs on
+	static SIMDLevel GetSIMDLevel();
+
+	// Caps the SIMD level used by GetNoiseSet(...), levels not supported by the cpu are ignored
+	// Default: the best level supported by the cpu
+	static void SetSIMDLevel(SIMDLevel level);
+
 	//4D
 	FN_DECIMAL GetSimplex(FN_DECIMAL x, FN_DECIMAL y, FN_DECIMAL z, FN_DECIMAL w) const;
 
@@ -0,0 +1,397 @@
+// FastNoiseBatch.cpp
+//
+// Batch evaluation of FastNoise::GetNoise(x, y, z) for Perlin and PerlinFractal noise.
+// Every lane repeats the scalar operations of FastNoise.cpp in the same order (no FMA),
+// so the results match the scalar path.
+//
+
+#include "FastNoise.h"
+
+#include <math.h>
+#include <algorithm>
+
+#if !defined(FN_USE_DOUBLES) && (defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__))
+#define FN_BATCH_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define FN_TARGET_SSE2
+#define FN_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define FN_TARGET_SSE2 __attribute__((target("sse2")))
+#define FN_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+	const float BATCH_GRAD_X[] =
+	{
+		1, -1, 1, -1,
+		1, -1, 1, -1,
+		0, 0, 0, 0
+	};
+	const float BATCH_GRAD_Y[] =
+	{
+		1, 1, -1, -1,
+		0, 0, 0, 0,
+		1, -1, 1, -1
+	};
+	const float BATCH_GRAD_Z[] =
+	{
+		0, 0, 0, 0,
+		1, 1, -1, -1,
+		1, 1, -1, -1
+	};
+
+	struct BatchParam
+	{
+		int perm[512];
+		int perm12[512];
+		int octaves;
+		float frequency;
+		float lacunarity;
+		float gain;
+		float fractalBounding;
+		bool isFractal;
+		bool isBillow;
+	};
+
+	int g_simdLevelCap = FastNoise::SIMD_AVX2;
+
+	int DetectSIMDLevel()
+	{
+#ifdef FN_BATCH_X86
+		int level = FastNoise::SIMD_SSE2;
+		unsigned int info[4] = {};
+#ifdef _MSC_VER
+		int msInfo[4];
+		__cpuid(msInfo, 0);
+		int maxLeaf = msInfo[0];
+		__cpuid(msInfo, 1);
+		bool isOsxSave = (msInfo[2] & (1 << 27)) != 0;
+		bool isAvx = (msInfo[2] & (1 << 28)) != 0;
+		bool isAvx2 = false;
+		if (maxLeaf >= 7)
+		{
+			__cpuidex(msInfo, 7, 0);
+			isAvx2 = (msInfo[1] & (1 << 5)) != 0;
+		}
+		bool isYmmEnable = isOsxSave && isAvx && ((_xgetbv(0) & 6) == 6);
+#else
+		unsigned int maxLeaf = __get_cpuid_max(0, nullptr);
+		__get_cpuid(1, &info[0], &info[1], &info[2], &info[3]);
+		bool isOsxSave = (info[2] & (1u << 27)) != 0;
+		bool isAvx = (info[2] & (1u << 28)) != 0;
+		bool isAvx2 = false;
+		if (maxLeaf >= 7)
+		{
+			__cpuid_count(7, 0, info[0], info[1], info[2], info[3]);
+			isAvx2 = (info[1] & (1u << 5)) != 0;
+		}
+		bool isYmmEnable = false;
+		if (isOsxSave && isAvx)
+		{
+			unsigned int eax, edx;
+			__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+			isYmmEnable = (eax & 6) == 6;
+		}
+#endif
+		if (isAvx2 && isYmmEnable)
+		{
+			level = FastNoise::SIMD_AVX2;
+		}
+		return level;
+#else
+		return FastNoise::SIMD_Scalar;
+#endif
+	}
+
+#ifdef FN_BATCH_X86
+	//AVX2, 8 points per lane group
+
+	FN_TARGET_AVX2 inline __m256 Avx2Lerp(__m256 a, __m256 b, __m256 t)
+	{
+		return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+	}
+
+	FN_TARGET_AVX2 inline __m256 Avx2Quintic(__m256 t)
+	{
+		__m256 t3 = _mm256_mul_ps(_mm256_mul_ps(t, t), t);
+		__m256 inner = _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6)), _mm256_set1_ps(15));
+		inner = _mm256_add_ps(_mm256_mul_ps(t, inner), _mm256_set1_ps(10));
+		return _mm256_mul_ps(t3, inner);
+	}
+
+	FN_TARGET_AVX2 inline __m256i Avx2FastFloor(__m256 f)
+	{
+		//same as FastFloor, negative values are truncated then minus one
+		__m256i truncated = _mm256_cvttps_epi32(f);
+		__m256i isNegative = _mm256_castps_si256(_mm256_cmp_ps(f, _mm256_setzero_ps(), _CMP_LT_OQ));
+		return _mm256_add_epi32(truncated, isNegative);
+	}
+
+	FN_TARGET_AVX2 inline __m256 Avx2Grad(const BatchParam& p, __m256i x, __m256i hashY, __m256 xd, __m256 yd, __m256 zd)
+	{
+		__m256i lutPos = _mm256_i32gather_epi32(p.perm12, _mm256_add_epi32(x, hashY), 4);
+		__m256 gx = _mm256_i32gather_ps(BATCH_GRAD_X, lutPos, 4);
+		__m256 gy = _mm256_i32gather_ps(BATCH_GRAD_Y, lutPos, 4);
+		__m256 gz = _mm256_i32gather_ps(BATCH_GRAD_Z, lutPos, 4);
+		return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(xd, gx), _mm256_mul_ps(yd, gy)), _mm256_mul_ps(zd, gz));
+	}
+
+	FN_TARGET_AVX2 __m256 Avx2Perlin(const BatchParam& p, int offset, __m256 x, __m256 y, __m256 z)
+	{
+		const __m256 one = _mm256_set1_ps(1);
+		const __m256i mask = _mm256_set1_epi32(0xff);
+		const __m256i oneI = _mm256_set1_epi32(1);
+
+		__m256i x0 = Avx2FastFloor(x);
+		__m256i y0 = Avx2FastFloor(y);
+		__m256i z0 = Avx2FastFloor(z);
+
+		__m256 xd0 = _mm256_sub_ps(x, _mm256_cvtepi32_ps(x0));
+		__m256 yd0 = _mm256_sub_ps(y, _mm256_cvtepi32_ps(y0));
+		__m256 zd0 = _mm256_sub_ps(z, _mm256_cvtepi32_ps(z0));
+		__m256 xs = Avx2Quintic(xd0);
+		__m256 ys = Avx2Quintic(yd0);
+		__m256 zs = Avx2Quintic(zd0);
+		__m256 xd1 = _mm256_sub_ps(xd0, one);
+		__m256 yd1 = _mm256_sub_ps(yd0, one);
+		__m256 zd1 = _mm256_sub_ps(zd0, one);
+
+		__m256i x0m = _mm256_and_si256(x0, mask);
+		__m256i x1m = _mm256_and_si256(_mm256_add_epi32(x0, oneI), mask);
+		__m256i y0m = _mm256_and_si256(y0, mask);
+		__m256i y1m = _mm256_and_si256(_mm256_add_epi32(y0, oneI), mask);
+		__m256i offsetV = _mm256_set1_epi32(offset);
+		__m256i hashZ0 = _mm256_i32gather_epi32(p.perm, _mm256_add_epi32(_mm256_and_si256(z0, mask), offsetV), 4);
+		__m256i hashZ1 = _mm256_i32gather_epi32(p.perm, _mm256_add_epi32(_mm256_and_si256(_mm256_add_epi32(z0, oneI), mask), offsetV), 4);
+		__m256i hashY00 = _mm256_i32gather_epi32(p.perm, _mm256_add_epi32(y0m, hashZ0), 4);
+		__m256i hashY10 = _mm256_i32gather_epi32(p.perm, _mm256_add_epi32(y1m, hashZ0), 4);
+		__m256i hashY01 = _mm256_i32gather_epi32(p.perm, _mm256_add_epi32(y0m, hashZ1), 4);
+		__m256i hashY11 = _mm256_i32gather_epi32(p.perm, _mm256_add_epi32(y1m, hashZ1), 4);
+
+		__m256 xf00 = Avx2Lerp(Avx2Grad(p, x0m, hashY00, xd0, yd0, zd0), Avx2Grad(p, x1m, hashY00, xd1, yd0, zd0), xs);
+		__m256 xf10 = Avx2Lerp(Avx2Grad(p, x0m, hashY10, xd0, yd1, zd0), Avx2Grad(p, x1m, hashY10, xd1, yd1, zd0), xs);
+		__m256 xf01 = Avx2Lerp(Avx2Grad(p, x0m, hashY01, xd0, yd0, zd1), Avx2Grad(p, x1m, hashY01, xd1, yd0, zd1), xs);
+		__m256 xf11 = Avx2Lerp(Avx2Grad(p, x0m, hashY11, xd0, yd1, zd1), Avx2Grad(p, x1m, hashY11, xd1, yd1, zd1), xs);
+
+		__m256 yf0 = Avx2Lerp(xf00, xf10, ys);
+		__m256 yf1 = Avx2Lerp(xf01, xf11, ys);
+
+		return Avx2Lerp(yf0, yf1, zs);
+	}
+
+	FN_TARGET_AVX2 inline __m256 Avx2Octave(const BatchParam& p, int offset, __m256 x, __m256 y, __m256 z)
+	{
+		__m256 v = Avx2Perlin(p, offset, x, y, z);
+		if (p.isBillow)
+		{
+			__m256 absV = _mm256_and_ps(v, _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)));
+			v = _mm256_sub_ps(_mm256_mul_ps(absV, _mm256_set1_ps(2)), _mm256_set1_ps(1));
+		}
+		return v;
+	}
+
+	FN_TARGET_AVX2 int Avx2NoiseSet(const BatchParam& p, const float* xIn, const float* yIn, const float* zIn, float* out, int count)
+	{
+		const __m256 frequency = _mm256_set1_ps(p.frequency);
+		const __m256 lacunarity = _mm256_set1_ps(p.lacunarity);
+		int i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 x = _mm256_mul_ps(_mm256_loadu_ps(xIn + i), frequency);
+			__m256 y = _mm256_mul_ps(_mm256_loadu_ps(yIn + i), frequency);
+			__m256 z = _mm256_mul_ps(_mm256_loadu_ps(zIn + i), frequency);
+			if (!p.isFractal)
+			{
+				_mm256_storeu_ps(out + i, Avx2Perlin(p, 0, x, y, z));
+				continue;
+			}
+			__m256 sum = Avx2Octave(p, p.perm[0], x, y, z);
+			float amp = 1;
+			for (int octave = 1; octave < p.octaves; octave++)
+			{
+				x = _mm256_mul_ps(x, lacunarity);
+				y = _mm256_mul_ps(y, lacunarity);
+				z = _mm256_mul_ps(z, lacunarity);
+				amp *= p.gain;
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(Avx2Octave(p, p.perm[octave], x, y, z), _mm256_set1_ps(amp)));
+			}
+			_mm256_storeu_ps(out + i, _mm256_mul_ps(sum, _mm256_set1_ps(p.fractalBounding)));
+		}
+		return i;
+	}
+
+	//SSE2, 4 points per lane group, the table lookups are done per lane
+
+	FN_TARGET_SSE2 inline __m128 SseLerp(__m128 a, __m128 b, __m128 t)
+	{
+		return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+	}
+
+	FN_TARGET_SSE2 inline __m128 SseQuintic(__m128 t)
+	{
+		__m128 t3 = _mm_mul_ps(_mm_mul_ps(t, t), t);
+		__m128 inner = _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6)), _mm_set1_ps(15));
+		inner = _mm_add_ps(_mm_mul_ps(t, inner), _mm_set1_ps(10));
+		return _mm_mul_ps(t3, inner);
+	}
+
+	FN_TARGET_SSE2 inline __m128i SseFastFloor(__m128 f)
+	{
+		__m128i truncated = _mm_cvttps_epi32(f);
+		__m128i isNegative = _mm_castps_si128(_mm_cmplt_ps(f, _mm_setzero_ps()));
+		return _mm_add_epi32(truncated, isNegative);
+	}
+
+	FN_TARGET_SSE2 inline __m128i SseGather(const int* table, __m128i index)
+	{
+		alignas(16) int lanes[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes), index);
+		return _mm_setr_epi32(table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]]);
+	}
+
+	FN_TARGET_SSE2 inline __m128 SseGrad(const BatchParam& p, __m128i x, __m128i hashY, __m128 xd, __m128 yd, __m128 zd)
+	{
+		alignas(16) int lutPos[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(lutPos), SseGather(p.perm12, _mm_add_epi32(x, hashY)));
+		__m128 gx = _mm_setr_ps(BATCH_GRAD_X[lutPos[0]], BATCH_GRAD_X[lutPos[1]], BATCH_GRAD_X[lutPos[2]], BATCH_GRAD_X[lutPos[3]]);
+		__m128 gy = _mm_setr_ps(BATCH_GRAD_Y[lutPos[0]], BATCH_GRAD_Y[lutPos[1]], BATCH_GRAD_Y[lutPos[2]], BATCH_GRAD_Y[lutPos[3]]);
+		__m128 gz = _mm_setr_ps(BATCH_GRAD_Z[lutPos[0]], BATCH_GRAD_Z[lutPos[1]], BATCH_GRAD_Z[lutPos[2]], BATCH_GRAD_Z[lutPos[3]]);
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(xd, gx), _mm_mul_ps(yd, gy)), _mm_mul_ps(zd, gz));
+	}
+
+	FN_TARGET_SSE2 __m128 SsePerlin(const BatchParam& p, int offset, __m128 x, __m128 y, __m128 z)
+	{
+		const __m128 one = _mm_set1_ps(1);
+		const __m128i mask = _mm_set1_epi32(0xff);
+		const __m128i oneI = _mm_set1_epi32(1);
+
+		__m128i x0 = SseFastFloor(x);
+		__m128i y0 = SseFastFloor(y);
+		__m128i z0 = SseFastFloor(z);
+
+		__m128 xd0 = _mm_sub_ps(x, _mm_cvtepi32_ps(x0));
+		__m128 yd0 = _mm_sub_ps(y, _mm_cvtepi32_ps(y0));
+		__m128 zd0 = _mm_sub_ps(z, _mm_cvtepi32_ps(z0));
+		__m128 xs = SseQuintic(xd0);
+		__m128 ys = SseQuintic(yd0);
+		__m128 zs = SseQuintic(zd0);
+		__m128 xd1 = _mm_sub_ps(xd0, one);
+		__m128 yd1 = _mm_sub_ps(yd0, one);
+		__m128 zd1 = _mm_sub_ps(zd0, one);
+
+		__m128i x0m = _mm_and_si128(x0, mask);
+		__m128i x1m = _mm_and_si128(_mm_add_epi32(x0, oneI), mask);
+		__m128i y0m = _mm_and_si128(y0, mask);
+		__m128i y1m = _mm_and_si128(_mm_add_epi32(y0, oneI), mask);
+		__m128i offsetV = _mm_set1_epi32(offset);
+		__m128i hashZ0 = SseGather(p.perm, _mm_add_epi32(_mm_and_si128(z0, mask), offsetV));
+		__m128i hashZ1 = SseGather(p.perm, _mm_add_epi32(_mm_and_si128(_mm_add_epi32(z0, oneI), mask), offsetV));
+		__m128i hashY00 = SseGather(p.perm, _mm_add_epi32(y0m, hashZ0));
+		__m128i hashY10 = SseGather(p.perm, _mm_add_epi32(y1m, hashZ0));
+		__m128i hashY01 = SseGather(p.perm, _mm_add_epi32(y0m, hashZ1));
+		__m128i hashY11 = SseGather(p.perm, _mm_add_epi32(y1m, hashZ1));
+
+		__m128 xf00 = SseLerp(SseGrad(p, x0m, hashY00, xd0, yd0, zd0), SseGrad(p, x1m, hashY00, xd1, yd0, zd0), xs);
+		__m128 xf10 = SseLerp(SseGrad(p, x0m, hashY10, xd0, yd1, zd0), SseGrad(p, x1m, hashY10, xd1, yd1, zd0), xs);
+		__m128 xf01 = SseLerp(SseGrad(p, x0m, hashY01, xd0, yd0, zd1), SseGrad(p, x1m, hashY01, xd1, yd0, zd1), xs);
+		__m128 xf11 = SseLerp(SseGrad(p, x0m, hashY11, xd0, yd1, zd1), SseGrad(p, x1m, hashY11, xd1, yd1, zd1), xs);
+
+		__m128 yf0 = SseLerp(xf00, xf10, ys);
+		__m128 yf1 = SseLerp(xf01, xf11, ys);
+
+		return SseLerp(yf0, yf1, zs);
+	}
+
+	FN_TARGET_SSE2 inline __m128 SseOctave(const BatchParam& p, int offset, __m128 x, __m128 y, __m128 z)
+	{
+		__m128 v = SsePerlin(p, offset, x, y, z);
+		if (p.isBillow)
+		{
+			__m128 absV = _mm_and_ps(v, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)));
+			v = _mm_sub_ps(_mm_mul_ps(absV, _mm_set1_ps(2)), _mm_set1_ps(1));
+		}
+		return v;
+	}
+
+	FN_TARGET_SSE2 int SseNoiseSet(const BatchParam& p, const float* xIn, const float* yIn, const float* zIn, float* out, int count)
+	{
+		const __m128 frequency = _mm_set1_ps(p.frequency);
+		const __m128 lacunarity = _mm_set1_ps(p.lacunarity);
+		int i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x = _mm_mul_ps(_mm_loadu_ps(xIn + i), frequency);
+			__m128 y = _mm_mul_ps(_mm_loadu_ps(yIn + i), frequency);
+			__m128 z = _mm_mul_ps(_mm_loadu_ps(zIn + i), frequency);
+			if (!p.isFractal)
+			{
+				_mm_storeu_ps(out + i, SsePerlin(p, 0, x, y, z));
+				continue;
+			}
+			__m128 sum = SseOctave(p, p.perm[0], x, y, z);
+			float amp = 1;
+			for (int octave = 1; octave < p.octaves; octave++)
+			{
+				x = _mm_mul_ps(x, lacunarity);
+				y = _mm_mul_ps(y, lacunarity);
+				z = _mm_mul_ps(z, lacunarity);
+				amp *= p.gain;
+				sum = _mm_add_ps(sum, _mm_mul_ps(SseOctave(p, p.perm[octave], x, y, z), _mm_set1_ps(amp)));
+			}
+			_mm_storeu_ps(out + i, _mm_mul_ps(sum, _mm_set1_ps(p.fractalBounding)));
+		}
+		return i;
+	}
+#endif
+}
+
+FastNoise::SIMDLevel FastNoise::GetSIMDLevel()
+{
+	static const int detectedLevel = DetectSIMDLevel();
+	return SIMDLevel(std::min(detectedLevel, g_simdLevelCap));
+}
+
+void FastNoise::SetSIMDLevel(SIMDLevel level)
+{
+	g_simdLevelCap = level;
+}
+
+void FastNoise::GetNoiseSet(const FN_DECIMAL* x, const FN_DECIMAL* y, const FN_DECIMAL* z, FN_DECIMAL* out, int count) const
+{
+	int done = 0;
+#ifdef FN_BATCH_X86
+	SIMDLevel level = GetSIMDLevel();
+	bool isSupported = m_interp == Quintic &&
+		(m_noiseType == Perlin || (m_noiseType == PerlinFractal && (m_fractalType == FBM || m_fractalType == Billow)));
+	if (level != SIMD_Scalar && isSupported)
+	{
+		BatchParam param;
+		for (int i = 0; i < 512; i++)
+		{
+			param.perm[i] = m_perm[i];
+			param.perm12[i] = m_perm12[i];
+		}
+		param.octaves = m_octaves;
+		param.frequency = m_frequency;
+		param.lacunarity = m_lacunarity;
+		param.gain = m_gain;
+		param.fractalBounding = m_fractalBounding;
+		param.isFractal = m_noiseType == PerlinFractal;
+		param.isBillow = param.isFractal && m_fractalType == Billow;
+		if (level == SIMD_AVX2)
+		{
+			done = Avx2NoiseSet(param, x, y, z, out, count);
+		}
+		done += SseNoiseSet(param, x + done, y + done, z + done, out + done, count - done);
+	}
+#endif
+	for (int i = done; i < count; i++)
+	{
+		out[i] = GetNoise(x[i], y[i], z[i]);
+	}
+}
@@ -1,9 +1,13 @@
 #include "EngineSrc/Engine/Engine.h"
 #include "Application/GameEntry.h"
+#include "EngineSrc/3D/Model/ModelLoader.h"
+#include "EngineSrc/Utility/file/Tfile.h"
+#include "EngineSrc/Utility/log/Log.h"
 #include <rapidjson/rapidjson.h>
 #include "External/Lua/lua.hpp"
 #include <iostream>
 #include <time.h>
+#include <string.h>
 #include <windows.h>
 #include <DbgHelp.h>  
 #pragma comment(lib, "dbghelp.lib")  
@@ -34,6 +38,7 @@ LONG ApplicationCrashHandler(EXCEPTION_POINTERS *pException)
     // ںܶǵһʹ󱨸ĶԻ
 
     // ԵһԻ˳Ϊ
+    tzw::flushLogOnCrash();
     CreateDumpFile(TEXT("last.dmp"), pException);
     FatalAppExit(-1, TEXT("Sorry, it crashed, please send the dump file to me(tzwtangziwen@163.com)"));
 
@@ -70,6 +75,29 @@ int main(int argc, char *argv[])
 {
 
     SetUnhandledExceptionFilter((LPTOP_LEVEL_EXCEPTION_FILTER)ApplicationCrashHandler);
+    //-bench <script> replays the script on the null render device
+    for(int i = 1; i + 1 < argc; i++)
+    {
+        if(strcmp(argv[i], "-bench") == 0)
+        {
+            EngineDef::isHeadless = true;
+            return Engine::run(argc, argv, new BenchmarkEntry(argv[i + 1]));
+        }
+        //-convert <model.tzw>... writes the .tzwb of every model beside it, no window is created
+        if(strcmp(argv[i], "-convert") == 0)
+        {
+            initLogSystem();
+            Tfile::shared()->addSearchPath("./Asset/");
+            Tfile::shared()->addSearchPath("./");
+            int failCount = 0;
+            for(int k = i + 1; k < argc; k++)
+            {
+                if(!ModelLoader::shared()->convertToBinary(argv[k])) failCount++;
+            }
+            shutdownLogSystem();
+            return failCount == 0 ? 0 : 1;
+        }
+    }
 #ifdef  TEST_VULKAN_ENTRY
     return Engine::run(argc,argv,new TestVulkanEntry());
 #else
@@ -15,6 +15,10 @@ def tzw_engine_ui_update(dt):
 def tzw_engine_input_event(eventInfo):
 	Main.onEngineInputEvent(eventInfo)
 
+def tzw_engine_input_event_list(eventList):
+	for eventInfo in eventList:
+		Main.onEngineInputEvent(eventInfo)
+
 def tzw_on_game_ready():
 	print("on Game Ready")
 	pass